@@ -76,4 +76,8 @@ void Shutdown() {
     DSP::HLE::Shutdown();
 }
 
+void DoState(PointerWrap& p) {
+    DSP::HLE::DoState(p);
+}
+
 } // namespace AudioCore
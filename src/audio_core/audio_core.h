@@ -6,6 +6,8 @@
 
 #include <string>
 
+class PointerWrap;
+
 namespace Kernel {
 class VMManager;
 }
@@ -26,4 +28,7 @@ void SelectSink(std::string sink_id);
 /// Shutdown Audio Core
 void Shutdown();
 
+/// Saves or restores the emulated DSP state. The host audio output is not affected.
+void DoState(PointerWrap& p);
+
 } // namespace
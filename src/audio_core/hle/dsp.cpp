@@ -12,6 +12,8 @@
 #include "audio_core/sink.h"
 #include "audio_core/time_stretch.h"
 
+#include "common/chunk_file.h"
+
 namespace DSP {
 namespace HLE {
 
@@ -131,6 +133,18 @@ bool Tick() {
     return true;
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("DSP", 1);
+    if (!s)
+        return;
+
+    p.DoVoid(g_regions.data(), sizeof(g_regions));
+    DoPipeState(p);
+    for (auto& source : sources)
+        source.DoState(p);
+    mixers.DoState(p);
+}
+
 void SetSink(std::unique_ptr<AudioCore::Sink> sink_) {
     sink = std::move(sink_);
     time_stretcher.SetOutputSampleRate(sink->GetNativeSampleRate());
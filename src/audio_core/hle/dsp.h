@@ -16,6 +16,8 @@
 #include "common/common_types.h"
 #include "common/swap.h"
 
+class PointerWrap;
+
 namespace AudioCore {
 class Sink;
 }
@@ -544,5 +546,8 @@ bool Tick();
  */
 void SetSink(std::unique_ptr<AudioCore::Sink> sink);
 
+/// Saves or restores the DSP shared memory regions, pipes and the state of every source and mixer.
+void DoState(PointerWrap& p);
+
 } // namespace HLE
 } // namespace DSP
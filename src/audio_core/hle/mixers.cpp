@@ -9,6 +9,7 @@
 #include "audio_core/hle/mixers.h"
 
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 
@@ -20,6 +21,11 @@ void Mixers::Reset() {
     state = {};
 }
 
+void Mixers::DoState(PointerWrap& p) {
+    p.DoVoid(&current_frame, sizeof(current_frame));
+    p.DoVoid(&state, sizeof(state));
+}
+
 DspStatus Mixers::Tick(DspConfiguration& config,
         const IntermediateMixSamples& read_samples,
         IntermediateMixSamples& write_samples,
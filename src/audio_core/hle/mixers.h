@@ -9,6 +9,8 @@
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/dsp.h"
 
+class PointerWrap;
+
 namespace DSP {
 namespace HLE {
 
@@ -29,6 +31,9 @@ public:
         return current_frame;
     }
 
+    /// Saves or restores the internal state.
+    void DoState(PointerWrap& p);
+
 private:
     StereoFrame16 current_frame = {};
 
@@ -9,6 +9,7 @@
 #include "audio_core/hle/pipe.h"
 
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 
@@ -28,6 +29,12 @@ void ResetPipes() {
     dsp_state = DspState::Off;
 }
 
+void DoPipeState(PointerWrap& p) {
+    for (auto& data : pipe_data)
+        p.DoPOD(data);
+    p.Do(dsp_state);
+}
+
 std::vector<u8> PipeRead(DspPipe pipe_number, u32 length) {
     const size_t pipe_index = static_cast<size_t>(pipe_number);
 
@@ -9,12 +9,17 @@
 
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace DSP {
 namespace HLE {
 
 /// Reset the pipes by setting pipe positions back to the beginning.
 void ResetPipes();
 
+/// Saves or restores the pipe contents and the DSP state.
+void DoPipeState(PointerWrap& p);
+
 enum class DspPipe {
     Debug = 0,
     Dma = 1,
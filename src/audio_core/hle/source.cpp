@@ -11,6 +11,7 @@
 #include "audio_core/interpolate.h"
 
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 
 #include "core/memory.h"
@@ -47,6 +48,38 @@ void Source::Reset() {
     state = {};
 }
 
+void Source::DoState(PointerWrap& p) {
+    p.DoVoid(&current_frame, sizeof(current_frame));
+
+    p.Do(state.enabled);
+    p.Do(state.sync);
+    p.Do(state.gain);
+
+    // std::priority_queue doesn't expose its contents, so it is drained into a vector and rebuilt.
+    std::vector<Buffer> queued_buffers;
+    while (!state.input_queue.empty()) {
+        queued_buffers.push_back(state.input_queue.top());
+        state.input_queue.pop();
+    }
+    p.DoPOD(queued_buffers);
+    for (const Buffer& buffer : queued_buffers)
+        state.input_queue.push(buffer);
+
+    p.Do(state.mono_or_stereo);
+    p.Do(state.format);
+    p.Do(state.current_sample_number);
+    p.Do(state.next_sample_number);
+    p.DoPOD(state.current_buffer);
+    p.Do(state.buffer_update);
+    p.Do(state.current_buffer_id);
+    p.Do(state.adpcm_coeffs);
+    p.DoVoid(&state.adpcm_state, sizeof(state.adpcm_state));
+    p.Do(state.rate_multiplier);
+    p.Do(state.interpolation_mode);
+    p.DoVoid(&state.interp_state, sizeof(state.interp_state));
+    p.DoVoid(&state.filters, sizeof(state.filters));
+}
+
 void Source::ParseConfig(SourceConfiguration::Configuration& config, const s16_le (&adpcm_coeffs)[16]) {
     if (!config.dirty_raw) {
         return;
@@ -16,6 +16,8 @@
 
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace DSP {
 namespace HLE {
 
@@ -52,6 +54,9 @@ public:
      */
     void MixInto(QuadFrame32& dest, size_t intermediate_mix_id) const;
 
+    /// Saves or restores the internal state, including the queue of pending buffers.
+    void DoState(PointerWrap& p);
+
 private:
     const size_t source_id;
     StereoFrame16 current_frame;
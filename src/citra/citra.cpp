@@ -2,10 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
+#include <cstdio>
 #include <string>
 #include <thread>
 #include <iostream>
 #include <memory>
+#include <vector>
 
 // This needs to be included before getopt.h because the latter #defines symbols used by it
 #include "common/microprofile.h"
@@ -21,6 +24,7 @@
 #include <Windows.h>
 #endif
 
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
@@ -31,10 +35,14 @@
 #include "core/settings.h"
 #include "core/system.h"
 #include "core/core.h"
+#include "core/memory.h"
 #include "core/gdbstub/gdbstub.h"
+#include "core/hw/gpu.h"
 #include "core/loader/loader.h"
 
 #include "citra/config.h"
+#include "citra/input_log.h"
+#include "citra/emu_window/emu_window_headless.h"
 #include "citra/emu_window/emu_window_sdl2.h"
 
 #include "video_core/video_core.h"
@@ -43,9 +51,29 @@
 static void PrintHelp(const char *argv0)
 {
     std::cout << "Usage: " << argv0 << " [options] <filename>\n"
-                 "-g, --gdbport=NUMBER  Enable gdb stub on port NUMBER\n"
-                 "-h, --help            Display this help and exit\n"
-                 "-v, --version         Output version information and exit\n";
+                 "-g, --gdbport=NUMBER       Enable gdb stub on port NUMBER\n"
+                 "    --headless             Run without a window, for automated testing\n"
+                 "-n, --frames=NUMBER        Exit after emulating NUMBER frames\n"
+                 "-r, --record-input=FILE    Record the input of every frame to FILE\n"
+                 "-i, --replay-input=FILE    Replay the input recorded in FILE (requires --headless)\n"
+                 "-s, --stats=FILE           Write per-frame timings and framebuffer hashes to FILE\n"
+                 "                           (defaults to the standard output when headless)\n"
+                 "-h, --help                 Display this help and exit\n"
+                 "-v, --version              Output version information and exit\n";
+}
+
+/// Hashes the framebuffer currently displayed on the given screen.
+static u64 HashFramebuffer(int screen) {
+    const auto& framebuffer = GPU::g_regs.framebuffer_config[screen];
+    const PAddr address = framebuffer.active_fb == 0 ? framebuffer.address_left1 : framebuffer.address_left2;
+    if (address == 0)
+        return 0;
+
+    const u8* data = Memory::GetPhysicalPointer(address);
+    if (data == nullptr)
+        return 0;
+
+    return Common::ComputeHash64(data, framebuffer.stride * framebuffer.height);
 }
 
 static void PrintVersion()
@@ -70,16 +98,29 @@ int main(int argc, char **argv) {
     }
 #endif
     std::string boot_filename;
+    bool headless = false;
+    u64 max_frames = 0;
+    std::string record_input_filename;
+    std::string replay_input_filename;
+    std::string stats_filename;
+
+    // Value returned by getopt_long for options that only have a long form
+    static const int OPTION_HEADLESS = 0x100;
 
     static struct option long_options[] = {
         { "gdbport", required_argument, 0, 'g' },
+        { "headless", no_argument, 0, OPTION_HEADLESS },
+        { "frames", required_argument, 0, 'n' },
+        { "record-input", required_argument, 0, 'r' },
+        { "replay-input", required_argument, 0, 'i' },
+        { "stats", required_argument, 0, 's' },
         { "help", no_argument, 0, 'h' },
         { "version", no_argument, 0, 'v' },
         { 0, 0, 0, 0 }
     };
 
     while (optind < argc) {
-        char arg = getopt_long(argc, argv, "g:hv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "g:n:r:i:s:hv", long_options, &option_index);
         if (arg != -1) {
             switch (arg) {
             case 'g':
@@ -92,6 +133,27 @@ int main(int argc, char **argv) {
                     exit(1);
                 }
                 break;
+            case OPTION_HEADLESS:
+                headless = true;
+                break;
+            case 'n':
+                errno = 0;
+                max_frames = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg) errno = EINVAL;
+                if (errno != 0) {
+                    perror("--frames");
+                    exit(1);
+                }
+                break;
+            case 'r':
+                record_input_filename = optarg;
+                break;
+            case 'i':
+                replay_input_filename = optarg;
+                break;
+            case 's':
+                stats_filename = optarg;
+                break;
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
@@ -124,16 +186,65 @@ int main(int argc, char **argv) {
         return -1;
     }
 
+    if (!replay_input_filename.empty() && !headless) {
+        LOG_CRITICAL(Frontend, "Replaying input requires --headless");
+        return -1;
+    }
+
+    std::vector<InputFrame> replay_input;
+    if (!replay_input_filename.empty() && !LoadInputLog(replay_input_filename, replay_input))
+        return -1;
+
+    InputLogWriter input_recorder;
+    if (!record_input_filename.empty() && !input_recorder.Open(record_input_filename))
+        return -1;
+
+    FILE* stats_file = nullptr;
+    if (!stats_filename.empty()) {
+        stats_file = std::fopen(stats_filename.c_str(), "w");
+        if (stats_file == nullptr) {
+            LOG_CRITICAL(Frontend, "Failed to open %s", stats_filename.c_str());
+            return -1;
+        }
+    } else if (headless) {
+        stats_file = stdout;
+    }
+    SCOPE_EXIT({
+        if (stats_file != nullptr && stats_file != stdout)
+            std::fclose(stats_file);
+    });
+
     log_filter.ParseFilterString(Settings::values.log_filter);
 
     // Apply the command line arguments
     Settings::values.gdbstub_port = gdb_port;
     Settings::values.use_gdbstub = use_gdbstub;
+    if (headless || input_recorder.IsOpen()) {
+        // Input is recorded and replayed once per presented frame, so every frame must be presented,
+        // and the emulated system must not depend on the host for the replay to be reproducible.
+        Settings::values.frame_skip = 0;
+        Settings::values.use_deterministic_mode = true;
+    }
+    if (headless) {
+        // Frame hashes must not depend on the renderer settings of the user's config file
+        Settings::values.use_hw_renderer = false;
+        Settings::values.use_async_gpu = false;
+        Settings::values.sink_id = "null";
+    }
     Settings::Apply();
 
-    std::unique_ptr<EmuWindow_SDL2> emu_window = std::make_unique<EmuWindow_SDL2>();
+    std::unique_ptr<EmuWindow_SDL2> sdl_window;
+    std::unique_ptr<EmuWindow_Headless> headless_window;
+    EmuWindow* emu_window;
+    if (headless) {
+        headless_window = std::make_unique<EmuWindow_Headless>(std::move(replay_input));
+        emu_window = headless_window.get();
+    } else {
+        sdl_window = std::make_unique<EmuWindow_SDL2>();
+        emu_window = sdl_window.get();
+    }
 
-    System::Init(emu_window.get());
+    System::Init(emu_window, headless);
     SCOPE_EXIT({ System::Shutdown(); });
 
     std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(boot_filename);
@@ -148,8 +259,44 @@ int main(int argc, char **argv) {
         return -1;
     }
 
-    while (emu_window->IsOpen()) {
+    if (stats_file != nullptr)
+        std::fprintf(stats_file, "frame,time_us,top_hash,bottom_hash\n");
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start_time = Clock::now();
+    Clock::time_point frame_start_time = start_time;
+    u64 frame = GPU::GetFrameCount();
+
+    while (headless || sdl_window->IsOpen()) {
         Core::RunLoop();
+
+        if (GPU::GetFrameCount() == frame)
+            continue;
+        frame = GPU::GetFrameCount();
+
+        if (input_recorder.IsOpen())
+            input_recorder.Write(CaptureInputFrame(*emu_window));
+
+        if (stats_file != nullptr) {
+            const Clock::time_point now = Clock::now();
+            const long long frame_time_us =
+                std::chrono::duration_cast<std::chrono::microseconds>(now - frame_start_time).count();
+            frame_start_time = now;
+
+            std::fprintf(stats_file, "%llu,%lld,%016llx,%016llx\n",
+                         static_cast<unsigned long long>(frame), frame_time_us,
+                         static_cast<unsigned long long>(HashFramebuffer(0)),
+                         static_cast<unsigned long long>(HashFramebuffer(1)));
+        }
+
+        if (max_frames != 0 && frame >= max_frames)
+            break;
+    }
+
+    if (headless) {
+        const double total_s = std::chrono::duration<double>(Clock::now() - start_time).count();
+        LOG_INFO(Frontend, "Emulated %llu frames in %.3f s (%.2f fps)",
+                 static_cast<unsigned long long>(frame), total_s, total_s > 0 ? frame / total_s : 0.0);
     }
 
     return 0;
@@ -66,10 +66,18 @@ void Config::ReadValues() {
 
     // Core
     Settings::values.frame_skip = sdl2_config->GetInteger("Core", "frame_skip", 0);
+    Settings::values.use_rewind = sdl2_config->GetBoolean("Core", "use_rewind", false);
+    Settings::values.rewind_interval = sdl2_config->GetInteger("Core", "rewind_interval", 30);
+    Settings::values.rewind_buffer_size = sdl2_config->GetInteger("Core", "rewind_buffer_size", 512);
 
     // Renderer
     Settings::values.use_hw_renderer = sdl2_config->GetBoolean("Renderer", "use_hw_renderer", true);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.use_shader_jit_async = sdl2_config->GetBoolean("Renderer", "use_shader_jit_async", true);
+    Settings::values.use_shader_disk_cache = sdl2_config->GetBoolean("Renderer", "use_shader_disk_cache", true);
+    Settings::values.parallel_vertex_threshold = sdl2_config->GetInteger("Renderer", "parallel_vertex_threshold", 2048);
+    Settings::values.use_sw_rasterizer_binning = sdl2_config->GetBoolean("Renderer", "use_sw_rasterizer_binning", true);
+    Settings::values.use_async_gpu = sdl2_config->GetBoolean("Renderer", "use_async_gpu", false);
     Settings::values.use_scaled_resolution = sdl2_config->GetBoolean("Renderer", "use_scaled_resolution", false);
 
     Settings::values.bg_red   = (float)sdl2_config->GetReal("Renderer", "bg_red",   1.0);
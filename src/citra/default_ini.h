@@ -42,6 +42,16 @@ pad_circle_modifier_scale =
 # 0 (default): No frameskip, 1: x2 frameskip, 2: x4 frameskip, 3: x8 frameskip, etc.
 frame_skip =
 
+# Whether to periodically take snapshots of the emulation state that can be rewound to
+# 0 (default): Off, 1: On
+use_rewind =
+
+# The number of frames between two rewind snapshots. Defaults to 30
+rewind_interval =
+
+# The maximum amount of memory used by rewind snapshots, in MiB. Defaults to 512
+rewind_buffer_size =
+
 [Renderer]
 # Whether to use software or hardware rendering.
 # 0: Software, 1 (default): Hardware
@@ -51,6 +61,27 @@ use_hw_renderer =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to compile shaders on a background thread, interpreting them until they are compiled
+# 0: Off, 1 (default): On
+use_shader_jit_async =
+
+# Whether to store the shaders of each game on disk, to compile them when the game starts next time
+# 0: Off, 1 (default): On
+use_shader_disk_cache =
+
+# Draws with at least this many vertices are loaded and shaded on multiple threads
+# 0: Off, defaults to 2048
+parallel_vertex_threshold =
+
+# Whether the software renderer bins triangles into screen tiles and rasterizes them on multiple threads
+# 0: Off, 1 (default): On
+use_sw_rasterizer_binning =
+
+# Whether the software renderer runs GPU commands on a separate thread, in parallel with the emulated CPU
+# Always off in deterministic mode (replays and --headless), as GPU interrupts then depend on host timing
+# 0 (default): Off, 1: On
+use_async_gpu =
+
 # Whether to use native 3DS screen resolution or to scale rendering resolution to the displayed screen size.
 # 0 (default): Native, 1: Scaled
 use_scaled_resolution =
@@ -0,0 +1,36 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+
+#include "core/hle/service/hid/hid.h"
+
+#include "citra/emu_window/emu_window_headless.h"
+
+EmuWindow_Headless::EmuWindow_Headless(std::vector<InputFrame> input) : input(std::move(input)) {
+}
+
+void EmuWindow_Headless::SwapBuffers() {
+}
+
+void EmuWindow_Headless::PollEvents() {
+    // Once the log runs out, the last recorded state is held
+    if (next_input_frame >= input.size())
+        return;
+
+    const InputFrame& frame = input[next_input_frame++];
+    Service::HID::PadState pad_state;
+    pad_state.hex = frame.pad_state;
+    SetInputState(pad_state, frame.circle_pad_x, frame.circle_pad_y,
+                  frame.touch_x, frame.touch_y, frame.touch_pressed);
+}
+
+void EmuWindow_Headless::MakeCurrent() {
+}
+
+void EmuWindow_Headless::DoneCurrent() {
+}
+
+void EmuWindow_Headless::ReloadSetKeymaps() {
+}
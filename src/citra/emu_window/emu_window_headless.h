@@ -0,0 +1,40 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "common/emu_window.h"
+
+#include "citra/input_log.h"
+
+/**
+ * Window used when running without a display. It has no graphics context, and its input is
+ * replayed from an input log, advancing by one entry every time events are polled (i.e. once per
+ * presented frame).
+ */
+class EmuWindow_Headless : public EmuWindow {
+public:
+    explicit EmuWindow_Headless(std::vector<InputFrame> input);
+
+    /// Swap buffers to display the next frame
+    void SwapBuffers() override;
+
+    /// Applies the input of the next frame
+    void PollEvents() override;
+
+    /// Makes the graphics context current for the caller thread
+    void MakeCurrent() override;
+
+    /// Releases the GL context from the caller thread
+    void DoneCurrent() override;
+
+    /// Load keymap from configuration
+    void ReloadSetKeymaps() override;
+
+private:
+    std::vector<InputFrame> input;
+    size_t next_input_frame = 0;
+};
@@ -0,0 +1,74 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <sstream>
+#include <tuple>
+
+#include "common/emu_window.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+
+#include "citra/input_log.h"
+
+InputFrame CaptureInputFrame(const EmuWindow& emu_window) {
+    InputFrame frame;
+    frame.pad_state = emu_window.GetPadState().hex;
+    std::tie(frame.circle_pad_x, frame.circle_pad_y) = emu_window.GetCirclePadState();
+    std::tie(frame.touch_x, frame.touch_y, frame.touch_pressed) = emu_window.GetTouchState();
+    return frame;
+}
+
+bool LoadInputLog(const std::string& path, std::vector<InputFrame>& frames) {
+    std::ifstream file;
+    OpenFStream(file, path, std::ios_base::in);
+    if (!file.is_open()) {
+        LOG_CRITICAL(Frontend, "Failed to open input log %s", path.c_str());
+        return false;
+    }
+
+    frames.clear();
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream stream(line);
+        InputFrame frame;
+        int touch_pressed;
+        stream >> std::hex >> frame.pad_state >> std::dec >> frame.circle_pad_x >> frame.circle_pad_y
+               >> frame.touch_x >> frame.touch_y >> touch_pressed;
+        if (stream.fail()) {
+            LOG_CRITICAL(Frontend, "Malformed input log %s at line %d", path.c_str(), line_number);
+            return false;
+        }
+        frame.touch_pressed = touch_pressed != 0;
+        frames.push_back(frame);
+    }
+
+    return true;
+}
+
+bool InputLogWriter::Open(const std::string& path) {
+    OpenFStream(file, path, std::ios_base::out | std::ios_base::trunc);
+    if (!file.is_open()) {
+        LOG_CRITICAL(Frontend, "Failed to open input log %s for writing", path.c_str());
+        return false;
+    }
+
+    file << "# pad_state circle_pad_x circle_pad_y touch_x touch_y touch_pressed\n";
+    return true;
+}
+
+bool InputLogWriter::IsOpen() const {
+    return file.is_open();
+}
+
+void InputLogWriter::Write(const InputFrame& frame) {
+    file << std::hex << frame.pad_state << std::dec << ' ' << frame.circle_pad_x << ' '
+         << frame.circle_pad_y << ' ' << frame.touch_x << ' ' << frame.touch_y << ' '
+         << (frame.touch_pressed ? 1 : 0) << '\n';
+}
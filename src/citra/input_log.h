@@ -0,0 +1,47 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+
+class EmuWindow;
+
+/**
+ * Input state read by Service::HID::Update during one frame. Input logs store one of these per
+ * line as text: "<pad state hex> <circle pad x> <circle pad y> <touch x> <touch y> <touch pressed>".
+ * Lines starting with '#' are ignored.
+ */
+struct InputFrame {
+    u32 pad_state = 0;
+    s16 circle_pad_x = 0;
+    s16 circle_pad_y = 0;
+    u16 touch_x = 0;
+    u16 touch_y = 0;
+    bool touch_pressed = false;
+};
+
+/// Returns the input state currently reported by the given window.
+InputFrame CaptureInputFrame(const EmuWindow& emu_window);
+
+/**
+ * Reads an input log.
+ * @return Whether the file could be opened and was entirely valid
+ */
+bool LoadInputLog(const std::string& path, std::vector<InputFrame>& frames);
+
+/// Writes input frames to a file as they are emulated.
+class InputLogWriter {
+public:
+    bool Open(const std::string& path);
+    bool IsOpen() const;
+    void Write(const InputFrame& frame);
+
+private:
+    std::ofstream file;
+};
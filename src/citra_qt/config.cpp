@@ -42,11 +42,19 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Core");
     Settings::values.frame_skip = qt_config->value("frame_skip", 0).toInt();
+    Settings::values.use_rewind = qt_config->value("use_rewind", false).toBool();
+    Settings::values.rewind_interval = qt_config->value("rewind_interval", 30).toInt();
+    Settings::values.rewind_buffer_size = qt_config->value("rewind_buffer_size", 512).toInt();
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
     Settings::values.use_hw_renderer = qt_config->value("use_hw_renderer", true).toBool();
     Settings::values.use_shader_jit = qt_config->value("use_shader_jit", true).toBool();
+    Settings::values.use_shader_jit_async = qt_config->value("use_shader_jit_async", true).toBool();
+    Settings::values.use_shader_disk_cache = qt_config->value("use_shader_disk_cache", true).toBool();
+    Settings::values.parallel_vertex_threshold = qt_config->value("parallel_vertex_threshold", 2048).toInt();
+    Settings::values.use_sw_rasterizer_binning = qt_config->value("use_sw_rasterizer_binning", true).toBool();
+    Settings::values.use_async_gpu = qt_config->value("use_async_gpu", false).toBool();
     Settings::values.use_scaled_resolution = qt_config->value("use_scaled_resolution", false).toBool();
 
     Settings::values.bg_red   = qt_config->value("bg_red",   1.0).toFloat();
@@ -133,11 +141,19 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Core");
     qt_config->setValue("frame_skip", Settings::values.frame_skip);
+    qt_config->setValue("use_rewind", Settings::values.use_rewind);
+    qt_config->setValue("rewind_interval", Settings::values.rewind_interval);
+    qt_config->setValue("rewind_buffer_size", Settings::values.rewind_buffer_size);
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
     qt_config->setValue("use_hw_renderer", Settings::values.use_hw_renderer);
     qt_config->setValue("use_shader_jit", Settings::values.use_shader_jit);
+    qt_config->setValue("use_shader_jit_async", Settings::values.use_shader_jit_async);
+    qt_config->setValue("use_shader_disk_cache", Settings::values.use_shader_disk_cache);
+    qt_config->setValue("parallel_vertex_threshold", Settings::values.parallel_vertex_threshold);
+    qt_config->setValue("use_sw_rasterizer_binning", Settings::values.use_sw_rasterizer_binning);
+    qt_config->setValue("use_async_gpu", Settings::values.use_async_gpu);
     qt_config->setValue("use_scaled_resolution", Settings::values.use_scaled_resolution);
 
     // Cast to double because Qt's written float values are not human-readable
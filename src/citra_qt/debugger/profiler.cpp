@@ -2,9 +2,16 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <QApplication>
+#include <QBoxLayout>
+#include <QClipboard>
+#include <QHeaderView>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QPushButton>
+#include <QStandardItemModel>
 #include <QString>
+#include <QTreeView>
 
 #include "citra_qt/debugger/profiler.h"
 #include "citra_qt/util/util.h"
@@ -12,6 +19,9 @@
 #include "common/common_types.h"
 #include "common/microprofile.h"
 #include "common/profiler_reporting.h"
+#include "common/logging/log.h"
+
+#include "core/hle/profiler.h"
 
 // Include the implementation of the UI in this file. This isn't in microprofile.cpp because the
 // non-Qt frontends don't need it (and don't implement the UI drawing hooks either).
@@ -128,6 +138,105 @@ void ProfilerWidget::setProfilingInfoUpdateEnabled(bool enable)
     }
 }
 
+HLEProfilerWidget::HLEProfilerWidget(QWidget* parent) : QDockWidget(tr("HLE Profiler"), parent)
+{
+    setObjectName("HLEProfiler");
+
+    model = new QStandardItemModel(this);
+    model->setHorizontalHeaderLabels({ tr("Function"), tr("Calls"), tr("Total (ms)"),
+                                       tr("Avg (us)"), tr("Min (us)"), tr("Max (us)") });
+
+    tree_view = new QTreeView;
+    tree_view->setAlternatingRowColors(true);
+    tree_view->setUniformRowHeights(true);
+    tree_view->setRootIsDecorated(false);
+    tree_view->setSortingEnabled(true);
+    tree_view->sortByColumn(2, Qt::DescendingOrder);
+    tree_view->setModel(model);
+
+    QPushButton* reset_button = new QPushButton(tr("Reset"));
+    QPushButton* copy_button = new QPushButton(tr("Copy Report"));
+    copy_button->setToolTip(tr("Copies a plain-text report to the clipboard and the log"));
+
+    connect(reset_button, SIGNAL(clicked()), this, SLOT(resetProfilingInfo()));
+    connect(copy_button, SIGNAL(clicked()), this, SLOT(copyReport()));
+
+    auto main_widget = new QWidget;
+    auto main_layout = new QVBoxLayout;
+    main_layout->addWidget(tree_view);
+    {
+        auto sub_layout = new QHBoxLayout;
+        sub_layout->addWidget(reset_button);
+        sub_layout->addWidget(copy_button);
+        main_layout->addLayout(sub_layout);
+    }
+    main_widget->setLayout(main_layout);
+    setWidget(main_widget);
+
+    connect(this, SIGNAL(visibilityChanged(bool)), SLOT(setProfilingInfoUpdateEnabled(bool)));
+    connect(&update_timer, SIGNAL(timeout()), SLOT(updateProfilingInfo()));
+}
+
+void HLEProfilerWidget::setProfilingInfoUpdateEnabled(bool enable)
+{
+    if (enable) {
+        update_timer.start(500);
+        updateProfilingInfo();
+    } else {
+        update_timer.stop();
+    }
+}
+
+void HLEProfilerWidget::updateProfilingInfo()
+{
+    using FloatUs = std::chrono::duration<double, std::micro>;
+    static auto to_us = [](HLE::Profiler::Duration dur) -> double {
+        return std::chrono::duration_cast<FloatUs>(dur).count();
+    };
+
+    std::vector<HLE::Profiler::CallStats> stats = HLE::Profiler::GetCallStats();
+
+    model->setRowCount(static_cast<int>(stats.size()));
+    for (int row = 0; row < static_cast<int>(stats.size()); ++row) {
+        const HLE::Profiler::CallStats& entry = stats[row];
+        double total_us = to_us(entry.total);
+
+        QVariant values[] = {
+            QString::fromStdString(entry.name),
+            static_cast<qulonglong>(entry.count),
+            total_us / 1000.0,
+            total_us / entry.count,
+            to_us(entry.min),
+            to_us(entry.max),
+        };
+        for (int column = 0; column < 6; ++column) {
+            QStandardItem* item = model->item(row, column);
+            if (item == nullptr) {
+                item = new QStandardItem;
+                item->setEditable(false);
+                model->setItem(row, column, item);
+            }
+            item->setData(values[column], Qt::DisplayRole);
+        }
+    }
+
+    model->sort(tree_view->header()->sortIndicatorSection(),
+                tree_view->header()->sortIndicatorOrder());
+}
+
+void HLEProfilerWidget::resetProfilingInfo()
+{
+    HLE::Profiler::ResetCallStats();
+    model->setRowCount(0);
+}
+
+void HLEProfilerWidget::copyReport()
+{
+    std::string report = HLE::Profiler::FormatReport();
+    LOG_INFO(Frontend, "HLE profiler report:\n%s", report.c_str());
+    QApplication::clipboard()->setText(QString::fromStdString(report));
+}
+
 #if MICROPROFILE_ENABLED
 
 class MicroProfileWidget : public QWidget {
@@ -13,6 +13,9 @@
 #include "common/microprofile.h"
 #include "common/profiler_reporting.h"
 
+class QStandardItemModel;
+class QTreeView;
+
 class ProfilerModel : public QAbstractItemModel
 {
     Q_OBJECT
@@ -51,6 +54,26 @@ private:
     QTimer update_timer;
 };
 
+/// Lists how much time was spent in each HLE service function and SVC.
+class HLEProfilerWidget : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    HLEProfilerWidget(QWidget* parent = nullptr);
+
+private slots:
+    void setProfilingInfoUpdateEnabled(bool enable);
+    void updateProfilingInfo();
+    void resetProfilingInfo();
+    void copyReport();
+
+private:
+    QStandardItemModel* model;
+    QTreeView* tree_view;
+
+    QTimer update_timer;
+};
 
 class MicroProfileDialog : public QWidget {
     Q_OBJECT
@@ -47,6 +47,8 @@
 #include "common/logging/text_formatter.h"
 
 #include "core/core.h"
+#include "core/rewind.h"
+#include "core/savestate.h"
 #include "core/settings.h"
 #include "core/system.h"
 #include "core/arm/disassembler/load_symbol_map.h"
@@ -72,6 +74,10 @@ GMainWindow::GMainWindow() : config(new Config()), emu_thread(nullptr)
     addDockWidget(Qt::BottomDockWidgetArea, profilerWidget);
     profilerWidget->hide();
 
+    auto hleProfilerWidget = new HLEProfilerWidget(this);
+    addDockWidget(Qt::BottomDockWidgetArea, hleProfilerWidget);
+    hleProfilerWidget->hide();
+
 #if MICROPROFILE_ENABLED
     microProfileDialog = new MicroProfileDialog(this);
     microProfileDialog->hide();
@@ -116,6 +122,7 @@ GMainWindow::GMainWindow() : config(new Config()), emu_thread(nullptr)
     debug_menu->addAction(graphicsSurfaceViewerAction);
     debug_menu->addSeparator();
     debug_menu->addAction(profilerWidget->toggleViewAction());
+    debug_menu->addAction(hleProfilerWidget->toggleViewAction());
 #if MICROPROFILE_ENABLED
     debug_menu->addAction(microProfileDialog->toggleViewAction());
 #endif
@@ -175,6 +182,9 @@ GMainWindow::GMainWindow() : config(new Config()), emu_thread(nullptr)
     connect(ui.action_Start, SIGNAL(triggered()), this, SLOT(OnStartGame()));
     connect(ui.action_Pause, SIGNAL(triggered()), this, SLOT(OnPauseGame()));
     connect(ui.action_Stop, SIGNAL(triggered()), this, SLOT(OnStopGame()));
+    connect(ui.action_Save_State, SIGNAL(triggered()), this, SLOT(OnSaveState()));
+    connect(ui.action_Load_State, SIGNAL(triggered()), this, SLOT(OnLoadState()));
+    connect(ui.action_Rewind, SIGNAL(triggered()), this, SLOT(OnRewind()));
     connect(ui.action_Single_Window_Mode, SIGNAL(triggered(bool)), this, SLOT(ToggleWindowMode()));
 
     connect(this, SIGNAL(EmulationStarting(EmuThread*)), disasmWidget, SLOT(OnEmulationStarting(EmuThread*)));
@@ -190,10 +200,12 @@ GMainWindow::GMainWindow() : config(new Config()), emu_thread(nullptr)
     // Setup hotkeys
     RegisterHotkey("Main Window", "Load File", QKeySequence::Open);
     RegisterHotkey("Main Window", "Start Emulation");
+    RegisterHotkey("Main Window", "Rewind", QKeySequence(Qt::Key_Backspace));
     LoadHotkeys();
 
     connect(GetHotkey("Main Window", "Load File", this), SIGNAL(activated()), this, SLOT(OnMenuLoadFile()));
     connect(GetHotkey("Main Window", "Start Emulation", this), SIGNAL(activated()), this, SLOT(OnStartGame()));
+    connect(GetHotkey("Main Window", "Rewind", this), SIGNAL(activated()), this, SLOT(OnRewind()));
 
     std::string window_title = Common::StringFromFormat("Citra | %s-%s", Common::g_scm_branch, Common::g_scm_desc);
     setWindowTitle(window_title.c_str());
@@ -374,6 +386,9 @@ void GMainWindow::ShutdownGame() {
     ui.action_Start->setText(tr("Start"));
     ui.action_Pause->setEnabled(false);
     ui.action_Stop->setEnabled(false);
+    ui.action_Save_State->setEnabled(false);
+    ui.action_Load_State->setEnabled(false);
+    ui.action_Rewind->setEnabled(false);
     render_window->hide();
     game_list->show();
 
@@ -468,6 +483,9 @@ void GMainWindow::OnStartGame() {
 
     ui.action_Pause->setEnabled(true);
     ui.action_Stop->setEnabled(true);
+    ui.action_Save_State->setEnabled(true);
+    ui.action_Load_State->setEnabled(true);
+    ui.action_Rewind->setEnabled(Settings::values.use_rewind);
 }
 
 void GMainWindow::OnPauseGame() {
@@ -482,6 +500,26 @@ void GMainWindow::OnStopGame() {
     ShutdownGame();
 }
 
+void GMainWindow::OnSaveState() {
+    QString filename = QFileDialog::getSaveFileName(this, tr("Save State"), QString(), tr("Citra savestate (*.cst)"));
+    if (!filename.isEmpty()) {
+        // The state is saved by the emulation thread the next time it finishes running a slice
+        SaveState::ScheduleSave(filename.toStdString());
+    }
+}
+
+void GMainWindow::OnLoadState() {
+    QString filename = QFileDialog::getOpenFileName(this, tr("Load State"), QString(), tr("Citra savestate (*.cst)"));
+    if (!filename.isEmpty()) {
+        SaveState::ScheduleLoad(filename.toStdString());
+    }
+}
+
+void GMainWindow::OnRewind() {
+    if (emulation_running && Settings::values.use_rewind)
+        Rewind::RequestStepBack();
+}
+
 void GMainWindow::ToggleWindowMode() {
     if (ui.action_Single_Window_Mode->isChecked()) {
         // Render in the main window...
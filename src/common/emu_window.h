@@ -254,6 +254,20 @@ protected:
         framebuffer_layout = layout;
     }
 
+    /**
+     * Replaces the whole input state at once, e.g. when replaying previously recorded input.
+     * Coordinates are given in the same units as returned by GetCirclePadState and GetTouchState.
+     */
+    void SetInputState(Service::HID::PadState new_pad_state, s16 new_circle_pad_x, s16 new_circle_pad_y,
+                       u16 new_touch_x, u16 new_touch_y, bool new_touch_pressed) {
+        pad_state.hex = new_pad_state.hex;
+        circle_pad_x = new_circle_pad_x;
+        circle_pad_y = new_circle_pad_y;
+        touch_x = new_touch_x;
+        touch_y = new_touch_y;
+        touch_pressed = new_touch_pressed;
+    }
+
     /**
      * Update internal client area size with the given parameter.
      * @note EmuWindow implementations will usually use this in window resize event handlers.
@@ -0,0 +1,61 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Common {
+
+/**
+ * Bounded lock-free queue between a single producer thread and a single consumer thread. Each
+ * index is only written by one of the threads, which publishes the items it pushed or popped by
+ * releasing the new index.
+ */
+template <typename T, size_t Capacity>
+class SPSCQueue {
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    /// Adds an item to the back of the queue, returns false if the queue is full. Producer only.
+    bool TryPush(const T& item) {
+        const size_t write = write_index.load(std::memory_order_relaxed);
+        if (write - read_index.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        items[write % Capacity] = item;
+        write_index.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Removes the item at the front of the queue, returns false if the queue is empty. Consumer only.
+    bool TryPop(T& item) {
+        const size_t read = read_index.load(std::memory_order_relaxed);
+        if (read == write_index.load(std::memory_order_acquire))
+            return false;
+
+        item = items[read % Capacity];
+        read_index.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Empty() const {
+        return read_index.load(std::memory_order_acquire) == write_index.load(std::memory_order_acquire);
+    }
+
+    bool Full() const {
+        return write_index.load(std::memory_order_acquire) - read_index.load(std::memory_order_acquire) == Capacity;
+    }
+
+private:
+    std::array<T, Capacity> items;
+
+    // Kept on separate cache lines, so that the threads don't invalidate each other's index
+    alignas(64) std::atomic<size_t> write_index{0};
+    alignas(64) std::atomic<size_t> read_index{0};
+};
+
+} // namespace Common
@@ -0,0 +1,119 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(size_t num_workers) {
+    for (size_t i = 0; i < num_workers + 1; ++i)
+        queues.emplace_back(std::make_unique<Queue>());
+
+    for (size_t i = 0; i < num_workers; ++i)
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, i + 1);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutting_down = true;
+    }
+    work_available.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::ParallelFor(size_t num_tasks, const Task& task) {
+    if (num_tasks == 0)
+        return;
+
+    if (workers.empty() || num_tasks == 1) {
+        for (size_t i = 0; i < num_tasks; ++i)
+            task(i, 0);
+        return;
+    }
+
+    // Hand out contiguous ranges of tasks, so that neighbouring tasks usually run on the same thread
+    const size_t num_threads = queues.size();
+    for (size_t thread = 0; thread < num_threads; ++thread) {
+        const size_t begin = num_tasks * thread / num_threads;
+        const size_t end = num_tasks * (thread + 1) / num_threads;
+
+        std::lock_guard<std::mutex> lock(queues[thread]->mutex);
+        for (size_t i = begin; i < end; ++i)
+            queues[thread]->tasks.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_task = &task;
+        active_workers = workers.size();
+        ++generation;
+    }
+    work_available.notify_all();
+
+    RunTasks(0);
+
+    // Workers may still be running the last tasks they took
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this] { return active_workers == 0; });
+    current_task = nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t thread) {
+    SetCurrentThreadName("ThreadPoolWorker");
+
+    size_t last_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_available.wait(lock, [this, last_generation] {
+                return shutting_down || generation != last_generation;
+            });
+            if (shutting_down)
+                return;
+            last_generation = generation;
+        }
+
+        RunTasks(thread);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active_workers == 0)
+            work_done.notify_one();
+    }
+}
+
+void ThreadPool::RunTasks(size_t thread) {
+    size_t task;
+    while (PopTask(thread, task))
+        (*current_task)(task, thread);
+}
+
+bool ThreadPool::PopTask(size_t thread, size_t& task) {
+    {
+        Queue& own = *queues[thread];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues.size(); ++i) {
+        Queue& victim = *queues[(thread + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace Common
@@ -0,0 +1,70 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Common {
+
+/**
+ * A pool of worker threads running the iterations of a parallel loop. Each thread owns a queue of
+ * tasks, threads which run out of tasks steal them from the back of the other queues. This keeps
+ * all threads busy even when the tasks take uneven amounts of time.
+ */
+class ThreadPool {
+public:
+    /// Function run for each task, called with the index of the task and of the thread running it
+    using Task = std::function<void(size_t task, size_t thread)>;
+
+    /// @param num_workers Number of threads spawned in addition to the thread calling ParallelFor
+    explicit ThreadPool(size_t num_workers);
+    ~ThreadPool();
+
+    /// Returns the number of threads running tasks, including the thread calling ParallelFor
+    size_t GetNumThreads() const {
+        return queues.size();
+    }
+
+    /**
+     * Runs `task` for each index in [0, num_tasks) and blocks until all tasks are finished. The
+     * calling thread runs tasks as thread 0. Must not be called from several threads at once.
+     */
+    void ParallelFor(size_t num_tasks, const Task& task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void WorkerLoop(size_t thread);
+
+    /// Runs tasks until the queues of all threads are empty
+    void RunTasks(size_t thread);
+
+    /// Takes a task from the front of the own queue, or steals one from the back of another queue
+    bool PopTask(size_t thread, size_t& task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+
+    const Task* current_task = nullptr;
+    size_t generation = 0;      ///< Incremented each time ParallelFor hands out new tasks
+    size_t active_workers = 0;  ///< Number of workers which haven't finished the current tasks
+    bool shutting_down = false;
+};
+
+} // namespace Common
@@ -119,6 +119,11 @@ struct ThreadQueueList {
         return cur->data.empty();
     }
 
+    // Returns the threads queued at the given priority level, in scheduling order.
+    const std::deque<T>& get_queue(Priority priority) const {
+        return queues[priority].data;
+    }
+
     void prepare(Priority priority) {
         Queue* cur = &queues[priority];
         if (cur->next_nonempty == UnlinkedTag())
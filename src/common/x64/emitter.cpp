@@ -1876,6 +1876,16 @@ void XEmitter::VSQRTSD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)  {WriteAV
 void XEmitter::VSHUFPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 shuffle) {WriteAVXOp(0x66, sseSHUF, regOp1, regOp2, arg, 1); Write8(shuffle);}
 void XEmitter::VUNPCKLPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg){WriteAVXOp(0x66, 0x14, regOp1, regOp2, arg);}
 void XEmitter::VUNPCKHPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg){WriteAVXOp(0x66, 0x15, regOp1, regOp2, arg);}
+void XEmitter::VADDPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)   {WriteAVXOp(0x00, sseADD, regOp1, regOp2, arg);}
+void XEmitter::VSUBPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)   {WriteAVXOp(0x00, sseSUB, regOp1, regOp2, arg);}
+void XEmitter::VMULPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)   {WriteAVXOp(0x00, sseMUL, regOp1, regOp2, arg);}
+void XEmitter::VMINPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)   {WriteAVXOp(0x00, sseMIN, regOp1, regOp2, arg);}
+void XEmitter::VMAXPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)   {WriteAVXOp(0x00, sseMAX, regOp1, regOp2, arg);}
+void XEmitter::VCMPPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 compare) {WriteAVXOp(0x00, sseCMP, regOp1, regOp2, arg, 1); Write8(compare);}
+void XEmitter::VSHUFPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 shuffle) {WriteAVXOp(0x00, sseSHUF, regOp1, regOp2, arg, 1); Write8(shuffle);}
+void XEmitter::VPERMILPS(X64Reg regOp, const OpArg& arg, u8 shuffle)    {WriteAVXOp(0x66, 0x3A04, regOp, arg, 1); Write8(shuffle);}
+void XEmitter::VBLENDPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 blend) {WriteAVXOp(0x66, 0x3A0C, regOp1, regOp2, arg, 1); Write8(blend);}
+void XEmitter::VBROADCASTSS(X64Reg regOp, const OpArg& arg)           {WriteAVXOp(0x66, 0x3818, regOp, arg);}
 
 void XEmitter::VANDPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)   { WriteAVXOp(0x00, sseAND, regOp1, regOp2, arg); }
 void XEmitter::VANDPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg)   { WriteAVXOp(0x66, sseAND, regOp1, regOp2, arg); }
@@ -872,6 +872,16 @@ public:
     void VSHUFPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 shuffle);
     void VUNPCKLPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
     void VUNPCKHPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VADDPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VSUBPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VMULPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VMINPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VMAXPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VCMPPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 compare);
+    void VSHUFPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 shuffle);
+    void VPERMILPS(X64Reg regOp, const OpArg& arg, u8 shuffle);
+    void VBLENDPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 blend);
+    void VBROADCASTSS(X64Reg regOp, const OpArg& arg);
 
     void VANDPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
     void VANDPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
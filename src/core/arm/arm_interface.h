@@ -12,6 +12,8 @@ namespace Core {
     struct ThreadContext;
 }
 
+class PointerWrap;
+
 /// Generic ARM11 CPU interface
 class ARM_Interface : NonCopyable {
 public:
@@ -145,6 +147,12 @@ public:
     /// Prepare core for thread reschedule (if needed to correctly handle state)
     virtual void PrepareReschedule() = 0;
 
+    /**
+     * Saves or restores the full CPU state, including the cycle counter used for scheduling
+     * @param p Savestate serializer
+     */
+    virtual void DoState(PointerWrap& p) = 0;
+
     /// Getter for num_instructions
     u64 GetNumInstructions() const {
         return num_instructions;
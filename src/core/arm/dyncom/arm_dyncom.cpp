@@ -5,6 +5,8 @@
 #include <cstring>
 #include <memory>
 
+#include "common/chunk_file.h"
+
 #include "core/arm/skyeye_common/armstate.h"
 #include "core/arm/skyeye_common/armsupp.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
@@ -131,3 +133,13 @@ void ARM_DynCom::LoadContext(const Core::ThreadContext& ctx) {
 void ARM_DynCom::PrepareReschedule() {
     state->NumInstrsToExecute = 0;
 }
+
+void ARM_DynCom::DoState(PointerWrap& p) {
+    p.Do(down_count);
+    state->DoState(p);
+
+    // Code may have been loaded or unloaded since the state was saved, so translated blocks
+    // can't be trusted anymore.
+    if (p.GetMode() == PointerWrap::MODE_READ)
+        ClearInstructionCache();
+}
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include "common/chunk_file.h"
 #include "common/swap.h"
 #include "common/logging/log.h"
 #include "core/memory.h"
@@ -688,3 +689,39 @@ void ARMul_State::WriteCP15Register(u32 value, u32 crn, u32 opcode_1, u32 crm, u
         CP15[CP15_THREAD_UPRW] = value;
     }
 }
+
+void ARMul_State::DoState(PointerWrap& p)
+{
+    p.Do(Reg);
+    p.Do(Reg_usr);
+    p.Do(Reg_svc);
+    p.Do(Reg_abort);
+    p.Do(Reg_undef);
+    p.Do(Reg_irq);
+    p.Do(Reg_firq);
+    p.Do(Spsr);
+    p.Do(CP15);
+    p.Do(VFP);
+    p.Do(ExtReg);
+
+    p.Do(Emulate);
+    p.Do(Cpsr);
+    p.Do(Spsr_copy);
+    p.Do(phys_pc);
+    p.Do(Mode);
+    p.Do(Bank);
+
+    p.Do(NFlag);
+    p.Do(ZFlag);
+    p.Do(CFlag);
+    p.Do(VFlag);
+    p.Do(IFFlags);
+    p.Do(shifter_carry_out);
+    p.Do(TFlag);
+
+    p.Do(NumInstrs);
+    p.Do(NumInstrsToExecute);
+
+    p.Do(exclusive_tag);
+    p.Do(exclusive_state);
+}
@@ -23,6 +23,8 @@
 #include "common/common_types.h"
 #include "core/arm/skyeye_common/arm_regformat.h"
 
+class PointerWrap;
+
 // Signal levels
 enum {
     LOW     = 0,
@@ -151,6 +153,9 @@ public:
     void ChangePrivilegeMode(u32 new_mode);
     void Reset();
 
+    // Saves or restores the register file, coprocessor state and exclusive monitor.
+    void DoState(PointerWrap& p);
+
     // Reads/writes data in big/little endian format based on the
     // state of the E (endian) bit in the APSR.
     u8 ReadMemory8(u32 address) const;
@@ -14,6 +14,8 @@
 #include "core/hle/hle.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hw/hw.h"
+#include "core/rewind.h"
+#include "core/savestate.h"
 
 #include "core/gdbstub/gdbstub.h"
 
@@ -54,6 +56,9 @@ void RunLoop(int tight_loop) {
     if (HLE::IsReschedulePending()) {
         Kernel::Reschedule();
     }
+
+    SaveState::ProcessScheduled();
+    Rewind::Update();
 }
 
 /// Step the CPU one instruction
@@ -539,6 +539,54 @@ void Idle(int max_idle) {
         Core::g_app_core->down_count = -1;
 }
 
+static void Event_DoState(PointerWrap& p, BaseEvent* event) {
+    p.Do(*event);
+}
+
+void DoState(PointerWrap& p) {
+    // Pending threadsafe events are merged into the main queue so only one list has contents
+    MoveEvents();
+
+    std::lock_guard<std::recursive_mutex> lock(external_event_section);
+
+    auto s = p.Section("CoreTiming", 1);
+    if (!s)
+        return;
+
+    // Event types are registered by each module on startup and only their index is stored in
+    // the queue, so the set of registered types must match for the saved queue to make sense.
+    u32 num_event_types = static_cast<u32>(event_types.size());
+    p.Do(num_event_types);
+    if (num_event_types != event_types.size()) {
+        LOG_ERROR(Core_Timing, "Savestate has %u event types, expected %zu",
+                  num_event_types, event_types.size());
+        p.SetError(PointerWrap::ERROR_FAILURE);
+        return;
+    }
+    for (const EventType& event_type : event_types) {
+        std::string name = event_type.name;
+        p.Do(name);
+        if (name != event_type.name) {
+            LOG_ERROR(Core_Timing, "Savestate event type %s does not match %s",
+                      name.c_str(), event_type.name);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+    }
+
+    p.DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoState>(first);
+    p.DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoState>(ts_first, &ts_last);
+
+    p.Do(g_clock_rate_arm11);
+    p.Do(g_slice_length);
+    p.Do(global_timer);
+    p.Do(idled_cycles);
+    p.Do(last_global_time_ticks);
+    p.Do(last_global_time_us);
+
+    has_ts_events = ts_first != nullptr;
+}
+
 std::string GetScheduledEventsSummary() {
     Event* event = first;
     std::string text = "Scheduled events\n";
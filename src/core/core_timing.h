@@ -23,6 +23,8 @@
 
 #include "common/common_types.h"
 
+class PointerWrap;
+
 extern int g_clock_rate_arm11;
 
 inline s64 msToCycles(int ms) {
@@ -133,6 +135,12 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback);
 
 std::string GetScheduledEventsSummary();
 
+/**
+ * Saves or restores the event queue and the timing counters. Event types are not stored: the
+ * same types must have been registered, in the same order, as when the state was saved.
+ */
+void DoState(PointerWrap& p);
+
 void SetClockFrequencyMHz(int cpu_mhz);
 int GetClockFrequencyMHz();
 extern int g_slice_length;
@@ -6,6 +6,7 @@
 #include <iomanip>
 #include <sstream>
 
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
 
@@ -126,4 +127,14 @@ std::vector<u8> Path::AsBinary() const {
     }
 }
 
+void Path::DoState(PointerWrap& p) {
+    p.Do(type);
+    p.Do(binary);
+    p.Do(string);
+
+    std::vector<u16> u16_chars(u16str.begin(), u16str.end());
+    p.Do(u16_chars);
+    u16str.assign(u16_chars.begin(), u16_chars.end());
+}
+
 }
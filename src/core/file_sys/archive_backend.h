@@ -15,6 +15,7 @@
 
 #include "core/hle/result.h"
 
+class PointerWrap;
 
 namespace FileSys {
 
@@ -56,6 +57,9 @@ public:
     std::u16string AsU16Str() const;
     std::vector<u8> AsBinary() const;
 
+    /// Saves or restores the path for savestates
+    void DoState(PointerWrap& p);
+
 private:
     LowPathType type;
     std::vector<u8> binary;
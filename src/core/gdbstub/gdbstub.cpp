@@ -670,6 +670,7 @@ static void WriteMemory() {
     }
 
     GdbHexToMem(dst, len_pos + 1, len);
+    Memory::MarkRegionDirty(addr, len);
     SendReply("OK");
 }
 
@@ -108,6 +108,15 @@ bool IsLibraryAppletRunning() {
     return false;
 }
 
+void DoState(PointerWrap& p) {
+    if (p.GetMode() != PointerWrap::MODE_READ && IsLibraryAppletRunning()) {
+        LOG_ERROR(Service_APT, "States can't be saved while a library applet is running");
+        p.SetError(PointerWrap::ERROR_FAILURE);
+    }
+    if (p.GetMode() == PointerWrap::MODE_READ)
+        applets.clear();
+}
+
 void Init() {
     // Register the applet update callback
     applet_update_event = CoreTiming::RegisterEvent("HLE Applet Update Event", AppletUpdateEvent);
@@ -71,6 +71,12 @@ protected:
 /// Returns whether a library applet is currently running
 bool IsLibraryAppletRunning();
 
+/**
+ * Saves or restores the state of the HLE applets. Applets can't be saved while they are running,
+ * so this only checks that none is when saving, and stops them when loading.
+ */
+void DoState(PointerWrap& p);
+
 /// Initializes the HLE applets
 void Init();
 
@@ -135,8 +135,10 @@ template<ResultCode func(u32)> void Wrap() {
 }
 
 template<ResultCode func(s64*, u32, u32*, u32)> void Wrap(){
-    FuncReturn(func((s64*)Memory::GetPointer(PARAM(0)), PARAM(1), (u32*)Memory::GetPointer(PARAM(2)),
-        (s32)PARAM(3)).raw);
+    u32 retval = func((s64*)Memory::GetPointer(PARAM(0)), PARAM(1), (u32*)Memory::GetPointer(PARAM(2)),
+        (s32)PARAM(3)).raw;
+    Memory::MarkRegionDirty(PARAM(0), PARAM(3) * sizeof(s64));
+    FuncReturn(retval);
 }
 
 template<ResultCode func(u32*, const char*)> void Wrap() {
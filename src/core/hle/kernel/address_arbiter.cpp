@@ -94,4 +94,8 @@ ResultCode AddressArbiter::ArbitrateAddress(ArbitrationType type, VAddr address,
     return RESULT_SUCCESS;
 }
 
+void AddressArbiter::DoState(PointerWrap& p) {
+    p.Do(name);
+}
+
 } // namespace Kernel
@@ -46,7 +46,11 @@ public:
 
     ResultCode ArbitrateAddress(ArbitrationType type, VAddr address, s32 value, u64 nanoseconds);
 
+    void DoState(PointerWrap& p) override;
+
 private:
+    friend void DoObjectTable(PointerWrap& p);
+
     AddressArbiter();
     ~AddressArbiter() override;
 };
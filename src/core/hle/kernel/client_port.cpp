@@ -13,4 +13,11 @@ namespace Kernel {
 ClientPort::ClientPort() {}
 ClientPort::~ClientPort() {}
 
+void ClientPort::DoState(PointerWrap& p) {
+    DoObjectRef(p, server_port);
+    p.Do(max_sessions);
+    p.Do(active_sessions);
+    p.Do(name);
+}
+
 } // namespace
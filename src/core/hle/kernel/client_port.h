@@ -28,7 +28,11 @@ public:
     u32 active_sessions;                        ///< Number of currently open sessions to this port
     std::string name;                           ///< Name of client port (optional)
 
+    void DoState(PointerWrap& p) override;
+
 protected:
+    friend void DoObjectTable(PointerWrap& p);
+
     ClientPort();
     ~ClientPort() override;
 };
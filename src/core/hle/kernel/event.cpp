@@ -48,4 +48,12 @@ void Event::Clear() {
     signaled = false;
 }
 
+void Event::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    p.Do(reset_type);
+    p.Do(signaled);
+    p.Do(name);
+}
+
 } // namespace
@@ -43,7 +43,11 @@ public:
     void Signal();
     void Clear();
 
+    void DoState(PointerWrap& p) override;
+
 private:
+    friend void DoObjectTable(PointerWrap& p);
+
     Event();
     ~Event() override;
 };
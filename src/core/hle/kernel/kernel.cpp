@@ -3,17 +3,27 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <unordered_map>
 
 #include "common/assert.h"
 #include "common/logging/log.h"
 
 #include "core/hle/config_mem.h"
+#include "core/hle/kernel/address_arbiter.h"
+#include "core/hle/kernel/client_port.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/mutex.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/resource_limit.h"
+#include "core/hle/kernel/semaphore.h"
+#include "core/hle/kernel/server_port.h"
+#include "core/hle/kernel/session.h"
+#include "core/hle/kernel/shared_memory.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/timer.h"
+#include "core/hle/service/service.h"
 #include "core/hle/shared_page.h"
 
 namespace Kernel {
@@ -21,6 +31,32 @@ namespace Kernel {
 unsigned int Object::next_object_id;
 HandleTable g_handle_table;
 
+/// Most recently created live object, at the head of the list of all live objects.
+static Object* first_object = nullptr;
+
+Object::Object() : prev_object(nullptr), next_object(first_object) {
+    if (first_object != nullptr)
+        first_object->prev_object = this;
+    first_object = this;
+}
+
+Object::~Object() {
+    if (prev_object != nullptr)
+        prev_object->next_object = next_object;
+    else
+        first_object = next_object;
+
+    if (next_object != nullptr)
+        next_object->prev_object = prev_object;
+}
+
+std::vector<SharedPtr<Object>> GetAllObjects() {
+    std::vector<SharedPtr<Object>> objects;
+    for (Object* object = first_object; object != nullptr; object = object->next_object)
+        objects.emplace_back(object);
+    return objects;
+}
+
 void WaitObject::AddWaitingThread(SharedPtr<Thread> thread) {
     auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
     if (itr == waiting_threads.end())
@@ -42,6 +78,10 @@ void WaitObject::WakeupAllWaitingThreads() {
     HLE::Reschedule(__func__);
 }
 
+void WaitObject::DoState(PointerWrap& p) {
+    DoObjectRefs(p, waiting_threads);
+}
+
 HandleTable::HandleTable() {
     next_generation = 1;
     Clear();
@@ -120,6 +160,187 @@ void HandleTable::Clear() {
     next_free_slot = 0;
 }
 
+void HandleTable::DoState(PointerWrap& p) {
+    for (size_t i = 0; i < MAX_COUNT; ++i) {
+        DoObjectRef(p, objects[i]);
+        p.Do(generations[i]);
+    }
+    p.Do(next_generation);
+    p.Do(next_free_slot);
+}
+
+static const u32 INVALID_OBJECT_ID = 0xFFFFFFFF;
+
+/// Objects listed in the savestate being saved or loaded, in the order they are stored.
+static std::vector<SharedPtr<Object>> state_objects;
+/// Objects of the savestate being loaded, by the object id they were saved with.
+static std::unordered_map<u32, SharedPtr<Object>> state_objects_by_id;
+
+void DoObjectRef(PointerWrap& p, SharedPtr<Object>& object) {
+    u32 object_id = object != nullptr ? object->GetObjectId() : INVALID_OBJECT_ID;
+    p.Do(object_id);
+
+    if (p.GetMode() != PointerWrap::MODE_READ)
+        return;
+
+    if (object_id == INVALID_OBJECT_ID) {
+        object = nullptr;
+        return;
+    }
+
+    auto itr = state_objects_by_id.find(object_id);
+    if (itr == state_objects_by_id.end()) {
+        LOG_ERROR(Kernel, "Savestate references unknown object %u", object_id);
+        p.SetError(PointerWrap::ERROR_FAILURE);
+        object = nullptr;
+        return;
+    }
+    object = itr->second;
+}
+
+void DoObjectTable(PointerWrap& p) {
+    state_objects.clear();
+    state_objects_by_id.clear();
+
+    auto s = p.Section("KernelObjects", 2);
+    if (!s)
+        return;
+
+    if (p.GetMode() != PointerWrap::MODE_READ)
+        state_objects = GetAllObjects();
+
+    u32 num_objects = static_cast<u32>(state_objects.size());
+    p.Do(num_objects);
+
+    for (u32 i = 0; i < num_objects && p.error != PointerWrap::ERROR_FAILURE; ++i) {
+        SharedPtr<Object> object;
+        u32 object_id = 0;
+        HandleType type = HandleType::Unknown;
+        if (p.GetMode() != PointerWrap::MODE_READ) {
+            object = state_objects[i];
+            object_id = object->GetObjectId();
+            type = object->GetHandleType();
+        }
+        p.Do(object_id);
+        p.Do(type);
+
+        switch (type) {
+        case HandleType::Process:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = g_current_process;
+            break;
+        case HandleType::CodeSet:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = g_current_process->codeset;
+            break;
+        case HandleType::ResourceLimit: {
+            std::string name;
+            if (p.GetMode() != PointerWrap::MODE_READ)
+                name = static_cast<ResourceLimit*>(object.get())->name;
+            p.Do(name);
+            if (p.GetMode() != PointerWrap::MODE_READ)
+                break;
+            for (u8 category = 0; category < 4; ++category) {
+                auto resource_limit = ResourceLimit::GetForCategory(static_cast<ResourceLimitCategory>(category));
+                if (resource_limit->name == name)
+                    object = resource_limit;
+            }
+            break;
+        }
+        case HandleType::Session: {
+            SharedPtr<Session> session = boost::static_pointer_cast<Session>(object);
+            Service::DoSessionRecord(p, session);
+            object = std::move(session);
+            break;
+        }
+        case HandleType::Event:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = new Event;
+            break;
+        case HandleType::Mutex:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = new Mutex;
+            break;
+        case HandleType::Semaphore:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = new Semaphore;
+            break;
+        case HandleType::Timer:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = new Timer;
+            break;
+        case HandleType::Thread:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = new Thread;
+            break;
+        case HandleType::AddressArbiter:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = new AddressArbiter;
+            break;
+        case HandleType::SharedMemory:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = new SharedMemory;
+            break;
+        case HandleType::ServerPort:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = new ServerPort;
+            break;
+        case HandleType::ClientPort:
+            if (p.GetMode() == PointerWrap::MODE_READ)
+                object = new ClientPort;
+            break;
+        default:
+            object = nullptr;
+            break;
+        }
+
+        if (p.GetMode() != PointerWrap::MODE_READ)
+            continue;
+
+        if (object == nullptr) {
+            LOG_ERROR(Kernel, "Savestate object %u (type %u) can't be restored",
+                      object_id, static_cast<u32>(type));
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            break;
+        }
+        state_objects.push_back(object);
+        state_objects_by_id.emplace(object_id, std::move(object));
+    }
+
+    if (p.error != PointerWrap::ERROR_FAILURE)
+        MemoryDoLayout(p, state_objects);
+
+    if (p.error == PointerWrap::ERROR_FAILURE) {
+        state_objects.clear();
+        state_objects_by_id.clear();
+    }
+}
+
+void DoState(PointerWrap& p) {
+    auto s = p.Section("Kernel", 1);
+    if (s) {
+        for (auto& object : state_objects)
+            object->DoState(p);
+
+        g_handle_table.DoState(p);
+        ThreadingDoState(p);
+        TimersDoState(p);
+        MemoryDoState(p);
+
+        p.DoVoid(&ConfigMem::config_mem, sizeof(ConfigMem::config_mem));
+        p.DoVoid(&SharedPage::shared_page, sizeof(SharedPage::shared_page));
+
+        // Objects created after the state was saved may still be alive, so ids are never reused.
+        u32 next_object_id = Object::next_object_id;
+        p.Do(next_object_id);
+        Object::next_object_id = std::max(Object::next_object_id, next_object_id);
+        p.Do(Process::next_process_id);
+    }
+
+    state_objects.clear();
+    state_objects_by_id.clear();
+}
+
 /// Initialize the kernel
 void Init() {
     ConfigMem::Init();
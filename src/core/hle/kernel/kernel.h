@@ -12,6 +12,7 @@
 #include <string>
 #include <vector>
 
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 
 #include "core/hle/hle.h"
@@ -19,8 +20,12 @@
 
 namespace Kernel {
 
+class Object;
 class Thread;
 
+template <typename T>
+using SharedPtr = boost::intrusive_ptr<T>;
+
 // TODO: Verify code
 const ResultCode ERR_OUT_OF_HANDLES(ErrorDescription::OutOfMemory, ErrorModule::Kernel,
         ErrorSummary::OutOfResource, ErrorLevel::Temporary);
@@ -58,7 +63,8 @@ enum {
 
 class Object : NonCopyable {
 public:
-    virtual ~Object() {}
+    Object();
+    virtual ~Object();
 
     /// Returns a unique identifier for the object. For debugging purposes only.
     unsigned int GetObjectId() const { return object_id; }
@@ -94,15 +100,28 @@ public:
         }
     }
 
+    /**
+     * Saves or restores the mutable state of the object for savestates. Objects that are not
+     * modified after creation don't need to override this. References to other kernel objects
+     * must be serialized with DoObjectRef.
+     * @param p Savestate serializer
+     */
+    virtual void DoState(PointerWrap& p) {}
+
 public:
     static unsigned int next_object_id;
 
 private:
     friend void intrusive_ptr_add_ref(Object*);
     friend void intrusive_ptr_release(Object*);
+    friend std::vector<SharedPtr<Object>> GetAllObjects();
 
     unsigned int ref_count = 0;
     unsigned int object_id = next_object_id++;
+
+    /// Intrusive list of all live objects, used to list the objects stored in savestates.
+    Object* prev_object;
+    Object* next_object;
 };
 
 // Special functions used by boost::instrusive_ptr to do automatic ref-counting
@@ -116,9 +135,6 @@ inline void intrusive_ptr_release(Object* object) {
     }
 }
 
-template <typename T>
-using SharedPtr = boost::intrusive_ptr<T>;
-
 /// Class that represents a Kernel object that a thread can be waiting on
 class WaitObject : public Object {
 public:
@@ -147,6 +163,8 @@ public:
     /// Wake up all threads waiting on this object
     void WakeupAllWaitingThreads();
 
+    void DoState(PointerWrap& p) override;
+
 private:
     /// Threads waiting for this object to become available
     std::vector<SharedPtr<Thread>> waiting_threads;
@@ -240,6 +258,9 @@ public:
     /// Closes all handles held in this table.
     void Clear();
 
+    /// Saves or restores the contents of the table, storing objects by their id.
+    void DoState(PointerWrap& p);
+
 private:
     /**
      * This is the maximum limit of handles allowed per process in CTR-OS. It can be further
@@ -271,6 +292,47 @@ private:
 
 extern HandleTable g_handle_table;
 
+/// Returns references to all kernel objects that are currently alive.
+std::vector<SharedPtr<Object>> GetAllObjects();
+
+/**
+ * Saves or restores a reference to a kernel object as its object id. When loading, the object
+ * is looked up in the object table read by DoObjectTable.
+ */
+void DoObjectRef(PointerWrap& p, SharedPtr<Object>& object);
+
+template <typename T>
+void DoObjectRef(PointerWrap& p, SharedPtr<T>& object) {
+    SharedPtr<Object> generic = object;
+    DoObjectRef(p, generic);
+    object = boost::static_pointer_cast<T>(std::move(generic));
+}
+
+/// Saves or restores a list of references to kernel objects.
+template <typename T>
+void DoObjectRefs(PointerWrap& p, std::vector<SharedPtr<T>>& objects) {
+    u32 count = static_cast<u32>(objects.size());
+    p.Do(count);
+    objects.resize(count);
+    for (auto& object : objects)
+        DoObjectRef(p, object);
+}
+
+/**
+ * Saves or restores the list of live kernel objects. When loading, the objects owned by the
+ * running title (its process, code set, resource limits and service ports) are matched with their
+ * live counterparts, which exist in every emulation session of the same title, and the others are
+ * recreated empty, to be filled in by DoState. Nothing else is modified, so if the table is
+ * rejected (setting an error on the serializer), emulation can continue.
+ */
+void DoObjectTable(PointerWrap& p);
+
+/**
+ * Saves or restores the state of all kernel objects listed by DoObjectTable, the handle tables,
+ * the scheduler, the address space of the current process and the contents of emulated memory.
+ */
+void DoState(PointerWrap& p);
+
 /// Initialize the kernel
 void Init();
 
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <map>
 #include <memory>
 #include <utility>
@@ -9,11 +11,13 @@
 
 #include "audio_core/audio_core.h"
 
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 
 #include "core/hle/config_mem.h"
 #include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/shared_memory.h"
 #include "core/hle/kernel/vm_manager.h"
 #include "core/hle/result.h"
 #include "core/hle/shared_page.h"
@@ -26,6 +30,10 @@ namespace Kernel {
 
 static MemoryRegionInfo memory_regions[3];
 
+/// Memory blocks and their sizes as of the previous call to MemoryListChangedPages.
+static std::vector<std::shared_ptr<std::vector<u8>>> tracked_blocks;
+static std::vector<u32> tracked_block_sizes;
+
 /// Size of the APPLICATION, SYSTEM and BASE memory regions (respectively) for each sytem
 /// memory configuration type.
 static const u32 memory_region_sizes[8][3] = {
@@ -81,6 +89,9 @@ void MemoryShutdown() {
         region.used = 0;
         region.linear_heap_memory = nullptr;
     }
+
+    tracked_blocks.clear();
+    tracked_block_sizes.clear();
 }
 
 MemoryRegionInfo* GetMemoryRegion(MemoryRegion region) {
@@ -96,6 +107,352 @@ MemoryRegionInfo* GetMemoryRegion(MemoryRegion region) {
     }
 }
 
+/// Where the memory blocks stored in savestates come from, which decides how they are restored.
+enum class BlockSource : u32 {
+    /// The linear heap of a memory region, which always exists. The index of the region follows.
+    LinearHeap,
+    /// The code of the running title, which is loaded again when the title is booted.
+    Code,
+    /// Any other block, allocated anew when the state is loaded.
+    Allocated,
+};
+
+static const u32 INVALID_BLOCK_INDEX = 0xFFFFFFFF;
+
+/// Memory blocks listed in the savestate being saved or loaded, in the order they are stored.
+static std::vector<std::shared_ptr<std::vector<u8>>> state_blocks;
+/// Sizes of the blocks in state_blocks as stored in the savestate.
+static std::vector<u32> state_block_sizes;
+/// Address space layout of the savestate being loaded, applied by MemoryDoState.
+static std::vector<VirtualMemoryArea> state_vmas;
+
+/// Returns the size a memory block takes in the contents saved by MemoryDoContents.
+static size_t GetPaddedBlockSize(u32 size) {
+    return (static_cast<size_t>(size) + Memory::PAGE_MASK) & ~static_cast<size_t>(Memory::PAGE_MASK);
+}
+
+/// Looks up the index of a memory block in state_blocks, or INVALID_BLOCK_INDEX.
+static u32 FindStateBlock(const std::shared_ptr<std::vector<u8>>& block) {
+    auto itr = std::find(state_blocks.begin(), state_blocks.end(), block);
+    return itr != state_blocks.end() ? static_cast<u32>(itr - state_blocks.begin()) : INVALID_BLOCK_INDEX;
+}
+
+void DoBlockRef(PointerWrap& p, std::shared_ptr<std::vector<u8>>& block) {
+    u32 index = block != nullptr ? FindStateBlock(block) : INVALID_BLOCK_INDEX;
+    if (p.GetMode() != PointerWrap::MODE_READ && block != nullptr && index == INVALID_BLOCK_INDEX) {
+        LOG_ERROR(Kernel, "Memory block isn't listed in the savestate");
+        p.SetError(PointerWrap::ERROR_FAILURE);
+    }
+    p.Do(index);
+
+    if (p.GetMode() != PointerWrap::MODE_READ)
+        return;
+
+    if (index == INVALID_BLOCK_INDEX) {
+        block = nullptr;
+    } else if (index < state_blocks.size()) {
+        block = state_blocks[index];
+    } else {
+        LOG_ERROR(Kernel, "Savestate references unknown memory block %u", index);
+        p.SetError(PointerWrap::ERROR_FAILURE);
+        block = nullptr;
+    }
+}
+
+/// Saves or restores the list of memory blocks, see MemoryDoLayout.
+static void DoBlockTable(PointerWrap& p, const std::vector<SharedPtr<Object>>& objects) {
+    const auto& process = g_current_process;
+
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        // The linear heaps come first so that their sizes can be restored in place
+        auto add_block = [](const std::shared_ptr<std::vector<u8>>& block) {
+            if (block != nullptr && FindStateBlock(block) == INVALID_BLOCK_INDEX)
+                state_blocks.push_back(block);
+        };
+        for (auto& region : memory_regions)
+            add_block(region.linear_heap_memory);
+        add_block(process->codeset->memory);
+        add_block(process->heap_memory);
+        for (const auto& object : objects) {
+            if (object->GetHandleType() == HandleType::SharedMemory)
+                add_block(static_cast<SharedMemory*>(object.get())->backing_block);
+        }
+        for (const auto& vma : process->vm_manager.vma_map) {
+            if (vma.second.type == VMAType::AllocatedMemoryBlock)
+                add_block(vma.second.backing_block);
+        }
+    }
+
+    u32 num_blocks = static_cast<u32>(state_blocks.size());
+    p.Do(num_blocks);
+
+    for (u32 i = 0; i < num_blocks && p.error != PointerWrap::ERROR_FAILURE; ++i) {
+        BlockSource source = BlockSource::Allocated;
+        u32 region_index = 0;
+        u32 size = 0;
+        if (p.GetMode() != PointerWrap::MODE_READ) {
+            const auto& block = state_blocks[i];
+            auto region = std::find_if(std::begin(memory_regions), std::end(memory_regions),
+                    [&block](const MemoryRegionInfo& info) { return info.linear_heap_memory == block; });
+            if (region != std::end(memory_regions)) {
+                source = BlockSource::LinearHeap;
+                region_index = static_cast<u32>(region - std::begin(memory_regions));
+            } else if (block == process->codeset->memory) {
+                source = BlockSource::Code;
+            }
+            size = static_cast<u32>(block->size());
+        }
+        p.Do(source);
+        p.Do(region_index);
+        p.Do(size);
+
+        if (p.GetMode() != PointerWrap::MODE_READ) {
+            state_block_sizes.push_back(size);
+            continue;
+        }
+
+        // The linear heaps are resized by MemoryDoState, within the capacity reserved for them so
+        // that pointers to them stay valid. Other blocks are never larger than FCRAM.
+        std::shared_ptr<std::vector<u8>> block;
+        switch (source) {
+        case BlockSource::LinearHeap:
+            if (region_index < 3 && size <= memory_regions[region_index].size)
+                block = memory_regions[region_index].linear_heap_memory;
+            break;
+        case BlockSource::Code:
+            if (size == process->codeset->memory->size())
+                block = process->codeset->memory;
+            break;
+        case BlockSource::Allocated:
+            if (size <= Memory::FCRAM_SIZE)
+                block = std::make_shared<std::vector<u8>>(size);
+            break;
+        }
+
+        if (block == nullptr) {
+            LOG_ERROR(Kernel, "Savestate memory block %u (source %u, size 0x%08X) can't be restored",
+                      i, static_cast<u32>(source), size);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            break;
+        }
+        state_blocks.push_back(std::move(block));
+        state_block_sizes.push_back(size);
+    }
+}
+
+/**
+ * Finds the live mapping covering a range of a savestate VMA that isn't backed by a memory block,
+ * which is always created by the kernel or HLE at the same place when the title is booted.
+ */
+static bool FindLiveMapping(const VMManager& vm_manager, VirtualMemoryArea& vma) {
+    auto live = vm_manager.FindVMA(vma.base);
+    if (live == vm_manager.vma_map.end() || live->second.type != vma.type ||
+            vma.base + vma.size > live->second.base + live->second.size)
+        return false;
+
+    u32 offset = vma.base - live->second.base;
+    if (vma.type == VMAType::BackingMemory) {
+        vma.backing_memory = live->second.backing_memory + offset;
+    } else {
+        if (vma.paddr != live->second.paddr + offset)
+            return false;
+        vma.mmio_handler = live->second.mmio_handler;
+    }
+    return true;
+}
+
+void MemoryDoLayout(PointerWrap& p, const std::vector<SharedPtr<Object>>& objects) {
+    state_blocks.clear();
+    state_block_sizes.clear();
+    state_vmas.clear();
+
+    DoBlockTable(p, objects);
+    if (p.error == PointerWrap::ERROR_FAILURE)
+        return;
+
+    const auto& vm_manager = g_current_process->vm_manager;
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        for (const auto& vma : vm_manager.vma_map) {
+            if (vma.second.type != VMAType::Free)
+                state_vmas.push_back(vma.second);
+        }
+    }
+
+    u32 num_vmas = static_cast<u32>(state_vmas.size());
+    p.Do(num_vmas);
+
+    VAddr previous_end = 0;
+    for (u32 i = 0; i < num_vmas && p.error != PointerWrap::ERROR_FAILURE; ++i) {
+        VirtualMemoryArea vma;
+        if (p.GetMode() != PointerWrap::MODE_READ)
+            vma = state_vmas[i];
+
+        u32 offset = static_cast<u32>(vma.offset);
+        p.Do(vma.base);
+        p.Do(vma.size);
+        p.Do(vma.type);
+        p.Do(vma.permissions);
+        p.Do(vma.meminfo_state);
+        if (vma.type == VMAType::AllocatedMemoryBlock) {
+            DoBlockRef(p, vma.backing_block);
+            p.Do(offset);
+        } else if (vma.type == VMAType::MMIO) {
+            p.Do(vma.paddr);
+        }
+
+        if (p.GetMode() != PointerWrap::MODE_READ || p.error == PointerWrap::ERROR_FAILURE)
+            continue;
+
+        vma.offset = offset;
+        bool valid = vma.base >= previous_end && vma.size != 0 &&
+                (vma.base & Memory::PAGE_MASK) == 0 && (vma.size & Memory::PAGE_MASK) == 0 &&
+                vma.size <= VMManager::MAX_ADDRESS - vma.base;
+        if (valid) {
+            switch (vma.type) {
+            case VMAType::AllocatedMemoryBlock:
+                valid = vma.backing_block != nullptr &&
+                        offset + u64(vma.size) <= state_block_sizes[FindStateBlock(vma.backing_block)];
+                break;
+            case VMAType::BackingMemory:
+            case VMAType::MMIO:
+                valid = FindLiveMapping(vm_manager, vma);
+                break;
+            default:
+                valid = false;
+                break;
+            }
+        }
+
+        if (!valid) {
+            LOG_ERROR(Kernel, "Savestate memory mapping at 0x%08X (size 0x%08X) can't be restored",
+                      vma.base, vma.size);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            break;
+        }
+        previous_end = vma.base + vma.size;
+        state_vmas.push_back(std::move(vma));
+    }
+
+    if (p.error == PointerWrap::ERROR_FAILURE) {
+        state_blocks.clear();
+        state_block_sizes.clear();
+        state_vmas.clear();
+    }
+}
+
+void MemoryDoState(PointerWrap& p) {
+    for (auto& region : memory_regions)
+        p.Do(region.used);
+
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        // Rebuild the address space from scratch once its blocks have their final size, their
+        // contents are restored later by MemoryDoContents
+        for (size_t i = 0; i < state_blocks.size(); ++i)
+            state_blocks[i]->resize(state_block_sizes[i]);
+
+        auto& vm_manager = g_current_process->vm_manager;
+        vm_manager.Reset();
+        for (const auto& vma : state_vmas) {
+            ResultVal<VMManager::VMAHandle> handle = ERR_INVALID_ADDRESS;
+            switch (vma.type) {
+            case VMAType::AllocatedMemoryBlock:
+                handle = vm_manager.MapMemoryBlock(vma.base, vma.backing_block, vma.offset,
+                                                   vma.size, vma.meminfo_state);
+                break;
+            case VMAType::BackingMemory:
+                handle = vm_manager.MapBackingMemory(vma.base, vma.backing_memory, vma.size,
+                                                     vma.meminfo_state);
+                break;
+            case VMAType::MMIO:
+                handle = vm_manager.MapMMIO(vma.base, vma.paddr, vma.size, vma.meminfo_state,
+                                            vma.mmio_handler);
+                break;
+            default:
+                break;
+            }
+            vm_manager.Reprotect(handle.Unwrap(), vma.permissions);
+        }
+    }
+}
+
+void MemoryDoContents(PointerWrap& p) {
+    static const std::array<u8, Memory::PAGE_SIZE> zeros = {};
+    std::array<u8, Memory::PAGE_SIZE> padding = zeros;
+
+    for (size_t i = 0; i < state_blocks.size(); ++i) {
+        const u32 size = state_block_sizes[i];
+        if (size != 0)
+            p.DoVoid(state_blocks[i]->data(), size);
+        p.DoVoid(padding.data(), static_cast<u32>(GetPaddedBlockSize(size) - size));
+    }
+
+    state_blocks.clear();
+    state_block_sizes.clear();
+    state_vmas.clear();
+}
+
+bool MemoryListChangedPages(std::vector<ContentsPage>& pages, size_t& contents_size, bool all_pages) {
+    std::vector<VAddr> dirty_pages;
+    const bool incremental = Memory::TakeDirtyPages(dirty_pages) && !all_pages &&
+            state_blocks == tracked_blocks && state_block_sizes == tracked_block_sizes;
+    tracked_blocks = state_blocks;
+    tracked_block_sizes = state_block_sizes;
+
+    std::vector<size_t> block_offsets;
+    contents_size = 0;
+    for (u32 size : state_block_sizes) {
+        block_offsets.push_back(contents_size);
+        contents_size += GetPaddedBlockSize(size);
+    }
+
+    // Adds the pages of a block touching the given range
+    auto add_range = [&](u32 index, size_t offset, size_t length) {
+        const size_t block_size = state_block_sizes[index];
+        const size_t end = std::min(offset + length, block_size);
+        for (size_t page = offset & ~static_cast<size_t>(Memory::PAGE_MASK); page < end; page += Memory::PAGE_SIZE) {
+            pages.push_back({block_offsets[index] + page, state_blocks[index]->data() + page,
+                             std::min<size_t>(Memory::PAGE_SIZE, block_size - page)});
+        }
+    };
+
+    if (!incremental) {
+        for (u32 i = 0; i < state_blocks.size(); ++i)
+            add_range(i, 0, state_block_sizes[i]);
+    } else {
+        const auto& vm_manager = g_current_process->vm_manager;
+        for (VAddr address : dirty_pages) {
+            auto vma = vm_manager.FindVMA(address);
+            if (vma == vm_manager.vma_map.end() || vma->second.type != VMAType::AllocatedMemoryBlock)
+                continue;
+            u32 index = FindStateBlock(vma->second.backing_block);
+            if (index != INVALID_BLOCK_INDEX)
+                add_range(index, vma->second.offset + (address - vma->second.base), Memory::PAGE_SIZE);
+        }
+
+        // HLE services write to shared memory through raw pointers, which isn't tracked
+        for (const auto& object : GetAllObjects()) {
+            if (object->GetHandleType() != HandleType::SharedMemory)
+                continue;
+            const auto& shared_memory = static_cast<const SharedMemory&>(*object);
+            u32 index = FindStateBlock(shared_memory.backing_block);
+            if (index != INVALID_BLOCK_INDEX)
+                add_range(index, shared_memory.backing_block_offset, shared_memory.size);
+        }
+
+        std::sort(pages.begin(), pages.end(), [](const ContentsPage& a, const ContentsPage& b) {
+            return a.offset < b.offset;
+        });
+        pages.erase(std::unique(pages.begin(), pages.end(), [](const ContentsPage& a, const ContentsPage& b) {
+            return a.offset == b.offset;
+        }), pages.end());
+    }
+
+    state_blocks.clear();
+    state_block_sizes.clear();
+    state_vmas.clear();
+    return incremental;
+}
+
 }
 
 namespace Memory {
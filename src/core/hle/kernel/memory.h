@@ -5,11 +5,14 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "common/common_types.h"
 
 #include "core/hle/kernel/process.h"
 
+class PointerWrap;
+
 namespace Kernel {
 
 class VMManager;
@@ -26,6 +29,55 @@ void MemoryInit(u32 mem_type);
 void MemoryShutdown();
 MemoryRegionInfo* GetMemoryRegion(MemoryRegion region);
 
+/**
+ * Saves or restores the list of memory blocks backing the given kernel objects and the address
+ * space of the current process, followed by the layout of that address space. When loading, the
+ * linear heaps and the code of the running title are matched with the live blocks, the others are
+ * allocated anew, and the layout is only checked, to be applied by MemoryDoState.
+ */
+void MemoryDoLayout(PointerWrap& p, const std::vector<SharedPtr<Object>>& objects);
+
+/**
+ * Saves or restores a reference to a memory block as its index in the list saved by
+ * MemoryDoLayout. Blocks backing kernel objects must be serialized with this.
+ */
+void DoBlockRef(PointerWrap& p, std::shared_ptr<std::vector<u8>>& block);
+
+/**
+ * Saves or restores the usage of the memory regions. When loading, the blocks listed by
+ * MemoryDoLayout are resized and the address space of the current process is rebuilt with the
+ * layout it read.
+ */
+void MemoryDoState(PointerWrap& p);
+
+/**
+ * Saves or restores the contents of the memory blocks listed by MemoryDoLayout, each padded to a
+ * whole number of pages. Must follow MemoryDoState.
+ */
+void MemoryDoContents(PointerWrap& p);
+
+/// A page of the memory block contents, as saved by MemoryDoContents.
+struct ContentsPage {
+    /// Offset of the page in the contents
+    size_t offset;
+    /// Current data of the page
+    const u8* data;
+    /// Size of the page, smaller than a whole page at the end of a block
+    size_t size;
+};
+
+/**
+ * Lists the pages of the memory block contents that may have changed since the previous call,
+ * instead of saving them with MemoryDoContents. This lets in-memory snapshots be updated without
+ * reading all of emulated memory. Pages are listed when Memory::TakeDirtyPages reports them as
+ * written, and when they hold shared memory, which HLE services write through raw pointers.
+ * @param contents_size Receives the size of the contents
+ * @param all_pages Whether to list all pages
+ * @return Whether only the changed pages were listed, in ascending order. All pages are listed
+ *         when requested, or when pages were mapped, unmapped or resized since the previous call.
+ */
+bool MemoryListChangedPages(std::vector<ContentsPage>& pages, size_t& contents_size, bool all_pages);
+
 }
 
 namespace Memory {
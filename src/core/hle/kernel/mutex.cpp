@@ -91,4 +91,12 @@ void Mutex::Release() {
     }
 }
 
+void Mutex::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    p.Do(lock_count);
+    DoObjectRef(p, holding_thread);
+    p.Do(name);
+}
+
 } // namespace
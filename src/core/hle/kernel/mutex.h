@@ -44,7 +44,11 @@ public:
     void Acquire(SharedPtr<Thread> thread);
     void Release();
 
+    void DoState(PointerWrap& p) override;
+
 private:
+    friend void DoObjectTable(PointerWrap& p);
+
     Mutex();
     ~Mutex() override;
 };
@@ -271,6 +271,21 @@ ResultCode Process::LinearFree(VAddr target, u32 size) {
 Kernel::Process::Process() {}
 Kernel::Process::~Process() {}
 
+void Process::DoState(PointerWrap& p) {
+    p.Do(heap_start);
+    p.Do(heap_end);
+    p.Do(heap_used);
+    p.Do(linear_heap_used);
+    p.Do(misc_memory_used);
+    DoBlockRef(p, heap_memory);
+
+    std::vector<u8> tls_slot_masks(tls_slots.size());
+    for (size_t i = 0; i < tls_slots.size(); ++i)
+        tls_slot_masks[i] = static_cast<u8>(tls_slots[i].to_ulong());
+    p.DoPOD(tls_slot_masks);
+    tls_slots.assign(tls_slot_masks.begin(), tls_slot_masks.end());
+}
+
 SharedPtr<Process> g_current_process;
 
 }
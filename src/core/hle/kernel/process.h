@@ -158,6 +158,8 @@ public:
     ResultVal<VAddr> LinearAllocate(VAddr target, u32 size, VMAPermission perms);
     ResultCode LinearFree(VAddr target, u32 size);
 
+    void DoState(PointerWrap& p) override;
+
 private:
     Process();
     ~Process() override;
@@ -53,4 +53,12 @@ ResultVal<s32> Semaphore::Release(s32 release_count) {
     return MakeResult<s32>(previous_count);
 }
 
+void Semaphore::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    p.Do(max_count);
+    p.Do(available_count);
+    p.Do(name);
+}
+
 } // namespace
@@ -45,7 +45,11 @@ public:
      */
     ResultVal<s32> Release(s32 release_count);
 
+    void DoState(PointerWrap& p) override;
+
 private:
+    friend void DoObjectTable(PointerWrap& p);
+
     Semaphore();
     ~Semaphore() override;
 };
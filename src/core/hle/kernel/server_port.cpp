@@ -25,6 +25,13 @@ void ServerPort::Acquire() {
     ASSERT_MSG(!ShouldWait(), "object unavailable!");
 }
 
+void ServerPort::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    DoObjectRefs(p, pending_sessions);
+    p.Do(name);
+}
+
 std::tuple<SharedPtr<ServerPort>, SharedPtr<ClientPort>> ServerPort::CreatePortPair(u32 max_sessions, std::string name) {
     SharedPtr<ServerPort> server_port(new ServerPort);
     SharedPtr<ClientPort> client_port(new ClientPort);
@@ -38,7 +38,11 @@ public:
     bool ShouldWait() override;
     void Acquire() override;
 
+    void DoState(PointerWrap& p) override;
+
 private:
+    friend void DoObjectTable(PointerWrap& p);
+
     ServerPort();
     ~ServerPort() override;
 };
@@ -143,6 +143,7 @@ inline DescriptorType GetDescriptorType(u32 descriptor) {
 namespace Kernel {
 
 static const int kCommandHeaderOffset = 0x80; ///< Offset into command buffer of header
+static const u32 kCommandBufferSize = 0x100; ///< Size of the command buffer
 
 /**
  * Returns a pointer to the command buffer in the current thread's TLS
@@ -153,7 +154,10 @@ static const int kCommandHeaderOffset = 0x80; ///< Offset into command buffer of
  * @return Pointer to command buffer
  */
 inline u32* GetCommandBuffer(const int offset = 0) {
-    return (u32*)Memory::GetPointer(GetCurrentThread()->GetTLSAddress() + kCommandHeaderOffset + offset);
+    const VAddr address = GetCurrentThread()->GetTLSAddress() + kCommandHeaderOffset + offset;
+    // Replies are written through the returned pointer
+    Memory::MarkRegionDirty(address, kCommandBufferSize);
+    return (u32*)Memory::GetPointer(address);
 }
 
 /**
@@ -194,6 +198,12 @@ public:
      */
     virtual ResultVal<bool> SyncRequest() = 0;
 
+    /**
+     * Writes what identifies this session to a savestate, so that Service::DoSessionRecord can
+     * find or recreate it when the state is loaded.
+     */
+    virtual void SaveRecord(PointerWrap& p) = 0;
+
     // TODO(bunnei): These functions exist to satisfy a hardware test with a Session object
     // passed into WaitSynchronization. Figure out the meaning of them.
 
@@ -168,4 +168,16 @@ u8* SharedMemory::GetPointer(u32 offset) {
     return backing_block->data() + backing_block_offset + offset;
 }
 
+void SharedMemory::DoState(PointerWrap& p) {
+    DoObjectRef(p, owner_process);
+    p.Do(base_address);
+    p.Do(linear_heap_phys_address);
+    DoBlockRef(p, backing_block);
+    p.Do(backing_block_offset);
+    p.Do(size);
+    p.Do(permissions);
+    p.Do(other_permissions);
+    p.Do(name);
+}
+
 } // namespace
@@ -90,6 +90,8 @@ public:
     */
     u8* GetPointer(u32 offset = 0);
 
+    void DoState(PointerWrap& p) override;
+
     /// Process that created this shared memory block.
     SharedPtr<Process> owner_process;
     /// Address of shared memory block in the owner process if specified.
@@ -110,6 +112,8 @@ public:
     std::string name;
 
 private:
+    friend void DoObjectTable(PointerWrap& p);
+
     SharedMemory();
     ~SharedMemory() override;
 };
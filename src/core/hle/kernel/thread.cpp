@@ -618,6 +618,35 @@ void Thread::SetWaitSynchronizationOutput(s32 output) {
     context.cpu_registers[1] = output;
 }
 
+void Thread::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    p.Do(context);
+    p.Do(thread_id);
+    p.Do(status);
+    p.Do(entry_point);
+    p.Do(stack_top);
+    p.Do(nominal_priority);
+    p.Do(current_priority);
+    p.Do(last_running_ticks);
+    p.Do(processor_id);
+    p.Do(tls_address);
+    p.Do(waitsynch_waited);
+
+    std::vector<SharedPtr<Mutex>> mutexes(held_mutexes.begin(), held_mutexes.end());
+    DoObjectRefs(p, mutexes);
+    held_mutexes.clear();
+    held_mutexes.insert(mutexes.begin(), mutexes.end());
+
+    DoObjectRef(p, owner_process);
+    DoObjectRefs(p, wait_objects);
+    p.Do(wait_address);
+    p.Do(wait_all);
+    p.Do(wait_set_output);
+    p.Do(callback_handle);
+    p.Do(name);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void ThreadingInit() {
@@ -627,6 +656,40 @@ void ThreadingInit() {
     next_thread_id = 1;
 }
 
+void ThreadingDoState(PointerWrap& p) {
+    std::vector<SharedPtr<Thread>> threads = thread_list;
+    DoObjectRefs(p, threads);
+
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        // Threads created after the state was saved no longer exist
+        for (auto& thread : thread_list) {
+            if (std::find(threads.begin(), threads.end(), thread) == threads.end())
+                thread->status = THREADSTATUS_DEAD;
+        }
+        thread_list = std::move(threads);
+        ready_queue.clear();
+    }
+
+    for (u32 priority = THREADPRIO_HIGHEST; priority <= THREADPRIO_LOWEST; ++priority) {
+        const auto& queue = ready_queue.get_queue(priority);
+        std::vector<SharedPtr<Thread>> ready_threads(queue.begin(), queue.end());
+        DoObjectRefs(p, ready_threads);
+
+        if (p.GetMode() == PointerWrap::MODE_READ && !ready_threads.empty()) {
+            ready_queue.prepare(priority);
+            for (auto& thread : ready_threads)
+                ready_queue.push_back(priority, thread.get());
+        }
+    }
+
+    SharedPtr<Thread> current = current_thread;
+    DoObjectRef(p, current);
+    current_thread = current.get();
+
+    p.Do(next_thread_id);
+    wakeup_callback_handle_table.DoState(p);
+}
+
 void ThreadingShutdown() {
     current_thread = nullptr;
 
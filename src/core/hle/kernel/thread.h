@@ -129,6 +129,8 @@ public:
      */
     VAddr GetTLSAddress() const { return tls_address; }
 
+    void DoState(PointerWrap& p) override;
+
     Core::ThreadContext context;
 
     u32 thread_id;
@@ -163,6 +165,8 @@ public:
     Handle callback_handle;
 
 private:
+    friend void DoObjectTable(PointerWrap& p);
+
     Thread();
     ~Thread() override;
 };
@@ -226,4 +230,9 @@ void ThreadingInit();
  */
 void ThreadingShutdown();
 
+/**
+ * Saves or restores the scheduler state: the thread list, ready queue and current thread
+ */
+void ThreadingDoState(PointerWrap& p);
+
 } // namespace
@@ -71,6 +71,17 @@ void Timer::Clear() {
     signaled = false;
 }
 
+void Timer::DoState(PointerWrap& p) {
+    WaitObject::DoState(p);
+
+    p.Do(reset_type);
+    p.Do(signaled);
+    p.Do(initial_delay);
+    p.Do(interval_delay);
+    p.Do(callback_handle);
+    p.Do(name);
+}
+
 /// The timer callback event, called when a timer is fired
 static void TimerCallback(u64 timer_handle, int cycles_late) {
     SharedPtr<Timer> timer = timer_callback_handle_table.Get<Timer>(static_cast<Handle>(timer_handle));
@@ -103,4 +114,8 @@ void TimersInit() {
 void TimersShutdown() {
 }
 
+void TimersDoState(PointerWrap& p) {
+    timer_callback_handle_table.DoState(p);
+}
+
 } // namespace
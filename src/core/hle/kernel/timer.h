@@ -48,7 +48,11 @@ public:
     void Cancel();
     void Clear();
 
+    void DoState(PointerWrap& p) override;
+
 private:
+    friend void DoObjectTable(PointerWrap& p);
+
     Timer();
     ~Timer() override;
 
@@ -60,5 +64,7 @@ private:
 void TimersInit();
 /// Tears down the timer variables
 void TimersShutdown();
+/// Saves or restores the handle table used to find timers from their CoreTiming events
+void TimersDoState(PointerWrap& p);
 
 } // namespace
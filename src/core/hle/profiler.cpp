@@ -0,0 +1,204 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/string_util.h"
+
+#include "core/hle/profiler.h"
+
+namespace HLE {
+namespace Profiler {
+
+/// MicroProfile has a fixed-size timer table shared with the rest of the emulator, so only this
+/// many HLE functions get their own MicroProfile timer. Statistics are gathered for all of them.
+static const size_t MAX_MICROPROFILE_TIMERS = 512;
+
+/// Maximum number of distinct HLE functions which can be registered. Only functions that are
+/// actually called get registered, which is far less than this.
+static const size_t MAX_CALLS = 4096;
+
+static const u64 INVALID_MP_TOKEN = static_cast<u64>(-1);
+
+namespace {
+struct CallEntry {
+    std::string name;
+    CallCategory category;
+    std::string service;
+    u32 command;
+    u64 mp_token;
+
+    // Updated by ScopedCall without taking the mutex. The fields are updated separately, so a
+    // snapshot taken during a call may be slightly inconsistent, which doesn't matter for a report.
+    std::atomic<u64> count{0};
+    std::atomic<Duration::rep> total{0};
+    std::atomic<Duration::rep> min{Duration::max().count()};
+    std::atomic<Duration::rep> max{0};
+};
+}
+
+/**
+ * Entries never move once registered, so calls can look up their entry by id without locking.
+ * The mutex only serializes registration.
+ */
+static std::mutex call_table_mutex;
+static std::array<CallEntry, MAX_CALLS> call_table;
+static std::atomic<size_t> num_calls{0};
+static std::map<std::tuple<CallCategory, std::string, u32>, CallId> call_ids;
+static size_t num_mp_timers = 0;
+
+static u64 GetMicroProfileToken(CallCategory category, const std::string& name) {
+#if MICROPROFILE_ENABLED
+    if (num_mp_timers >= MAX_MICROPROFILE_TIMERS)
+        return INVALID_MP_TOKEN;
+    ++num_mp_timers;
+
+    switch (category) {
+    case CallCategory::Service:
+        return MicroProfileGetToken("HLE Service", name.c_str(), MP_RGB(70, 200, 200));
+    case CallCategory::SVC:
+        return MicroProfileGetToken("HLE SVC", name.c_str(), MP_RGB(70, 200, 70));
+    }
+#endif
+    return INVALID_MP_TOKEN;
+}
+
+CallId RegisterCall(CallCategory category, const std::string& service, u32 command, const std::string& name) {
+    std::lock_guard<std::mutex> lock(call_table_mutex);
+
+    auto key = std::make_tuple(category, service, command);
+    auto it = call_ids.find(key);
+    if (it != call_ids.end())
+        return it->second;
+
+    const CallId id = num_calls.load(std::memory_order_relaxed);
+    ASSERT_MSG(id < MAX_CALLS, "Too many HLE functions registered with the profiler");
+
+    CallEntry& entry = call_table[id];
+    entry.name = service.empty() ? name : service + "::" + name;
+    entry.category = category;
+    entry.service = service;
+    entry.command = command;
+    entry.mp_token = GetMicroProfileToken(category, entry.name);
+
+    // Publishes the entry to GetCallStats
+    num_calls.store(id + 1, std::memory_order_release);
+    call_ids.emplace(std::move(key), id);
+    return id;
+}
+
+/// Lowers or raises `value` to `candidate`, depending on `compare`.
+template <typename Compare>
+static void UpdateExtreme(std::atomic<Duration::rep>& value, Duration::rep candidate, Compare compare) {
+    Duration::rep current = value.load(std::memory_order_relaxed);
+    while (compare(candidate, current) &&
+           !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+    }
+}
+
+ScopedCall::ScopedCall(CallId id) : id(id), mp_tick(0) {
+    DEBUG_ASSERT(id < MAX_CALLS);
+    mp_token = call_table[id].mp_token;
+
+#if MICROPROFILE_ENABLED
+    if (mp_token != INVALID_MP_TOKEN)
+        mp_tick = MicroProfileEnter(mp_token);
+#endif
+    start = Clock::now();
+}
+
+ScopedCall::~ScopedCall() {
+    Duration elapsed = Clock::now() - start;
+
+#if MICROPROFILE_ENABLED
+    if (mp_token != INVALID_MP_TOKEN)
+        MicroProfileLeave(mp_token, mp_tick);
+#endif
+
+    CallEntry& entry = call_table[id];
+    const Duration::rep ticks = elapsed.count();
+    entry.count.fetch_add(1, std::memory_order_relaxed);
+    entry.total.fetch_add(ticks, std::memory_order_relaxed);
+    UpdateExtreme(entry.min, ticks, std::less<Duration::rep>());
+    UpdateExtreme(entry.max, ticks, std::greater<Duration::rep>());
+}
+
+std::vector<CallStats> GetCallStats() {
+    const size_t count = num_calls.load(std::memory_order_acquire);
+
+    std::vector<CallStats> result;
+    for (size_t id = 0; id < count; ++id) {
+        const CallEntry& entry = call_table[id];
+        if (entry.count.load(std::memory_order_relaxed) == 0)
+            continue;
+
+        CallStats stats;
+        stats.name = entry.name;
+        stats.category = entry.category;
+        stats.service = entry.service;
+        stats.command = entry.command;
+        stats.count = entry.count.load(std::memory_order_relaxed);
+        stats.total = Duration(entry.total.load(std::memory_order_relaxed));
+        stats.min = Duration(entry.min.load(std::memory_order_relaxed));
+        stats.max = Duration(entry.max.load(std::memory_order_relaxed));
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+void ResetCallStats() {
+    const size_t count = num_calls.load(std::memory_order_acquire);
+
+    for (size_t id = 0; id < count; ++id) {
+        CallEntry& entry = call_table[id];
+        entry.count.store(0, std::memory_order_relaxed);
+        entry.total.store(0, std::memory_order_relaxed);
+        entry.min.store(Duration::max().count(), std::memory_order_relaxed);
+        entry.max.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::string FormatReport() {
+    using FloatUs = std::chrono::duration<double, std::micro>;
+    auto to_us = [](Duration dur) -> double {
+        return std::chrono::duration_cast<FloatUs>(dur).count();
+    };
+
+    std::vector<CallStats> stats = GetCallStats();
+    std::sort(stats.begin(), stats.end(), [](const CallStats& a, const CallStats& b) {
+        return a.total > b.total;
+    });
+
+    // Service commands are issued from within the SendSyncRequest SVC, so percentages are given
+    // relative to the total of each category to avoid counting that time twice.
+    Duration service_total = Duration::zero();
+    Duration svc_total = Duration::zero();
+    for (const CallStats& entry : stats)
+        (entry.category == CallCategory::Service ? service_total : svc_total) += entry.total;
+
+    std::string report = Common::StringFromFormat("%-48s %10s %12s %6s %10s %10s %10s\n",
+            "Function", "Calls", "Total (ms)", "%", "Avg (us)", "Min (us)", "Max (us)");
+    for (const CallStats& entry : stats) {
+        double total_us = to_us(entry.total);
+        Duration category_total = entry.category == CallCategory::Service ? service_total : svc_total;
+        double percent = category_total != Duration::zero() ?
+                100.0 * total_us / to_us(category_total) : 0.0;
+        report += Common::StringFromFormat("%-48s %10llu %12.3f %6.2f %10.2f %10.2f %10.2f\n",
+                entry.name.c_str(), static_cast<unsigned long long>(entry.count),
+                total_us / 1000.0, percent, total_us / entry.count,
+                to_us(entry.min), to_us(entry.max));
+    }
+    return report;
+}
+
+} // namespace Profiler
+} // namespace HLE
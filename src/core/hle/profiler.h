@@ -0,0 +1,89 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+
+/**
+ * Per-function timing of HLE entry points (service commands and SVCs). Every profiled call is
+ * wrapped in a MicroProfile scope named after the function, and its duration is additionally
+ * accumulated into a table that frontends can query to build an aggregate report.
+ */
+namespace HLE {
+namespace Profiler {
+
+using Clock = std::chrono::high_resolution_clock;
+using Duration = Clock::duration;
+
+enum class CallCategory {
+    Service, ///< A command dispatched through a service session (e.g. "FS_USER::OpenFile")
+    SVC,     ///< A supervisor call dispatched through the SVC table (e.g. "SendSyncRequest")
+};
+
+/// Handle to a registered HLE function. Obtained once per function and cached by the caller.
+using CallId = size_t;
+
+/// Aggregated timing information for a single HLE function.
+struct CallStats {
+    std::string name;
+    CallCategory category;
+    std::string service; ///< Name of the service port or session type, empty for SVCs
+    u32 command;         ///< Command header of the service function, or the SVC number
+
+    u64 count = 0;
+    Duration total = Duration::zero();
+    Duration min = Duration::max();
+    Duration max = Duration::zero();
+};
+
+/**
+ * Registers an HLE function to be profiled. Functions are identified by their service and command
+ * header, so registering the same function twice returns the same id, while identically named
+ * commands of different services are profiled separately.
+ * @param category Category the function belongs to, used to group the MicroProfile timers
+ * @param service Name of the service port or session type, e.g. "gsp::Gpu", or empty for SVCs
+ * @param command Command header of the service function, or the SVC number
+ * @param name Name of the function, e.g. "FlushDataCache"
+ */
+CallId RegisterCall(CallCategory category, const std::string& service, u32 command, const std::string& name);
+
+/**
+ * Times a call to a registered HLE function for as long as this object is alive. No lock is taken,
+ * so it is cheap enough to wrap every SVC and service command.
+ */
+class ScopedCall final {
+public:
+    explicit ScopedCall(CallId id);
+    ~ScopedCall();
+
+    ScopedCall(const ScopedCall&) = delete;
+    ScopedCall& operator=(const ScopedCall&) = delete;
+
+private:
+    CallId id;
+    u64 mp_token;
+    u64 mp_tick;
+    Clock::time_point start;
+};
+
+/// Returns a snapshot of the statistics of every function that was called at least once.
+std::vector<CallStats> GetCallStats();
+
+/// Clears all accumulated statistics. Registered functions and their ids remain valid.
+void ResetCallStats();
+
+/**
+ * Formats the current statistics as a plain-text table, sorted by total time spent in each
+ * function, suitable for logging or copying out of the debugger.
+ */
+std::string FormatReport();
+
+} // namespace Profiler
+} // namespace HLE
@@ -178,6 +178,18 @@ void Shutdown() {
 
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("AM", 1);
+    if (!s)
+        return;
+
+    p.Do(am_content_count);
+    p.Do(am_titles_count);
+    p.Do(am_titles_list_count);
+    p.Do(am_ticket_count);
+    p.Do(am_ticket_list_count);
+}
+
 } // namespace AM
 
 } // namespace Service
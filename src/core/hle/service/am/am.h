@@ -160,5 +160,8 @@ void Init();
 /// Shutdown AM service
 void Shutdown();
 
+/// Saves or restores the state of the AM services
+void DoState(PointerWrap& p);
+
 } // namespace AM
 } // namespace Service
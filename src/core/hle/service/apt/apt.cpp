@@ -524,5 +524,28 @@ void Shutdown() {
     HLE::Applets::Shutdown();
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("APT", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, shared_font_mem);
+    p.Do(shared_font_relocated);
+    Kernel::DoObjectRef(p, lock);
+    Kernel::DoObjectRef(p, notification_event);
+    Kernel::DoObjectRef(p, parameter_event);
+    p.Do(cpu_percent);
+    p.Do(unknown_ns_state_field);
+    p.Do(screen_capture_post_permission);
+
+    p.Do(next_parameter.sender_id);
+    p.Do(next_parameter.destination_id);
+    p.Do(next_parameter.signal);
+    Kernel::DoObjectRef(p, next_parameter.object);
+    p.Do(next_parameter.buffer);
+
+    HLE::Applets::DoState(p);
+}
+
 } // namespace APT
 } // namespace Service
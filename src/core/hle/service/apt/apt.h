@@ -438,5 +438,8 @@ void Init();
 /// Shutdown the APT service
 void Shutdown();
 
+/// Saves or restores the state of the APT services and of the HLE applets
+void DoState(PointerWrap& p);
+
 } // namespace APT
 } // namespace Service
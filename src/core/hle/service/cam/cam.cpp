@@ -306,6 +306,17 @@ void Shutdown() {
     vsync_interrupt_error_event = nullptr;
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("CAM", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, completion_event_cam1);
+    Kernel::DoObjectRef(p, completion_event_cam2);
+    Kernel::DoObjectRef(p, interrupt_error_event);
+    Kernel::DoObjectRef(p, vsync_interrupt_error_event);
+}
+
 } // namespace CAM
 
 } // namespace Service
@@ -433,5 +433,8 @@ void Init();
 /// Shutdown CAM service(s)
 void Shutdown();
 
+/// Saves or restores the state of the CAM services
+void DoState(PointerWrap& p);
+
 } // namespace CAM
 } // namespace Service
@@ -56,6 +56,15 @@ void Shutdown() {
     change_state_event = nullptr;
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("CECD", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, cecinfo_event);
+    Kernel::DoObjectRef(p, change_state_event);
+}
+
 } // namespace CECD
 
 } // namespace Service
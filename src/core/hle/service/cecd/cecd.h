@@ -54,5 +54,8 @@ void Init();
 /// Shutdown CECD service(s)
 void Shutdown();
 
+/// Saves or restores the state of the CECD services
+void DoState(PointerWrap& p);
+
 } // namespace CECD
 } // namespace Service
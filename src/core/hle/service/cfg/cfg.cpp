@@ -547,5 +547,14 @@ SoundOutputMode GetSoundOutputMode() {
     return static_cast<SoundOutputMode>(block);
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("CFG", 1);
+    if (!s)
+        return;
+
+    p.Do(cfg_config_file_buffer);
+    p.Do(cfg_system_save_data_archive);
+}
+
 } // namespace CFG
 } // namespace Service
@@ -337,5 +337,8 @@ void SetSoundOutputMode(SoundOutputMode mode);
  */
 SoundOutputMode GetSoundOutputMode();
 
+/// Saves or restores the state of the CFG services
+void DoState(PointerWrap& p);
+
 } // namespace CFG
 } // namespace Service
@@ -85,4 +85,13 @@ void Shutdown(Service::Interface* self) {
     mutex = nullptr;
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("CSND_SND", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, shared_memory);
+    Kernel::DoObjectRef(p, mutex);
+}
+
 } // namespace
@@ -33,4 +33,7 @@ void ExecuteType0Commands(Service::Interface* self);
 void AcquireSoundChannels(Service::Interface* self);
 void Shutdown(Service::Interface* self);
 
+/// Saves or restores the state of the CSND service
+void DoState(PointerWrap& p);
+
 } // namespace
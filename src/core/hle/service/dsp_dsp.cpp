@@ -69,6 +69,13 @@ public:
         return number >= max_number_of_interrupt_events;
     }
 
+    void DoState(PointerWrap& p) {
+        Kernel::DoObjectRef(p, zero);
+        Kernel::DoObjectRef(p, one);
+        for (auto& event : pipe)
+            Kernel::DoObjectRef(p, event);
+    }
+
 private:
     /// Currently unknown purpose
     Kernel::SharedPtr<Kernel::Event> zero = nullptr;
@@ -562,4 +569,13 @@ Interface::~Interface() {
     interrupt_events = {};
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("DSP_DSP", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, semaphore_event);
+    interrupt_events.DoState(p);
+}
+
 } // namespace
@@ -35,4 +35,7 @@ public:
  */
 void SignalPipeInterrupt(DSP::HLE::DspPipe pipe);
 
+/// Saves or restores the state of the DSP service
+void DoState(PointerWrap& p);
+
 } // namespace DSP_DSP
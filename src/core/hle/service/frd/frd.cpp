@@ -109,6 +109,15 @@ void Init() {
 void Shutdown() {
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("FRD", 1);
+    if (!s)
+        return;
+
+    p.Do(my_friend_key);
+    p.Do(my_presence);
+}
+
 } // namespace FRD
 
 } // namespace Service
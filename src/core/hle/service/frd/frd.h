@@ -101,5 +101,8 @@ void Init();
 /// Shutdown FRD service(s)
 void Shutdown();
 
+/// Saves or restores the state of the FRD services
+void DoState(PointerWrap& p);
+
 } // namespace FRD
 } // namespace Service
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <system_error>
 #include <type_traits>
@@ -12,6 +14,7 @@
 #include <boost/container/flat_map.hpp>
 
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -25,6 +28,7 @@
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/hle.h"
+#include "core/hle/profiler.h"
 #include "core/hle/service/service.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/hle/service/fs/fs_user.h"
@@ -88,6 +92,53 @@ enum class DirectoryCommand : u32 {
     Close           = 0x08020000,
 };
 
+static const char* GetFileCommandName(FileCommand cmd) {
+    switch (cmd) {
+    case FileCommand::Dummy1:        return "Dummy1";
+    case FileCommand::Control:       return "Control";
+    case FileCommand::OpenSubFile:   return "OpenSubFile";
+    case FileCommand::Read:          return "Read";
+    case FileCommand::Write:         return "Write";
+    case FileCommand::GetSize:       return "GetSize";
+    case FileCommand::SetSize:       return "SetSize";
+    case FileCommand::GetAttributes: return "GetAttributes";
+    case FileCommand::SetAttributes: return "SetAttributes";
+    case FileCommand::Close:         return "Close";
+    case FileCommand::Flush:         return "Flush";
+    case FileCommand::SetPriority:   return "SetPriority";
+    case FileCommand::GetPriority:   return "GetPriority";
+    case FileCommand::OpenLinkFile:  return "OpenLinkFile";
+    }
+    return "Unknown";
+}
+
+static const char* GetDirectoryCommandName(DirectoryCommand cmd) {
+    switch (cmd) {
+    case DirectoryCommand::Dummy1:  return "Dummy1";
+    case DirectoryCommand::Control: return "Control";
+    case DirectoryCommand::Read:    return "Read";
+    case DirectoryCommand::Close:   return "Close";
+    }
+    return "Unknown";
+}
+
+/**
+ * Returns the profiler id of a command of a File or Directory session, registering it on its first
+ * call. These sessions aren't Service::Interfaces, so their commands are dispatched and profiled here.
+ * @param ids Profiler ids of the session type, keyed by command header
+ */
+static HLE::Profiler::CallId GetSessionProfilerId(boost::container::flat_map<u32, HLE::Profiler::CallId>& ids,
+                                                  const char* session, u32 header, const char* name) {
+    auto itr = ids.find(header);
+    if (itr != ids.end())
+        return itr->second;
+
+    HLE::Profiler::CallId profiler_id = HLE::Profiler::RegisterCall(
+            HLE::Profiler::CallCategory::Service, session, header, name);
+    ids.emplace(header, profiler_id);
+    return profiler_id;
+}
+
 File::File(std::unique_ptr<FileSys::FileBackend>&& backend, const FileSys::Path & path)
     : path(path), priority(0), backend(std::move(backend)) {}
 
@@ -96,6 +147,11 @@ File::~File() {}
 ResultVal<bool> File::SyncRequest() {
     u32* cmd_buff = Kernel::GetCommandBuffer();
     FileCommand cmd = static_cast<FileCommand>(cmd_buff[0]);
+
+    static boost::container::flat_map<u32, HLE::Profiler::CallId> profiler_ids;
+    HLE::Profiler::ScopedCall profile_scope(
+            GetSessionProfilerId(profiler_ids, "FS_File", cmd_buff[0], GetFileCommandName(cmd)));
+
     switch (cmd) {
 
         // Read from file...
@@ -216,6 +272,11 @@ Directory::~Directory() {}
 ResultVal<bool> Directory::SyncRequest() {
     u32* cmd_buff = Kernel::GetCommandBuffer();
     DirectoryCommand cmd = static_cast<DirectoryCommand>(cmd_buff[0]);
+
+    static boost::container::flat_map<u32, HLE::Profiler::CallId> profiler_ids;
+    HLE::Profiler::ScopedCall profile_scope(
+            GetSessionProfilerId(profiler_ids, "FS_Directory", cmd_buff[0], GetDirectoryCommandName(cmd)));
+
     switch (cmd) {
 
         // Read from directory...
@@ -229,6 +290,7 @@ ResultVal<bool> Directory::SyncRequest() {
 
             // Number of entries actually read
             u32 read = backend->Read(entries.size(), entries.data());
+            entries_read += read;
             cmd_buff[2] = read;
             Memory::WriteBlock(address, entries.data(), read * sizeof(FileSys::Entry));
             break;
@@ -263,34 +325,50 @@ using FileSys::ArchiveFactory;
  */
 static boost::container::flat_map<ArchiveIdCode, std::unique_ptr<ArchiveFactory>> id_code_map;
 
+/// An open archive, along with what it was opened from so that it can be reopened by savestates.
+struct OpenedArchive {
+    ArchiveIdCode id_code;
+    FileSys::Path path;
+    std::unique_ptr<ArchiveBackend> backend;
+};
+
 /**
  * Map of active archive handles. Values are pointers to the archives in `idcode_map`.
  */
-static std::unordered_map<ArchiveHandle, std::unique_ptr<ArchiveBackend>> handle_map;
+static std::unordered_map<ArchiveHandle, OpenedArchive> handle_map;
 static ArchiveHandle next_handle;
 
-static ArchiveBackend* GetArchive(ArchiveHandle handle) {
+static OpenedArchive* GetOpenedArchive(ArchiveHandle handle) {
     auto itr = handle_map.find(handle);
-    return (itr == handle_map.end()) ? nullptr : itr->second.get();
+    return (itr == handle_map.end()) ? nullptr : &itr->second;
 }
 
-ResultVal<ArchiveHandle> OpenArchive(ArchiveIdCode id_code, FileSys::Path& archive_path) {
-    LOG_TRACE(Service_FS, "Opening archive with id code 0x%08X", id_code);
+static ArchiveBackend* GetArchive(ArchiveHandle handle) {
+    OpenedArchive* archive = GetOpenedArchive(handle);
+    return (archive == nullptr) ? nullptr : archive->backend.get();
+}
 
+static ResultVal<std::unique_ptr<ArchiveBackend>> OpenArchiveBackend(ArchiveIdCode id_code,
+        FileSys::Path& archive_path) {
     auto itr = id_code_map.find(id_code);
     if (itr == id_code_map.end()) {
         // TODO: Verify error against hardware
         return ResultCode(ErrorDescription::NotFound, ErrorModule::FS,
                           ErrorSummary::NotFound, ErrorLevel::Permanent);
     }
+    return itr->second->Open(archive_path);
+}
+
+ResultVal<ArchiveHandle> OpenArchive(ArchiveIdCode id_code, FileSys::Path& archive_path) {
+    LOG_TRACE(Service_FS, "Opening archive with id code 0x%08X", id_code);
 
-    CASCADE_RESULT(std::unique_ptr<ArchiveBackend> res, itr->second->Open(archive_path));
+    CASCADE_RESULT(std::unique_ptr<ArchiveBackend> res, OpenArchiveBackend(id_code, archive_path));
 
     // This should never even happen in the first place with 64-bit handles,
     while (handle_map.count(next_handle) != 0) {
         ++next_handle;
     }
-    handle_map.emplace(next_handle, std::move(res));
+    handle_map.emplace(next_handle, OpenedArchive{id_code, archive_path, std::move(res)});
     return MakeResult<ArchiveHandle>(next_handle++);
 }
 
@@ -316,18 +394,67 @@ ResultCode RegisterArchiveType(std::unique_ptr<FileSys::ArchiveFactory>&& factor
 
 ResultVal<Kernel::SharedPtr<File>> OpenFileFromArchive(ArchiveHandle archive_handle,
         const FileSys::Path& path, const FileSys::Mode mode) {
-    ArchiveBackend* archive = GetArchive(archive_handle);
+    OpenedArchive* archive = GetOpenedArchive(archive_handle);
     if (archive == nullptr)
         return ERR_INVALID_ARCHIVE_HANDLE;
 
-    auto backend = archive->OpenFile(path, mode);
+    auto backend = archive->backend->OpenFile(path, mode);
     if (backend.Failed())
         return backend.Code();
 
     auto file = Kernel::SharedPtr<File>(new File(backend.MoveFrom(), path));
+    file->archive_id_code = archive->id_code;
+    file->archive_path = archive->path;
+    file->mode.hex = mode.hex;
     return MakeResult<Kernel::SharedPtr<File>>(std::move(file));
 }
 
+void File::SaveRecord(PointerWrap& p) {
+    SessionRecordType type = SessionRecordType::File;
+    p.Do(type);
+    p.Do(archive_id_code);
+    archive_path.DoState(p);
+    path.DoState(p);
+    p.Do(mode.hex);
+    p.Do(priority);
+}
+
+Kernel::SharedPtr<File> File::LoadRecord(PointerWrap& p) {
+    ArchiveIdCode archive_id_code;
+    FileSys::Path archive_path;
+    FileSys::Path path;
+    FileSys::Mode mode;
+    u32 priority;
+    p.Do(archive_id_code);
+    archive_path.DoState(p);
+    path.DoState(p);
+    p.Do(mode.hex);
+    p.Do(priority);
+
+    auto archive = OpenArchiveBackend(archive_id_code, archive_path);
+    if (archive.Failed()) {
+        LOG_ERROR(Service_FS, "Could not reopen archive 0x%08X of file %s", archive_id_code,
+                  path.DebugStr().c_str());
+        return nullptr;
+    }
+
+    // The file was created when it was first opened, if it had to be
+    FileSys::Mode open_mode = mode;
+    open_mode.create_flag.Assign(0);
+    auto backend = (*archive)->OpenFile(path, open_mode);
+    if (backend.Failed()) {
+        LOG_ERROR(Service_FS, "Could not reopen file %s", path.DebugStr().c_str());
+        return nullptr;
+    }
+
+    auto file = Kernel::SharedPtr<File>(new File(backend.MoveFrom(), path));
+    file->priority = priority;
+    file->archive_id_code = archive_id_code;
+    file->archive_path = std::move(archive_path);
+    file->mode.hex = mode.hex;
+    return file;
+}
+
 ResultCode DeleteFileFromArchive(ArchiveHandle archive_handle, const FileSys::Path& path) {
     ArchiveBackend* archive = GetArchive(archive_handle);
     if (archive == nullptr)
@@ -410,20 +537,71 @@ ResultCode RenameDirectoryBetweenArchives(ArchiveHandle src_archive_handle, cons
 
 ResultVal<Kernel::SharedPtr<Directory>> OpenDirectoryFromArchive(ArchiveHandle archive_handle,
         const FileSys::Path& path) {
-    ArchiveBackend* archive = GetArchive(archive_handle);
+    OpenedArchive* archive = GetOpenedArchive(archive_handle);
     if (archive == nullptr)
         return ERR_INVALID_ARCHIVE_HANDLE;
 
-    std::unique_ptr<FileSys::DirectoryBackend> backend = archive->OpenDirectory(path);
+    std::unique_ptr<FileSys::DirectoryBackend> backend = archive->backend->OpenDirectory(path);
     if (backend == nullptr) {
         return ResultCode(ErrorDescription::FS_NotFound, ErrorModule::FS,
                           ErrorSummary::NotFound, ErrorLevel::Permanent);
     }
 
     auto directory = Kernel::SharedPtr<Directory>(new Directory(std::move(backend), path));
+    directory->archive_id_code = archive->id_code;
+    directory->archive_path = archive->path;
     return MakeResult<Kernel::SharedPtr<Directory>>(std::move(directory));
 }
 
+void Directory::SaveRecord(PointerWrap& p) {
+    SessionRecordType type = SessionRecordType::Directory;
+    p.Do(type);
+    p.Do(archive_id_code);
+    archive_path.DoState(p);
+    path.DoState(p);
+    p.Do(entries_read);
+}
+
+Kernel::SharedPtr<Directory> Directory::LoadRecord(PointerWrap& p) {
+    ArchiveIdCode archive_id_code;
+    FileSys::Path archive_path;
+    FileSys::Path path;
+    u32 entries_read;
+    p.Do(archive_id_code);
+    archive_path.DoState(p);
+    path.DoState(p);
+    p.Do(entries_read);
+
+    auto archive = OpenArchiveBackend(archive_id_code, archive_path);
+    if (archive.Failed()) {
+        LOG_ERROR(Service_FS, "Could not reopen archive 0x%08X of directory %s", archive_id_code,
+                  path.DebugStr().c_str());
+        return nullptr;
+    }
+
+    std::unique_ptr<FileSys::DirectoryBackend> backend = (*archive)->OpenDirectory(path);
+    if (backend == nullptr) {
+        LOG_ERROR(Service_FS, "Could not reopen directory %s", path.DebugStr().c_str());
+        return nullptr;
+    }
+
+    // Skip the entries the application has already read
+    std::array<FileSys::Entry, 16> entries;
+    for (u32 skipped = 0; skipped < entries_read;) {
+        u32 count = std::min<u32>(entries_read - skipped, static_cast<u32>(entries.size()));
+        u32 read = backend->Read(count, entries.data());
+        if (read == 0)
+            break;
+        skipped += read;
+    }
+
+    auto directory = Kernel::SharedPtr<Directory>(new Directory(std::move(backend), path));
+    directory->archive_id_code = archive_id_code;
+    directory->archive_path = std::move(archive_path);
+    directory->entries_read = entries_read;
+    return directory;
+}
+
 ResultVal<u64> GetFreeBytesInArchive(ArchiveHandle archive_handle) {
     ArchiveBackend* archive = GetArchive(archive_handle);
     if (archive == nullptr)
@@ -576,5 +754,40 @@ void ArchiveShutdown() {
     UnregisterArchiveTypes();
 }
 
+void ArchiveDoState(PointerWrap& p) {
+    u32 num_archives = static_cast<u32>(handle_map.size());
+    p.Do(num_archives);
+
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        for (auto& archive : handle_map) {
+            ArchiveHandle handle = archive.first;
+            p.Do(handle);
+            p.Do(archive.second.id_code);
+            archive.second.path.DoState(p);
+        }
+    } else {
+        handle_map.clear();
+        for (u32 i = 0; i < num_archives; ++i) {
+            ArchiveHandle handle;
+            ArchiveIdCode id_code;
+            FileSys::Path path;
+            p.Do(handle);
+            p.Do(id_code);
+            path.DoState(p);
+
+            auto backend = OpenArchiveBackend(id_code, path);
+            if (backend.Failed()) {
+                LOG_ERROR(Service_FS, "Could not reopen archive 0x%08X %s", id_code,
+                          path.DebugStr().c_str());
+                p.SetError(PointerWrap::ERROR_FAILURE);
+                break;
+            }
+            handle_map.emplace(handle, OpenedArchive{id_code, std::move(path), backend.MoveFrom()});
+        }
+    }
+
+    p.Do(next_handle);
+}
+
 } // namespace FS
 } // namespace Service
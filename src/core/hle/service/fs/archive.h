@@ -53,10 +53,18 @@ public:
 
     std::string GetName() const override { return "Path: " + path.DebugStr(); }
     ResultVal<bool> SyncRequest() override;
+    void SaveRecord(PointerWrap& p) override;
+
+    /// Reopens a file saved by SaveRecord, returning nullptr if it can't be opened anymore
+    static Kernel::SharedPtr<File> LoadRecord(PointerWrap& p);
 
     FileSys::Path path; ///< Path of the file
     u32 priority; ///< Priority of the file. TODO(Subv): Find out what this means
     std::unique_ptr<FileSys::FileBackend> backend; ///< File backend interface
+
+    ArchiveIdCode archive_id_code; ///< Id code of the archive the file was opened from
+    FileSys::Path archive_path; ///< Path of the archive the file was opened from
+    FileSys::Mode mode; ///< Mode the file was opened with
 };
 
 class Directory : public Kernel::Session {
@@ -66,9 +74,17 @@ public:
 
     std::string GetName() const override { return "Directory: " + path.DebugStr(); }
     ResultVal<bool> SyncRequest() override;
+    void SaveRecord(PointerWrap& p) override;
+
+    /// Reopens a directory saved by SaveRecord, returning nullptr if it can't be opened anymore
+    static Kernel::SharedPtr<Directory> LoadRecord(PointerWrap& p);
 
     FileSys::Path path; ///< Path of the directory
     std::unique_ptr<FileSys::DirectoryBackend> backend; ///< File backend interface
+
+    ArchiveIdCode archive_id_code; ///< Id code of the archive the directory was opened from
+    FileSys::Path archive_path; ///< Path of the archive the directory was opened from
+    u32 entries_read = 0; ///< Number of entries read so far
 };
 
 /**
@@ -235,6 +251,12 @@ void ArchiveInit();
 /// Shutdown archives
 void ArchiveShutdown();
 
+/**
+ * Saves or restores the open archive handles. Archives are reopened from their id code and path
+ * when loading: their contents live on the host and aren't part of savestates.
+ */
+void ArchiveDoState(PointerWrap& p);
+
 /// Register all archive types
 void RegisterArchiveTypes();
 
@@ -953,5 +953,14 @@ Interface::Interface() {
     Register(FunctionTable);
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("FS", 1);
+    if (!s)
+        return;
+
+    ArchiveDoState(p);
+    p.Do(priority);
+}
+
 } // namespace FS
 } // namespace Service
@@ -19,5 +19,8 @@ public:
     }
 };
 
+/// Saves or restores the state of the FS services, including the open archives
+void DoState(PointerWrap& p);
+
 } // namespace FS
 } // namespace Service
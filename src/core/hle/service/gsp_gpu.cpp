@@ -292,7 +292,8 @@ static void SetBufferSwap(Service::Interface* self) {
 /**
  * GSP_GPU::FlushDataCache service function
  *
- * This Function is a no-op, We aren't emulating the CPU cache any time soon.
+ * We aren't emulating the CPU cache any time soon, this only waits for the GPU thread to finish
+ * its pending work, so that memory shared with the GPU is up to date.
  *
  *  Inputs:
  *      1 : Address
@@ -308,6 +309,8 @@ static void FlushDataCache(Service::Interface* self) {
     u32 size    = cmd_buff[2];
     u32 process = cmd_buff[4];
 
+    GPU::WaitForIdle();
+
     // TODO(purpasmart96): Verify return header on HW
 
     cmd_buff[1] = RESULT_SUCCESS.raw; // No error
@@ -736,4 +739,16 @@ Interface::~Interface() {
     gpu_right_acquired = false;
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("GSP_GPU", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, g_interrupt_event);
+    Kernel::DoObjectRef(p, g_shared_memory);
+    p.Do(g_thread_id);
+    p.Do(gpu_right_acquired);
+    p.Do(first_initialization);
+}
+
 } // namespace
@@ -205,4 +205,8 @@ ResultCode SetBufferSwap(u32 screen_id, const FrameBufferInfo& info);
  * @returns FramebufferUpdate Information about the specified framebuffer.
  */
 FrameBufferUpdate* GetFrameBufferInfo(u32 thread_id, u32 screen_index);
+
+/// Saves or restores the state of the GSP service
+void DoState(PointerWrap& p);
+
 } // namespace
@@ -310,6 +310,25 @@ void Shutdown() {
     event_debug_pad = nullptr;
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("HID", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, shared_mem);
+    Kernel::DoObjectRef(p, event_pad_or_touch_1);
+    Kernel::DoObjectRef(p, event_pad_or_touch_2);
+    Kernel::DoObjectRef(p, event_accelerometer);
+    Kernel::DoObjectRef(p, event_gyroscope);
+    Kernel::DoObjectRef(p, event_debug_pad);
+    p.Do(next_pad_index);
+    p.Do(next_touch_index);
+    p.Do(next_accelerometer_index);
+    p.Do(next_gyroscope_index);
+    p.Do(enable_accelerometer_count);
+    p.Do(enable_gyroscope_count);
+}
+
 } // namespace HID
 
 } // namespace Service
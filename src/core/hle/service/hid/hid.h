@@ -14,6 +14,8 @@
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace Service {
 
 class Interface;
@@ -306,5 +308,8 @@ void Init();
 /// Shutdown HID service
 void Shutdown();
 
+/// Saves or restores the state of the HID services
+void DoState(PointerWrap& p);
+
 }
 }
@@ -111,6 +111,17 @@ void Shutdown() {
     conn_status_event = nullptr;
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("IR", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, handle_event);
+    Kernel::DoObjectRef(p, conn_status_event);
+    Kernel::DoObjectRef(p, shared_memory);
+    Kernel::DoObjectRef(p, transfer_shared_memory);
+}
+
 } // namespace IR
 
 } // namespace Service
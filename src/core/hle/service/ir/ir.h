@@ -73,5 +73,8 @@ void Init();
 /// Shutdown IR service
 void Shutdown();
 
+/// Saves or restores the state of the IR services
+void DoState(PointerWrap& p);
+
 } // namespace IR
 } // namespace Service
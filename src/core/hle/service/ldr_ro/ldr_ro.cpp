@@ -745,4 +745,13 @@ Interface::Interface() {
     memory_synchronizer.Clear();
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("LDR_RO", 1);
+    if (!s)
+        return;
+
+    memory_synchronizer.DoState(p);
+    p.Do(loaded_crs);
+}
+
 } // namespace
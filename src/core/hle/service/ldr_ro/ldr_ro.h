@@ -20,4 +20,7 @@ public:
     }
 };
 
+/// Saves or restores the state of the LDR:RO service
+void DoState(PointerWrap& p);
+
 } // namespace
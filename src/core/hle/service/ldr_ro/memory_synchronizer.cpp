@@ -5,6 +5,7 @@
 #include <algorithm>
 
 #include "common/assert.h"
+#include "common/chunk_file.h"
 
 #include "core/hle/service/ldr_ro/memory_synchronizer.h"
 
@@ -43,4 +44,8 @@ void MemorySynchronizer::SynchronizeOriginalMemory() {
     }
 }
 
+void MemorySynchronizer::DoState(PointerWrap& p) {
+    p.DoPOD(memory_blocks);
+}
+
 } // namespace
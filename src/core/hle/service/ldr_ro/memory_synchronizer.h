@@ -8,6 +8,8 @@
 
 #include "core/memory.h"
 
+class PointerWrap;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Namespace LDR_RO
 
@@ -29,6 +31,8 @@ public:
 
     void SynchronizeOriginalMemory();
 
+    void DoState(PointerWrap& p);
+
 private:
     struct MemoryBlock {
         VAddr mapping;
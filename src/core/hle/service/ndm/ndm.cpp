@@ -232,5 +232,19 @@ void Shutdown() {
 
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("NDM", 1);
+    if (!s)
+        return;
+
+    p.Do(daemon_bit_mask);
+    p.Do(default_daemon_bit_mask);
+    p.Do(daemon_status);
+    p.Do(exclusive_state);
+    p.Do(scan_interval);
+    p.Do(retry_interval);
+    p.Do(daemon_lock_enabled);
+}
+
 }// namespace NDM
 }// namespace Service
@@ -252,5 +252,8 @@ void Init();
 /// Shutdown NDM service
 void Shutdown();
 
+/// Saves or restores the state of the NDM service
+void DoState(PointerWrap& p);
+
 }// namespace NDM
 }// namespace Service
@@ -147,4 +147,12 @@ Interface::~Interface() {
     handle_event = nullptr;
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("NWM_UDS", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, handle_event);
+}
+
 } // namespace
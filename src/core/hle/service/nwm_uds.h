@@ -23,4 +23,7 @@ public:
     }
 };
 
+/// Saves or restores the state of the NWM_UDS service
+void DoState(PointerWrap& p);
+
 } // namespace
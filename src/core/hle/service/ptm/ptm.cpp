@@ -140,5 +140,14 @@ void Shutdown() {
 
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("PTM", 1);
+    if (!s)
+        return;
+
+    p.Do(shell_open);
+    p.Do(battery_is_charging);
+}
+
 } // namespace PTM
 } // namespace Service
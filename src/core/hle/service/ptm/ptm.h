@@ -102,5 +102,8 @@ void Init();
 /// Shutdown the PTM service
 void Shutdown();
 
+/// Saves or restores the state of the PTM services
+void DoState(PointerWrap& p);
+
 } // namespace PTM
 } // namespace Service
@@ -5,6 +5,7 @@
 #include "common/logging/log.h"
 #include "common/string_util.h"
 
+#include "core/hle/profiler.h"
 #include "core/hle/service/service.h"
 #include "core/hle/service/ac_u.h"
 #include "core/hle/service/act_a.h"
@@ -32,6 +33,7 @@
 #include "core/hle/service/dlp/dlp.h"
 #include "core/hle/service/frd/frd.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/hle/service/fs/fs_user.h"
 #include "core/hle/service/cfg/cfg.h"
 #include "core/hle/service/hid/hid.h"
 #include "core/hle/service/ir/ir.h"
@@ -75,11 +77,32 @@ ResultVal<bool> Interface::SyncRequest() {
     }
     LOG_TRACE(Service, "%s", MakeFunctionString(itr->second.name, GetPortName().c_str(), cmd_buff).c_str());
 
+    HLE::Profiler::ScopedCall profile_scope(GetProfilerId(itr->second));
     itr->second.func(this);
 
     return MakeResult<bool>(false); // TODO: Implement return from actual function
 }
 
+HLE::Profiler::CallId Interface::GetProfilerId(const FunctionInfo& info) {
+    auto itr = m_profiler_ids.find(info.id);
+    if (itr != m_profiler_ids.end())
+        return itr->second;
+
+    // The port name can't be queried from Register() since it's called from the constructor of the
+    // derived class, so functions are registered with the profiler lazily on their first call.
+    HLE::Profiler::CallId profiler_id = HLE::Profiler::RegisterCall(
+            HLE::Profiler::CallCategory::Service, GetPortName(), info.id, info.name);
+    m_profiler_ids.emplace(info.id, profiler_id);
+    return profiler_id;
+}
+
+void Interface::SaveRecord(PointerWrap& p) {
+    SessionRecordType type = SessionRecordType::Service;
+    std::string port_name = GetPortName();
+    p.Do(type);
+    p.Do(port_name);
+}
+
 void Interface::Register(const FunctionInfo* functions, size_t n) {
     m_functions.reserve(n);
     for (size_t i = 0; i < n; ++i) {
@@ -164,5 +187,76 @@ void Shutdown() {
     LOG_DEBUG(Service, "shutdown OK");
 }
 
+/// Finds the service interface with the given port name, among both kinds of ports
+static Kernel::SharedPtr<Interface> FindInterface(const std::string& port_name) {
+    auto itr = g_kernel_named_ports.find(port_name);
+    if (itr != g_kernel_named_ports.end())
+        return itr->second;
+
+    itr = g_srv_services.find(port_name);
+    if (itr != g_srv_services.end())
+        return itr->second;
+
+    return nullptr;
+}
+
+void DoSessionRecord(PointerWrap& p, Kernel::SharedPtr<Kernel::Session>& session) {
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        session->SaveRecord(p);
+        return;
+    }
+
+    SessionRecordType type;
+    p.Do(type);
+
+    switch (type) {
+    case SessionRecordType::Service: {
+        std::string port_name;
+        p.Do(port_name);
+        session = FindInterface(port_name);
+        if (session == nullptr)
+            LOG_ERROR(Service, "Savestate references unknown service %s", port_name.c_str());
+        break;
+    }
+    case SessionRecordType::File:
+        session = FS::File::LoadRecord(p);
+        break;
+    case SessionRecordType::Directory:
+        session = FS::Directory::LoadRecord(p);
+        break;
+    default:
+        LOG_ERROR(Service, "Savestate contains unknown session type %u", static_cast<u32>(type));
+        session = nullptr;
+        break;
+    }
+
+    if (session == nullptr)
+        p.SetError(PointerWrap::ERROR_FAILURE);
+}
+
+void DoState(PointerWrap& p) {
+    FS::DoState(p);
+    AM::DoState(p);
+    APT::DoState(p);
+    CAM::DoState(p);
+    CECD::DoState(p);
+    CFG::DoState(p);
+    FRD::DoState(p);
+    HID::DoState(p);
+    IR::DoState(p);
+    NDM::DoState(p);
+    PTM::DoState(p);
+
+    CSND_SND::DoState(p);
+    DSP_DSP::DoState(p);
+    GSP_GPU::DoState(p);
+    LDR_RO::DoState(p);
+    NWM_UDS::DoState(p);
+    SOC_U::DoState(p);
+    SRV::DoState(p);
+    SSL_C::DoState(p);
+    Y2R_U::DoState(p);
+}
+
 
 }
@@ -13,6 +13,7 @@
 #include "common/common_types.h"
 
 #include "core/hle/kernel/session.h"
+#include "core/hle/profiler.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -22,6 +23,16 @@ namespace Service {
 
 static const int kMaxPortSize = 8; ///< Maximum size of a port name (8 characters)
 
+/// Kinds of HLE sessions, as recorded in savestates by Kernel::Session::SaveRecord.
+enum class SessionRecordType : u32 {
+    /// A service interface, found again by its port name
+    Service   = 0,
+    /// A file opened from an archive, see FS::File::LoadRecord
+    File      = 1,
+    /// A directory opened from an archive, see FS::Directory::LoadRecord
+    Directory = 2,
+};
+
 /// Interface to a CTROS service
 class Interface : public Kernel::Session {
     // TODO(yuriks): An "Interface" being a Kernel::Object is mostly non-sense. Interface should be
@@ -47,6 +58,7 @@ public:
     }
 
     ResultVal<bool> SyncRequest() override;
+    void SaveRecord(PointerWrap& p) override;
 
 protected:
 
@@ -61,7 +73,11 @@ protected:
     void Register(const FunctionInfo* functions, size_t n);
 
 private:
+    /// Returns the profiler id of a function, registering it with the HLE profiler if needed
+    HLE::Profiler::CallId GetProfilerId(const FunctionInfo& info);
+
     boost::container::flat_map<u32, FunctionInfo> m_functions;
+    boost::container::flat_map<u32, HLE::Profiler::CallId> m_profiler_ids;
 
 };
 
@@ -71,6 +87,18 @@ void Init();
 /// Shutdown ServiceManager
 void Shutdown();
 
+/**
+ * Saves a session to the kernel object table of a savestate, or finds or recreates it when
+ * loading. Sets an error on the serializer if the session can't be restored.
+ */
+void DoSessionRecord(PointerWrap& p, Kernel::SharedPtr<Kernel::Session>& session);
+
+/**
+ * Saves or restores the state of the HLE services. Host resources used by the services, such as
+ * the contents of archives and network sockets, aren't part of savestates.
+ */
+void DoState(PointerWrap& p);
+
 /// Map of named ports managed by the kernel, which can be retrieved using the ConnectToPort SVC.
 extern std::unordered_map<std::string, Kernel::SharedPtr<Interface>> g_kernel_named_ports;
 /// Map of services registered with the "srv:" service, retrieved using GetServiceHandle.
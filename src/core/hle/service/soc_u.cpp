@@ -819,6 +819,7 @@ static void GetSockOpt(Service::Interface* self) {
         // + 0x4 = 2nd pointer (u32) position
         // >> 2  = convert to u32 offset instead of byte offset (cmd_buffer = u32*)
         char* optval = reinterpret_cast<char *>(Memory::GetPointer(cmd_buffer[0x104 >> 2]));
+        Memory::MarkRegionDirty(cmd_buffer[0x104 >> 2], optlen);
 
         ret = ::getsockopt(socket_handle, level, optname, optval, &optlen);
         err = 0;
@@ -914,4 +915,10 @@ Interface::~Interface() {
 #endif
 }
 
+void DoState(PointerWrap& p) {
+    // Sockets are host resources, which savestates can't capture
+    if (p.GetMode() == PointerWrap::MODE_WRITE && !open_sockets.empty())
+        LOG_WARNING(Service_SOC, "Open sockets aren't saved in savestates");
+}
+
 } // namespace
@@ -23,4 +23,7 @@ public:
     }
 };
 
+/// Saves or restores the state of the SOC service
+void DoState(PointerWrap& p);
+
 } // namespace
@@ -178,4 +178,12 @@ Interface::~Interface() {
     event_handle = nullptr;
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("SRV", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, event_handle);
+}
+
 } // namespace SRV
@@ -20,4 +20,7 @@ public:
     }
 };
 
+/// Saves or restores the state of the service manager
+void DoState(PointerWrap& p);
+
 } // namespace
@@ -3,9 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <random>
+#include <sstream>
+#include <string>
 
 #include "common/common_types.h"
 #include "core/hle/service/ssl_c.h"
+#include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Namespace SSL_C
@@ -19,8 +22,12 @@ static void Initialize(Service::Interface* self) {
     u32* cmd_buff = Kernel::GetCommandBuffer();
 
     // Seed random number generator when the SSL service is initialized
-    std::random_device rand_device;
-    rand_gen.seed(rand_device());
+    if (Settings::values.use_deterministic_mode) {
+        rand_gen.seed(std::mt19937::default_seed);
+    } else {
+        std::random_device rand_device;
+        rand_gen.seed(rand_device());
+    }
 
     // Stub, return success
     cmd_buff[1] = RESULT_SUCCESS.raw;
@@ -88,4 +95,19 @@ Interface::Interface() {
     Register(FunctionTable);
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("SSL_C", 1);
+    if (!s)
+        return;
+
+    std::stringstream rand_gen_state;
+    rand_gen_state << rand_gen;
+    std::string state = rand_gen_state.str();
+    p.Do(state);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        rand_gen_state.str(state);
+        rand_gen_state >> rand_gen;
+    }
+}
+
 } // namespace
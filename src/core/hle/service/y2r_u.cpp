@@ -772,4 +772,17 @@ Interface::~Interface() {
     completion_event = nullptr;
 }
 
+void DoState(PointerWrap& p) {
+    auto s = p.Section("Y2R_U", 1);
+    if (!s)
+        return;
+
+    Kernel::DoObjectRef(p, completion_event);
+    p.Do(conversion);
+    p.Do(dithering_weight_params);
+    p.Do(temporal_dithering_enabled);
+    p.Do(transfer_end_interrupt_enabled);
+    p.Do(spacial_dithering_enabled);
+}
+
 } // namespace
@@ -139,4 +139,7 @@ public:
     }
 };
 
+/// Saves or restores the state of the Y2R service
+void DoState(PointerWrap& p);
+
 } // namespace
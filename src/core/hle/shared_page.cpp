@@ -8,6 +8,7 @@
 
 #include "core/core_timing.h"
 #include "core/hle/shared_page.h"
+#include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -17,8 +18,15 @@ SharedPageDef shared_page;
 
 static int update_time_event;
 
+/// Milliseconds between the 3DS epoch (Jan 1900) and Jan 1 2000
+static const u64 CONSOLE_TIME_2000 = 3155673600000ULL;
+
 /// Gets system time in 3DS format. The epoch is Jan 1900, and the unit is millisecond.
 static u64 GetSystemTime() {
+    // Deterministic runs start on Jan 1 2000 and advance with the emulated clock
+    if (Settings::values.use_deterministic_mode)
+        return CONSOLE_TIME_2000 + cyclesToMs(CoreTiming::GetTicks());
+
     auto now = std::chrono::system_clock::now();
 
     // 3DS system does't allow user to set a time before Jan 1 2000,
@@ -35,7 +43,7 @@ static u64 GetSystemTime() {
 
     // 3DS console time uses Jan 1 1900 as internal epoch,
     // so we use the milliseconds between 1900 and 2000 as base console time
-    u64 console_time = 3155673600000ULL;
+    u64 console_time = CONSOLE_TIME_2000;
 
     // Only when system time is after 2000, we set it as 3DS system time
     if (now > epoch) {
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
 #include <map>
 
 #include "common/logging/log.h"
@@ -28,6 +29,7 @@
 #include "core/hle/kernel/vm_manager.h"
 
 #include "core/hle/function_wrappers.h"
+#include "core/hle/profiler.h"
 #include "core/hle/result.h"
 #include "core/hle/service/service.h"
 
@@ -1095,14 +1097,32 @@ static const FunctionDef* GetSVCInfo(u32 func_num) {
     return &SVC_Table[func_num];
 }
 
+/// HLE profiler ids of the implemented SVCs, indexed by SVC number
+static std::array<HLE::Profiler::CallId, ARRAY_SIZE(SVC_Table)> svc_profiler_ids;
+static bool svc_profiler_ids_registered = false;
+
+static void RegisterSVCProfilerIds() {
+    for (size_t i = 0; i < ARRAY_SIZE(SVC_Table); ++i) {
+        if (SVC_Table[i].func != nullptr) {
+            svc_profiler_ids[i] = HLE::Profiler::RegisterCall(HLE::Profiler::CallCategory::SVC, "",
+                                                              static_cast<u32>(i), SVC_Table[i].name);
+        }
+    }
+    svc_profiler_ids_registered = true;
+}
+
 MICROPROFILE_DEFINE(Kernel_SVC, "Kernel", "SVC", MP_RGB(70, 200, 70));
 
 void CallSVC(u32 immediate) {
     MICROPROFILE_SCOPE(Kernel_SVC);
 
+    if (!svc_profiler_ids_registered)
+        RegisterSVCProfilerIds();
+
     const FunctionDef* info = GetSVCInfo(immediate);
     if (info) {
         if (info->func) {
+            HLE::Profiler::ScopedCall profile_scope(svc_profiler_ids[immediate]);
             info->func();
         } else {
             LOG_ERROR(Kernel_SVC, "unimplemented SVC function %s(..)", info->name);
@@ -3,14 +3,17 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <memory>
 #include <numeric>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
-#include "common/color.h"
+#include "common/chunk_file.h"
+#include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
-#include "common/vector_math.h"
 
 #include "core/settings.h"
 #include "core/memory.h"
@@ -21,13 +24,14 @@
 
 #include "core/hw/hw.h"
 #include "core/hw/gpu.h"
+#include "core/hw/gpu_thread.h"
 
 #include "core/tracer/recorder.h"
 
 #include "video_core/command_processor.h"
+#include "video_core/gpu_transfer.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
-#include "video_core/utils.h"
 #include "video_core/video_core.h"
 
 #include "video_core/debug_utils/debug_utils.h"
@@ -59,34 +63,212 @@ inline void Read(T &var, const u32 raw_addr) {
         return;
     }
 
+    // Finish the pending work first, as it may update the register
+    WaitForIdle();
+
     var = g_regs[addr / 4];
 }
 
-static Math::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
-    switch (input_format) {
-    case Regs::PixelFormat::RGBA8:
-        return Color::DecodeRGBA8(src_pixel);
+MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
+MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
+
+/// Thread running the GPU commands when asynchronous GPU emulation is enabled
+static std::unique_ptr<GPUThread> gpu_thread;
+/// Event id for CoreTiming, used to raise the interrupts of the GPU thread on the emulation thread
+static int interrupt_event;
+
+static void InterruptCallback(u64 userdata, int cycles_late) {
+    GSP_GPU::SignalInterrupt(static_cast<GSP_GPU::InterruptId>(userdata));
+}
 
-    case Regs::PixelFormat::RGB8:
-        return Color::DecodeRGB8(src_pixel);
+void SignalInterrupt(GSP_GPU::InterruptId interrupt_id) {
+    if (gpu_thread && gpu_thread->IsGPUThread()) {
+        // The GSP shared memory and the kernel may only be touched by the emulation thread
+        CoreTiming::ScheduleEvent_Threadsafe(0, interrupt_event, static_cast<u64>(interrupt_id));
+    } else {
+        GSP_GPU::SignalInterrupt(interrupt_id);
+    }
+}
 
-    case Regs::PixelFormat::RGB565:
-        return Color::DecodeRGB565(src_pixel);
+void WaitForIdle() {
+    if (gpu_thread)
+        gpu_thread->WaitIdle();
+}
 
-    case Regs::PixelFormat::RGB5A1:
-        return Color::DecodeRGB5A1(src_pixel);
+static void MemoryFill(const Regs::MemoryFillConfig& config, bool is_second_filler) {
+    u8* start = Memory::GetPhysicalPointer(config.GetStartAddress());
+    u8* end = Memory::GetPhysicalPointer(config.GetEndAddress());
+
+    // The rasterizer clears the cached surfaces within the fill and leaves the memory between
+    // them to be filled here, lined up with the values of the whole fill
+    std::vector<std::pair<PAddr, PAddr>> cpu_fill_regions;
+    if (VideoCore::g_renderer->Rasterizer()->AccelerateFill(config, cpu_fill_regions)) {
+        for (const auto& region : cpu_fill_regions) {
+            VideoCore::MemoryFillPart(config, start, end, start + (region.first - config.GetStartAddress()),
+                                      start + (region.second - config.GetStartAddress()));
+        }
+    } else {
+        Memory::RasterizerFlushAndInvalidateRegion(config.GetStartAddress(), config.GetEndAddress() - config.GetStartAddress());
+        VideoCore::MemoryFill(config, start, end);
+    }
+    Memory::MarkRegionDirty(Memory::PhysicalToVirtualAddress(config.GetStartAddress()),
+                            config.GetEndAddress() - config.GetStartAddress());
 
-    case Regs::PixelFormat::RGBA4:
-        return Color::DecodeRGBA4(src_pixel);
+    LOG_TRACE(HW_GPU, "MemoryFill from 0x%08x to 0x%08x", config.GetStartAddress(), config.GetEndAddress());
 
-    default:
-        LOG_ERROR(HW_GPU, "Unknown source framebuffer format %x", input_format);
-        return {0, 0, 0, 0};
+    if (!is_second_filler) {
+        GPU::SignalInterrupt(GSP_GPU::InterruptId::PSC0);
+    } else {
+        GPU::SignalInterrupt(GSP_GPU::InterruptId::PSC1);
     }
 }
 
-MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
-MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
+static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
+    MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+
+    if (Pica::g_debug_context)
+        Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer, nullptr);
+
+    if (!VideoCore::g_renderer->Rasterizer()->AccelerateDisplayTransfer(config)) {
+        u8* src_pointer = Memory::GetPhysicalPointer(config.GetPhysicalInputAddress());
+        u8* dst_pointer = Memory::GetPhysicalPointer(config.GetPhysicalOutputAddress());
+
+        if (config.is_texture_copy) {
+            u32 input_width = config.texture_copy.input_width * 16;
+            u32 input_gap = config.texture_copy.input_gap * 16;
+            u32 output_width = config.texture_copy.output_width * 16;
+            u32 output_gap = config.texture_copy.output_gap * 16;
+
+            size_t contiguous_input_size = config.texture_copy.size / input_width * (input_width + input_gap);
+            Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), static_cast<u32>(contiguous_input_size));
+
+            size_t contiguous_output_size = config.texture_copy.size / output_width * (output_width + output_gap);
+            Memory::RasterizerFlushAndInvalidateRegion(config.GetPhysicalOutputAddress(), static_cast<u32>(contiguous_output_size));
+            Memory::MarkRegionDirty(Memory::PhysicalToVirtualAddress(config.GetPhysicalOutputAddress()),
+                                    static_cast<u32>(contiguous_output_size));
+
+            u32 remaining_size = config.texture_copy.size;
+            u32 remaining_input = input_width;
+            u32 remaining_output = output_width;
+            while (remaining_size > 0) {
+                u32 copy_size = std::min({ remaining_input, remaining_output, remaining_size });
+
+                std::memcpy(dst_pointer, src_pointer, copy_size);
+                src_pointer += copy_size;
+                dst_pointer += copy_size;
+
+                remaining_input -= copy_size;
+                remaining_output -= copy_size;
+                remaining_size -= copy_size;
+
+                if (remaining_input == 0) {
+                    remaining_input = input_width;
+                    src_pointer += input_gap;
+                }
+                if (remaining_output == 0) {
+                    remaining_output = output_width;
+                    dst_pointer += output_gap;
+                }
+            }
+
+            LOG_TRACE(HW_GPU, "TextureCopy: 0x%X bytes from 0x%08X(%u+%u)-> 0x%08X(%u+%u), flags 0x%08X",
+                config.texture_copy.size,
+                config.GetPhysicalInputAddress(), input_width, input_gap,
+                config.GetPhysicalOutputAddress(), output_width, output_gap,
+                config.flags);
+
+            GPU::SignalInterrupt(GSP_GPU::InterruptId::PPF);
+            return;
+        }
+
+        if (config.scaling > config.ScaleXY) {
+            LOG_CRITICAL(HW_GPU, "Unimplemented display transfer scaling mode %u", config.scaling.Value());
+            UNIMPLEMENTED();
+            return;
+        }
+
+        if (config.input_linear && config.scaling != config.NoScale) {
+            LOG_CRITICAL(HW_GPU, "Scaling is only implemented on tiled input");
+            UNIMPLEMENTED();
+            return;
+        }
+
+        int horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+        int vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+
+        u32 output_width = config.output_width >> horizontal_scale;
+        u32 output_height = config.output_height >> vertical_scale;
+
+        u32 input_size = config.input_width * config.input_height * GPU::Regs::BytesPerPixel(config.input_format);
+        u32 output_size = output_width * output_height * GPU::Regs::BytesPerPixel(config.output_format);
+
+        Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
+        Memory::RasterizerFlushAndInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
+        Memory::MarkRegionDirty(Memory::PhysicalToVirtualAddress(config.GetPhysicalOutputAddress()), output_size);
+
+        VideoCore::DisplayTransfer(config, src_pointer, dst_pointer);
+
+        LOG_TRACE(HW_GPU, "DisplayTriggerTransfer: 0x%08x bytes from 0x%08x(%ux%u)-> 0x%08x(%ux%u), dst format %x, flags 0x%08X",
+              config.output_height * output_width * GPU::Regs::BytesPerPixel(config.output_format),
+              config.GetPhysicalInputAddress(), config.input_width.Value(), config.input_height.Value(),
+              config.GetPhysicalOutputAddress(), output_width, output_height,
+              config.output_format.Value(), config.flags);
+    }
+
+    GPU::SignalInterrupt(GSP_GPU::InterruptId::PPF);
+}
+
+static void ExecuteCommand(const Command& command) {
+    switch (command.type) {
+    case Command::Type::ProcessCommandList:
+    {
+        MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+        Pica::CommandProcessor::ProcessCommandList(command.command_list.list, command.command_list.size);
+        break;
+    }
+
+    case Command::Type::MemoryFill:
+        MemoryFill(command.GetMemoryFillConfig(), command.memory_fill.is_second_filler);
+        break;
+
+    case Command::Type::DisplayTransfer:
+        DisplayTransfer(command.GetDisplayTransferConfig());
+        break;
+    }
+}
+
+/// Returns whether GPU commands should be handed over to the GPU thread
+static bool UseGPUThread() {
+    // The CiTrace recorder logs memory accesses of the command processor in order with the
+    // register writes of the emulation thread
+    if (Pica::g_debug_context && Pica::g_debug_context->recorder)
+        return false;
+
+    return VideoCore::g_async_gpu_enabled && VideoCore::g_renderer->Rasterizer()->SupportsGPUThread();
+}
+
+/// Copies `count` consecutive registers starting at `index` into `dest`
+static void CopyRegs(u32* dest, u32 index, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        dest[i] = g_regs[index + i];
+}
+
+static void SubmitCommand(const Command& command) {
+    const bool use_gpu_thread = UseGPUThread();
+
+    // Commands queued before the GPU thread was disabled still need to run first
+    if (!use_gpu_thread)
+        WaitForIdle();
+
+    // Nothing is queued when switching to the GPU thread, as the previous command ran here
+    VideoCore::g_renderer->Rasterizer()->SetGPUThreadActive(use_gpu_thread);
+
+    if (use_gpu_thread) {
+        gpu_thread->Push(command);
+    } else {
+        ExecuteCommand(command);
+    }
+}
 
 template <typename T>
 inline void Write(u32 addr, const T data) {
@@ -112,51 +294,14 @@ inline void Write(u32 addr, const T data) {
 
         if (config.trigger) {
             if (config.address_start) { // Some games pass invalid values here
-                u8* start = Memory::GetPhysicalPointer(config.GetStartAddress());
-                u8* end = Memory::GetPhysicalPointer(config.GetEndAddress());
-
-                // TODO: Consider always accelerating and returning vector of
-                //       regions that the accelerated fill did not cover to
-                //       reduce/eliminate the fill that the cpu has to do.
-                //       This would also mean that the flush below is not needed.
-                //       Fill should first flush all surfaces that touch but are
-                //       not completely within the fill range.
-                //       Then fill all completely covered surfaces, and return the
-                //       regions that were between surfaces or within the touching
-                //       ones for cpu to manually fill here.
-                if (!VideoCore::g_renderer->Rasterizer()->AccelerateFill(config)) {
-                    Memory::RasterizerFlushAndInvalidateRegion(config.GetStartAddress(), config.GetEndAddress() - config.GetStartAddress());
-
-                    if (config.fill_24bit) {
-                        // fill with 24-bit values
-                        for (u8* ptr = start; ptr < end; ptr += 3) {
-                            ptr[0] = config.value_24bit_r;
-                            ptr[1] = config.value_24bit_g;
-                            ptr[2] = config.value_24bit_b;
-                        }
-                    } else if (config.fill_32bit) {
-                        // fill with 32-bit values
-                        if (end > start) {
-                            u32 value = config.value_32bit;
-                            size_t len = (end - start) / sizeof(u32);
-                            for (size_t i = 0; i < len; ++i)
-                                memcpy(&start[i * sizeof(u32)], &value, sizeof(u32));
-                        }
-                    } else {
-                        // fill with 16-bit values
-                        u16 value_16bit = config.value_16bit.Value();
-                        for (u8* ptr = start; ptr < end; ptr += sizeof(u16))
-                            memcpy(ptr, &value_16bit, sizeof(u16));
-                    }
-                }
-
-                LOG_TRACE(HW_GPU, "MemoryFill from 0x%08x to 0x%08x", config.GetStartAddress(), config.GetEndAddress());
-
-                if (!is_second_filler) {
-                    GSP_GPU::SignalInterrupt(GSP_GPU::InterruptId::PSC0);
-                } else {
-                    GSP_GPU::SignalInterrupt(GSP_GPU::InterruptId::PSC1);
-                }
+                Command command;
+                command.type = Command::Type::MemoryFill;
+                // The trigger is at the same offset in both fillers
+                const u32 config_index = index - GPU_REG_INDEX(memory_fill_config[0].trigger) +
+                                         GPU_REG_INDEX(memory_fill_config[0]);
+                CopyRegs(command.memory_fill.config, config_index, ARRAY_SIZE(command.memory_fill.config));
+                command.memory_fill.is_second_filler = is_second_filler;
+                SubmitCommand(command);
             }
 
             // Reset "trigger" flag and set the "finish" flag
@@ -169,193 +314,15 @@ inline void Write(u32 addr, const T data) {
 
     case GPU_REG_INDEX(display_transfer_config.trigger):
     {
-        MICROPROFILE_SCOPE(GPU_DisplayTransfer);
-
         const auto& config = g_regs.display_transfer_config;
         if (config.trigger & 1) {
-
-            if (Pica::g_debug_context)
-                Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer, nullptr);
-
-            if (!VideoCore::g_renderer->Rasterizer()->AccelerateDisplayTransfer(config)) {
-                u8* src_pointer = Memory::GetPhysicalPointer(config.GetPhysicalInputAddress());
-                u8* dst_pointer = Memory::GetPhysicalPointer(config.GetPhysicalOutputAddress());
-
-                if (config.is_texture_copy) {
-                    u32 input_width = config.texture_copy.input_width * 16;
-                    u32 input_gap = config.texture_copy.input_gap * 16;
-                    u32 output_width = config.texture_copy.output_width * 16;
-                    u32 output_gap = config.texture_copy.output_gap * 16;
-
-                    size_t contiguous_input_size = config.texture_copy.size / input_width * (input_width + input_gap);
-                    Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), static_cast<u32>(contiguous_input_size));
-
-                    size_t contiguous_output_size = config.texture_copy.size / output_width * (output_width + output_gap);
-                    Memory::RasterizerFlushAndInvalidateRegion(config.GetPhysicalOutputAddress(), static_cast<u32>(contiguous_output_size));
-
-                    u32 remaining_size = config.texture_copy.size;
-                    u32 remaining_input = input_width;
-                    u32 remaining_output = output_width;
-                    while (remaining_size > 0) {
-                        u32 copy_size = std::min({ remaining_input, remaining_output, remaining_size });
-
-                        std::memcpy(dst_pointer, src_pointer, copy_size);
-                        src_pointer += copy_size;
-                        dst_pointer += copy_size;
-
-                        remaining_input -= copy_size;
-                        remaining_output -= copy_size;
-                        remaining_size -= copy_size;
-
-                        if (remaining_input == 0) {
-                            remaining_input = input_width;
-                            src_pointer += input_gap;
-                        }
-                        if (remaining_output == 0) {
-                            remaining_output = output_width;
-                            dst_pointer += output_gap;
-                        }
-                    }
-
-                    LOG_TRACE(HW_GPU, "TextureCopy: 0x%X bytes from 0x%08X(%u+%u)-> 0x%08X(%u+%u), flags 0x%08X",
-                        config.texture_copy.size,
-                        config.GetPhysicalInputAddress(), input_width, input_gap,
-                        config.GetPhysicalOutputAddress(), output_width, output_gap,
-                        config.flags);
-
-                    GSP_GPU::SignalInterrupt(GSP_GPU::InterruptId::PPF);
-                    break;
-                }
-
-                if (config.scaling > config.ScaleXY) {
-                    LOG_CRITICAL(HW_GPU, "Unimplemented display transfer scaling mode %u", config.scaling.Value());
-                    UNIMPLEMENTED();
-                    break;
-                }
-
-                if (config.input_linear && config.scaling != config.NoScale) {
-                    LOG_CRITICAL(HW_GPU, "Scaling is only implemented on tiled input");
-                    UNIMPLEMENTED();
-                    break;
-                }
-
-                int horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
-                int vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
-
-                u32 output_width = config.output_width >> horizontal_scale;
-                u32 output_height = config.output_height >> vertical_scale;
-
-                u32 input_size = config.input_width * config.input_height * GPU::Regs::BytesPerPixel(config.input_format);
-                u32 output_size = output_width * output_height * GPU::Regs::BytesPerPixel(config.output_format);
-
-                Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
-                Memory::RasterizerFlushAndInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
-
-                for (u32 y = 0; y < output_height; ++y) {
-                    for (u32 x = 0; x < output_width; ++x) {
-                        Math::Vec4<u8> src_color;
-
-                        // Calculate the [x,y] position of the input image
-                        // based on the current output position and the scale
-                        u32 input_x = x << horizontal_scale;
-                        u32 input_y = y << vertical_scale;
-
-                        if (config.flip_vertically) {
-                            // Flip the y value of the output data,
-                            // we do this after calculating the [x,y] position of the input image
-                            // to account for the scaling options.
-                            y = output_height - y - 1;
-                        }
-
-                        u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-                        u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-                        u32 src_offset;
-                        u32 dst_offset;
-
-                        if (config.input_linear) {
-                            if (!config.dont_swizzle) {
-                                // Interpret the input as linear and the output as tiled
-                                u32 coarse_y = y & ~7;
-                                u32 stride = output_width * dst_bytes_per_pixel;
-
-                                src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                                dst_offset = VideoCore::GetMortonOffset(x, y, dst_bytes_per_pixel) + coarse_y * stride;
-                            } else {
-                                // Both input and output are linear
-                                src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                                dst_offset = (x + y * output_width) * dst_bytes_per_pixel;
-                            }
-                        } else {
-                            if (!config.dont_swizzle) {
-                                // Interpret the input as tiled and the output as linear
-                                u32 coarse_y = input_y & ~7;
-                                u32 stride = config.input_width * src_bytes_per_pixel;
-
-                                src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) + coarse_y * stride;
-                                dst_offset = (x + y * output_width) * dst_bytes_per_pixel;
-                            } else {
-                                // Both input and output are tiled
-                                u32 out_coarse_y = y & ~7;
-                                u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                                u32 in_coarse_y = input_y & ~7;
-                                u32 in_stride = config.input_width * src_bytes_per_pixel;
-
-                                src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) + in_coarse_y * in_stride;
-                                dst_offset = VideoCore::GetMortonOffset(x, y, dst_bytes_per_pixel) + out_coarse_y * out_stride;
-                            }
-                        }
-
-                        const u8* src_pixel = src_pointer + src_offset;
-                        src_color = DecodePixel(config.input_format, src_pixel);
-                        if (config.scaling == config.ScaleX) {
-                            Math::Vec4<u8> pixel = DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                            src_color = ((src_color + pixel) / 2).Cast<u8>();
-                        } else if (config.scaling == config.ScaleXY) {
-                            Math::Vec4<u8> pixel1 = DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                            Math::Vec4<u8> pixel2 = DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                            Math::Vec4<u8> pixel3 = DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                            src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
-                        }
-
-                        u8* dst_pixel = dst_pointer + dst_offset;
-                        switch (config.output_format) {
-                        case Regs::PixelFormat::RGBA8:
-                            Color::EncodeRGBA8(src_color, dst_pixel);
-                            break;
-
-                        case Regs::PixelFormat::RGB8:
-                            Color::EncodeRGB8(src_color, dst_pixel);
-                            break;
-
-                        case Regs::PixelFormat::RGB565:
-                            Color::EncodeRGB565(src_color, dst_pixel);
-                            break;
-
-                        case Regs::PixelFormat::RGB5A1:
-                            Color::EncodeRGB5A1(src_color, dst_pixel);
-                            break;
-
-                        case Regs::PixelFormat::RGBA4:
-                            Color::EncodeRGBA4(src_color, dst_pixel);
-                            break;
-
-                        default:
-                            LOG_ERROR(HW_GPU, "Unknown destination framebuffer format %x", config.output_format.Value());
-                            break;
-                        }
-                    }
-                }
-
-                LOG_TRACE(HW_GPU, "DisplayTriggerTransfer: 0x%08x bytes from 0x%08x(%ux%u)-> 0x%08x(%ux%u), dst format %x, flags 0x%08X",
-                      config.output_height * output_width * GPU::Regs::BytesPerPixel(config.output_format),
-                      config.GetPhysicalInputAddress(), config.input_width.Value(), config.input_height.Value(),
-                      config.GetPhysicalOutputAddress(), output_width, output_height,
-                      config.output_format.Value(), config.flags);
-            }
+            Command command;
+            command.type = Command::Type::DisplayTransfer;
+            CopyRegs(command.display_transfer, GPU_REG_INDEX(display_transfer_config),
+                     ARRAY_SIZE(command.display_transfer));
+            SubmitCommand(command);
 
             g_regs.display_transfer_config.trigger = 0;
-            GSP_GPU::SignalInterrupt(GSP_GPU::InterruptId::PPF);
         }
         break;
     }
@@ -366,15 +333,17 @@ inline void Write(u32 addr, const T data) {
         const auto& config = g_regs.command_processor_config;
         if (config.trigger & 1)
         {
-            MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
-
             u32* buffer = (u32*)Memory::GetPhysicalPointer(config.GetPhysicalAddress());
 
             if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
                 Pica::g_debug_context->recorder->MemoryAccessed((u8*)buffer, config.size * sizeof(u32), config.GetPhysicalAddress());
             }
 
-            Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            Command command;
+            command.type = Command::Type::ProcessCommandList;
+            command.command_list.list = buffer;
+            command.command_list.size = config.size;
+            SubmitCommand(command);
 
             g_regs.command_processor_config.trigger = 0;
         }
@@ -407,6 +376,9 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(u64 userdata, int cycles_late) {
+    // The frame is presented from emulated memory, so the GPU must be done rendering it
+    WaitForIdle();
+
     frame_count++;
     last_skip_frame = g_skip_frame;
     g_skip_frame = (frame_count & Settings::values.frame_skip) != 0;
@@ -474,12 +446,34 @@ void Init() {
     vblank_event = CoreTiming::RegisterEvent("GPU::VBlankCallback", VBlankCallback);
     CoreTiming::ScheduleEvent(frame_ticks, vblank_event);
 
+    interrupt_event = CoreTiming::RegisterEvent("GPU::InterruptCallback", InterruptCallback);
+    gpu_thread = std::make_unique<GPUThread>(ExecuteCommand);
+
     LOG_DEBUG(HW_GPU, "initialized OK");
 }
 
 /// Shutdown hardware
 void Shutdown() {
+    gpu_thread.reset();
+
     LOG_DEBUG(HW_GPU, "shutdown OK");
 }
 
+u64 GetFrameCount() {
+    return frame_count;
+}
+
+void DoState(PointerWrap& p) {
+    auto s = p.Section("GPU", 1);
+    if (!s)
+        return;
+
+    WaitForIdle();
+
+    p.DoVoid(&g_regs, sizeof(g_regs));
+    p.Do(frame_count);
+    p.Do(last_skip_frame);
+    p.Do(g_skip_frame);
+}
+
 } // namespace
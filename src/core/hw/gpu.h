@@ -12,6 +12,12 @@
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 
+class PointerWrap;
+
+namespace GSP_GPU {
+enum class InterruptId : u8;
+}
+
 namespace GPU {
 
 // Returns index corresponding to the Regs member labeled by field_name
@@ -326,5 +332,23 @@ void Init();
 /// Shutdown hardware
 void Shutdown();
 
+/// Returns the number of VBlanks emulated since the hardware was initialized
+u64 GetFrameCount();
+
+/// Saves or restores the hardware registers
+void DoState(PointerWrap& p);
+
+/**
+ * Signals a GPU interrupt to the application. Interrupts raised on the GPU thread are delivered
+ * by the emulation thread, at the next CoreTiming event check.
+ */
+void SignalInterrupt(GSP_GPU::InterruptId interrupt_id);
+
+/**
+ * Waits until the GPU thread has run all submitted commands, so that the emulation thread sees
+ * their effects on memory and on the rasterizer state.
+ */
+void WaitForIdle();
+
 
 } // namespace
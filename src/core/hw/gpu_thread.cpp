@@ -0,0 +1,77 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+
+#include "common/microprofile.h"
+#include "common/thread.h"
+
+#include "core/hw/gpu_thread.h"
+
+namespace GPU {
+
+GPUThread::GPUThread(Executor execute) : execute(std::move(execute)) {
+    thread = std::thread(&GPUThread::ThreadLoop, this);
+}
+
+GPUThread::~GPUThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    command_pushed.notify_one();
+    thread.join();
+}
+
+void GPUThread::Push(const Command& command) {
+    while (!queue.TryPush(command)) {
+        std::unique_lock<std::mutex> lock(mutex);
+        command_done.wait(lock, [this] { return !queue.Full(); });
+    }
+    num_pushed.store(num_pushed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    // Taking the mutex orders the push before the GPU thread checks the queue and goes to sleep
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    command_pushed.notify_one();
+}
+
+void GPUThread::WaitIdle() {
+    if (IsGPUThread())
+        return;
+
+    const u64 target = num_pushed.load(std::memory_order_relaxed);
+    if (num_done.load(std::memory_order_acquire) == target)
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    command_done.wait(lock, [this, target] { return num_done.load(std::memory_order_acquire) == target; });
+}
+
+void GPUThread::ThreadLoop() {
+    Common::SetCurrentThreadName("GPUThread");
+    MicroProfileOnThreadCreate("GPUThread");
+
+    while (true) {
+        Command command;
+        if (queue.TryPop(command)) {
+            execute(command);
+
+            num_done.store(num_done.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+            }
+            command_done.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        command_pushed.wait(lock, [this] { return stopping || !queue.Empty(); });
+        if (stopping && queue.Empty())
+            return;
+    }
+}
+
+} // namespace
@@ -0,0 +1,107 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "common/common_types.h"
+#include "common/spsc_queue.h"
+
+#include "core/hw/gpu.h"
+
+namespace GPU {
+
+/**
+ * Work submitted to the GPU, along with a copy of the registers configuring it. The registers are
+ * stored as plain words, since the BitField-based config structs can't be assigned, and are
+ * reinterpreted as their config struct when the command runs.
+ */
+struct Command {
+    enum class Type : u32 {
+        ProcessCommandList,
+        MemoryFill,
+        DisplayTransfer,
+    };
+
+    Type type;
+
+    union {
+        struct {
+            const u32* list;
+            u32 size;
+        } command_list;
+
+        struct {
+            u32 config[sizeof(Regs::MemoryFillConfig) / sizeof(u32)];
+            bool is_second_filler;
+        } memory_fill;
+
+        u32 display_transfer[sizeof(Regs::DisplayTransferConfig) / sizeof(u32)];
+    };
+
+    const Regs::MemoryFillConfig& GetMemoryFillConfig() const {
+        return *reinterpret_cast<const Regs::MemoryFillConfig*>(memory_fill.config);
+    }
+
+    const Regs::DisplayTransferConfig& GetDisplayTransferConfig() const {
+        return *reinterpret_cast<const Regs::DisplayTransferConfig*>(display_transfer);
+    }
+};
+
+/**
+ * Thread running the work submitted to the GPU while the emulated CPU keeps running. Commands are
+ * handed over through a lock-free queue and run in the order they were pushed. Only the emulation
+ * thread may push commands or wait for them.
+ */
+class GPUThread {
+public:
+    using Executor = std::function<void(const Command&)>;
+
+    /// @param execute Function running a command on the GPU thread
+    explicit GPUThread(Executor execute);
+
+    /// Runs the commands still queued, then stops the thread
+    ~GPUThread();
+
+    /// Queues a command, waiting for room in the queue if it's full
+    void Push(const Command& command);
+
+    /**
+     * Blocks until all queued commands have been run, making their results visible to the calling
+     * thread. Does nothing when called from the GPU thread itself.
+     */
+    void WaitIdle();
+
+    /// Returns whether the calling thread is the GPU thread
+    bool IsGPUThread() const {
+        return std::this_thread::get_id() == thread.get_id();
+    }
+
+private:
+    void ThreadLoop();
+
+    Executor execute;
+
+    Common::SPSCQueue<Command, 256> queue;
+
+    /// Number of commands pushed, only written by the emulation thread
+    std::atomic<u64> num_pushed{0};
+    /// Number of commands run, only written by the GPU thread
+    std::atomic<u64> num_done{0};
+
+    /// Only used to sleep until a command is pushed or done, the queue itself doesn't need it
+    std::mutex mutex;
+    std::condition_variable command_pushed;
+    std::condition_variable command_done;
+    bool stopping = false;
+
+    std::thread thread;
+};
+
+} // namespace
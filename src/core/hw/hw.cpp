@@ -99,4 +99,9 @@ void Shutdown() {
     LOG_DEBUG(HW, "shutdown OK");
 }
 
+void DoState(PointerWrap& p) {
+    GPU::DoState(p);
+    LCD::DoState(p);
+}
+
 }
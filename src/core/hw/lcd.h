@@ -13,6 +13,8 @@
 
 #define LCD_REG_INDEX(field_name) (offsetof(LCD::Regs, field_name) / sizeof(u32))
 
+class PointerWrap;
+
 namespace LCD {
 
 struct Regs {
@@ -85,4 +87,7 @@ void Init();
 /// Shutdown hardware
 void Shutdown();
 
+/// Saves or restores the hardware registers
+void DoState(PointerWrap& p);
+
 } // namespace
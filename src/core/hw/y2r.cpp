@@ -107,6 +107,7 @@ static void ReceiveData(u8* output, ConversionBuffer& buf, size_t amount_of_data
 static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data,
         OutputFormat output_format, u8 alpha) {
 
+    const VAddr start_address = buf.address;
     u8* output = Memory::GetPointer(buf.address);
 
     while (amount_of_data > 0) {
@@ -143,6 +144,8 @@ static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data
         buf.address += buf.transfer_unit + buf.gap;
         buf.image_size -= buf.transfer_unit;
     }
+
+    Memory::MarkRegionDirty(start_address, buf.address - start_address);
 }
 
 static const u8 linear_lut[64] = {
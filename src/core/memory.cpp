@@ -11,6 +11,7 @@
 #include "common/swap.h"
 
 #include "core/hle/kernel/process.h"
+#include "core/hw/gpu.h"
 #include "core/memory.h"
 #include "core/memory_setup.h"
 #include "core/mmio.h"
@@ -70,17 +71,26 @@ struct PageTable {
      * flushed before the memory is accessed
      */
     std::array<u8, NUM_ENTRIES> cached_res_count;
+
+    /**
+     * Indicates the pages written since the last call to TakeDirtyPages. Only the Write and
+     * *Block functions and MarkRegionDirty set it, writes through raw pointers aren't tracked.
+     */
+    std::array<bool, NUM_ENTRIES> dirty;
 };
 
 /// Singular page table used for the singleton process
 static PageTable main_page_table;
 /// Currently active page table
 static PageTable* current_page_table = &main_page_table;
+/// Whether any page was mapped or unmapped since the last call to TakeDirtyPages
+static bool mappings_changed = true;
 
 static void MapPages(u32 base, u32 size, u8* memory, PageType type) {
     LOG_DEBUG(HW_Memory, "Mapping %p onto %08X-%08X", memory, base * PAGE_SIZE, (base + size) * PAGE_SIZE);
 
     u32 end = base + size;
+    mappings_changed = true;
 
     while (base != end) {
         ASSERT_MSG(base < PageTable::NUM_ENTRIES, "out of range mapping at %08X", base);
@@ -94,6 +104,7 @@ static void MapPages(u32 base, u32 size, u8* memory, PageType type) {
         current_page_table->attributes[base] = type;
         current_page_table->pointers[base] = memory;
         current_page_table->cached_res_count[base] = 0;
+        current_page_table->dirty[base] = false;
 
         base += 1;
         if (memory != nullptr)
@@ -105,6 +116,8 @@ void InitMemoryMap() {
     main_page_table.pointers.fill(nullptr);
     main_page_table.attributes.fill(PageType::Unmapped);
     main_page_table.cached_res_count.fill(0);
+    main_page_table.dirty.fill(false);
+    mappings_changed = true;
 }
 
 void MapMemoryRegion(VAddr base, u32 size, u8* target) {
@@ -213,6 +226,7 @@ void Write(const VAddr vaddr, const T data) {
     if (page_pointer) {
         // NOTE: Avoid adding any extra logic to this fast-path block
         std::memcpy(&page_pointer[vaddr & PAGE_MASK], &data, sizeof(T));
+        current_page_table->dirty[vaddr >> PAGE_BITS] = true;
         return;
     }
 
@@ -229,6 +243,7 @@ void Write(const VAddr vaddr, const T data) {
         RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(vaddr), sizeof(T));
 
         std::memcpy(GetPointerFromVMA(vaddr), &data, sizeof(T));
+        current_page_table->dirty[vaddr >> PAGE_BITS] = true;
         break;
     }
     case PageType::Special:
@@ -273,6 +288,13 @@ u8* GetPointer(const VAddr vaddr) {
     }
 
     if (current_page_table->attributes[vaddr >> PAGE_BITS] == PageType::RasterizerCachedMemory) {
+        // Accesses through the pointer bypass the rasterizer, so a readback it still has in flight
+        // would land on top of them later. The caller may access any of the following cached pages.
+        VAddr end = (vaddr & ~PAGE_MASK) + PAGE_SIZE;
+        while (end != 0 && current_page_table->attributes[end >> PAGE_BITS] == PageType::RasterizerCachedMemory) {
+            end += PAGE_SIZE;
+        }
+        RasterizerFinishPendingWrites(VirtualToPhysicalAddress(vaddr), end - vaddr);
         return GetPointerFromVMA(vaddr);
     }
 
@@ -351,17 +373,50 @@ void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta) {
 }
 
 void RasterizerFlushRegion(PAddr start, u32 size) {
+    // The GPU thread may still be rendering to the region
+    GPU::WaitForIdle();
     if (VideoCore::g_renderer != nullptr) {
         VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
     }
 }
 
 void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
+    GPU::WaitForIdle();
     if (VideoCore::g_renderer != nullptr) {
         VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
     }
 }
 
+void RasterizerFinishPendingWrites(PAddr start, u32 size) {
+    GPU::WaitForIdle();
+    if (VideoCore::g_renderer != nullptr) {
+        VideoCore::g_renderer->Rasterizer()->FinishPendingWrites(start, size);
+    }
+}
+
+void MarkRegionDirty(VAddr start, u32 size) {
+    if (size == 0)
+        return;
+
+    // The end is computed in 64 bits so that regions reaching the end of the address space work
+    const u64 end = (u64(start) + size + PAGE_MASK) >> PAGE_BITS;
+    for (u64 page = start >> PAGE_BITS; page < end && page < PageTable::NUM_ENTRIES; ++page)
+        current_page_table->dirty[page] = true;
+}
+
+bool TakeDirtyPages(std::vector<VAddr>& pages) {
+    for (size_t page = 0; page < PageTable::NUM_ENTRIES; ++page) {
+        if (current_page_table->dirty[page]) {
+            pages.push_back(static_cast<VAddr>(page << PAGE_BITS));
+            current_page_table->dirty[page] = false;
+        }
+    }
+
+    const bool unchanged = !mappings_changed;
+    mappings_changed = false;
+    return unchanged;
+}
+
 u8 Read8(const VAddr addr) {
     return Read<u8>(addr);
 }
@@ -466,6 +521,7 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
 
             u8* dest_ptr = current_page_table->pointers[page_index] + page_offset;
             std::memcpy(dest_ptr, src_buffer, copy_amount);
+            current_page_table->dirty[page_index] = true;
             break;
         }
         case PageType::Special: {
@@ -478,6 +534,7 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
             RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(current_vaddr), copy_amount);
 
             std::memcpy(GetPointerFromVMA(current_vaddr), src_buffer, copy_amount);
+            current_page_table->dirty[page_index] = true;
             break;
         }
         case PageType::RasterizerCachedSpecial: {
@@ -520,6 +577,7 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
 
             u8* dest_ptr = current_page_table->pointers[page_index] + page_offset;
             std::memset(dest_ptr, 0, copy_amount);
+            current_page_table->dirty[page_index] = true;
             break;
         }
         case PageType::Special: {
@@ -532,6 +590,7 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
             RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(current_vaddr), copy_amount);
 
             std::memset(GetPointerFromVMA(current_vaddr), 0, copy_amount);
+            current_page_table->dirty[page_index] = true;
             break;
         }
         case PageType::RasterizerCachedSpecial: {
@@ -6,6 +6,7 @@
 
 #include <cstddef>
 #include <string>
+#include <vector>
 
 #include "common/common_types.h"
 
@@ -167,4 +168,24 @@ void RasterizerFlushRegion(PAddr start, u32 size);
  */
 void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size);
 
+/**
+ * Completes the writes to the given region that the rasterizer still has in flight, before the
+ * region is accessed through a raw pointer.
+ */
+void RasterizerFinishPendingWrites(PAddr start, u32 size);
+
+/**
+ * Marks the pages touching the given region as written. The Write and *Block functions do this on
+ * their own; it is needed after writing through a pointer from GetPointer or GetPhysicalPointer.
+ */
+void MarkRegionDirty(VAddr start, u32 size);
+
+/**
+ * Collects the pages written since the previous call, and marks all pages as clean again.
+ * @param pages Receives the virtual addresses of the written pages, in ascending order
+ * @return Whether no page was mapped or unmapped since the previous call. Otherwise, the pages
+ *         don't account for the memory that moved to or from other addresses.
+ */
+bool TakeDirtyPages(std::vector<VAddr>& pages);
+
 }
@@ -0,0 +1,451 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+
+#include "core/hw/gpu.h"
+#include "core/memory.h"
+#include "core/rewind.h"
+#include "core/savestate.h"
+#include "core/settings.h"
+
+namespace Rewind {
+
+/**
+ * Granularity at which consecutive snapshots are compared. Most of a snapshot is emulated memory,
+ * which is updated page by page, so this matches the size of an emulated page.
+ */
+static const size_t DELTA_PAGE_SIZE = Memory::PAGE_SIZE;
+
+/**
+ * Pages of a snapshot buffer that differ from the same buffer in the snapshot taken right after
+ * it. Applying the delta to the buffer of the newer snapshot reconstructs the older one.
+ */
+struct BufferDelta {
+    /// Size of the buffer of the older snapshot
+    size_t size = 0;
+    /// Indices of the pages stored in `data`, in ascending order
+    std::vector<u32> pages;
+    /// Contents of the pages of the older snapshot, DELTA_PAGE_SIZE bytes each
+    std::vector<u8> data;
+
+    size_t GetMemoryUsage() const {
+        return pages.capacity() * sizeof(u32) + data.capacity();
+    }
+};
+
+/// Differences between a snapshot and the snapshot taken right after it.
+struct Delta {
+    /// Delta of the serialized state
+    BufferDelta data;
+    /// Delta of the contents of emulated memory
+    BufferDelta memory;
+
+    size_t GetMemoryUsage() const {
+        return data.GetMemoryUsage() + memory.GetMemoryUsage();
+    }
+};
+
+struct Entry {
+    /// Frame at which the snapshot was taken
+    u64 frame;
+    /// Delta to the previous entry. Empty for the oldest entry in the buffer.
+    Delta delta;
+};
+
+/// Snapshots held in the buffer, oldest first
+static std::deque<Entry> entries;
+/// Full data of the newest entry
+static SaveState::Snapshot newest;
+/// Buffers new snapshots are serialized to before being compared against `newest`
+static SaveState::Snapshot scratch;
+/// State saved for the snapshot being taken
+static SaveState::SnapshotChanges changes;
+/// Total size of all deltas in `entries`
+static size_t delta_memory_usage;
+
+enum class DeltaState {
+    /// No delta is pending, the emulation thread owns `newest` and `scratch`
+    Idle,
+    /// The delta thread is comparing `scratch` against `newest`, and owns both
+    Computing,
+    /// `pending_delta` is ready to be moved into the newest entry
+    Done,
+};
+
+/**
+ * Comparing whole snapshot buffers reads both of them in full, so it is done on a separate
+ * thread. The emulation thread only serializes the state and copies the pages of emulated memory
+ * that changed, and collects the delta before it touches the buffers again. Emulated memory is
+ * only compared in full when its layout changed, otherwise its delta is built as pages are copied.
+ */
+static std::thread delta_thread;
+static std::mutex delta_mutex;
+static std::condition_variable delta_requested;
+static std::condition_variable delta_finished;
+static DeltaState delta_state = DeltaState::Idle;
+static bool delta_thread_stopping;
+/// Whether the delta thread also compares the emulated memory of `scratch` against `newest`
+static bool delta_compare_memory;
+/// Delta of the newest entry, written by the delta thread
+static Delta pending_delta;
+
+static u64 last_snapshot_frame;
+static std::atomic<bool> step_back_requested;
+/// Whether emulated memory was restored to an older snapshot than `newest` holds now
+static bool memory_rewound;
+
+/**
+ * Set when a single snapshot doesn't fit in the buffer, which disables rewinding until the
+ * configured buffer size changes. The setting itself belongs to the frontend.
+ */
+static bool disabled;
+/// Buffer size rewinding was disabled with
+static int disabled_buffer_size;
+
+/// Protects the statistics read by the frontend from another thread
+static std::mutex stats_mutex;
+static size_t stats_snapshot_count;
+static size_t stats_memory_usage;
+
+MICROPROFILE_DEFINE(Rewind_Snapshot, "Rewind", "Snapshot", MP_RGB(255, 128, 64));
+MICROPROFILE_DEFINE(Rewind_Delta, "Rewind", "Compute delta", MP_RGB(255, 160, 96));
+
+/// Computes the delta needed to turn `new_data` back into `old_data`.
+static void ComputeDelta(const std::vector<u8>& old_data, const std::vector<u8>& new_data, BufferDelta& delta) {
+    delta.size = old_data.size();
+    delta.pages.clear();
+    delta.data.clear();
+
+    const size_t num_pages = (old_data.size() + DELTA_PAGE_SIZE - 1) / DELTA_PAGE_SIZE;
+    for (size_t page = 0; page < num_pages; ++page) {
+        const size_t offset = page * DELTA_PAGE_SIZE;
+        const size_t length = std::min(DELTA_PAGE_SIZE, old_data.size() - offset);
+
+        if (offset + length <= new_data.size() &&
+                std::memcmp(&old_data[offset], &new_data[offset], length) == 0)
+            continue;
+
+        delta.pages.push_back(static_cast<u32>(page));
+        delta.data.insert(delta.data.end(), &old_data[offset], &old_data[offset] + length);
+        delta.data.resize(delta.pages.size() * DELTA_PAGE_SIZE);
+    }
+
+    delta.pages.shrink_to_fit();
+    delta.data.shrink_to_fit();
+}
+
+/// Turns `data` into the older snapshot buffer described by `delta`.
+static void ApplyDelta(const BufferDelta& delta, std::vector<u8>& data) {
+    data.resize(delta.size);
+
+    for (size_t i = 0; i < delta.pages.size(); ++i) {
+        const size_t offset = delta.pages[i] * DELTA_PAGE_SIZE;
+        const size_t length = std::min(DELTA_PAGE_SIZE, delta.size - offset);
+        std::memcpy(&data[offset], &delta.data[i * DELTA_PAGE_SIZE], length);
+    }
+}
+
+static void DeltaThreadLoop() {
+    Common::SetCurrentThreadName("RewindThread");
+    MicroProfileOnThreadCreate("RewindThread");
+
+    std::unique_lock<std::mutex> lock(delta_mutex);
+    while (true) {
+        delta_requested.wait(lock, [] { return delta_thread_stopping || delta_state == DeltaState::Computing; });
+        if (delta_thread_stopping)
+            return;
+
+        lock.unlock();
+        {
+            MICROPROFILE_SCOPE(Rewind_Delta);
+            // The new snapshot becomes the reference, the old reference is reused for the next one
+            ComputeDelta(newest.data, scratch.data, pending_delta.data);
+            std::swap(newest.data, scratch.data);
+            if (delta_compare_memory) {
+                ComputeDelta(newest.memory, scratch.memory, pending_delta.memory);
+                std::swap(newest.memory, scratch.memory);
+            }
+        }
+        lock.lock();
+
+        delta_state = DeltaState::Done;
+        delta_finished.notify_all();
+    }
+}
+
+/// Blocks until the delta thread doesn't use `newest` and `scratch` anymore.
+static void WaitForDelta() {
+    std::unique_lock<std::mutex> lock(delta_mutex);
+    delta_finished.wait(lock, [] { return delta_state != DeltaState::Computing; });
+}
+
+static size_t GetTotalMemoryUsage() {
+    return newest.data.capacity() + newest.memory.capacity() + scratch.data.capacity() +
+           scratch.memory.capacity() + delta_memory_usage;
+}
+
+static void UpdateStats() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stats_snapshot_count = entries.size();
+    stats_memory_usage = GetTotalMemoryUsage();
+}
+
+static void Clear() {
+    WaitForDelta();
+    {
+        std::lock_guard<std::mutex> lock(delta_mutex);
+        delta_state = DeltaState::Idle;
+    }
+    pending_delta = {};
+
+    entries.clear();
+    newest = {};
+    scratch = {};
+    changes = {};
+    delta_memory_usage = 0;
+    UpdateStats();
+}
+
+/// Discards the oldest entries until the buffer fits in the configured budget.
+static void EnforceBudget() {
+    const size_t budget = static_cast<size_t>(std::max(Settings::values.rewind_buffer_size, 0)) * 1024 * 1024;
+
+    while (entries.size() > 1 && GetTotalMemoryUsage() > budget) {
+        entries.pop_front();
+
+        // The delta of the oldest entry leads to a snapshot that isn't in the buffer anymore
+        Delta& delta = entries.front().delta;
+        delta_memory_usage -= delta.GetMemoryUsage();
+        delta = {};
+    }
+
+    if (entries.size() == 1 && GetTotalMemoryUsage() > budget) {
+        LOG_WARNING(Core, "Rewind buffer size is too small to hold a single snapshot, disabling "
+                          "rewinding until it is changed");
+        disabled = true;
+        disabled_buffer_size = Settings::values.rewind_buffer_size;
+        Clear();
+    }
+}
+
+/**
+ * Moves the delta computed by the delta thread into the newest entry.
+ * @param wait Whether to wait for a delta that is still being computed
+ */
+static void FinishDelta(bool wait) {
+    {
+        std::unique_lock<std::mutex> lock(delta_mutex);
+        if (delta_state == DeltaState::Idle || (delta_state == DeltaState::Computing && !wait))
+            return;
+        delta_finished.wait(lock, [] { return delta_state == DeltaState::Done; });
+        delta_state = DeltaState::Idle;
+    }
+
+    Delta& delta = entries.back().delta;
+    delta = std::move(pending_delta);
+    delta_memory_usage += delta.GetMemoryUsage();
+
+    // Only needed again when the next snapshot has to be compared in full
+    scratch.memory.clear();
+    scratch.memory.shrink_to_fit();
+
+    EnforceBudget();
+    UpdateStats();
+}
+
+/**
+ * Copies the pages of emulated memory that changed into `newest`, and records their previous
+ * contents in `delta`.
+ */
+static void UpdateMemoryPages(BufferDelta& delta) {
+    delta.size = newest.memory.size();
+    delta.pages.clear();
+    delta.data.clear();
+
+    for (const auto& page : changes.pages) {
+        u8* snapshot_page = &newest.memory[page.offset];
+        if (std::memcmp(snapshot_page, page.data, page.size) == 0)
+            continue;
+
+        delta.pages.push_back(static_cast<u32>(page.offset / DELTA_PAGE_SIZE));
+        delta.data.insert(delta.data.end(), snapshot_page, snapshot_page + page.size);
+        delta.data.resize(delta.pages.size() * DELTA_PAGE_SIZE);
+        std::memcpy(snapshot_page, page.data, page.size);
+    }
+
+    delta.pages.shrink_to_fit();
+    delta.data.shrink_to_fit();
+}
+
+/// Copies all pages of emulated memory listed in `changes` into `memory`.
+static void CopyMemoryPages(std::vector<u8>& memory) {
+    memory.resize(changes.memory_size);
+    for (const auto& page : changes.pages)
+        std::memcpy(&memory[page.offset], page.data, page.size);
+}
+
+static void TakeSnapshot() {
+    MICROPROFILE_SCOPE(Rewind_Snapshot);
+
+    // The previous snapshot must be done with the buffers before they are reused
+    FinishDelta(true);
+
+    // The changed pages are relative to the previous snapshot, which `newest` doesn't hold
+    // anymore after stepping back
+    const bool has_previous = !entries.empty();
+    if (!SaveState::SaveChanges(changes, !has_previous || memory_rewound)) {
+        LOG_ERROR(Core, "Failed to take rewind snapshot");
+        return;
+    }
+    memory_rewound = false;
+
+    Entry entry;
+    entry.frame = GPU::GetFrameCount();
+    entries.push_back(std::move(entry));
+
+    if (!has_previous) {
+        std::swap(newest.data, changes.data);
+        CopyMemoryPages(newest.memory);
+        EnforceBudget();
+        UpdateStats();
+        return;
+    }
+
+    std::swap(scratch.data, changes.data);
+    // Pages that didn't change keep their contents from the previous snapshot, so only the ones
+    // listed need to be copied. After memory was remapped, the whole of it is compared instead.
+    delta_compare_memory = !changes.incremental || changes.memory_size != newest.memory.size();
+    if (delta_compare_memory) {
+        CopyMemoryPages(scratch.memory);
+    } else {
+        UpdateMemoryPages(pending_delta.memory);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(delta_mutex);
+        delta_state = DeltaState::Computing;
+    }
+    delta_requested.notify_one();
+}
+
+static void StepBack() {
+    FinishDelta(true);
+
+    if (entries.empty())
+        return;
+
+    if (!SaveState::Load(newest)) {
+        LOG_ERROR(Core, "Failed to restore rewind snapshot, clearing rewind buffer");
+        Clear();
+        return;
+    }
+
+    LOG_DEBUG(Core, "Rewound to frame %llu", static_cast<unsigned long long>(entries.back().frame));
+    memory_rewound = true;
+
+    Entry& entry = entries.back();
+    if (entries.size() > 1) {
+        ApplyDelta(entry.delta.data, newest.data);
+        ApplyDelta(entry.delta.memory, newest.memory);
+        delta_memory_usage -= entry.delta.GetMemoryUsage();
+    } else {
+        newest.data.clear();
+        newest.memory.clear();
+    }
+    entries.pop_back();
+
+    UpdateStats();
+}
+
+/// Starts the delta thread, which only runs while rewinding is enabled.
+static void StartDeltaThread() {
+    if (delta_thread.joinable())
+        return;
+
+    delta_thread_stopping = false;
+    delta_thread = std::thread(DeltaThreadLoop);
+}
+
+void Init() {
+    Clear();
+    last_snapshot_frame = 0;
+    step_back_requested = false;
+    memory_rewound = false;
+    disabled = false;
+
+    if (Settings::values.use_rewind)
+        StartDeltaThread();
+}
+
+void Shutdown() {
+    Clear();
+
+    if (!delta_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(delta_mutex);
+        delta_thread_stopping = true;
+    }
+    delta_requested.notify_one();
+    delta_thread.join();
+}
+
+void Update() {
+    if (disabled && Settings::values.rewind_buffer_size != disabled_buffer_size)
+        disabled = false;
+
+    if (!Settings::values.use_rewind || disabled) {
+        if (!entries.empty())
+            Clear();
+        step_back_requested = false;
+        return;
+    }
+
+    StartDeltaThread();
+
+    FinishDelta(false);
+
+    if (step_back_requested.exchange(false)) {
+        StepBack();
+        last_snapshot_frame = GPU::GetFrameCount();
+        return;
+    }
+
+    const u64 frame = GPU::GetFrameCount();
+    const u64 interval = static_cast<u64>(std::max(Settings::values.rewind_interval, 1));
+    if (frame - last_snapshot_frame >= interval) {
+        last_snapshot_frame = frame;
+        TakeSnapshot();
+    }
+}
+
+void RequestStepBack() {
+    step_back_requested = true;
+}
+
+size_t GetSnapshotCount() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats_snapshot_count;
+}
+
+size_t GetMemoryUsage() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats_memory_usage;
+}
+
+} // namespace
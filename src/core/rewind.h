@@ -0,0 +1,41 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Rewind buffer built on top of in-memory savestates. A snapshot is taken every
+ * Settings::values.rewind_interval frames. Only the newest snapshot is kept in full; every older
+ * snapshot is stored as the set of pages that differ from the snapshot taken after it, and the
+ * oldest snapshots are discarded once the configured memory budget is exceeded. The emulation
+ * thread serializes the state apart from emulated memory, of which it only copies the pages written
+ * since the previous snapshot. Everything else is compared on a separate thread, which only runs
+ * while rewinding is enabled.
+ */
+namespace Rewind {
+
+void Init();
+void Shutdown();
+
+/**
+ * Takes a snapshot when enough frames have been emulated since the previous one, and performs a
+ * pending step back request. Called by Core::RunLoop.
+ */
+void Update();
+
+/**
+ * Requests the emulation state to be restored to the newest snapshot in the buffer. The snapshot
+ * is removed from the buffer so that further requests step further back in time.
+ */
+void RequestStepBack();
+
+/// Returns the number of snapshots currently held in the buffer.
+size_t GetSnapshotCount();
+
+/// Returns the total size in bytes of the memory used by the buffer.
+size_t GetMemoryUsage();
+
+} // namespace
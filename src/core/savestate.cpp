@@ -0,0 +1,396 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "audio_core/audio_core.h"
+
+#include "common/chunk_file.h"
+#include "common/common_funcs.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/swap.h"
+
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/service/service.h"
+#include "core/hw/hw.h"
+#include "core/memory.h"
+#include "core/savestate.h"
+
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace SaveState {
+
+struct FileHeader {
+    u32_le magic;
+    /// Version of the file container. Changes to the state itself are versioned per section.
+    u32_le version;
+    /// Non-zero if the state following the header is zlib-compressed
+    u32_le compressed;
+    INSERT_PADDING_WORDS(1);
+    u64_le uncompressed_size;
+};
+static_assert(sizeof(FileHeader) == 0x18, "FileHeader has incorrect size");
+
+static const u32 FILE_MAGIC = 0x54535343; // "CSST"
+static const u32 FILE_VERSION = 1;
+
+/// Size of the chunks the state is streamed to and from files in when compressed.
+static const size_t FILE_CHUNK_SIZE = 1024 * 1024;
+
+/**
+ * How much larger than the current state a state of the same title can be. Apart from a few
+ * kernel objects, states only grow with the emulated memory allocated by the title, which comes
+ * from FCRAM, except for the heap which is backed by a block spanning its whole address range.
+ */
+static const u64 MAX_STATE_GROWTH = u64(Memory::FCRAM_SIZE) + Memory::HEAP_SIZE;
+
+/**
+ * Saves or restores the emulation state. The contents of emulated memory go to `memory` last,
+ * which is `p` itself for files. In-memory snapshots store them separately, see SaveChanges.
+ */
+static void DoState(PointerWrap& p, PointerWrap* memory) {
+    {
+        // Older versions could only be loaded in the emulation session that created them
+        auto s = p.Section("SaveState", 3);
+        if (!s)
+            return;
+
+        // The objects owned by the title are matched with the ones created when it was booted
+        std::string revision = Common::g_scm_rev;
+        u64 program_id = Kernel::g_current_process->codeset->program_id;
+        p.Do(revision);
+        p.Do(program_id);
+
+        if (p.GetMode() == PointerWrap::MODE_READ &&
+                (revision != Common::g_scm_rev || program_id != Kernel::g_current_process->codeset->program_id)) {
+            LOG_ERROR(Core, "Savestate was created by a different build (%s) or title (%016llX)",
+                      revision.c_str(), static_cast<unsigned long long>(program_id));
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+    }
+
+    // When loading, this only recreates the kernel objects and memory blocks of the state, nothing
+    // has been modified if it fails.
+    Kernel::DoObjectTable(p);
+    if (p.error == PointerWrap::ERROR_FAILURE)
+        return;
+
+    {
+        auto s = p.Section("CPU", 1);
+        if (s)
+            Core::g_app_core->DoState(p);
+    }
+    CoreTiming::DoState(p);
+    Kernel::DoState(p);
+    Service::DoState(p);
+    HW::DoState(p);
+    Pica::g_state.DoState(p);
+    AudioCore::DoState(p);
+
+    if (memory != nullptr && p.error != PointerWrap::ERROR_FAILURE)
+        Kernel::MemoryDoContents(*memory);
+}
+
+/**
+ * Returns the size of the current emulation state, as it would be saved.
+ * @param include_memory Whether to include the contents of emulated memory
+ */
+static size_t MeasureState(bool include_memory = true) {
+    u8* measure_ptr = nullptr;
+    PointerWrap measure(&measure_ptr, PointerWrap::MODE_MEASURE);
+    DoState(measure, include_memory ? &measure : nullptr);
+    return reinterpret_cast<size_t>(measure_ptr);
+}
+
+static bool SaveToBuffer(std::vector<u8>& buffer) {
+    // Make sure emulated memory contains everything the GPU has rendered so far
+    if (VideoCore::g_renderer != nullptr)
+        VideoCore::g_renderer->Rasterizer()->FlushAll();
+
+    const size_t size = MeasureState();
+
+    buffer.resize(size);
+    u8* ptr = buffer.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_WRITE);
+    DoState(p, &p);
+
+    if (p.error == PointerWrap::ERROR_FAILURE || ptr != buffer.data() + size) {
+        LOG_ERROR(Core, "Failed to save state");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Loads the emulation state from `buffer`, with the contents of emulated memory at its end, or in
+ * `memory` if it isn't null.
+ */
+static bool LoadFromBuffer(const std::vector<u8>& buffer, const std::vector<u8>* memory = nullptr) {
+    // Surfaces cached by the rasterizer are about to be overwritten
+    Memory::RasterizerFlushAndInvalidateRegion(Memory::VRAM_PADDR, Memory::VRAM_SIZE);
+    Memory::RasterizerFlushAndInvalidateRegion(Memory::FCRAM_PADDR, Memory::FCRAM_SIZE);
+
+    u8* ptr = const_cast<u8*>(buffer.data());
+    PointerWrap p(&ptr, PointerWrap::MODE_READ);
+    u8* memory_ptr = memory != nullptr ? const_cast<u8*>(memory->data()) : nullptr;
+    PointerWrap memory_p(&memory_ptr, PointerWrap::MODE_READ);
+    DoState(p, memory != nullptr ? &memory_p : &p);
+
+    if (p.error == PointerWrap::ERROR_FAILURE || memory_p.error == PointerWrap::ERROR_FAILURE) {
+        LOG_ERROR(Core, "Failed to load state");
+        return false;
+    }
+    if (ptr != buffer.data() + buffer.size() ||
+            (memory != nullptr && memory_ptr != memory->data() + memory->size())) {
+        LOG_ERROR(Core, "Loaded state has unexpected size, emulation state may be corrupted");
+        return false;
+    }
+
+    // Let the renderer pick up the restored Pica configuration
+    if (VideoCore::g_renderer != nullptr) {
+        for (u32 id = 0; id < Pica::Regs::NumIds(); ++id)
+            VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    }
+    return true;
+}
+
+bool SaveChanges(SnapshotChanges& changes, bool all_pages) {
+    if (VideoCore::g_renderer != nullptr)
+        VideoCore::g_renderer->Rasterizer()->FlushAll();
+
+    const size_t size = MeasureState(false);
+
+    changes.data.resize(size);
+    u8* ptr = changes.data.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_WRITE);
+    DoState(p, nullptr);
+
+    if (p.error == PointerWrap::ERROR_FAILURE || ptr != changes.data.data() + size) {
+        LOG_ERROR(Core, "Failed to save state");
+        return false;
+    }
+
+    changes.pages.clear();
+    changes.incremental = Kernel::MemoryListChangedPages(changes.pages, changes.memory_size, all_pages);
+    return true;
+}
+
+bool Load(const Snapshot& snapshot) {
+    return LoadFromBuffer(snapshot.data, &snapshot.memory);
+}
+
+#ifdef HAVE_ZLIB
+static bool WriteCompressed(FileUtil::IOFile& file, const std::vector<u8>& buffer) {
+    z_stream stream = {};
+    if (deflateInit(&stream, Z_BEST_SPEED) != Z_OK)
+        return false;
+
+    std::vector<u8> chunk(FILE_CHUNK_SIZE);
+    size_t input_offset = 0;
+    int flush = Z_NO_FLUSH;
+    int result = Z_OK;
+    while (result != Z_STREAM_END) {
+        if (stream.avail_in == 0 && flush != Z_FINISH) {
+            size_t input_size = std::min(FILE_CHUNK_SIZE, buffer.size() - input_offset);
+            stream.next_in = const_cast<Bytef*>(buffer.data() + input_offset);
+            stream.avail_in = static_cast<uInt>(input_size);
+            input_offset += input_size;
+            if (input_offset == buffer.size())
+                flush = Z_FINISH;
+        }
+
+        stream.next_out = chunk.data();
+        stream.avail_out = static_cast<uInt>(chunk.size());
+        result = deflate(&stream, flush);
+        if (result == Z_STREAM_ERROR)
+            break;
+
+        size_t output_size = chunk.size() - stream.avail_out;
+        if (file.WriteBytes(chunk.data(), output_size) != output_size)
+            break;
+    }
+
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+static bool ReadCompressed(FileUtil::IOFile& file, std::vector<u8>& buffer) {
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK)
+        return false;
+
+    stream.next_out = buffer.data();
+    stream.avail_out = static_cast<uInt>(buffer.size());
+
+    std::vector<u8> chunk(FILE_CHUNK_SIZE);
+    int result = Z_OK;
+    while (result == Z_OK) {
+        if (stream.avail_in == 0) {
+            size_t input_size = file.ReadBytes(chunk.data(), chunk.size());
+            if (input_size == 0)
+                break;
+            stream.next_in = chunk.data();
+            stream.avail_in = static_cast<uInt>(input_size);
+        }
+        result = inflate(&stream, Z_NO_FLUSH);
+    }
+
+    inflateEnd(&stream);
+    return result == Z_STREAM_END && stream.avail_out == 0;
+}
+#endif
+
+bool SaveToFile(const std::string& path) {
+    std::vector<u8> buffer;
+    if (!SaveToBuffer(buffer))
+        return false;
+
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Core, "Could not open savestate file %s", path.c_str());
+        return false;
+    }
+
+    FileHeader header = {};
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.uncompressed_size = buffer.size();
+#ifdef HAVE_ZLIB
+    header.compressed = 1;
+#else
+    header.compressed = 0;
+#endif
+    file.WriteObject(header);
+
+    bool success;
+#ifdef HAVE_ZLIB
+    success = WriteCompressed(file, buffer);
+#else
+    success = file.WriteBytes(buffer.data(), buffer.size()) == buffer.size();
+#endif
+
+    if (!success || !file.IsGood()) {
+        LOG_ERROR(Core, "Failed to write savestate file %s", path.c_str());
+        return false;
+    }
+
+    LOG_INFO(Core, "Saved state to %s", path.c_str());
+    return true;
+}
+
+bool LoadFromFile(const std::string& path) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Core, "Could not open savestate file %s", path.c_str());
+        return false;
+    }
+
+    FileHeader header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+            header.magic != FILE_MAGIC || header.version != FILE_VERSION) {
+        LOG_ERROR(Core, "%s is not a valid savestate file", path.c_str());
+        return false;
+    }
+
+    // The size is checked before anything is allocated, so that a corrupted header is rejected
+    // instead of exhausting host memory
+    const u64 max_size = MeasureState() + MAX_STATE_GROWTH;
+    const u64 file_size = file.GetSize();
+    if (header.uncompressed_size > max_size ||
+            (!header.compressed && header.uncompressed_size != file_size - sizeof(header))) {
+        LOG_ERROR(Core, "Savestate %s has an invalid size (0x%llX bytes)", path.c_str(),
+                  static_cast<unsigned long long>(header.uncompressed_size));
+        return false;
+    }
+
+    std::vector<u8> buffer(static_cast<size_t>(header.uncompressed_size));
+    bool success;
+    if (header.compressed) {
+#ifdef HAVE_ZLIB
+        success = ReadCompressed(file, buffer);
+#else
+        LOG_ERROR(Core, "Savestate %s is compressed, but zlib support is not available",
+                  path.c_str());
+        success = false;
+#endif
+    } else {
+        success = file.ReadBytes(buffer.data(), buffer.size()) == buffer.size();
+    }
+
+    if (!success) {
+        LOG_ERROR(Core, "Failed to read savestate file %s", path.c_str());
+        return false;
+    }
+
+    if (!LoadFromBuffer(buffer))
+        return false;
+
+    LOG_INFO(Core, "Loaded state from %s", path.c_str());
+    return true;
+}
+
+enum class ScheduledOperation {
+    None,
+    Save,
+    Load,
+};
+
+static std::mutex scheduled_mutex;
+static ScheduledOperation scheduled_operation = ScheduledOperation::None;
+static std::string scheduled_path;
+
+void ScheduleSave(const std::string& path) {
+    std::lock_guard<std::mutex> lock(scheduled_mutex);
+    scheduled_operation = ScheduledOperation::Save;
+    scheduled_path = path;
+}
+
+void ScheduleLoad(const std::string& path) {
+    std::lock_guard<std::mutex> lock(scheduled_mutex);
+    scheduled_operation = ScheduledOperation::Load;
+    scheduled_path = path;
+}
+
+void ProcessScheduled() {
+    ScheduledOperation operation;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(scheduled_mutex);
+        operation = scheduled_operation;
+        path = std::move(scheduled_path);
+        scheduled_operation = ScheduledOperation::None;
+    }
+
+    switch (operation) {
+    case ScheduledOperation::None:
+        break;
+    case ScheduledOperation::Save:
+        SaveToFile(path);
+        break;
+    case ScheduledOperation::Load:
+        LoadFromFile(path);
+        break;
+    }
+}
+
+} // namespace
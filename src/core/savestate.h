@@ -0,0 +1,94 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+
+#include "core/hle/kernel/memory.h"
+
+/**
+ * Full-system savestates: CPU registers, CoreTiming events, kernel objects, HLE service modules
+ * and emulated memory, hardware and Pica registers, and the DSP.
+ *
+ * The objects created when the title was booted (its process, code set, resource limits and
+ * service ports) are matched with the current ones, all other kernel objects are recreated from
+ * the state. A state can therefore be loaded whenever the same title is running on the same
+ * build, including after the emulator is restarted. Loading an incompatible state is refused
+ * before any emulator state is modified.
+ *
+ * Not saved: the contents of host-backed archives (e.g. save data, which is left as it is on
+ * disk when files are reopened), open sockets, and running library applets, which make saving
+ * fail.
+ *
+ * States must only be saved or loaded from the emulation thread between two calls to
+ * Core::RunLoop. Other threads should use ScheduleSave and ScheduleLoad instead.
+ */
+namespace SaveState {
+
+/// An in-memory savestate, meant to be saved and restored quickly (e.g. for rewinding).
+struct Snapshot {
+    /// Serialized state, except for the contents of emulated memory
+    std::vector<u8> data;
+    /// Contents of emulated memory, see Kernel::MemoryDoContents
+    std::vector<u8> memory;
+};
+
+/**
+ * The current emulation state, with the pages of emulated memory that changed since the previous
+ * snapshot instead of all of emulated memory.
+ */
+struct SnapshotChanges {
+    /// Serialized state, except for the contents of emulated memory
+    std::vector<u8> data;
+    /// Size of the contents of emulated memory
+    size_t memory_size;
+    /// Whether `pages` only holds the pages that may have changed. Otherwise, it holds all pages.
+    bool incremental;
+    /// Pages of Snapshot::memory to update, which point into emulated memory
+    std::vector<Kernel::ContentsPage> pages;
+};
+
+/**
+ * Serializes the current emulation state, except for emulated memory, and lists the pages of
+ * emulated memory that changed since the previous call. Only the written pages are visited, so
+ * this takes time in proportion to them rather than to all of emulated memory. The pages point
+ * into emulated memory and must be copied into the snapshot before emulation resumes.
+ * @param all_pages Whether to list all pages, e.g. because the previous snapshot was discarded
+ * @return Whether the state was saved successfully
+ */
+bool SaveChanges(SnapshotChanges& changes, bool all_pages);
+
+/**
+ * Restores the emulation state from a snapshot.
+ * @return Whether the state was restored successfully. If the snapshot is rejected before any
+ *         state is modified, emulation can continue normally.
+ */
+bool Load(const Snapshot& snapshot);
+
+/**
+ * Saves the current emulation state to a file. The state is compressed if zlib is available.
+ * @return Whether the state was saved successfully
+ */
+bool SaveToFile(const std::string& path);
+
+/**
+ * Loads the emulation state from a file written by SaveToFile while the same title was running.
+ * @return Whether the state was loaded successfully
+ */
+bool LoadFromFile(const std::string& path);
+
+/// Requests the state to be saved to a file the next time the emulation thread reaches ProcessScheduled.
+void ScheduleSave(const std::string& path);
+
+/// Requests the state to be loaded from a file the next time the emulation thread reaches ProcessScheduled.
+void ScheduleLoad(const std::string& path);
+
+/// Performs the scheduled save or load operation, if there is any. Called by Core::RunLoop.
+void ProcessScheduled();
+
+} // namespace
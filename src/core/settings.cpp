@@ -21,6 +21,12 @@ void Apply() {
 
     VideoCore::g_hw_renderer_enabled = values.use_hw_renderer;
     VideoCore::g_shader_jit_enabled = values.use_shader_jit;
+    VideoCore::g_shader_jit_async_enabled = values.use_shader_jit_async;
+    VideoCore::g_shader_disk_cache_enabled = values.use_shader_disk_cache;
+    VideoCore::g_parallel_vertex_threshold = values.parallel_vertex_threshold;
+    VideoCore::g_sw_rasterizer_binning_enabled = values.use_sw_rasterizer_binning;
+    // GPU interrupts raised on the GPU thread land on a cycle that depends on host scheduling
+    VideoCore::g_async_gpu_enabled = values.use_async_gpu && !values.use_deterministic_mode;
     VideoCore::g_scaled_resolution_enabled = values.use_scaled_resolution;
 
     AudioCore::SelectSink(values.sink_id);
@@ -61,6 +61,9 @@ struct Values {
 
     // Core
     int frame_skip;
+    bool use_rewind;
+    int rewind_interval;
+    int rewind_buffer_size;
 
     // Data Storage
     bool use_virtual_sd;
@@ -71,6 +74,11 @@ struct Values {
     // Renderer
     bool use_hw_renderer;
     bool use_shader_jit;
+    bool use_shader_jit_async;
+    bool use_shader_disk_cache;
+    int parallel_vertex_threshold;
+    bool use_sw_rasterizer_binning;
+    bool use_async_gpu;
     bool use_scaled_resolution;
 
     float bg_red;
@@ -85,6 +93,11 @@ struct Values {
     // Debugging
     bool use_gdbstub;
     u16 gdbstub_port;
+
+    // Replay
+    /// Avoids host state that differs between runs (wall-clock time, random seeds) so that runs
+    /// with the same input are reproducible.
+    bool use_deterministic_mode;
 } extern values;
 
 void Apply();
@@ -8,32 +8,38 @@
 #include "core/core_timing.h"
 #include "core/system.h"
 #include "core/gdbstub/gdbstub.h"
+#include "core/hw/gpu.h"
 #include "core/hw/hw.h"
 #include "core/hle/hle.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/memory.h"
+#include "core/rewind.h"
 
 #include "video_core/video_core.h"
 
 namespace System {
 
-Result Init(EmuWindow* emu_window) {
+Result Init(EmuWindow* emu_window, bool headless) {
     Core::Init();
     CoreTiming::Init();
     Memory::Init();
     HW::Init();
     Kernel::Init();
     HLE::Init();
-    if (!VideoCore::Init(emu_window)) {
+    if (!VideoCore::Init(emu_window, headless)) {
         return Result::ErrorInitVideoCore;
     }
     AudioCore::Init();
     GDBStub::Init();
+    Rewind::Init();
 
     return Result::Success;
 }
 
 void Shutdown() {
+    // Queued GPU work still uses the renderer, which is destroyed before the GPU itself
+    GPU::WaitForIdle();
+    Rewind::Shutdown();
     GDBStub::Shutdown();
     AudioCore::Shutdown();
     VideoCore::Shutdown();
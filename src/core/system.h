@@ -15,7 +15,12 @@ enum class Result {
     ErrorInitVideoCore,     ///< Something went wrong during video core init
 };
 
-Result Init(EmuWindow* emu_window);
+/**
+ * Initializes the emulated system
+ * @param emu_window Window used for presentation and input
+ * @param headless If true, no display is used and frames are only rendered to emulated memory
+ */
+Result Init(EmuWindow* emu_window, bool headless = false);
 void Shutdown();
 
 }
@@ -0,0 +1,35 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+
+#include "common/common_types.h"
+
+/**
+ * Timing helpers for the benchmark test cases. Benchmarks are tagged "[.][benchmark]" so that
+ * they are hidden from normal test runs; run them with `tests [benchmark]`.
+ */
+namespace Benchmark {
+
+/// Number of runs each measurement is averaged over
+constexpr int ITERATIONS = 20;
+
+/// Seed of the random inputs of benchmarks, fixed so that results of different runs are comparable
+constexpr u32 RANDOM_SEED = 0x3D5;
+
+/// Runs `func` ITERATIONS times and returns the average duration of a run in milliseconds.
+template <typename Func>
+double AverageMilliseconds(Func&& func) {
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    const auto start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+        func();
+    return Milliseconds(Clock::now() - start).count() / ITERATIONS;
+}
+
+} // namespace
@@ -0,0 +1,254 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "common/color.h"
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+#include "core/hw/gpu.h"
+
+#include "video_core/gpu_transfer.h"
+#include "video_core/utils.h"
+
+#include "tests/benchmark.h"
+
+using GPU::Regs;
+
+static const Regs::PixelFormat pixel_formats[] = {
+    Regs::PixelFormat::RGBA8, Regs::PixelFormat::RGB8, Regs::PixelFormat::RGB565,
+    Regs::PixelFormat::RGB5A1, Regs::PixelFormat::RGBA4,
+};
+
+static Math::Vec4<u8> DecodePixel(Regs::PixelFormat format, const u8* pixel) {
+    switch (format) {
+    case Regs::PixelFormat::RGBA8:
+        return Color::DecodeRGBA8(pixel);
+    case Regs::PixelFormat::RGB8:
+        return Color::DecodeRGB8(pixel);
+    case Regs::PixelFormat::RGB565:
+        return Color::DecodeRGB565(pixel);
+    case Regs::PixelFormat::RGB5A1:
+        return Color::DecodeRGB5A1(pixel);
+    default:
+        return Color::DecodeRGBA4(pixel);
+    }
+}
+
+static void EncodePixel(Regs::PixelFormat format, const Math::Vec4<u8>& color, u8* pixel) {
+    switch (format) {
+    case Regs::PixelFormat::RGBA8:
+        return Color::EncodeRGBA8(color, pixel);
+    case Regs::PixelFormat::RGB8:
+        return Color::EncodeRGB8(color, pixel);
+    case Regs::PixelFormat::RGB565:
+        return Color::EncodeRGB565(color, pixel);
+    case Regs::PixelFormat::RGB5A1:
+        return Color::EncodeRGB5A1(color, pixel);
+    default:
+        return Color::EncodeRGBA4(color, pixel);
+    }
+}
+
+static u32 PixelOffset(bool tiled, u32 x, u32 y, u32 width, u32 bytes_per_pixel) {
+    if (tiled)
+        return VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + (y & ~7) * width * bytes_per_pixel;
+    return (x + y * width) * bytes_per_pixel;
+}
+
+/// Performs a display transfer a pixel at a time, averaging the input pixels by their coordinates
+static void DisplayTransferReference(const Regs::DisplayTransferConfig& config, const u8* src, u8* dst) {
+    const int horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    const int vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+    const u32 output_width = config.output_width >> horizontal_scale;
+    const u32 output_height = config.output_height >> vertical_scale;
+    const u32 src_bytes_per_pixel = Regs::BytesPerPixel(config.input_format);
+    const u32 dst_bytes_per_pixel = Regs::BytesPerPixel(config.output_format);
+    const bool input_tiled = !config.input_linear;
+    const bool output_tiled = config.input_linear != config.dont_swizzle;
+
+    auto input_pixel = [&](u32 x, u32 y) {
+        return DecodePixel(config.input_format,
+                           src + PixelOffset(input_tiled, x, y, config.input_width, src_bytes_per_pixel)).Cast<int>();
+    };
+
+    for (u32 y = 0; y < output_height; ++y) {
+        for (u32 x = 0; x < output_width; ++x) {
+            const u32 input_x = x << horizontal_scale;
+            const u32 input_y = y << vertical_scale;
+
+            Math::Vec4<int> color = input_pixel(input_x, input_y);
+            if (config.scaling == config.ScaleX) {
+                color = (color + input_pixel(input_x + 1, input_y)) / 2;
+            } else if (config.scaling == config.ScaleXY) {
+                color = (color + input_pixel(input_x + 1, input_y) + input_pixel(input_x, input_y + 1) +
+                         input_pixel(input_x + 1, input_y + 1)) / 4;
+            }
+
+            const u32 output_y = config.flip_vertically ? output_height - 1 - y : y;
+            EncodePixel(config.output_format, color.Cast<u8>(),
+                        dst + PixelOffset(output_tiled, x, output_y, output_width, dst_bytes_per_pixel));
+        }
+    }
+}
+
+static Regs::DisplayTransferConfig MakeDisplayTransferConfig(Regs::PixelFormat input_format, Regs::PixelFormat output_format,
+                                                             u32 input_width, u32 output_width, u32 output_height) {
+    Regs::DisplayTransferConfig config;
+    std::memset(&config, 0, sizeof(config));
+    config.input_width.Assign(input_width);
+    config.input_height.Assign(output_height);
+    config.output_width.Assign(output_width);
+    config.output_height.Assign(output_height);
+    config.input_format.Assign(input_format);
+    config.output_format.Assign(output_format);
+    return config;
+}
+
+TEST_CASE("DisplayTransfer matches a pixel by pixel transfer", "[video_core][display_transfer]") {
+    struct Setup {
+        u32 input_width, output_width, output_height;
+        bool input_linear, dont_swizzle;
+        Regs::DisplayTransferConfig::ScalingMode scaling;
+    };
+    static const Setup setups[] = {
+        // Tiled to linear, the usual framebuffer copy, with every scaling mode
+        { 32, 32, 24, false, false, Regs::DisplayTransferConfig::NoScale },
+        { 32, 32, 24, false, false, Regs::DisplayTransferConfig::ScaleX },
+        { 32, 32, 32, false, false, Regs::DisplayTransferConfig::ScaleXY },
+        // Tiled to tiled, with a narrower output
+        { 32, 24, 16, false, true, Regs::DisplayTransferConfig::NoScale },
+        { 32, 32, 32, false, true, Regs::DisplayTransferConfig::ScaleXY },
+        // Linear to tiled and linear to linear
+        { 32, 32, 16, true, false, Regs::DisplayTransferConfig::NoScale },
+        { 32, 32, 16, true, true, Regs::DisplayTransferConfig::NoScale },
+        // Not aligned to tiles, or wider than the input, which go a pixel at a time
+        { 20, 20, 13, true, true, Regs::DisplayTransferConfig::NoScale },
+        { 24, 20, 16, true, false, Regs::DisplayTransferConfig::NoScale },
+        { 16, 24, 8, true, true, Regs::DisplayTransferConfig::NoScale },
+    };
+
+    std::mt19937 rng(0x3D5);
+    std::vector<u8> src(64 * 64 * 4);
+    for (auto& byte : src)
+        byte = static_cast<u8>(rng());
+
+    for (const Setup& setup : setups) {
+        for (auto input_format : pixel_formats) {
+            for (auto output_format : pixel_formats) {
+                for (bool flip : { false, true }) {
+                    auto config = MakeDisplayTransferConfig(input_format, output_format, setup.input_width,
+                                                            setup.output_width, setup.output_height);
+                    config.input_linear.Assign(setup.input_linear);
+                    config.dont_swizzle.Assign(setup.dont_swizzle);
+                    config.scaling.Assign(setup.scaling);
+                    config.flip_vertically.Assign(flip);
+
+                    std::vector<u8> expected(64 * 64 * 4, 0xCD);
+                    std::vector<u8> result(64 * 64 * 4, 0xCD);
+                    DisplayTransferReference(config, src.data(), expected.data());
+                    VideoCore::DisplayTransfer(config, src.data(), result.data());
+
+                    INFO(setup.input_width << " to " << setup.output_width << "x" << setup.output_height
+                         << ", input linear " << setup.input_linear << ", dont swizzle " << setup.dont_swizzle
+                         << ", scaling " << setup.scaling << ", formats " << static_cast<int>(input_format)
+                         << " to " << static_cast<int>(output_format) << (flip ? ", flipped" : ""));
+                    REQUIRE(result == expected);
+                }
+            }
+        }
+    }
+}
+
+/// Fills memory a value at a time
+static void MemoryFillReference(const Regs::MemoryFillConfig& config, u8* start, u8* end) {
+    if (config.fill_24bit) {
+        for (u8* ptr = start; ptr < end; ptr += 3) {
+            ptr[0] = config.value_24bit_r;
+            ptr[1] = config.value_24bit_g;
+            ptr[2] = config.value_24bit_b;
+        }
+    } else if (config.fill_32bit) {
+        const u32 value = config.value_32bit;
+        for (u8* ptr = start; ptr + sizeof(u32) <= end; ptr += sizeof(u32))
+            std::memcpy(ptr, &value, sizeof(u32));
+    } else {
+        const u16 value = config.value_16bit.Value();
+        for (u8* ptr = start; ptr < end; ptr += sizeof(u16))
+            std::memcpy(ptr, &value, sizeof(u16));
+    }
+}
+
+TEST_CASE("MemoryFill and MemoryFillPart match a value by value fill", "[video_core][memory_fill]") {
+    for (int mode = 0; mode < 3; ++mode) {
+        for (size_t size : { 0, 1, 2, 3, 47, 48, 49, 100, 1000, 4097 }) {
+            Regs::MemoryFillConfig config;
+            std::memset(&config, 0, sizeof(config));
+            config.value_32bit = 0x89ABCDEF;
+            config.fill_24bit.Assign(mode == 1);
+            config.fill_32bit.Assign(mode == 2);
+
+            // Leaves room for the last value crossing the end of the region
+            std::vector<u8> expected(size + 8, 0xCD);
+            std::vector<u8> result(size + 8, 0xCD);
+            MemoryFillReference(config, &expected[1], &expected[1 + size]);
+            VideoCore::MemoryFill(config, &result[1], &result[1 + size]);
+
+            INFO("mode " << mode << ", " << size << " bytes");
+            REQUIRE(result == expected);
+
+            // The same fill done in three parts, not aligned to the values
+            std::vector<u8> parts_result(size + 8, 0xCD);
+            u8* const region_start = &parts_result[1];
+            u8* const region_end = &parts_result[1 + size];
+            const size_t splits[] = { 0, size / 3, size * 2 / 3 + 1, size };
+            for (int part = 0; part < 3; ++part) {
+                VideoCore::MemoryFillPart(config, region_start, region_end, region_start + std::min(splits[part], size),
+                                          region_start + std::min(splits[part + 1], size));
+            }
+            REQUIRE(parts_result == expected);
+        }
+    }
+}
+
+TEST_CASE("Display transfer and memory fill benchmark", "[.][benchmark]") {
+    // A top screen framebuffer being copied for display
+    std::vector<u8> src(400 * 240 * 4);
+    std::vector<u8> dst(400 * 240 * 4);
+    for (auto output_format : { Regs::PixelFormat::RGBA8, Regs::PixelFormat::RGB8 }) {
+        auto config = MakeDisplayTransferConfig(Regs::PixelFormat::RGBA8, output_format, 240, 240, 400);
+
+        const double reference_ms = Benchmark::AverageMilliseconds([&] {
+            DisplayTransferReference(config, src.data(), dst.data());
+        });
+        const double transfer_ms = Benchmark::AverageMilliseconds([&] {
+            VideoCore::DisplayTransfer(config, src.data(), dst.data());
+        });
+
+        WARN("Display transfer from RGBA8 to format " << static_cast<int>(output_format) << ": pixel by pixel "
+             << reference_ms << " ms, DisplayTransfer " << transfer_ms << " ms per 240x400 framebuffer");
+    }
+
+    for (int mode = 0; mode < 3; ++mode) {
+        Regs::MemoryFillConfig config;
+        std::memset(&config, 0, sizeof(config));
+        config.fill_24bit.Assign(mode == 1);
+        config.fill_32bit.Assign(mode == 2);
+
+        u8* const start = dst.data();
+        u8* const end = dst.data() + 400 * 240 * 3;
+
+        const double reference_ms = Benchmark::AverageMilliseconds([&] { MemoryFillReference(config, start, end); });
+        const double fill_ms = Benchmark::AverageMilliseconds([&] { VideoCore::MemoryFill(config, start, end); });
+
+        WARN(16 + mode * 8 << "-bit fill: value by value " << reference_ms << " ms, MemoryFill " << fill_ms
+             << " ms per 240x400x3 bytes");
+    }
+}
@@ -0,0 +1,105 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica.h"
+#include "video_core/texture/texture_decode.h"
+
+#include "tests/benchmark.h"
+
+using Pica::Regs;
+using Pica::DebugUtils::TextureInfo;
+
+static const Regs::TextureFormat texture_formats[] = {
+    Regs::TextureFormat::RGBA8, Regs::TextureFormat::RGB8, Regs::TextureFormat::RGB5A1,
+    Regs::TextureFormat::RGB565, Regs::TextureFormat::RGBA4, Regs::TextureFormat::IA8,
+    Regs::TextureFormat::RG8, Regs::TextureFormat::I8, Regs::TextureFormat::A8,
+    Regs::TextureFormat::IA4, Regs::TextureFormat::I4, Regs::TextureFormat::A4,
+    Regs::TextureFormat::ETC1, Regs::TextureFormat::ETC1A4,
+};
+
+static TextureInfo MakeTextureInfo(Regs::TextureFormat format, int width, int height) {
+    TextureInfo info;
+    info.physical_address = 0;
+    info.width = width;
+    info.height = height;
+    info.stride = Regs::NibblesPerPixel(format) * width / 2;
+    info.format = format;
+    return info;
+}
+
+static std::vector<u8> MakeRandomTexture(const TextureInfo& info, std::mt19937& rng) {
+    // The largest formats take 32 bits per texel
+    std::vector<u8> data(info.width * info.height * 4);
+    for (auto& byte : data)
+        byte = static_cast<u8>(rng());
+    return data;
+}
+
+static bool TexelsEqual(const Math::Vec4<u8>& a, const Math::Vec4<u8>& b) {
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+TEST_CASE("DecodeTexture matches LookupTexture", "[video_core][texture]") {
+    std::mt19937 rng(0x3D5);
+
+    for (auto format : texture_formats) {
+        for (int size : { 8, 32, 64 }) {
+            const TextureInfo info = MakeTextureInfo(format, size, size * 2);
+            const std::vector<u8> data = MakeRandomTexture(info, rng);
+
+            std::vector<Math::Vec4<u8>> texels(info.width * info.height);
+            std::vector<Math::Vec4<u8>> flipped_texels(info.width * info.height);
+            Pica::Texture::DecodeTexture(info, data.data(), texels.data(), info.width);
+            Pica::Texture::DecodeTexture(info, data.data(), flipped_texels.data() + info.width * (info.height - 1),
+                                         -info.width);
+
+            int mismatches = 0;
+            for (int y = 0; y < info.height; ++y) {
+                for (int x = 0; x < info.width; ++x) {
+                    const auto expected = Pica::DebugUtils::LookupTexture(data.data(), x, y, info);
+                    if (!TexelsEqual(expected, texels[x + y * info.width]))
+                        ++mismatches;
+                    if (!TexelsEqual(expected, flipped_texels[x + (info.height - 1 - y) * info.width]))
+                        ++mismatches;
+                }
+            }
+
+            INFO("format " << static_cast<int>(format) << ", " << info.width << "x" << info.height);
+            REQUIRE(mismatches == 0);
+        }
+    }
+}
+
+TEST_CASE("DecodeTexture benchmark", "[.][benchmark]") {
+    std::mt19937 rng(Benchmark::RANDOM_SEED);
+
+    for (auto format : texture_formats) {
+        const TextureInfo info = MakeTextureInfo(format, 512, 512);
+        const std::vector<u8> data = MakeRandomTexture(info, rng);
+        std::vector<Math::Vec4<u8>> texels(info.width * info.height);
+
+        const double lookup_ms = Benchmark::AverageMilliseconds([&] {
+            for (int y = 0; y < info.height; ++y) {
+                for (int x = 0; x < info.width; ++x)
+                    texels[x + y * info.width] = Pica::DebugUtils::LookupTexture(data.data(), x, y, info);
+            }
+        });
+        const double decode_ms = Benchmark::AverageMilliseconds([&] {
+            Pica::Texture::DecodeTexture(info, data.data(), texels.data(), info.width);
+        });
+
+        WARN("format " << static_cast<int>(format) << ": LookupTexture " << lookup_ms << " ms, DecodeTexture "
+             << decode_ms << " ms per 512x512 texture");
+    }
+}
@@ -0,0 +1,100 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "common/common_types.h"
+
+#include "video_core/utils.h"
+
+#include "tests/benchmark.h"
+
+/// Copies a Morton ordered image to rows of pixels through GetMortonOffset, a pixel at a time
+static void UnswizzleImageReference(u32 bytes_per_pixel, int width, int height, const u8* morton, u8* linear) {
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const u32 coarse_y = y & ~7;
+            const u32 offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * width * bytes_per_pixel;
+            std::memcpy(linear + (x + y * width) * bytes_per_pixel, morton + offset, bytes_per_pixel);
+        }
+    }
+}
+
+TEST_CASE("Morton tile swizzling matches GetMortonOffset", "[video_core][morton]") {
+    const int width = 32;
+    const int height = 24;
+    std::mt19937 rng(0x3D5);
+
+    for (u32 bytes_per_pixel = 1; bytes_per_pixel <= 4; ++bytes_per_pixel) {
+        for (bool flip : { false, true }) {
+            const size_t size = width * height * bytes_per_pixel;
+            std::vector<u8> morton(size);
+            for (auto& byte : morton)
+                byte = static_cast<u8>(rng());
+
+            std::vector<u8> expected(size);
+            UnswizzleImageReference(bytes_per_pixel, width, height, morton.data(), expected.data());
+
+            // Rows of a flipped image are stored bottom to top, as OpenGL does
+            const int row_size = width * bytes_per_pixel;
+            const int stride = flip ? -row_size : row_size;
+            std::vector<u8> linear(size);
+            u8* const origin = linear.data() + (flip ? (height - 1) * row_size : 0);
+
+            std::vector<u8> swizzled(size);
+            for (int y = 0; y < height; y += 8) {
+                for (int x = 0; x < width; x += 8) {
+                    const size_t tile_offset = (x * 8 + y * width) * bytes_per_pixel;
+                    u8* tile_origin = origin + x * bytes_per_pixel + y * stride;
+                    VideoCore::MortonUnswizzleTile(bytes_per_pixel, morton.data() + tile_offset, tile_origin, stride);
+                    VideoCore::MortonSwizzleTile(bytes_per_pixel, tile_origin, stride, swizzled.data() + tile_offset);
+                }
+            }
+
+            INFO(bytes_per_pixel << " bytes per pixel" << (flip ? ", flipped" : ""));
+            for (int y = 0; y < height; ++y) {
+                const int row = flip ? height - 1 - y : y;
+                REQUIRE(std::memcmp(&linear[row * row_size], &expected[y * row_size], row_size) == 0);
+            }
+            REQUIRE(swizzled == morton);
+        }
+    }
+}
+
+TEST_CASE("Morton tile swizzling benchmark", "[.][benchmark]") {
+    const int width = 1024;
+    const int height = 1024;
+
+    for (u32 bytes_per_pixel = 1; bytes_per_pixel <= 4; ++bytes_per_pixel) {
+        std::vector<u8> morton(width * height * bytes_per_pixel);
+        std::vector<u8> linear(width * height * bytes_per_pixel);
+
+        const double reference_ms = Benchmark::AverageMilliseconds([&] {
+            UnswizzleImageReference(bytes_per_pixel, width, height, morton.data(), linear.data());
+        });
+        const double unswizzle_ms = Benchmark::AverageMilliseconds([&] {
+            for (int y = 0; y < height; y += 8) {
+                for (int x = 0; x < width; x += 8) {
+                    VideoCore::MortonUnswizzleTile(bytes_per_pixel, &morton[(x * 8 + y * width) * bytes_per_pixel],
+                                                   &linear[(x + y * width) * bytes_per_pixel], width * bytes_per_pixel);
+                }
+            }
+        });
+        const double swizzle_ms = Benchmark::AverageMilliseconds([&] {
+            for (int y = 0; y < height; y += 8) {
+                for (int x = 0; x < width; x += 8) {
+                    VideoCore::MortonSwizzleTile(bytes_per_pixel, &linear[(x + y * width) * bytes_per_pixel],
+                                                 width * bytes_per_pixel, &morton[(x * 8 + y * width) * bytes_per_pixel]);
+                }
+            }
+        });
+
+        WARN(bytes_per_pixel << " bytes per pixel: GetMortonOffset " << reference_ms << " ms, MortonUnswizzleTile "
+             << unswizzle_ms << " ms, MortonSwizzleTile " << swizzle_ms << " ms per 1024x1024 image");
+    }
+}
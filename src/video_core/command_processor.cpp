@@ -2,14 +2,20 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <memory>
+#include <thread>
 #include <utility>
+#include <vector>
+
+#include <boost/container/static_vector.hpp>
 
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 
 #include "core/hle/service/gsp_gpu.h"
@@ -19,13 +25,16 @@
 
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/geometry_pipeline.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
 #include "video_core/primitive_assembly.h"
+#include "video_core/rasterizer.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/shader/shader.h"
+#include "video_core/vertex_cache.h"
 #include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
@@ -33,9 +42,14 @@ namespace Pica {
 
 namespace CommandProcessor {
 
-static int float_regs_counter = 0;
+/// Float uniform words written to a shader unit, uniforms are written once a full vector is received
+struct UniformWriteBuffer {
+    int float_regs_counter = 0;
+    u32 words[4];
+};
 
-static u32 uniform_write_buffer[4];
+static UniformWriteBuffer vs_uniform_write_buffer;
+static UniformWriteBuffer gs_uniform_write_buffer;
 
 static int default_attr_counter = 0;
 
@@ -51,6 +65,138 @@ static const u32 expand_bits_to_bytes[] = {
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+/// Threads loading and shading the vertices of draws above VideoCore::g_parallel_vertex_threshold
+static std::unique_ptr<Common::ThreadPool> vertex_thread_pool;
+
+/// Number of vertices processed by each task of a parallel draw
+static const unsigned int PARALLEL_VERTEX_CHUNK_SIZE = 256;
+
+/// Post-transform vertex cache of indexed draws, kept across draws to reuse its allocations
+static VertexCache vertex_cache;
+
+/// Geometry shader stage, used instead of the primitive assembler if enabled
+static GeometryPipeline geometry_pipeline;
+
+/// Vertex shader output registers of draws using the geometry shader, kept across draws to reuse its allocation
+static std::vector<Shader::OutputRegisters> vs_outputs;
+
+/// Returns the shader units receiving the vertex shader configuration
+static boost::container::static_vector<Shader::ShaderSetup*, 2> GetVertexShaderSetups() {
+    if (g_state.regs.vs_com_mode == Regs::VSComMode::Shared)
+        return { &g_state.vs, &g_state.gs };
+    return { &g_state.vs };
+}
+
+static void WriteUniformBoolReg(Shader::ShaderSetup& setup, u32 value) {
+    for (unsigned i = 0; i < 16; ++i)
+        setup.uniforms.b[i] = (value & (1 << i)) != 0;
+}
+
+template <typename IntUniform>
+static void WriteUniformIntReg(Shader::ShaderSetup& setup, unsigned index, const IntUniform& values) {
+    setup.uniforms.i[index] = Math::Vec4<u8>(values.x, values.y, values.z, values.w);
+    LOG_TRACE(HW_GPU, "Set integer uniform %d to %02x %02x %02x %02x",
+              index, values.x.Value(), values.y.Value(), values.z.Value(), values.w.Value());
+}
+
+static void WriteUniformFloatReg(Regs::ShaderConfig& config, UniformWriteBuffer& buffer, u32 value,
+                                 const boost::container::static_vector<Shader::ShaderSetup*, 2>& setups) {
+    auto& uniform_setup = config.uniform_setup;
+
+    // TODO: Does actual hardware indeed keep an intermediate buffer or does
+    //       it directly write the values?
+    buffer.words[buffer.float_regs_counter++] = value;
+
+    // Uniforms are written in a packed format such that four float24 values are encoded in
+    // three 32-bit numbers. We write to internal memory once a full such vector is
+    // written.
+    if ((buffer.float_regs_counter >= 4 && uniform_setup.IsFloat32()) ||
+        (buffer.float_regs_counter >= 3 && !uniform_setup.IsFloat32())) {
+        buffer.float_regs_counter = 0;
+
+        if (uniform_setup.index > 95) {
+            LOG_ERROR(HW_GPU, "Invalid uniform index %d", (int)uniform_setup.index);
+            return;
+        }
+
+        Math::Vec4<float24> uniform;
+
+        // NOTE: The destination component order indeed is "backwards"
+        if (uniform_setup.IsFloat32()) {
+            for (auto i : {0,1,2,3})
+                uniform[3 - i] = float24::FromFloat32(*(float*)(&buffer.words[i]));
+        } else {
+            // TODO: Untested
+            uniform.w = float24::FromRaw(buffer.words[0] >> 8);
+            uniform.z = float24::FromRaw(((buffer.words[0] & 0xFF) << 16) | ((buffer.words[1] >> 16) & 0xFFFF));
+            uniform.y = float24::FromRaw(((buffer.words[1] & 0xFFFF) << 8) | ((buffer.words[2] >> 24) & 0xFF));
+            uniform.x = float24::FromRaw(buffer.words[2] & 0xFFFFFF);
+        }
+
+        LOG_TRACE(HW_GPU, "Set uniform %x to (%f %f %f %f)", (int)uniform_setup.index,
+                  uniform.x.ToFloat32(), uniform.y.ToFloat32(), uniform.z.ToFloat32(),
+                  uniform.w.ToFloat32());
+
+        for (auto setup : setups)
+            setup->uniforms.f[uniform_setup.index] = uniform;
+
+        // TODO: Verify that this actually modifies the register!
+        uniform_setup.index.Assign(uniform_setup.index + 1);
+    }
+}
+
+/// Whether a batch of triangles was queued in the renderer and not yet drawn
+static bool draw_batch_pending = false;
+
+/// Draws the triangles queued in the renderer
+static void FlushDrawBatch() {
+    if (!draw_batch_pending)
+        return;
+
+    draw_batch_pending = false;
+    VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+
+    if (g_debug_context)
+        g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
+}
+
+/**
+ * Returns whether a register write changes the state triangles are rasterized with. Vertices are
+ * shaded as soon as they are submitted, so only the registers configuring the stages after vertex
+ * processing matter. Writes to data ports and triggers take effect regardless of the value written.
+ */
+static bool IsRasterizerStateChange(u32 id, u32 old_value, u32 new_value) {
+    if (id >= PICA_REG_INDEX(vertex_attributes))
+        return false;
+
+    switch (id) {
+    case PICA_REG_INDEX(trigger_irq):
+    // Render target flush and invalidation triggers
+    case PICA_REG_INDEX(framebuffer):
+    case PICA_REG_INDEX(framebuffer) + 1:
+    case PICA_REG_INDEX_WORKAROUND(fog_lut_data[0], 0xe8):
+    case PICA_REG_INDEX_WORKAROUND(fog_lut_data[1], 0xe9):
+    case PICA_REG_INDEX_WORKAROUND(fog_lut_data[2], 0xea):
+    case PICA_REG_INDEX_WORKAROUND(fog_lut_data[3], 0xeb):
+    case PICA_REG_INDEX_WORKAROUND(fog_lut_data[4], 0xec):
+    case PICA_REG_INDEX_WORKAROUND(fog_lut_data[5], 0xed):
+    case PICA_REG_INDEX_WORKAROUND(fog_lut_data[6], 0xee):
+    case PICA_REG_INDEX_WORKAROUND(fog_lut_data[7], 0xef):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[0], 0x1c8):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[1], 0x1c9):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[2], 0x1ca):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[3], 0x1cb):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[4], 0x1cc):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[5], 0x1cd):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[6], 0x1ce):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[7], 0x1cf):
+        return true;
+
+    default:
+        return old_value != new_value;
+    }
+}
+
 static void WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
@@ -66,7 +212,16 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
     const u32 write_mask = expand_bits_to_bytes[mask];
 
-    regs[id] = (old_value & ~write_mask) | (value & write_mask);
+    const u32 new_value = (old_value & ~write_mask) | (value & write_mask);
+
+    // Triangles queued by the renderer must be rasterized with the state they were submitted with,
+    // consecutive draws sharing the same state are drawn together
+    if (IsRasterizerStateChange(id, old_value, new_value)) {
+        FlushDrawBatch();
+        Rasterizer::FlushTriangles();
+    }
+
+    regs[id] = new_value;
 
     DebugUtils::OnPicaRegWrite({ (u16)id, (u16)mask, regs[id] });
 
@@ -76,15 +231,23 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     switch(id) {
         // Trigger IRQ
         case PICA_REG_INDEX(trigger_irq):
-            GSP_GPU::SignalInterrupt(GSP_GPU::InterruptId::P3D);
+            GPU::SignalInterrupt(GSP_GPU::InterruptId::P3D);
             break;
 
         case PICA_REG_INDEX_WORKAROUND(triangle_topology, 0x25E):
             g_state.primitive_assembler.Reconfigure(regs.triangle_topology);
             break;
 
+        case PICA_REG_INDEX_WORKAROUND(gs_config, 0x252):
+            if (regs.gs_config.mode != Regs::GSMode::Point) {
+                LOG_ERROR(HW_GPU, "Unimplemented geometry shader mode %u, running it in point mode",
+                          static_cast<u32>(regs.gs_config.mode.Value()));
+            }
+            break;
+
         case PICA_REG_INDEX_WORKAROUND(restart_primitive, 0x25F):
             g_state.primitive_assembler.Reset();
+            geometry_pipeline.Reset();
             break;
 
         case PICA_REG_INDEX_WORKAROUND(vs_default_attributes_setup.index, 0x232):
@@ -150,15 +313,21 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                         if (g_debug_context)
                             g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation, static_cast<void*>(&immediate_input));
                         g_state.vs.Run(shader_unit, immediate_input, regs.vs.num_input_attributes+1);
-                        Shader::OutputVertex output_vertex = shader_unit.output_registers.ToVertex(regs.vs);
 
-                        // Send to renderer
-                        using Pica::Shader::OutputVertex;
-                        auto AddTriangle = [](const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
-                            VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
-                        };
+                        if (regs.use_gs == Regs::UseGS::Yes) {
+                            geometry_pipeline.SubmitVertex(shader_unit.output_registers);
+                            geometry_pipeline.Flush(nullptr, 0);
+                        } else {
+                            Shader::OutputVertex output_vertex = shader_unit.output_registers.ToVertex(regs.vs);
+
+                            // Send to renderer
+                            using Pica::Shader::OutputVertex;
+                            auto AddTriangle = [](const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+                                VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
+                            };
 
-                        g_state.primitive_assembler.SubmitVertex(output_vertex, AddTriangle);
+                            g_state.primitive_assembler.SubmitVertex(output_vertex, AddTriangle);
+                        }
                     }
                 }
             }
@@ -167,12 +336,12 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         case PICA_REG_INDEX(gpu_mode):
             if (regs.gpu_mode == Regs::GPUMode::Configuring) {
-                // Draw immediate mode triangles when GPU Mode is set to GPUMode::Configuring
-                VideoCore::g_renderer->Rasterizer()->DrawTriangles();
-
-                if (g_debug_context) {
-                    g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
-                }
+                // Triangles are drawn when GPU Mode is set to GPUMode::Configuring, but the draw is
+                // deferred until the rasterizer state changes so that it can be batched with the
+                // following ones. Draws are kept separate when the debugger breaks after each one.
+                draw_batch_pending = true;
+                if (g_debug_context && g_debug_context->breakpoints[(int)DebugContext::Event::FinishedPrimitiveBatch].enabled)
+                    FlushDrawBatch();
             }
             break;
 
@@ -199,7 +368,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 g_debug_context->OnEvent(DebugContext::Event::IncomingPrimitiveBatch, nullptr);
 
             // Processes information about internal vertex attributes to figure out how a vertex is loaded.
-            // Later, these can be compiled and cached.
+            // The resulting layout is compiled and cached when the JIT is enabled.
             const u32 base_address = regs.vertex_attributes.GetPhysicalBaseAddress();
             VertexLoader loader(regs);
 
@@ -211,6 +380,13 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
             bool index_u16 = index_info.format != 0;
 
+            // Determine the range of vertices referenced by the draw
+            u32 min_vertex = regs.vertex_offset;
+            u32 max_vertex = regs.vertex_offset + regs.num_vertices - 1;
+            if (is_indexed)
+                GetIndexRange(index_address_8, index_u16, regs.num_vertices, min_vertex, max_vertex);
+            loader.PrepareDraw(base_address, min_vertex, max_vertex);
+
             PrimitiveAssembler<Shader::OutputVertex>& primitive_assembler = g_state.primitive_assembler;
 
             if (g_debug_context) {
@@ -227,74 +403,139 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
             DebugUtils::MemoryAccessTracker memory_accesses;
 
-            // Simple circular-replacement vertex cache
-            // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-            const size_t VERTEX_CACHE_SIZE = 32;
-            std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-            std::array<Shader::OutputRegisters, VERTEX_CACHE_SIZE> vertex_cache;
-
-            unsigned int vertex_cache_pos = 0;
-            vertex_cache_ids.fill(-1);
-
-            Shader::UnitState<false> shader_unit;
             g_state.vs.Setup();
 
-            for (unsigned int index = 0; index < regs.num_vertices; ++index)
-            {
-                // Indexed rendering doesn't use the start offset
-                unsigned int vertex = is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index]) : (index + regs.vertex_offset);
-
-                // -1 is a common special value used for primitive restart. Since it's unknown if
-                // the PICA supports it, and it would mess up the caching, guard against it here.
-                ASSERT(vertex != -1);
-
-                bool vertex_cache_hit = false;
-                Shader::OutputRegisters output_registers;
-
-                if (is_indexed) {
-                    if (g_debug_context && Pica::g_debug_context->recorder) {
-                        int size = index_u16 ? 2 : 1;
-                        memory_accesses.AddAccess(base_address + index_info.offset + size * index, size);
-                    }
+            // Send to renderer
+            using Pica::Shader::OutputVertex;
+            auto AddTriangle = [](
+                    const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+                VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
+            };
 
-                    for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                        if (vertex == vertex_cache_ids[i]) {
-                            output_registers = vertex_cache[i];
-                            vertex_cache_hit = true;
-                            break;
-                        }
-                    }
+            // Returns the vertex referenced by the given index of the draw
+            auto GetVertex = [&](unsigned int index) -> unsigned int {
+                // Indexed rendering doesn't use the start offset
+                return is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index]) : (index + regs.vertex_offset);
+            };
+
+            // For indexed draws, the index array is scanned up front and each referenced vertex is
+            // assigned a slot of the vertex cache. Every slot is shaded once, then the primitives
+            // are assembled from the cached vertices.
+            if (is_indexed) {
+                if (g_debug_context && Pica::g_debug_context->recorder) {
+                    int size = index_u16 ? 2 : 1;
+                    memory_accesses.AddAccess(base_address + index_info.offset, size * regs.num_vertices);
                 }
 
-                if (!vertex_cache_hit) {
-                    // Initialize data for the current vertex
-                    Shader::InputVertex input;
-                    loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+                vertex_cache.Setup(index_address_8, index_u16, regs.num_vertices, min_vertex, max_vertex);
 
-                    // Send to vertex shader
-                    if (g_debug_context)
-                        g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation, (void*)&input);
-                    g_state.vs.Run(shader_unit, input, loader.GetNumTotalAttributes());
-                    output_registers = shader_unit.output_registers;
-
-                    if (is_indexed) {
-                        vertex_cache[vertex_cache_pos] = output_registers;
-                        vertex_cache_ids[vertex_cache_pos] = vertex;
-                        vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                MICROPROFILE_META_CPU("Vertex cache hits", regs.num_vertices - vertex_cache.GetNumVertices());
+                MICROPROFILE_META_CPU("Vertex cache misses", vertex_cache.GetNumVertices());
+            }
+            const unsigned int num_shaded = is_indexed ? vertex_cache.GetNumVertices() : regs.num_vertices;
+
+            const unsigned int parallel_threshold = VideoCore::g_parallel_vertex_threshold;
+            const bool serial = g_debug_context && g_debug_context->RequiresSerialDraws();
+            const bool parallel = vertex_thread_pool && parallel_threshold != 0 && num_shaded >= parallel_threshold && !serial;
+
+            // Loads and shades the vertices [begin, end) of the vertex cache slots or of the draw,
+            // passing the output registers to `store` in order. Vertices are run through the vertex
+            // shader in batches of up to Shader::BATCH_SIZE.
+            auto ShadeVertices = [&](unsigned int begin, unsigned int end, Shader::UnitState<false>& shader_unit,
+                                     Shader::BatchUnitState& batch_unit, DebugUtils::MemoryAccessTracker& vertex_accesses,
+                                     auto&& store) {
+                for (unsigned int batch_start = begin; batch_start < end; batch_start += Shader::BATCH_SIZE)
+                {
+                    const unsigned int batch_end = std::min<unsigned int>(batch_start + Shader::BATCH_SIZE, end);
+
+                    std::array<Shader::InputVertex, Shader::BATCH_SIZE> shader_inputs;
+                    std::array<Shader::OutputRegisters, Shader::BATCH_SIZE> shader_outputs;
+
+                    for (unsigned int i = batch_start; i < batch_end; ++i) {
+                        // The slot is reported as the index of cached vertices
+                        unsigned int index = i;
+                        unsigned int vertex = is_indexed ? vertex_cache.GetVertex(i) : GetVertex(i);
+
+                        // -1 is a common special value used for primitive restart. Since it's unknown if
+                        // the PICA supports it, and it would mess up the caching, guard against it here.
+                        ASSERT(vertex != -1);
+
+                        // Initialize data for the current vertex
+                        Shader::InputVertex& input = shader_inputs[i - batch_start];
+                        loader.LoadVertex(base_address, index, vertex, input, vertex_accesses);
+
+                        if (!parallel && g_debug_context)
+                            g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation, (void*)&input);
                     }
-                }
 
-                // Retreive vertex from register data
-                Shader::OutputVertex output_vertex = output_registers.ToVertex(regs.vs);
+                    // Send to vertex shader
+                    g_state.vs.RunBatch(shader_unit, batch_unit, shader_inputs.data(), shader_outputs.data(), batch_end - batch_start, loader.GetNumTotalAttributes());
 
-                // Send to renderer
-                using Pica::Shader::OutputVertex;
-                auto AddTriangle = [](
-                        const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
-                    VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
-                };
+                    for (unsigned int i = batch_start; i < batch_end; ++i)
+                        store(i, shader_outputs[i - batch_start]);
+                }
+            };
+
+            // Shades the first `count` vertex cache slots or vertices of the draw. Large draws are split
+            // into chunks processed by the thread pool, each thread with its own shader unit, in which
+            // case `store` is called out of order.
+            auto ShadeAllVertices = [&](unsigned int count, auto&& store) {
+                if (parallel) {
+                    const size_t num_threads = vertex_thread_pool->GetNumThreads();
+                    std::vector<Shader::UnitState<false>> shader_units(num_threads);
+                    std::vector<Shader::BatchUnitState> batch_units(num_threads);
+
+                    const unsigned int num_chunks = (count + PARALLEL_VERTEX_CHUNK_SIZE - 1) / PARALLEL_VERTEX_CHUNK_SIZE;
+                    vertex_thread_pool->ParallelFor(num_chunks, [&](size_t chunk, size_t thread) {
+                        const unsigned int begin = static_cast<unsigned int>(chunk) * PARALLEL_VERTEX_CHUNK_SIZE;
+                        const unsigned int end = std::min<unsigned int>(begin + PARALLEL_VERTEX_CHUNK_SIZE, count);
+
+                        // Memory accesses are only tracked while recording, which disables this path
+                        DebugUtils::MemoryAccessTracker chunk_memory_accesses;
+                        ShadeVertices(begin, end, shader_units[thread], batch_units[thread], chunk_memory_accesses, store);
+                    });
+                } else {
+                    Shader::UnitState<false> shader_unit;
+                    Shader::BatchUnitState batch_unit;
+                    ShadeVertices(0, count, shader_unit, batch_unit, memory_accesses, store);
+                }
+            };
+
+            if (regs.use_gs == Regs::UseGS::Yes) {
+                // The geometry shader receives the output registers of the vertex shader, which are
+                // kept for each vertex cache slot or vertex of the draw, then submitted in draw order
+                vs_outputs.resize(num_shaded);
+                ShadeAllVertices(num_shaded, [&](unsigned int index, const Shader::OutputRegisters& output) {
+                    vs_outputs[index] = output;
+                });
+
+                for (unsigned int index = 0; index < regs.num_vertices; ++index) {
+                    const unsigned int slot = is_indexed ? vertex_cache.GetSlot(GetVertex(index)) : index;
+                    geometry_pipeline.SubmitVertex(vs_outputs[slot]);
+                }
 
-                primitive_assembler.SubmitVertex(output_vertex, AddTriangle);
+                geometry_pipeline.Flush(serial ? nullptr : vertex_thread_pool.get(), parallel_threshold);
+            } else if (is_indexed) {
+                ShadeAllVertices(num_shaded, [&](unsigned int slot, const Shader::OutputRegisters& output) {
+                    vertex_cache.Get(slot) = output.ToVertex(regs.vs);
+                });
+
+                for (unsigned int index = 0; index < regs.num_vertices; ++index)
+                    primitive_assembler.SubmitVertex(vertex_cache.Get(vertex_cache.GetSlot(GetVertex(index))), AddTriangle);
+            } else if (parallel) {
+                // The vertices are assembled in order once all chunks are done
+                std::vector<Shader::OutputVertex> output_vertices(regs.num_vertices);
+                ShadeAllVertices(regs.num_vertices, [&](unsigned int index, const Shader::OutputRegisters& output) {
+                    output_vertices[index] = output.ToVertex(regs.vs);
+                });
+
+                for (auto& output_vertex : output_vertices)
+                    primitive_assembler.SubmitVertex(output_vertex, AddTriangle);
+            } else {
+                ShadeAllVertices(regs.num_vertices, [&](unsigned int index, const Shader::OutputRegisters& output) {
+                    Shader::OutputVertex output_vertex = output.ToVertex(regs.vs);
+                    primitive_assembler.SubmitVertex(output_vertex, AddTriangle);
+                });
             }
 
             for (auto& range : memory_accesses.ranges) {
@@ -305,10 +546,66 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             break;
         }
 
-        case PICA_REG_INDEX(vs.bool_uniforms):
-            for (unsigned i = 0; i < 16; ++i)
-                g_state.vs.uniforms.b[i] = (regs.vs.bool_uniforms.Value() & (1 << i)) != 0;
+        case PICA_REG_INDEX(gs.bool_uniforms):
+            WriteUniformBoolReg(g_state.gs, regs.gs.bool_uniforms);
+            break;
 
+        case PICA_REG_INDEX_WORKAROUND(gs.int_uniforms[0], 0x281):
+        case PICA_REG_INDEX_WORKAROUND(gs.int_uniforms[1], 0x282):
+        case PICA_REG_INDEX_WORKAROUND(gs.int_uniforms[2], 0x283):
+        case PICA_REG_INDEX_WORKAROUND(gs.int_uniforms[3], 0x284):
+        {
+            unsigned index = (id - PICA_REG_INDEX_WORKAROUND(gs.int_uniforms[0], 0x281));
+            WriteUniformIntReg(g_state.gs, index, regs.gs.int_uniforms[index]);
+            break;
+        }
+
+        case PICA_REG_INDEX_WORKAROUND(gs.uniform_setup.set_value[0], 0x291):
+        case PICA_REG_INDEX_WORKAROUND(gs.uniform_setup.set_value[1], 0x292):
+        case PICA_REG_INDEX_WORKAROUND(gs.uniform_setup.set_value[2], 0x293):
+        case PICA_REG_INDEX_WORKAROUND(gs.uniform_setup.set_value[3], 0x294):
+        case PICA_REG_INDEX_WORKAROUND(gs.uniform_setup.set_value[4], 0x295):
+        case PICA_REG_INDEX_WORKAROUND(gs.uniform_setup.set_value[5], 0x296):
+        case PICA_REG_INDEX_WORKAROUND(gs.uniform_setup.set_value[6], 0x297):
+        case PICA_REG_INDEX_WORKAROUND(gs.uniform_setup.set_value[7], 0x298):
+            WriteUniformFloatReg(regs.gs, gs_uniform_write_buffer, value, { &g_state.gs });
+            break;
+
+        // Load geometry shader program code
+        case PICA_REG_INDEX_WORKAROUND(gs.program.set_word[0], 0x29c):
+        case PICA_REG_INDEX_WORKAROUND(gs.program.set_word[1], 0x29d):
+        case PICA_REG_INDEX_WORKAROUND(gs.program.set_word[2], 0x29e):
+        case PICA_REG_INDEX_WORKAROUND(gs.program.set_word[3], 0x29f):
+        case PICA_REG_INDEX_WORKAROUND(gs.program.set_word[4], 0x2a0):
+        case PICA_REG_INDEX_WORKAROUND(gs.program.set_word[5], 0x2a1):
+        case PICA_REG_INDEX_WORKAROUND(gs.program.set_word[6], 0x2a2):
+        case PICA_REG_INDEX_WORKAROUND(gs.program.set_word[7], 0x2a3):
+        {
+            g_state.gs.program_code[regs.gs.program.offset] = value;
+            regs.gs.program.offset++;
+            break;
+        }
+
+        // Load geometry shader swizzle pattern data
+        case PICA_REG_INDEX_WORKAROUND(gs.swizzle_patterns.set_word[0], 0x2a6):
+        case PICA_REG_INDEX_WORKAROUND(gs.swizzle_patterns.set_word[1], 0x2a7):
+        case PICA_REG_INDEX_WORKAROUND(gs.swizzle_patterns.set_word[2], 0x2a8):
+        case PICA_REG_INDEX_WORKAROUND(gs.swizzle_patterns.set_word[3], 0x2a9):
+        case PICA_REG_INDEX_WORKAROUND(gs.swizzle_patterns.set_word[4], 0x2aa):
+        case PICA_REG_INDEX_WORKAROUND(gs.swizzle_patterns.set_word[5], 0x2ab):
+        case PICA_REG_INDEX_WORKAROUND(gs.swizzle_patterns.set_word[6], 0x2ac):
+        case PICA_REG_INDEX_WORKAROUND(gs.swizzle_patterns.set_word[7], 0x2ad):
+        {
+            g_state.gs.swizzle_data[regs.gs.swizzle_patterns.offset] = value;
+            regs.gs.swizzle_patterns.offset++;
+            break;
+        }
+
+        // Unless the geometry shader unit is configured separately, the vertex shader configuration
+        // is also written to it
+        case PICA_REG_INDEX(vs.bool_uniforms):
+            for (auto setup : GetVertexShaderSetups())
+                WriteUniformBoolReg(*setup, regs.vs.bool_uniforms);
             break;
 
         case PICA_REG_INDEX_WORKAROUND(vs.int_uniforms[0], 0x2b1):
@@ -316,11 +613,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         case PICA_REG_INDEX_WORKAROUND(vs.int_uniforms[2], 0x2b3):
         case PICA_REG_INDEX_WORKAROUND(vs.int_uniforms[3], 0x2b4):
         {
-            int index = (id - PICA_REG_INDEX_WORKAROUND(vs.int_uniforms[0], 0x2b1));
-            auto values = regs.vs.int_uniforms[index];
-            g_state.vs.uniforms.i[index] = Math::Vec4<u8>(values.x, values.y, values.z, values.w);
-            LOG_TRACE(HW_GPU, "Set integer uniform %d to %02x %02x %02x %02x",
-                      index, values.x.Value(), values.y.Value(), values.z.Value(), values.w.Value());
+            unsigned index = (id - PICA_REG_INDEX_WORKAROUND(vs.int_uniforms[0], 0x2b1));
+            for (auto setup : GetVertexShaderSetups())
+                WriteUniformIntReg(*setup, index, regs.vs.int_uniforms[index]);
             break;
         }
 
@@ -332,48 +627,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[5], 0x2c6):
         case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[6], 0x2c7):
         case PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[7], 0x2c8):
-        {
-            auto& uniform_setup = regs.vs.uniform_setup;
-
-            // TODO: Does actual hardware indeed keep an intermediate buffer or does
-            //       it directly write the values?
-            uniform_write_buffer[float_regs_counter++] = value;
-
-            // Uniforms are written in a packed format such that four float24 values are encoded in
-            // three 32-bit numbers. We write to internal memory once a full such vector is
-            // written.
-            if ((float_regs_counter >= 4 && uniform_setup.IsFloat32()) ||
-                (float_regs_counter >= 3 && !uniform_setup.IsFloat32())) {
-                float_regs_counter = 0;
-
-                auto& uniform = g_state.vs.uniforms.f[uniform_setup.index];
-
-                if (uniform_setup.index > 95) {
-                    LOG_ERROR(HW_GPU, "Invalid VS uniform index %d", (int)uniform_setup.index);
-                    break;
-                }
-
-                // NOTE: The destination component order indeed is "backwards"
-                if (uniform_setup.IsFloat32()) {
-                    for (auto i : {0,1,2,3})
-                        uniform[3 - i] = float24::FromFloat32(*(float*)(&uniform_write_buffer[i]));
-                } else {
-                    // TODO: Untested
-                    uniform.w = float24::FromRaw(uniform_write_buffer[0] >> 8);
-                    uniform.z = float24::FromRaw(((uniform_write_buffer[0] & 0xFF) << 16) | ((uniform_write_buffer[1] >> 16) & 0xFFFF));
-                    uniform.y = float24::FromRaw(((uniform_write_buffer[1] & 0xFFFF) << 8) | ((uniform_write_buffer[2] >> 24) & 0xFF));
-                    uniform.x = float24::FromRaw(uniform_write_buffer[2] & 0xFFFFFF);
-                }
-
-                LOG_TRACE(HW_GPU, "Set uniform %x to (%f %f %f %f)", (int)uniform_setup.index,
-                          uniform.x.ToFloat32(), uniform.y.ToFloat32(), uniform.z.ToFloat32(),
-                          uniform.w.ToFloat32());
-
-                // TODO: Verify that this actually modifies the register!
-                uniform_setup.index.Assign(uniform_setup.index + 1);
-            }
+            WriteUniformFloatReg(regs.vs, vs_uniform_write_buffer, value, GetVertexShaderSetups());
             break;
-        }
 
         // Load shader program code
         case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[0], 0x2cc):
@@ -385,7 +640,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[6], 0x2d2):
         case PICA_REG_INDEX_WORKAROUND(vs.program.set_word[7], 0x2d3):
         {
-            g_state.vs.program_code[regs.vs.program.offset] = value;
+            for (auto setup : GetVertexShaderSetups())
+                setup->program_code[regs.vs.program.offset] = value;
             regs.vs.program.offset++;
             break;
         }
@@ -400,7 +656,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         case PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[6], 0x2dc):
         case PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[7], 0x2dd):
         {
-            g_state.vs.swizzle_data[regs.vs.swizzle_patterns.offset] = value;
+            for (auto setup : GetVertexShaderSetups())
+                setup->swizzle_data[regs.vs.swizzle_patterns.offset] = value;
             regs.vs.swizzle_patterns.offset++;
             break;
         }
@@ -447,6 +704,17 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         g_debug_context->OnEvent(DebugContext::Event::PicaCommandProcessed, reinterpret_cast<void*>(&id));
 }
 
+void Init() {
+    // The emulation thread takes part in processing the vertices, so one thread less is started
+    const unsigned int num_threads = std::thread::hardware_concurrency();
+    if (num_threads > 1)
+        vertex_thread_pool = std::make_unique<Common::ThreadPool>(num_threads - 1);
+}
+
+void Shutdown() {
+    vertex_thread_pool.reset();
+}
+
 void ProcessCommandList(const u32* list, u32 size) {
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = list;
     g_state.cmd_list.length = size / sizeof(u32);
@@ -467,6 +735,9 @@ void ProcessCommandList(const u32* list, u32 size) {
             WritePicaReg(cmd, *g_state.cmd_list.current_ptr++, header.parameter_mask);
          }
     }
+
+    // The results of the command list may be accessed as soon as it's processed
+    FlushDrawBatch();
 }
 
 } // namespace
@@ -35,6 +35,12 @@ static_assert(std::is_standard_layout<CommandHeader>::value == true,
               "CommandHeader does not use standard layout");
 static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect size!");
 
+/// Starts the threads used to process the vertices of large draws
+void Init();
+
+/// Stops the threads started by Init
+void Shutdown();
+
 void ProcessCommandList(const u32* list, u32 size);
 
 } // namespace
@@ -150,6 +150,15 @@ public:
         Resume();
     }
 
+    /**
+     * Whether draws have to be processed in order on the emulation thread, because the CiTrace
+     * recorder logs their memory accesses or a breakpoint inspects their vertices or results.
+     */
+    bool RequiresSerialDraws() const {
+        return recorder != nullptr || breakpoints[(int)Event::VertexShaderInvocation].enabled ||
+               breakpoints[(int)Event::FinishedPrimitiveBatch].enabled;
+    }
+
     // TODO: Evaluate if access to these members should be hidden behind a public interface.
     std::array<BreakPoint, (int)Event::NumEvents> breakpoints;
     Event active_breakpoint;
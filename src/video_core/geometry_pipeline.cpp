@@ -0,0 +1,103 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "common/microprofile.h"
+#include "common/thread_pool.h"
+
+#include "video_core/geometry_pipeline.h"
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace Pica {
+
+/// Number of geometry shader invocations run by each task of a parallel flush
+static const size_t PARALLEL_INVOCATION_CHUNK_SIZE = 64;
+
+MICROPROFILE_DEFINE(GPU_GeometryShader, "GPU", "Geometry Shader", MP_RGB(100, 50, 240));
+
+void GeometryPipeline::Reset() {
+    next_attribute = 0;
+    invocations.clear();
+}
+
+void GeometryPipeline::SubmitVertex(const Shader::OutputRegisters& vs_output) {
+    const auto& regs = g_state.regs;
+    const unsigned num_attributes = regs.gs.num_input_attributes + 1;
+
+    for (unsigned i = 0; i < 16; ++i) {
+        if ((regs.vs.output_mask & (1 << i)) == 0)
+            continue;
+
+        next_input.attr[next_attribute++] = vs_output.value[i];
+        if (next_attribute >= num_attributes) {
+            invocations.push_back(next_input);
+            next_attribute = 0;
+        }
+    }
+}
+
+/**
+ * Runs the geometry shader for a range of invocations, appending the vertices of the emitted
+ * triangles to `triangles`. The emitter is reset for each invocation, so that the result doesn't
+ * depend on how the invocations are split between threads.
+ */
+static void RunInvocations(const Shader::InputVertex* inputs, size_t count, Shader::UnitState<false>& shader_unit,
+                           std::vector<Shader::OutputVertex>& triangles) {
+    const int num_attributes = g_state.regs.gs.num_input_attributes + 1;
+
+    Shader::GSEmitter emitter;
+    emitter.triangles = &triangles;
+    shader_unit.emitter_ptr = &emitter;
+
+    for (size_t i = 0; i < count; ++i) {
+        emitter.vertex_id = 0;
+        emitter.prim_emit = false;
+        emitter.winding = false;
+        g_state.gs.Run(shader_unit, inputs[i], num_attributes);
+    }
+
+    shader_unit.emitter_ptr = nullptr;
+}
+
+void GeometryPipeline::Flush(Common::ThreadPool* thread_pool, unsigned parallel_threshold) {
+    if (invocations.empty())
+        return;
+
+    MICROPROFILE_SCOPE(GPU_GeometryShader);
+
+    g_state.gs.Setup();
+
+    // Each chunk of invocations emits its triangles into its own batch, the batches are sent to the
+    // rasterizer in order once all chunks are done
+    const bool parallel = thread_pool && parallel_threshold != 0 && invocations.size() >= parallel_threshold;
+    const size_t chunk_size = parallel ? PARALLEL_INVOCATION_CHUNK_SIZE : invocations.size();
+    const size_t num_chunks = (invocations.size() + chunk_size - 1) / chunk_size;
+    std::vector<std::vector<Shader::OutputVertex>> batches(num_chunks);
+
+    if (parallel) {
+        std::vector<Shader::UnitState<false>> shader_units(thread_pool->GetNumThreads());
+        thread_pool->ParallelFor(num_chunks, [&](size_t chunk, size_t thread) {
+            const size_t begin = chunk * chunk_size;
+            const size_t count = std::min(chunk_size, invocations.size() - begin);
+            RunInvocations(&invocations[begin], count, shader_units[thread], batches[chunk]);
+        });
+    } else {
+        Shader::UnitState<false> shader_unit;
+        RunInvocations(invocations.data(), invocations.size(), shader_unit, batches[0]);
+    }
+    invocations.clear();
+
+    auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+    for (const auto& batch : batches) {
+        for (size_t i = 0; i + 2 < batch.size(); i += 3)
+            rasterizer->AddTriangle(batch[i], batch[i + 1], batch[i + 2]);
+    }
+}
+
+} // namespace
@@ -0,0 +1,50 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "video_core/shader/shader.h"
+
+namespace Common {
+class ThreadPool;
+}
+
+namespace Pica {
+
+/**
+ * Geometry shader stage, run between the vertex shader and the rasterizer if Regs::use_gs is set.
+ * The enabled output registers of each vertex shader invocation are appended to the input
+ * attributes of the geometry shader, which is invoked each time all of its attributes are present.
+ *
+ * Invocations are queued until Flush, which runs them in batches and sends the emitted triangles
+ * to the rasterizer in order. Only the point input mode (Regs::GSMode::Point) is implemented, the
+ * other modes are run as if they were point mode.
+ */
+class GeometryPipeline {
+public:
+    /// Discards the attributes gathered for the next invocation and any queued invocation
+    void Reset();
+
+    /// Appends the output registers of a vertex shader invocation to the geometry shader inputs
+    void SubmitVertex(const Shader::OutputRegisters& vs_output);
+
+    /**
+     * Runs the queued invocations of the geometry shader and sends the emitted triangles to the
+     * rasterizer.
+     * @param thread_pool Threads running the invocations if there are at least `parallel_threshold`
+     *                    of them, may be null
+     * @param parallel_threshold Minimum number of invocations run in parallel, 0 to disable
+     */
+    void Flush(Common::ThreadPool* thread_pool, unsigned parallel_threshold);
+
+private:
+    Shader::InputVertex next_input;
+    unsigned next_attribute = 0;
+
+    std::vector<Shader::InputVertex> invocations;
+};
+
+} // namespace
@@ -0,0 +1,377 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+
+#include "video_core/gpu_transfer.h"
+#include "video_core/utils.h"
+
+namespace VideoCore {
+
+using PixelFormat = GPU::Regs::PixelFormat;
+using DisplayTransferConfig = GPU::Regs::DisplayTransferConfig;
+using ScalingMode = DisplayTransferConfig::ScalingMode;
+
+/// Size of a fill pattern, which holds a whole number of 16-bit, 24-bit and 32-bit values
+constexpr size_t FILL_PATTERN_SIZE = 48;
+
+/// Repeats a pattern of FILL_PATTERN_SIZE bytes over a region
+static void FillPattern(u8* dest, size_t size, const u8* pattern) {
+    size_t offset = 0;
+
+#ifdef ARCHITECTURE_x86_64
+    const __m128i pattern0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+    const __m128i pattern1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + 16));
+    const __m128i pattern2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + 32));
+    for (; offset + FILL_PATTERN_SIZE <= size; offset += FILL_PATTERN_SIZE) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset), pattern0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset + 16), pattern1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset + 32), pattern2);
+    }
+#else
+    for (; offset + FILL_PATTERN_SIZE <= size; offset += FILL_PATTERN_SIZE)
+        std::memcpy(dest + offset, pattern, FILL_PATTERN_SIZE);
+#endif
+
+    std::memcpy(dest + offset, pattern, size - offset);
+}
+
+void MemoryFill(const GPU::Regs::MemoryFillConfig& config, u8* start, u8* end) {
+    MemoryFillPart(config, start, end, start, end);
+}
+
+void MemoryFillPart(const GPU::Regs::MemoryFillConfig& config, u8* region_start, u8* region_end, u8* start, u8* end) {
+    if (end <= start)
+        return;
+
+    u8 value[4];
+    size_t value_size;
+    if (config.fill_24bit) {
+        // fill with 24-bit values
+        value[0] = config.value_24bit_r;
+        value[1] = config.value_24bit_g;
+        value[2] = config.value_24bit_b;
+        value_size = 3;
+    } else if (config.fill_32bit) {
+        // fill with 32-bit values
+        const u32 value_32bit = config.value_32bit;
+        std::memcpy(value, &value_32bit, sizeof(u32));
+        value_size = sizeof(u32);
+    } else {
+        // fill with 16-bit values
+        const u16 value_16bit = config.value_16bit.Value();
+        std::memcpy(value, &value_16bit, sizeof(u16));
+        value_size = sizeof(u16);
+    }
+
+    // The pattern starts at the byte of the value which the part starts at
+    const size_t offset = start - region_start;
+    u8 pattern[FILL_PATTERN_SIZE];
+    for (size_t i = 0; i < FILL_PATTERN_SIZE; ++i)
+        pattern[i] = value[(offset + i) % value_size];
+
+    // 32-bit fills stop at the last whole value of the region, the others complete it
+    const size_t region_size = region_end - region_start;
+    const size_t values = config.fill_32bit ? region_size / value_size : (region_size + value_size - 1) / value_size;
+    const size_t fill_end = end == region_end ? values * value_size : std::min<size_t>(end - region_start, values * value_size);
+    const size_t fill_size = fill_end > offset ? fill_end - offset : 0;
+
+    FillPattern(start, fill_size, pattern);
+}
+
+static bool IsKnownFormat(PixelFormat format) {
+    return format == PixelFormat::RGBA8 || format == PixelFormat::RGB8 || format == PixelFormat::RGB565 ||
+           format == PixelFormat::RGB5A1 || format == PixelFormat::RGBA4;
+}
+
+static Math::Vec4<u8> DecodePixel(PixelFormat input_format, const u8* src_pixel) {
+    switch (input_format) {
+    case PixelFormat::RGBA8:
+        return Color::DecodeRGBA8(src_pixel);
+
+    case PixelFormat::RGB8:
+        return Color::DecodeRGB8(src_pixel);
+
+    case PixelFormat::RGB565:
+        return Color::DecodeRGB565(src_pixel);
+
+    case PixelFormat::RGB5A1:
+        return Color::DecodeRGB5A1(src_pixel);
+
+    case PixelFormat::RGBA4:
+        return Color::DecodeRGBA4(src_pixel);
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown source framebuffer format %x", static_cast<u32>(input_format));
+        return {0, 0, 0, 0};
+    }
+}
+
+static void EncodePixel(PixelFormat output_format, const Math::Vec4<u8>& color, u8* dst_pixel) {
+    switch (output_format) {
+    case PixelFormat::RGBA8:
+        Color::EncodeRGBA8(color, dst_pixel);
+        break;
+
+    case PixelFormat::RGB8:
+        Color::EncodeRGB8(color, dst_pixel);
+        break;
+
+    case PixelFormat::RGB565:
+        Color::EncodeRGB565(color, dst_pixel);
+        break;
+
+    case PixelFormat::RGB5A1:
+        Color::EncodeRGB5A1(color, dst_pixel);
+        break;
+
+    case PixelFormat::RGBA4:
+        Color::EncodeRGBA4(color, dst_pixel);
+        break;
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown destination framebuffer format %x", static_cast<u32>(output_format));
+        break;
+    }
+}
+
+/// Transfers a pixel at a time, for the setups not handled by the row conversions
+static void DisplayTransferPixels(const DisplayTransferConfig& config, const u8* src_pointer, u8* dst_pointer) {
+    int horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    int vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+
+    u32 output_width = config.output_width >> horizontal_scale;
+    u32 output_height = config.output_height >> vertical_scale;
+
+    u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
+    u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
+
+    for (u32 y = 0; y < output_height; ++y) {
+        // Calculate the y position of the input image based on the current output position and
+        // the scale. Flipping only moves the output row, after the input position is known.
+        u32 input_y = y << vertical_scale;
+        u32 output_y = config.flip_vertically ? output_height - y - 1 : y;
+
+        for (u32 x = 0; x < output_width; ++x) {
+            Math::Vec4<u8> src_color;
+
+            u32 input_x = x << horizontal_scale;
+
+            u32 src_offset;
+            u32 dst_offset;
+
+            if (config.input_linear) {
+                if (!config.dont_swizzle) {
+                    // Interpret the input as linear and the output as tiled
+                    u32 coarse_y = output_y & ~7;
+                    u32 stride = output_width * dst_bytes_per_pixel;
+
+                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) + coarse_y * stride;
+                } else {
+                    // Both input and output are linear
+                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                }
+            } else {
+                if (!config.dont_swizzle) {
+                    // Interpret the input as tiled and the output as linear
+                    u32 coarse_y = input_y & ~7;
+                    u32 stride = config.input_width * src_bytes_per_pixel;
+
+                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) + coarse_y * stride;
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                } else {
+                    // Both input and output are tiled
+                    u32 out_coarse_y = output_y & ~7;
+                    u32 out_stride = output_width * dst_bytes_per_pixel;
+
+                    u32 in_coarse_y = input_y & ~7;
+                    u32 in_stride = config.input_width * src_bytes_per_pixel;
+
+                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) + in_coarse_y * in_stride;
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) + out_coarse_y * out_stride;
+                }
+            }
+
+            const u8* src_pixel = src_pointer + src_offset;
+            src_color = DecodePixel(config.input_format, src_pixel);
+            if (config.scaling == config.ScaleX) {
+                Math::Vec4<u8> pixel = DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
+                src_color = ((src_color + pixel) / 2).Cast<u8>();
+            } else if (config.scaling == config.ScaleXY) {
+                Math::Vec4<u8> pixel1 = DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
+                Math::Vec4<u8> pixel2 = DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
+                Math::Vec4<u8> pixel3 = DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
+                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+            }
+
+            EncodePixel(config.output_format, src_color, dst_pointer + dst_offset);
+        }
+    }
+}
+
+static constexpr int PixelSize(PixelFormat format) {
+    return format == PixelFormat::RGBA8 ? 4 : format == PixelFormat::RGB8 ? 3 : 2;
+}
+
+using ConvertRowFunc = void (*)(const u8* src, int src_stride, u8* dst, int width);
+
+/**
+ * Converts a row of output pixels, downscaling the input with a box filter.
+ * @param src First input row, pixels being linear
+ * @param src_stride Distance in bytes to the second input row, used by ScaleXY
+ * @param dst Output row
+ * @param width Number of output pixels
+ */
+template <PixelFormat input_format, PixelFormat output_format, ScalingMode scaling>
+static void ConvertRow(const u8* src, int src_stride, u8* dst, int width) {
+    constexpr int src_bytes_per_pixel = PixelSize(input_format);
+    constexpr int dst_bytes_per_pixel = PixelSize(output_format);
+
+    if (input_format == output_format && scaling == DisplayTransferConfig::NoScale) {
+        std::memcpy(dst, src, width * dst_bytes_per_pixel);
+        return;
+    }
+
+    for (int x = 0; x < width; ++x) {
+        const u8* src_pixel = src + (x << (scaling != DisplayTransferConfig::NoScale)) * src_bytes_per_pixel;
+        Math::Vec4<u8> color = DecodePixel(input_format, src_pixel);
+        if (scaling == DisplayTransferConfig::ScaleX) {
+            Math::Vec4<u8> pixel = DecodePixel(input_format, src_pixel + src_bytes_per_pixel);
+            color = ((color + pixel) / 2).Cast<u8>();
+        } else if (scaling == DisplayTransferConfig::ScaleXY) {
+            Math::Vec4<u8> pixel1 = DecodePixel(input_format, src_pixel + src_bytes_per_pixel);
+            Math::Vec4<u8> pixel2 = DecodePixel(input_format, src_pixel + src_stride);
+            Math::Vec4<u8> pixel3 = DecodePixel(input_format, src_pixel + src_stride + src_bytes_per_pixel);
+            color = (((color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+        }
+        EncodePixel(output_format, color, dst + x * dst_bytes_per_pixel);
+    }
+}
+
+template <PixelFormat input_format, PixelFormat output_format>
+static ConvertRowFunc GetConvertRowFunc(ScalingMode scaling) {
+    switch (scaling) {
+    case DisplayTransferConfig::ScaleX:
+        return ConvertRow<input_format, output_format, DisplayTransferConfig::ScaleX>;
+    case DisplayTransferConfig::ScaleXY:
+        return ConvertRow<input_format, output_format, DisplayTransferConfig::ScaleXY>;
+    default:
+        return ConvertRow<input_format, output_format, DisplayTransferConfig::NoScale>;
+    }
+}
+
+template <PixelFormat input_format>
+static ConvertRowFunc GetConvertRowFunc(PixelFormat output_format, ScalingMode scaling) {
+    switch (output_format) {
+    case PixelFormat::RGBA8:
+        return GetConvertRowFunc<input_format, PixelFormat::RGBA8>(scaling);
+    case PixelFormat::RGB8:
+        return GetConvertRowFunc<input_format, PixelFormat::RGB8>(scaling);
+    case PixelFormat::RGB565:
+        return GetConvertRowFunc<input_format, PixelFormat::RGB565>(scaling);
+    case PixelFormat::RGB5A1:
+        return GetConvertRowFunc<input_format, PixelFormat::RGB5A1>(scaling);
+    default:
+        return GetConvertRowFunc<input_format, PixelFormat::RGBA4>(scaling);
+    }
+}
+
+/// Returns the row conversion between two known formats, specialized to let the compiler inline the pixel codecs
+static ConvertRowFunc GetConvertRowFunc(PixelFormat input_format, PixelFormat output_format, ScalingMode scaling) {
+    switch (input_format) {
+    case PixelFormat::RGBA8:
+        return GetConvertRowFunc<PixelFormat::RGBA8>(output_format, scaling);
+    case PixelFormat::RGB8:
+        return GetConvertRowFunc<PixelFormat::RGB8>(output_format, scaling);
+    case PixelFormat::RGB565:
+        return GetConvertRowFunc<PixelFormat::RGB565>(output_format, scaling);
+    case PixelFormat::RGB5A1:
+        return GetConvertRowFunc<PixelFormat::RGB5A1>(output_format, scaling);
+    default:
+        return GetConvertRowFunc<PixelFormat::RGBA4>(output_format, scaling);
+    }
+}
+
+void DisplayTransfer(const DisplayTransferConfig& config, const u8* src, u8* dst) {
+    const int horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    const int vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+
+    const int output_width = config.output_width >> horizontal_scale;
+    const int output_height = config.output_height >> vertical_scale;
+    const int input_width = config.input_width;
+
+    const bool input_tiled = !config.input_linear;
+    // Swizzling converts between linear and tiled, so the output is tiled if exactly one is set
+    const bool output_tiled = config.input_linear != config.dont_swizzle;
+
+    // Tiled images are handled a row of tiles at a time
+    const bool aligned = (!input_tiled || input_width % 8 == 0) &&
+                         (!(input_tiled || output_tiled) || (output_width % 8 == 0 && output_height % 8 == 0));
+
+    if (!IsKnownFormat(config.input_format) || !IsKnownFormat(config.output_format) || !aligned ||
+        (output_width << horizontal_scale) > input_width) {
+        DisplayTransferPixels(config, src, dst);
+        return;
+    }
+
+    const ConvertRowFunc convert_row = GetConvertRowFunc(config.input_format, config.output_format, config.scaling);
+
+    const int src_bytes_per_pixel = PixelSize(config.input_format);
+    const int dst_bytes_per_pixel = PixelSize(config.output_format);
+    const int src_row_size = input_width * src_bytes_per_pixel;
+    const int dst_row_size = output_width * dst_bytes_per_pixel;
+
+    // Rows of the current strip of tiles, unswizzled from the input or to be swizzled to the output
+    std::vector<u8> input_rows(input_tiled ? (8 << vertical_scale) * src_row_size : 0);
+    std::vector<u8> output_rows(output_tiled ? 8 * dst_row_size : 0);
+
+    for (int y = 0; y < output_height; y += 8) {
+        const int strip_height = std::min(8, output_height - y);
+        const int input_y = y << vertical_scale;
+
+        const u8* src_rows = src + input_y * src_row_size;
+        if (input_tiled) {
+            for (int row = 0; row < (strip_height << vertical_scale); row += 8) {
+                for (int x = 0; x < (output_width << horizontal_scale); x += 8) {
+                    MortonUnswizzleTile(src_bytes_per_pixel, src_rows + (x * 8 + row * input_width) * src_bytes_per_pixel,
+                                        &input_rows[row * src_row_size + x * src_bytes_per_pixel], src_row_size);
+                }
+            }
+            src_rows = input_rows.data();
+        }
+
+        // With flipping, the strip is written bottom to top, starting from its last output row
+        const int output_y = config.flip_vertically ? output_height - y - strip_height : y;
+        u8* dst_rows = output_tiled ? output_rows.data() : dst + output_y * dst_row_size;
+        if (config.flip_vertically)
+            dst_rows += (strip_height - 1) * dst_row_size;
+        const int dst_stride = config.flip_vertically ? -dst_row_size : dst_row_size;
+
+        for (int row = 0; row < strip_height; ++row) {
+            convert_row(src_rows + (row << vertical_scale) * src_row_size, src_row_size,
+                        dst_rows + row * dst_stride, output_width);
+        }
+
+        if (output_tiled) {
+            for (int x = 0; x < output_width; x += 8) {
+                MortonSwizzleTile(dst_bytes_per_pixel, &output_rows[x * dst_bytes_per_pixel], dst_row_size,
+                                  dst + (x * 8 + output_y * output_width) * dst_bytes_per_pixel);
+            }
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,41 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+#include "core/hw/gpu.h"
+
+namespace VideoCore {
+
+/**
+ * Fills memory with the 16-bit, 24-bit or 32-bit value of a memory fill. 16-bit and 24-bit fills
+ * write their last value whole, even if it crosses the end of the region.
+ * @param config Memory fill setup
+ * @param start First byte of the region to fill
+ * @param end End of the region to fill
+ */
+void MemoryFill(const GPU::Regs::MemoryFillConfig& config, u8* start, u8* end);
+
+/**
+ * Fills a part of the region of a memory fill, with the values lined up as if the whole region was
+ * filled. The last value is only written whole if the part reaches the end of the region.
+ * @param config Memory fill setup
+ * @param region_start,region_end Region of the memory fill
+ * @param start,end Part of the region to fill
+ */
+void MemoryFillPart(const GPU::Regs::MemoryFillConfig& config, u8* region_start, u8* region_end, u8* start, u8* end);
+
+/**
+ * Performs a display transfer on the CPU, converting the pixel format, tiling and scaling of the
+ * source image. Texture copies are not handled here. Transfers with 8x8 aligned dimensions are
+ * processed 8 rows at a time with format specific row conversions, others a pixel at a time.
+ * @param config Display transfer setup, scaling requires tiled input
+ * @param src Source image
+ * @param dst Destination image
+ */
+void DisplayTransfer(const GPU::Regs::DisplayTransferConfig& config, const u8* src, u8* dst);
+
+} // namespace
@@ -7,10 +7,14 @@
 #include <unordered_map>
 #include <utility>
 
+#include "common/chunk_file.h"
+
+#include "video_core/command_processor.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/primitive_assembly.h"
 #include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
 
 namespace Pica {
 
@@ -497,10 +501,13 @@ std::string Regs::GetCommandName(int index) {
 
 void Init() {
     g_state.Reset();
+    CommandProcessor::Init();
 }
 
 void Shutdown() {
+    CommandProcessor::Shutdown();
     Shader::ClearCache();
+    VertexLoader::ClearCache();
 }
 
 template <typename T>
@@ -517,4 +524,19 @@ void State::Reset() {
     primitive_assembler.Reconfigure(Regs::TriangleTopology::List);
 }
 
+void State::DoState(PointerWrap& p) {
+    auto s = p.Section("Pica", 1);
+    if (!s)
+        return;
+
+    p.DoVoid(&regs, sizeof(regs));
+    p.DoVoid(&vs, sizeof(vs));
+    p.DoVoid(&gs, sizeof(gs));
+    p.DoVoid(&vs_default_attributes, sizeof(vs_default_attributes));
+    p.DoVoid(&lighting, sizeof(lighting));
+    p.DoVoid(&fog, sizeof(fog));
+    p.DoVoid(&immediate, sizeof(immediate));
+    primitive_assembler.DoState(p);
+}
+
 }
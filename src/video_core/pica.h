@@ -1124,7 +1124,13 @@ struct Regs {
     // Number of vertices to render
     u32 num_vertices;
 
-    INSERT_PADDING_WORDS(0x1);
+    enum class UseGS : u32 {
+        No  = 0,
+        Yes = 2,
+    };
+
+    // Enables the geometry shader stage, which then receives the vertex shader output
+    BitField<0, 2, UseGS> use_gs;
 
     // The index of the first vertex to render
     u32 vertex_offset;
@@ -1172,7 +1178,14 @@ struct Regs {
         }
     } command_buffer;
 
-    INSERT_PADDING_WORDS(0x07);
+    INSERT_PADDING_WORDS(0x06);
+
+    enum class VSComMode : u32 {
+        Shared    = 0, // The geometry shader unit receives the vertex shader configuration
+        Exclusive = 1, // The geometry shader unit is configured separately
+    };
+
+    VSComMode vs_com_mode;
 
     enum class GPUMode : u32 {
         Drawing = 0,
@@ -1181,7 +1194,23 @@ struct Regs {
 
     GPUMode gpu_mode;
 
-    INSERT_PADDING_WORDS(0x18);
+    INSERT_PADDING_WORDS(0xc);
+
+    enum class GSMode : u32 {
+        Point             = 0, // Each invocation receives a fixed number of input attributes
+        VariablePrimitive = 1, // Each invocation receives a primitive with a vertex count given by its input
+        FixedPrimitive    = 2, // Each invocation receives a primitive of fixed_vertex_num vertices
+    };
+
+    // Configures how the vertex shader output is grouped into geometry shader invocations
+    union {
+        BitField< 0, 8, GSMode> mode;
+        BitField< 8, 4, u32> fixed_vertex_num_minus_1;
+        BitField<12, 4, u32> stride_minus_1;
+        BitField<16, 4, u32> start_index;
+    } gs_config;
+
+    INSERT_PADDING_WORDS(0xb);
 
     enum class TriangleTopology : u32 {
         List   = 0,
@@ -1378,12 +1407,15 @@ ASSERT_REG_POSITION(lighting, 0x140);
 ASSERT_REG_POSITION(vertex_attributes, 0x200);
 ASSERT_REG_POSITION(index_array, 0x227);
 ASSERT_REG_POSITION(num_vertices, 0x228);
+ASSERT_REG_POSITION(use_gs, 0x229);
 ASSERT_REG_POSITION(vertex_offset, 0x22a);
 ASSERT_REG_POSITION(trigger_draw, 0x22e);
 ASSERT_REG_POSITION(trigger_draw_indexed, 0x22f);
 ASSERT_REG_POSITION(vs_default_attributes_setup, 0x232);
 ASSERT_REG_POSITION(command_buffer, 0x238);
+ASSERT_REG_POSITION(vs_com_mode, 0x244);
 ASSERT_REG_POSITION(gpu_mode, 0x245);
+ASSERT_REG_POSITION(gs_config, 0x252);
 ASSERT_REG_POSITION(triangle_topology, 0x25e);
 ASSERT_REG_POSITION(restart_primitive, 0x25f);
 ASSERT_REG_POSITION(gs, 0x280);
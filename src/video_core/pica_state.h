@@ -13,12 +13,17 @@
 #include "video_core/primitive_assembly.h"
 #include "video_core/shader/shader.h"
 
+class PointerWrap;
+
 namespace Pica {
 
 /// Struct used to describe current Pica state
 struct State {
     void Reset();
 
+    /// Saves or restores the Pica state. The current command list is not included.
+    void DoState(PointerWrap& p);
+
     /// Pica registers
     Regs regs;
 
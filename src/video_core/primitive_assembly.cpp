@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 
 #include "video_core/pica.h"
@@ -64,6 +65,14 @@ void PrimitiveAssembler<VertexType>::Reconfigure(Regs::TriangleTopology topology
     this->topology = topology;
 }
 
+template<typename VertexType>
+void PrimitiveAssembler<VertexType>::DoState(PointerWrap& p) {
+    p.Do(topology);
+    p.Do(buffer_index);
+    p.DoVoid(buffer, sizeof(buffer));
+    p.Do(strip_ready);
+}
+
 // explicitly instantiate use cases
 template
 struct PrimitiveAssembler<Shader::OutputVertex>;
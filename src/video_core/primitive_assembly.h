@@ -8,6 +8,8 @@
 
 #include "video_core/pica.h"
 
+class PointerWrap;
+
 namespace Pica {
 
 /*
@@ -40,6 +42,11 @@ struct PrimitiveAssembler {
      */
     void Reconfigure(Regs::TriangleTopology topology);
 
+    /**
+     * Saves or restores the vertices buffered for the next primitive.
+     */
+    void DoState(PointerWrap& p);
+
 private:
     Regs::TriangleTopology topology;
 
@@ -5,14 +5,25 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/color.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 
 #include "core/memory.h"
@@ -23,6 +34,7 @@
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
 #include "video_core/rasterizer.h"
+#include "video_core/texture_cache.h"
 #include "video_core/utils.h"
 #include "video_core/shader/shader.h"
 
@@ -294,17 +306,39 @@ static int SignedArea (const Math::Vec2<Fix12P4>& vtx1,
 
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+/// Triangle which passed culling, with its vertices wound counter-clockwise
+struct TriangleSetup {
+    Shader::OutputVertex v0;
+    Shader::OutputVertex v1;
+    Shader::OutputVertex v2;
+
+    // Vertex positions in rasterizer coordinates
+    Math::Vec3<Fix12P4> vtxpos[3];
+
+    // Biases applied to the barycentric coordinates to implement the filling rules
+    int bias0;
+    int bias1;
+    int bias2;
+
+    // Bounding box of the covered pixels, including the scissor box in Include mode
+    u16 min_x;
+    u16 min_y;
+    u16 max_x;
+    u16 max_y;
+};
+
 /**
- * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
- * culling via recursion.
+ * Sets up a triangle for rasterization. The "reversed" flag allows for implementing culling via
+ * recursion.
+ * @return False if the triangle was culled
  */
-static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
-                                    const Shader::OutputVertex& v1,
-                                    const Shader::OutputVertex& v2,
-                                    bool reversed = false)
+static bool SetupTriangle(const Shader::OutputVertex& v0,
+                          const Shader::OutputVertex& v1,
+                          const Shader::OutputVertex& v2,
+                          TriangleSetup& setup,
+                          bool reversed = false)
 {
     const auto& regs = g_state.regs;
-    MICROPROFILE_SCOPE(GPU_Rasterization);
 
     // vertex positions in rasterizer coordinates
     static auto FloatToFix = [](float24 flt) {
@@ -322,20 +356,17 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
 
     if (regs.cull_mode == Regs::CullMode::KeepAll) {
         // Make sure we always end up with a triangle wound counter-clockwise
-        if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
-            return;
-        }
+        if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0)
+            return SetupTriangle(v0, v2, v1, setup, true);
     } else {
         if (!reversed && regs.cull_mode == Regs::CullMode::KeepClockWise) {
             // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
-            return;
+            return SetupTriangle(v0, v2, v1, setup, true);
         }
 
         // Cull away triangles which are wound clockwise.
         if (SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0)
-            return;
+            return false;
     }
 
     u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
@@ -384,851 +415,1346 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
     int bias1 = IsRightSideOrFlatBottomEdge(vtxpos[1].xy(), vtxpos[2].xy(), vtxpos[0].xy()) ? -1 : 0;
     int bias2 = IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
+    setup.v0 = v0;
+    setup.v1 = v1;
+    setup.v2 = v2;
+    std::copy(std::begin(vtxpos), std::end(vtxpos), setup.vtxpos);
+    setup.bias0 = bias0;
+    setup.bias1 = bias1;
+    setup.bias2 = bias2;
+    setup.min_x = min_x;
+    setup.min_y = min_y;
+    setup.max_x = max_x;
+    setup.max_y = max_y;
+    return true;
+}
+
+/**
+ * Edge function of a triangle: the signed area spanned by one of its edges and a point, plus the
+ * bias of the edge. It's linear in the point coordinates, so it's evaluated once at the center of a
+ * reference pixel and then stepped by constant increments rather than being recomputed per pixel.
+ */
+struct EdgeFunction {
+    EdgeFunction(const Math::Vec2<Fix12P4>& vtx1, const Math::Vec2<Fix12P4>& vtx2, int bias, u16 x, u16 y)
+        : origin(bias + SignedArea(vtx1, vtx2, {x, y})),
+          step_x(((int)vtx1.y - (int)vtx2.y) * 0x10),
+          step_y(((int)vtx2.x - (int)vtx1.x) * 0x10) {}
+
+    /// Returns the value at the center of the pixel dx pixels right and dy pixels below the reference
+    int At(int dx, int dy) const {
+        return origin + dx * step_x + dy * step_y;
+    }
+
+    int origin; ///< Value at the center of the reference pixel
+    int step_x; ///< Increment per pixel along the x axis
+    int step_y; ///< Increment per pixel along the y axis
+};
+
+/// Width and height of the blocks of pixels which are tested for coverage as a whole, in pixels
+static const int BLOCK_SIZE = 8;
+
+/**
+ * Values of an edge function at the pixels of a 2x2 quad, in the order top left, top right, bottom
+ * left, bottom right.
+ */
+struct QuadEdge {
+    /// Evaluates the edge function at the quad whose topleft pixel is at (dx, dy) from its reference
+    QuadEdge(const EdgeFunction& edge, int dx, int dy) {
+        const int value = edge.At(dx, dy);
+#ifdef ARCHITECTURE_x86_64
+        values = _mm_add_epi32(_mm_set1_epi32(value),
+                               _mm_setr_epi32(0, edge.step_x, edge.step_y, edge.step_x + edge.step_y));
+        step = _mm_set1_epi32(2 * edge.step_x);
+#else
+        values = {value, value + edge.step_x, value + edge.step_y, value + edge.step_x + edge.step_y};
+        step = 2 * edge.step_x;
+#endif
+    }
+
+    /// Moves to the next quad along the x axis
+    void StepX() {
+#ifdef ARCHITECTURE_x86_64
+        values = _mm_add_epi32(values, step);
+#else
+        for (int& value : values)
+            value += step;
+#endif
+    }
+
+    void Store(std::array<int, 4>& out) const {
+#ifdef ARCHITECTURE_x86_64
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.data()), values);
+#else
+        out = values;
+#endif
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    __m128i values;
+    __m128i step;
+#else
+    std::array<int, 4> values;
+    int step;
+#endif
+};
+
+/// Returns a mask with bit i set if pixel i of a quad is covered by the triangle
+static int GetQuadCoverage(const QuadEdge& quad0, const QuadEdge& quad1, const QuadEdge& quad2) {
+#ifdef ARCHITECTURE_x86_64
+    // A pixel is covered if none of its edge function values has its sign bit set
+    const __m128i any_negative = _mm_or_si128(_mm_or_si128(quad0.values, quad1.values), quad2.values);
+    return ~_mm_movemask_ps(_mm_castsi128_ps(any_negative)) & 0xF;
+#else
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (quad0.values[i] >= 0 && quad1.values[i] >= 0 && quad2.values[i] >= 0)
+            mask |= 1 << i;
+    }
+    return mask;
+#endif
+}
+
+/// Pixel pipeline stages which are only compiled into the rasterization loop if they are enabled
+enum PixelPipelineFeature : u32 {
+    FEATURE_TEXTURING    = 1 << 0,
+    FEATURE_ALPHA_TEST   = 1 << 1,
+    FEATURE_STENCIL_TEST = 1 << 2,
+    FEATURE_DEPTH_TEST   = 1 << 3,
+    FEATURE_ALPHA_BLEND  = 1 << 4,
+
+    NUM_FEATURE_COMBINATIONS = 1 << 5,
+};
+
+struct PixelPipeline;
+
+using RasterizeFunction = void (*)(const PixelPipeline& pipeline, const TriangleSetup& setup,
+                                   u16 min_x, u16 min_y, u16 max_x, u16 max_y);
+
+/// Pixel pipeline specialised to a render state, with the parts of the state it reads per pixel decoded
+struct PixelPipeline {
+    /// RasterizeTriangle instantiation for the enabled stages of the pipeline
+    RasterizeFunction rasterize;
+
+    DebugUtils::TextureInfo texture_info[3];
+    u8* texture_data[3];
+    /// Decoded texels of the enabled textures, null if they're sampled from their encoded data
+    const Math::Vec4<u8>* texture_texels[3];
+
+    std::array<bool, 6> passthrough_tev_stages;
+};
+
+/**
+ * Rasterizes the part of a triangle within the given bounds, in 12.4 fixed point coordinates
+ * aligned to pixels.
+ * @tparam Features Combination of the PixelPipelineFeature flags of the current render state,
+ *                  pixel pipeline stages which are not part of it are compiled out
+ */
+template <u32 Features>
+static void RasterizeTriangle(const PixelPipeline& pipeline, const TriangleSetup& setup,
+                              u16 min_x, u16 min_y, u16 max_x, u16 max_y) {
+    const auto& regs = g_state.regs;
+
+    const auto& v0 = setup.v0;
+    const auto& v1 = setup.v1;
+    const auto& v2 = setup.v2;
+    const auto& vtxpos = setup.vtxpos;
+    const int bias0 = setup.bias0;
+    const int bias1 = setup.bias1;
+    const int bias2 = setup.bias2;
+
+    min_x = std::max(min_x, setup.min_x);
+    min_y = std::max(min_y, setup.min_y);
+    max_x = std::min(max_x, setup.max_x);
+    max_y = std::min(max_y, setup.max_y);
+
+    // Convert the scissor box coordinates to 12.4 fixed point
+    u16 scissor_x1 = (u16)( regs.scissor_test.x1      << 4);
+    u16 scissor_y1 = (u16)( regs.scissor_test.y1      << 4);
+    // x2,y2 have +1 added to cover the entire sub-pixel area
+    u16 scissor_x2 = (u16)((regs.scissor_test.x2 + 1) << 4);
+    u16 scissor_y2 = (u16)((regs.scissor_test.y2 + 1) << 4);
+
     auto w_inverse = Math::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
 
     auto textures = regs.GetTextures();
     auto tev_stages = regs.GetTevStages();
 
-    bool stencil_action_enable = g_state.regs.output_merger.stencil_test.enable && g_state.regs.framebuffer.depth_format == Regs::DepthFormat::D24S8;
+    const bool stencil_action_enable = (Features & FEATURE_STENCIL_TEST) != 0;
     const auto stencil_test = g_state.regs.output_merger.stencil_test;
 
-    // Enter rasterization loop, starting at the center of the topleft bounding box corner.
-    // TODO: Not sure if looping through x first might be faster
-    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
-
-            // Do not process the pixel if it's inside the scissor box and the scissor mode is set to Exclude
-            if (regs.scissor_test.mode == Regs::ScissorMode::Exclude) {
-                if (x >= scissor_x1 && x < scissor_x2 &&
-                    y >= scissor_y1 && y < scissor_y2)
-                    continue;
-            }
+    // Shades a pixel covered by the triangle, given the 12.4 fixed point coordinates of its center
+    // and its barycentric coordinates w0, w1 and w2
+    auto ShadePixel = [&](u16 x, u16 y, int w0, int w1, int w2) {
+        // Do not process the pixel if it's inside the scissor box and the scissor mode is set to Exclude
+        if (regs.scissor_test.mode == Regs::ScissorMode::Exclude) {
+            if (x >= scissor_x1 && x < scissor_x2 &&
+                y >= scissor_y1 && y < scissor_y2)
+                return;
+        }
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-            int wsum = w0 + w1 + w2;
+        int wsum = w0 + w1 + w2;
 
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
-                continue;
+        auto baricentric_coordinates = Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
+                                            float24::FromFloat32(static_cast<float>(w1)),
+                                            float24::FromFloat32(static_cast<float>(w2)));
+        float24 interpolated_w_inverse = float24::FromFloat32(1.0f) / Math::Dot(w_inverse, baricentric_coordinates);
 
-            auto baricentric_coordinates = Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
-                                                float24::FromFloat32(static_cast<float>(w1)),
-                                                float24::FromFloat32(static_cast<float>(w2)));
-            float24 interpolated_w_inverse = float24::FromFloat32(1.0f) / Math::Dot(w_inverse, baricentric_coordinates);
-
-            // interpolated_z = z / w
-            float interpolated_z_over_w = (v0.screenpos[2].ToFloat32() * w0 +
-                                           v1.screenpos[2].ToFloat32() * w1 +
-                                           v2.screenpos[2].ToFloat32() * w2) / wsum;
-
-            // Not fully accurate. About 3 bits in precision are missing.
-            // Z-Buffer (z / w * scale + offset)
-            float depth_scale = float24::FromRaw(regs.viewport_depth_range).ToFloat32();
-            float depth_offset = float24::FromRaw(regs.viewport_depth_near_plane).ToFloat32();
-            float depth = interpolated_z_over_w * depth_scale + depth_offset;
-
-            // Potentially switch to W-Buffer
-            if (regs.depthmap_enable == Pica::Regs::DepthBuffering::WBuffering) {
-                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                depth *= interpolated_w_inverse.ToFloat32() * wsum;
-            }
+        // interpolated_z = z / w
+        float interpolated_z_over_w = (v0.screenpos[2].ToFloat32() * w0 +
+                                       v1.screenpos[2].ToFloat32() * w1 +
+                                       v2.screenpos[2].ToFloat32() * w2) / wsum;
 
-            // Clamp the result
-            depth = MathUtil::Clamp(depth, 0.0f, 1.0f);
-
-            // Perspective correct attribute interpolation:
-            // Attribute values cannot be calculated by simple linear interpolation since
-            // they are not linear in screen space. For example, when interpolating a
-            // texture coordinate across two vertices, something simple like
-            //     u = (u0*w0 + u1*w1)/(w0+w1)
-            // will not work. However, the attribute value divided by the
-            // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-            // in screenspace. Hence, we can linearly interpolate these two independently and
-            // calculate the interpolated attribute by dividing the results.
-            // I.e.
-            //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-            //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-            //     u = u_over_w / one_over_w
-            //
-            // The generalization to three vertices is straightforward in baricentric coordinates.
-            auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
-                auto attr_over_w = Math::MakeVec(attr0, attr1, attr2);
-                float24 interpolated_attr_over_w = Math::Dot(attr_over_w, baricentric_coordinates);
-                return interpolated_attr_over_w * interpolated_w_inverse;
-            };
+        // Not fully accurate. About 3 bits in precision are missing.
+        // Z-Buffer (z / w * scale + offset)
+        float depth_scale = float24::FromRaw(regs.viewport_depth_range).ToFloat32();
+        float depth_offset = float24::FromRaw(regs.viewport_depth_near_plane).ToFloat32();
+        float depth = interpolated_z_over_w * depth_scale + depth_offset;
 
-            Math::Vec4<u8> primary_color{
-                (u8)(GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() * 255),
-                (u8)(GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() * 255),
-                (u8)(GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() * 255),
-                (u8)(GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() * 255)
-            };
+        // Potentially switch to W-Buffer
+        if (regs.depthmap_enable == Pica::Regs::DepthBuffering::WBuffering) {
+            // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
+            depth *= interpolated_w_inverse.ToFloat32() * wsum;
+        }
 
-            Math::Vec2<float24> uv[3];
+        // Clamp the result
+        depth = MathUtil::Clamp(depth, 0.0f, 1.0f);
+
+        // Perspective correct attribute interpolation:
+        // Attribute values cannot be calculated by simple linear interpolation since
+        // they are not linear in screen space. For example, when interpolating a
+        // texture coordinate across two vertices, something simple like
+        //     u = (u0*w0 + u1*w1)/(w0+w1)
+        // will not work. However, the attribute value divided by the
+        // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+        // in screenspace. Hence, we can linearly interpolate these two independently and
+        // calculate the interpolated attribute by dividing the results.
+        // I.e.
+        //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+        //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+        //     u = u_over_w / one_over_w
+        //
+        // The generalization to three vertices is straightforward in baricentric coordinates.
+        auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
+            auto attr_over_w = Math::MakeVec(attr0, attr1, attr2);
+            float24 interpolated_attr_over_w = Math::Dot(attr_over_w, baricentric_coordinates);
+            return interpolated_attr_over_w * interpolated_w_inverse;
+        };
+
+        Math::Vec4<u8> primary_color{
+            (u8)(GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() * 255),
+            (u8)(GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() * 255),
+            (u8)(GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() * 255),
+            (u8)(GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() * 255)
+        };
+
+        Math::Vec2<float24> uv[3];
+        if (Features & FEATURE_TEXTURING) {
             uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
             uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
             uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
             uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
             uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
             uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+        }
 
-            Math::Vec4<u8> texture_color[3]{};
-            for (int i = 0; i < 3; ++i) {
-                const auto& texture = textures[i];
-                if (!texture.enabled)
-                    continue;
+        Math::Vec4<u8> texture_color[3]{};
+        for (int i = 0; i < 3; ++i) {
+            const auto& texture = textures[i];
+            if (!(Features & FEATURE_TEXTURING) || !texture.enabled)
+                continue;
 
-                DEBUG_ASSERT(0 != texture.config.address);
-
-                float24 u = uv[i].u();
-                float24 v = uv[i].v();
-
-                // Only unit 0 respects the texturing type (according to 3DBrew)
-                // TODO: Refactor so cubemaps and shadowmaps can be handled
-                if (i == 0) {
-                    switch(texture.config.type) {
-                    case Regs::TextureConfig::Texture2D:
-                        break;
-                    case Regs::TextureConfig::Projection2D: {
-                        auto tc0_w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-                        u /= tc0_w;
-                        v /= tc0_w;
-                        break;
-                    }
-                    default:
-                        // TODO: Change to LOG_ERROR when more types are handled.
-                        LOG_DEBUG(HW_GPU, "Unhandled texture type %x", (int)texture.config.type);
-                        UNIMPLEMENTED();
-                        break;
-                    }
-                }
+            DEBUG_ASSERT(0 != texture.config.address);
+
+            float24 u = uv[i].u();
+            float24 v = uv[i].v();
 
-                int s = (int)(u * float24::FromFloat32(static_cast<float>(texture.config.width))).ToFloat32();
-                int t = (int)(v * float24::FromFloat32(static_cast<float>(texture.config.height))).ToFloat32();
+            // Only unit 0 respects the texturing type (according to 3DBrew)
+            // TODO: Refactor so cubemaps and shadowmaps can be handled
+            if (i == 0) {
+                switch(texture.config.type) {
+                case Regs::TextureConfig::Texture2D:
+                    break;
+                case Regs::TextureConfig::Projection2D: {
+                    auto tc0_w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
+                    u /= tc0_w;
+                    v /= tc0_w;
+                    break;
+                }
+                default:
+                    // TODO: Change to LOG_ERROR when more types are handled.
+                    LOG_DEBUG(HW_GPU, "Unhandled texture type %x", (int)texture.config.type);
+                    UNIMPLEMENTED();
+                    break;
+                }
+            }
 
+            int s = (int)(u * float24::FromFloat32(static_cast<float>(texture.config.width))).ToFloat32();
+            int t = (int)(v * float24::FromFloat32(static_cast<float>(texture.config.height))).ToFloat32();
 
-                static auto GetWrappedTexCoord = [](Regs::TextureConfig::WrapMode mode, int val, unsigned size) {
-                    switch (mode) {
-                        case Regs::TextureConfig::ClampToEdge:
-                            val = std::max(val, 0);
-                            val = std::min(val, (int)size - 1);
-                            return val;
 
-                        case Regs::TextureConfig::ClampToBorder:
-                            return val;
+            static auto GetWrappedTexCoord = [](Regs::TextureConfig::WrapMode mode, int val, unsigned size) {
+                switch (mode) {
+                    case Regs::TextureConfig::ClampToEdge:
+                        val = std::max(val, 0);
+                        val = std::min(val, (int)size - 1);
+                        return val;
 
-                        case Regs::TextureConfig::Repeat:
-                            return (int)((unsigned)val % size);
+                    case Regs::TextureConfig::ClampToBorder:
+                        return val;
 
-                        case Regs::TextureConfig::MirroredRepeat:
-                        {
-                            unsigned int coord = ((unsigned)val % (2 * size));
-                            if (coord >= size)
-                                coord = 2 * size - 1 - coord;
-                            return (int)coord;
-                        }
+                    case Regs::TextureConfig::Repeat:
+                        return (int)((unsigned)val % size);
 
-                        default:
-                            LOG_ERROR(HW_GPU, "Unknown texture coordinate wrapping mode %x", (int)mode);
-                            UNIMPLEMENTED();
-                            return 0;
+                    case Regs::TextureConfig::MirroredRepeat:
+                    {
+                        unsigned int coord = ((unsigned)val % (2 * size));
+                        if (coord >= size)
+                            coord = 2 * size - 1 - coord;
+                        return (int)coord;
                     }
-                };
 
-                if ((texture.config.wrap_s == Regs::TextureConfig::ClampToBorder && (s < 0 || s >= texture.config.width))
-                    || (texture.config.wrap_t == Regs::TextureConfig::ClampToBorder && (t < 0 || t >= texture.config.height))) {
-                    auto border_color = texture.config.border_color;
-                    texture_color[i] = { border_color.r, border_color.g, border_color.b, border_color.a };
-                } else {
-                    // Textures are laid out from bottom to top, hence we invert the t coordinate.
-                    // NOTE: This may not be the right place for the inversion.
-                    // TODO: Check if this applies to ETC textures, too.
-                    s = GetWrappedTexCoord(texture.config.wrap_s, s, texture.config.width);
-                    t = texture.config.height - 1 - GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
-
-                    u8* texture_data = Memory::GetPhysicalPointer(texture.config.GetPhysicalAddress());
-                    auto info = DebugUtils::TextureInfo::FromPicaRegister(texture.config, texture.format);
+                    default:
+                        LOG_ERROR(HW_GPU, "Unknown texture coordinate wrapping mode %x", (int)mode);
+                        UNIMPLEMENTED();
+                        return 0;
+                }
+            };
 
-                    // TODO: Apply the min and mag filters to the texture
+            if ((texture.config.wrap_s == Regs::TextureConfig::ClampToBorder && (s < 0 || s >= texture.config.width))
+                || (texture.config.wrap_t == Regs::TextureConfig::ClampToBorder && (t < 0 || t >= texture.config.height))) {
+                auto border_color = texture.config.border_color;
+                texture_color[i] = { border_color.r, border_color.g, border_color.b, border_color.a };
+            } else {
+                // Textures are laid out from bottom to top, hence we invert the t coordinate.
+                // NOTE: This may not be the right place for the inversion.
+                // TODO: Check if this applies to ETC textures, too.
+                s = GetWrappedTexCoord(texture.config.wrap_s, s, texture.config.width);
+                t = texture.config.height - 1 - GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
+
+                u8* texture_data = pipeline.texture_data[i];
+                const auto& info = pipeline.texture_info[i];
+
+                // TODO: Apply the min and mag filters to the texture
+                if (pipeline.texture_texels[i] != nullptr) {
+                    texture_color[i] = pipeline.texture_texels[i][s + t * texture.config.width];
+                } else {
                     texture_color[i] = DebugUtils::LookupTexture(texture_data, s, t, info);
+                }
 #if PICA_DUMP_TEXTURES
-                    DebugUtils::DumpTexture(texture.config, texture_data);
+                DebugUtils::DumpTexture(texture.config, texture_data);
 #endif
-                }
             }
+        }
+
+        // Texture environment - consists of 6 stages of color and alpha combining.
+        //
+        // Color combiners take three input color values from some source (e.g. interpolated
+        // vertex color, texture color, previous stage, etc), perform some very simple
+        // operations on each of them (e.g. inversion) and then calculate the output color
+        // with some basic arithmetic. Alpha combiners can be configured separately but work
+        // analogously.
+        Math::Vec4<u8> combiner_output;
+        Math::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
+        Math::Vec4<u8> next_combiner_buffer = {
+            regs.tev_combiner_buffer_color.r, regs.tev_combiner_buffer_color.g,
+            regs.tev_combiner_buffer_color.b, regs.tev_combiner_buffer_color.a
+        };
+
+        auto UpdateCombinerBuffer = [&](unsigned tev_stage_index) {
+            combiner_buffer = next_combiner_buffer;
+
+            if (regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(tev_stage_index)) {
+                next_combiner_buffer.r() = combiner_output.r();
+                next_combiner_buffer.g() = combiner_output.g();
+                next_combiner_buffer.b() = combiner_output.b();
+            }
+
+            if (regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(tev_stage_index)) {
+                next_combiner_buffer.a() = combiner_output.a();
+            }
+        };
+
+        for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size(); ++tev_stage_index) {
+            // Pass-through stages leave the combiner output unchanged
+            if (pipeline.passthrough_tev_stages[tev_stage_index]) {
+                UpdateCombinerBuffer(tev_stage_index);
+                continue;
+            }
+
+            const auto& tev_stage = tev_stages[tev_stage_index];
+            using Source = Regs::TevStageConfig::Source;
+            using ColorModifier = Regs::TevStageConfig::ColorModifier;
+            using AlphaModifier = Regs::TevStageConfig::AlphaModifier;
+            using Operation = Regs::TevStageConfig::Operation;
+
+            auto GetSource = [&](Source source) -> Math::Vec4<u8> {
+                switch (source) {
+                case Source::PrimaryColor:
+
+                // HACK: Until we implement fragment lighting, use primary_color
+                case Source::PrimaryFragmentColor:
+                    return primary_color;
 
-            // Texture environment - consists of 6 stages of color and alpha combining.
-            //
-            // Color combiners take three input color values from some source (e.g. interpolated
-            // vertex color, texture color, previous stage, etc), perform some very simple
-            // operations on each of them (e.g. inversion) and then calculate the output color
-            // with some basic arithmetic. Alpha combiners can be configured separately but work
-            // analogously.
-            Math::Vec4<u8> combiner_output;
-            Math::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
-            Math::Vec4<u8> next_combiner_buffer = {
-                regs.tev_combiner_buffer_color.r, regs.tev_combiner_buffer_color.g,
-                regs.tev_combiner_buffer_color.b, regs.tev_combiner_buffer_color.a
+                // HACK: Until we implement fragment lighting, use zero
+                case Source::SecondaryFragmentColor:
+                    return {0, 0, 0, 0};
+
+                case Source::Texture0:
+                    return texture_color[0];
+
+                case Source::Texture1:
+                    return texture_color[1];
+
+                case Source::Texture2:
+                    return texture_color[2];
+
+                case Source::PreviousBuffer:
+                    return combiner_buffer;
+
+                case Source::Constant:
+                    return {tev_stage.const_r, tev_stage.const_g, tev_stage.const_b, tev_stage.const_a};
+
+                case Source::Previous:
+                    return combiner_output;
+
+                default:
+                    LOG_ERROR(HW_GPU, "Unknown color combiner source %d", (int)source);
+                    UNIMPLEMENTED();
+                    return {0, 0, 0, 0};
+                }
             };
 
-            for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size(); ++tev_stage_index) {
-                const auto& tev_stage = tev_stages[tev_stage_index];
-                using Source = Regs::TevStageConfig::Source;
-                using ColorModifier = Regs::TevStageConfig::ColorModifier;
-                using AlphaModifier = Regs::TevStageConfig::AlphaModifier;
-                using Operation = Regs::TevStageConfig::Operation;
+            static auto GetColorModifier = [](ColorModifier factor, const Math::Vec4<u8>& values) -> Math::Vec3<u8> {
+                switch (factor) {
+                case ColorModifier::SourceColor:
+                    return values.rgb();
 
-                auto GetSource = [&](Source source) -> Math::Vec4<u8> {
-                    switch (source) {
-                    case Source::PrimaryColor:
+                case ColorModifier::OneMinusSourceColor:
+                    return (Math::Vec3<u8>(255, 255, 255) - values.rgb()).Cast<u8>();
 
-                    // HACK: Until we implement fragment lighting, use primary_color
-                    case Source::PrimaryFragmentColor:
-                        return primary_color;
+                case ColorModifier::SourceAlpha:
+                    return values.aaa();
 
-                    // HACK: Until we implement fragment lighting, use zero
-                    case Source::SecondaryFragmentColor:
-                        return {0, 0, 0, 0};
+                case ColorModifier::OneMinusSourceAlpha:
+                    return (Math::Vec3<u8>(255, 255, 255) - values.aaa()).Cast<u8>();
 
-                    case Source::Texture0:
-                        return texture_color[0];
+                case ColorModifier::SourceRed:
+                    return values.rrr();
 
-                    case Source::Texture1:
-                        return texture_color[1];
+                case ColorModifier::OneMinusSourceRed:
+                    return (Math::Vec3<u8>(255, 255, 255) - values.rrr()).Cast<u8>();
 
-                    case Source::Texture2:
-                        return texture_color[2];
+                case ColorModifier::SourceGreen:
+                    return values.ggg();
 
-                    case Source::PreviousBuffer:
-                        return combiner_buffer;
+                case ColorModifier::OneMinusSourceGreen:
+                    return (Math::Vec3<u8>(255, 255, 255) - values.ggg()).Cast<u8>();
 
-                    case Source::Constant:
-                        return {tev_stage.const_r, tev_stage.const_g, tev_stage.const_b, tev_stage.const_a};
+                case ColorModifier::SourceBlue:
+                    return values.bbb();
 
-                    case Source::Previous:
-                        return combiner_output;
+                case ColorModifier::OneMinusSourceBlue:
+                    return (Math::Vec3<u8>(255, 255, 255) - values.bbb()).Cast<u8>();
+                }
+            };
 
-                    default:
-                        LOG_ERROR(HW_GPU, "Unknown color combiner source %d", (int)source);
-                        UNIMPLEMENTED();
-                        return {0, 0, 0, 0};
-                    }
-                };
+            static auto GetAlphaModifier = [](AlphaModifier factor, const Math::Vec4<u8>& values) -> u8 {
+                switch (factor) {
+                case AlphaModifier::SourceAlpha:
+                    return values.a();
 
-                static auto GetColorModifier = [](ColorModifier factor, const Math::Vec4<u8>& values) -> Math::Vec3<u8> {
-                    switch (factor) {
-                    case ColorModifier::SourceColor:
-                        return values.rgb();
+                case AlphaModifier::OneMinusSourceAlpha:
+                    return 255 - values.a();
 
-                    case ColorModifier::OneMinusSourceColor:
-                        return (Math::Vec3<u8>(255, 255, 255) - values.rgb()).Cast<u8>();
+                case AlphaModifier::SourceRed:
+                    return values.r();
 
-                    case ColorModifier::SourceAlpha:
-                        return values.aaa();
+                case AlphaModifier::OneMinusSourceRed:
+                    return 255 - values.r();
 
-                    case ColorModifier::OneMinusSourceAlpha:
-                        return (Math::Vec3<u8>(255, 255, 255) - values.aaa()).Cast<u8>();
+                case AlphaModifier::SourceGreen:
+                    return values.g();
 
-                    case ColorModifier::SourceRed:
-                        return values.rrr();
+                case AlphaModifier::OneMinusSourceGreen:
+                    return 255 - values.g();
 
-                    case ColorModifier::OneMinusSourceRed:
-                        return (Math::Vec3<u8>(255, 255, 255) - values.rrr()).Cast<u8>();
+                case AlphaModifier::SourceBlue:
+                    return values.b();
 
-                    case ColorModifier::SourceGreen:
-                        return values.ggg();
+                case AlphaModifier::OneMinusSourceBlue:
+                    return 255 - values.b();
+                }
+            };
 
-                    case ColorModifier::OneMinusSourceGreen:
-                        return (Math::Vec3<u8>(255, 255, 255) - values.ggg()).Cast<u8>();
+            static auto ColorCombine = [](Operation op, const Math::Vec3<u8> input[3]) -> Math::Vec3<u8> {
+                switch (op) {
+                case Operation::Replace:
+                    return input[0];
+
+                case Operation::Modulate:
+                    return ((input[0] * input[1]) / 255).Cast<u8>();
+
+                case Operation::Add:
+                {
+                    auto result = input[0] + input[1];
+                    result.r() = std::min(255, result.r());
+                    result.g() = std::min(255, result.g());
+                    result.b() = std::min(255, result.b());
+                    return result.Cast<u8>();
+                }
 
-                    case ColorModifier::SourceBlue:
-                        return values.bbb();
+                case Operation::AddSigned:
+                {
+                    // TODO(bunnei): Verify that the color conversion from (float) 0.5f to (byte) 128 is correct
+                    auto result = input[0].Cast<int>() + input[1].Cast<int>() - Math::MakeVec<int>(128, 128, 128);
+                    result.r() = MathUtil::Clamp<int>(result.r(), 0, 255);
+                    result.g() = MathUtil::Clamp<int>(result.g(), 0, 255);
+                    result.b() = MathUtil::Clamp<int>(result.b(), 0, 255);
+                    return result.Cast<u8>();
+                }
 
-                    case ColorModifier::OneMinusSourceBlue:
-                        return (Math::Vec3<u8>(255, 255, 255) - values.bbb()).Cast<u8>();
-                    }
-                };
+                case Operation::Lerp:
+                    return ((input[0] * input[2] + input[1] * (Math::MakeVec<u8>(255, 255, 255) - input[2]).Cast<u8>()) / 255).Cast<u8>();
 
-                static auto GetAlphaModifier = [](AlphaModifier factor, const Math::Vec4<u8>& values) -> u8 {
-                    switch (factor) {
-                    case AlphaModifier::SourceAlpha:
-                        return values.a();
+                case Operation::Subtract:
+                {
+                    auto result = input[0].Cast<int>() - input[1].Cast<int>();
+                    result.r() = std::max(0, result.r());
+                    result.g() = std::max(0, result.g());
+                    result.b() = std::max(0, result.b());
+                    return result.Cast<u8>();
+                }
 
-                    case AlphaModifier::OneMinusSourceAlpha:
-                        return 255 - values.a();
+                case Operation::MultiplyThenAdd:
+                {
+                    auto result = (input[0] * input[1] + 255 * input[2].Cast<int>()) / 255;
+                    result.r() = std::min(255, result.r());
+                    result.g() = std::min(255, result.g());
+                    result.b() = std::min(255, result.b());
+                    return result.Cast<u8>();
+                }
 
-                    case AlphaModifier::SourceRed:
-                        return values.r();
+                case Operation::AddThenMultiply:
+                {
+                    auto result = input[0] + input[1];
+                    result.r() = std::min(255, result.r());
+                    result.g() = std::min(255, result.g());
+                    result.b() = std::min(255, result.b());
+                    result = (result * input[2].Cast<int>()) / 255;
+                    return result.Cast<u8>();
+                }
+                case Operation::Dot3_RGB:
+                {
+                    // Not fully accurate.
+                    // Worst case scenario seems to yield a +/-3 error
+                    // Some HW results indicate that the per-component computation can't have a higher precision than 1/256,
+                    // while dot3_rgb( (0x80,g0,b0),(0x7F,g1,b1) ) and dot3_rgb( (0x80,g0,b0),(0x80,g1,b1) ) give different results
+                    int result = ((input[0].r() * 2 - 255) * (input[1].r() * 2 - 255) + 128) / 256 +
+                                 ((input[0].g() * 2 - 255) * (input[1].g() * 2 - 255) + 128) / 256 +
+                                 ((input[0].b() * 2 - 255) * (input[1].b() * 2 - 255) + 128) / 256;
+                    result = std::max(0, std::min(255, result));
+                    return { (u8)result, (u8)result, (u8)result };
+                }
+                default:
+                    LOG_ERROR(HW_GPU, "Unknown color combiner operation %d", (int)op);
+                    UNIMPLEMENTED();
+                    return {0, 0, 0};
+                }
+            };
 
-                    case AlphaModifier::OneMinusSourceRed:
-                        return 255 - values.r();
+            static auto AlphaCombine = [](Operation op, const std::array<u8,3>& input) -> u8 {
+                switch (op) {
+                case Operation::Replace:
+                    return input[0];
 
-                    case AlphaModifier::SourceGreen:
-                        return values.g();
+                case Operation::Modulate:
+                    return input[0] * input[1] / 255;
 
-                    case AlphaModifier::OneMinusSourceGreen:
-                        return 255 - values.g();
+                case Operation::Add:
+                    return std::min(255, input[0] + input[1]);
 
-                    case AlphaModifier::SourceBlue:
-                        return values.b();
+                case Operation::AddSigned:
+                {
+                    // TODO(bunnei): Verify that the color conversion from (float) 0.5f to (byte) 128 is correct
+                    auto result = static_cast<int>(input[0]) + static_cast<int>(input[1]) - 128;
+                    return static_cast<u8>(MathUtil::Clamp<int>(result, 0, 255));
+                }
 
-                    case AlphaModifier::OneMinusSourceBlue:
-                        return 255 - values.b();
-                    }
-                };
+                case Operation::Lerp:
+                    return (input[0] * input[2] + input[1] * (255 - input[2])) / 255;
 
-                static auto ColorCombine = [](Operation op, const Math::Vec3<u8> input[3]) -> Math::Vec3<u8> {
-                    switch (op) {
-                    case Operation::Replace:
-                        return input[0];
+                case Operation::Subtract:
+                    return std::max(0, (int)input[0] - (int)input[1]);
 
-                    case Operation::Modulate:
-                        return ((input[0] * input[1]) / 255).Cast<u8>();
+                case Operation::MultiplyThenAdd:
+                    return std::min(255, (input[0] * input[1] + 255 * input[2]) / 255);
 
-                    case Operation::Add:
-                    {
-                        auto result = input[0] + input[1];
-                        result.r() = std::min(255, result.r());
-                        result.g() = std::min(255, result.g());
-                        result.b() = std::min(255, result.b());
-                        return result.Cast<u8>();
-                    }
+                case Operation::AddThenMultiply:
+                    return (std::min(255, (input[0] + input[1])) * input[2]) / 255;
 
-                    case Operation::AddSigned:
-                    {
-                        // TODO(bunnei): Verify that the color conversion from (float) 0.5f to (byte) 128 is correct
-                        auto result = input[0].Cast<int>() + input[1].Cast<int>() - Math::MakeVec<int>(128, 128, 128);
-                        result.r() = MathUtil::Clamp<int>(result.r(), 0, 255);
-                        result.g() = MathUtil::Clamp<int>(result.g(), 0, 255);
-                        result.b() = MathUtil::Clamp<int>(result.b(), 0, 255);
-                        return result.Cast<u8>();
-                    }
+                default:
+                    LOG_ERROR(HW_GPU, "Unknown alpha combiner operation %d", (int)op);
+                    UNIMPLEMENTED();
+                    return 0;
+                }
+            };
 
-                    case Operation::Lerp:
-                        return ((input[0] * input[2] + input[1] * (Math::MakeVec<u8>(255, 255, 255) - input[2]).Cast<u8>()) / 255).Cast<u8>();
+            // color combiner
+            // NOTE: Not sure if the alpha combiner might use the color output of the previous
+            //       stage as input. Hence, we currently don't directly write the result to
+            //       combiner_output.rgb(), but instead store it in a temporary variable until
+            //       alpha combining has been done.
+            Math::Vec3<u8> color_result[3] = {
+                GetColorModifier(tev_stage.color_modifier1, GetSource(tev_stage.color_source1)),
+                GetColorModifier(tev_stage.color_modifier2, GetSource(tev_stage.color_source2)),
+                GetColorModifier(tev_stage.color_modifier3, GetSource(tev_stage.color_source3))
+            };
+            auto color_output = ColorCombine(tev_stage.color_op, color_result);
+
+            // alpha combiner
+            std::array<u8,3> alpha_result = {{
+                GetAlphaModifier(tev_stage.alpha_modifier1, GetSource(tev_stage.alpha_source1)),
+                GetAlphaModifier(tev_stage.alpha_modifier2, GetSource(tev_stage.alpha_source2)),
+                GetAlphaModifier(tev_stage.alpha_modifier3, GetSource(tev_stage.alpha_source3))
+            }};
+            auto alpha_output = AlphaCombine(tev_stage.alpha_op, alpha_result);
+
+            combiner_output[0] = std::min((unsigned)255, color_output.r() * tev_stage.GetColorMultiplier());
+            combiner_output[1] = std::min((unsigned)255, color_output.g() * tev_stage.GetColorMultiplier());
+            combiner_output[2] = std::min((unsigned)255, color_output.b() * tev_stage.GetColorMultiplier());
+            combiner_output[3] = std::min((unsigned)255, alpha_output * tev_stage.GetAlphaMultiplier());
+
+            UpdateCombinerBuffer(tev_stage_index);
+        }
 
-                    case Operation::Subtract:
-                    {
-                        auto result = input[0].Cast<int>() - input[1].Cast<int>();
-                        result.r() = std::max(0, result.r());
-                        result.g() = std::max(0, result.g());
-                        result.b() = std::max(0, result.b());
-                        return result.Cast<u8>();
-                    }
+        const auto& output_merger = regs.output_merger;
+        // TODO: Does alpha testing happen before or after stencil?
+        if (Features & FEATURE_ALPHA_TEST) {
+            bool pass = false;
 
-                    case Operation::MultiplyThenAdd:
-                    {
-                        auto result = (input[0] * input[1] + 255 * input[2].Cast<int>()) / 255;
-                        result.r() = std::min(255, result.r());
-                        result.g() = std::min(255, result.g());
-                        result.b() = std::min(255, result.b());
-                        return result.Cast<u8>();
-                    }
+            switch (output_merger.alpha_test.func) {
+            case Regs::CompareFunc::Never:
+                pass = false;
+                break;
 
-                    case Operation::AddThenMultiply:
-                    {
-                        auto result = input[0] + input[1];
-                        result.r() = std::min(255, result.r());
-                        result.g() = std::min(255, result.g());
-                        result.b() = std::min(255, result.b());
-                        result = (result * input[2].Cast<int>()) / 255;
-                        return result.Cast<u8>();
-                    }
-                    case Operation::Dot3_RGB:
-                    {
-                        // Not fully accurate.
-                        // Worst case scenario seems to yield a +/-3 error
-                        // Some HW results indicate that the per-component computation can't have a higher precision than 1/256,
-                        // while dot3_rgb( (0x80,g0,b0),(0x7F,g1,b1) ) and dot3_rgb( (0x80,g0,b0),(0x80,g1,b1) ) give different results
-                        int result = ((input[0].r() * 2 - 255) * (input[1].r() * 2 - 255) + 128) / 256 +
-                                     ((input[0].g() * 2 - 255) * (input[1].g() * 2 - 255) + 128) / 256 +
-                                     ((input[0].b() * 2 - 255) * (input[1].b() * 2 - 255) + 128) / 256;
-                        result = std::max(0, std::min(255, result));
-                        return { (u8)result, (u8)result, (u8)result };
-                    }
-                    default:
-                        LOG_ERROR(HW_GPU, "Unknown color combiner operation %d", (int)op);
-                        UNIMPLEMENTED();
-                        return {0, 0, 0};
-                    }
-                };
+            case Regs::CompareFunc::Always:
+                pass = true;
+                break;
 
-                static auto AlphaCombine = [](Operation op, const std::array<u8,3>& input) -> u8 {
-                    switch (op) {
-                    case Operation::Replace:
-                        return input[0];
+            case Regs::CompareFunc::Equal:
+                pass = combiner_output.a() == output_merger.alpha_test.ref;
+                break;
 
-                    case Operation::Modulate:
-                        return input[0] * input[1] / 255;
+            case Regs::CompareFunc::NotEqual:
+                pass = combiner_output.a() != output_merger.alpha_test.ref;
+                break;
 
-                    case Operation::Add:
-                        return std::min(255, input[0] + input[1]);
+            case Regs::CompareFunc::LessThan:
+                pass = combiner_output.a() < output_merger.alpha_test.ref;
+                break;
 
-                    case Operation::AddSigned:
-                    {
-                        // TODO(bunnei): Verify that the color conversion from (float) 0.5f to (byte) 128 is correct
-                        auto result = static_cast<int>(input[0]) + static_cast<int>(input[1]) - 128;
-                        return static_cast<u8>(MathUtil::Clamp<int>(result, 0, 255));
-                    }
+            case Regs::CompareFunc::LessThanOrEqual:
+                pass = combiner_output.a() <= output_merger.alpha_test.ref;
+                break;
 
-                    case Operation::Lerp:
-                        return (input[0] * input[2] + input[1] * (255 - input[2])) / 255;
+            case Regs::CompareFunc::GreaterThan:
+                pass = combiner_output.a() > output_merger.alpha_test.ref;
+                break;
 
-                    case Operation::Subtract:
-                        return std::max(0, (int)input[0] - (int)input[1]);
+            case Regs::CompareFunc::GreaterThanOrEqual:
+                pass = combiner_output.a() >= output_merger.alpha_test.ref;
+                break;
+            }
 
-                    case Operation::MultiplyThenAdd:
-                        return std::min(255, (input[0] * input[1] + 255 * input[2]) / 255);
+            if (!pass)
+                return;
+        }
 
-                    case Operation::AddThenMultiply:
-                        return (std::min(255, (input[0] + input[1])) * input[2]) / 255;
+        // Apply fog combiner
+        // Not fully accurate. We'd have to know what data type is used to
+        // store the depth etc. Using float for now until we know more
+        // about Pica datatypes
+        if (regs.fog_mode == Regs::FogMode::Fog) {
+            const Math::Vec3<u8> fog_color = {
+                static_cast<u8>(regs.fog_color.r.Value()),
+                static_cast<u8>(regs.fog_color.g.Value()),
+                static_cast<u8>(regs.fog_color.b.Value()),
+            };
 
-                    default:
-                        LOG_ERROR(HW_GPU, "Unknown alpha combiner operation %d", (int)op);
-                        UNIMPLEMENTED();
-                        return 0;
-                    }
-                };
+            // Get index into fog LUT
+            float fog_index;
+            if (g_state.regs.fog_flip) {
+                fog_index = (1.0f - depth) * 128.0f;
+            } else {
+                fog_index = depth * 128.0f;
+            }
 
-                // color combiner
-                // NOTE: Not sure if the alpha combiner might use the color output of the previous
-                //       stage as input. Hence, we currently don't directly write the result to
-                //       combiner_output.rgb(), but instead store it in a temporary variable until
-                //       alpha combining has been done.
-                Math::Vec3<u8> color_result[3] = {
-                    GetColorModifier(tev_stage.color_modifier1, GetSource(tev_stage.color_source1)),
-                    GetColorModifier(tev_stage.color_modifier2, GetSource(tev_stage.color_source2)),
-                    GetColorModifier(tev_stage.color_modifier3, GetSource(tev_stage.color_source3))
-                };
-                auto color_output = ColorCombine(tev_stage.color_op, color_result);
-
-                // alpha combiner
-                std::array<u8,3> alpha_result = {{
-                    GetAlphaModifier(tev_stage.alpha_modifier1, GetSource(tev_stage.alpha_source1)),
-                    GetAlphaModifier(tev_stage.alpha_modifier2, GetSource(tev_stage.alpha_source2)),
-                    GetAlphaModifier(tev_stage.alpha_modifier3, GetSource(tev_stage.alpha_source3))
-                }};
-                auto alpha_output = AlphaCombine(tev_stage.alpha_op, alpha_result);
-
-                combiner_output[0] = std::min((unsigned)255, color_output.r() * tev_stage.GetColorMultiplier());
-                combiner_output[1] = std::min((unsigned)255, color_output.g() * tev_stage.GetColorMultiplier());
-                combiner_output[2] = std::min((unsigned)255, color_output.b() * tev_stage.GetColorMultiplier());
-                combiner_output[3] = std::min((unsigned)255, alpha_output * tev_stage.GetAlphaMultiplier());
-
-                combiner_buffer = next_combiner_buffer;
-
-                if (regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(tev_stage_index)) {
-                    next_combiner_buffer.r() = combiner_output.r();
-                    next_combiner_buffer.g() = combiner_output.g();
-                    next_combiner_buffer.b() = combiner_output.b();
-                }
+            // Generate clamped fog factor from LUT for given fog index
+            float fog_i = MathUtil::Clamp(floorf(fog_index), 0.0f, 127.0f);
+            float fog_f = fog_index - fog_i;
+            const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
+            float fog_factor = (fog_lut_entry.value + fog_lut_entry.difference * fog_f) / 2047.0f; // This is signed fixed point 1.11
+            fog_factor = MathUtil::Clamp(fog_factor, 0.0f, 1.0f);
 
-                if (regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(tev_stage_index)) {
-                    next_combiner_buffer.a() = combiner_output.a();
-                }
+            // Blend the fog
+            for (unsigned i = 0; i < 3; i++) {
+                combiner_output[i] = fog_factor * combiner_output[i] + (1.0f - fog_factor) * fog_color[i];
             }
+        }
 
-            const auto& output_merger = regs.output_merger;
-            // TODO: Does alpha testing happen before or after stencil?
-            if (output_merger.alpha_test.enable) {
-                bool pass = false;
+        u8 old_stencil = 0;
 
-                switch (output_merger.alpha_test.func) {
-                case Regs::CompareFunc::Never:
-                    pass = false;
-                    break;
+        auto UpdateStencil = [stencil_test, x, y, &old_stencil](Pica::Regs::StencilAction action) {
+            u8 new_stencil = PerformStencilAction(action, old_stencil, stencil_test.reference_value);
+            if (g_state.regs.framebuffer.allow_depth_stencil_write != 0)
+                SetStencil(x >> 4, y >> 4, (new_stencil & stencil_test.write_mask) | (old_stencil & ~stencil_test.write_mask));
+        };
 
-                case Regs::CompareFunc::Always:
-                    pass = true;
-                    break;
+        if (stencil_action_enable) {
+            old_stencil = GetStencil(x >> 4, y >> 4);
+            u8 dest = old_stencil & stencil_test.input_mask;
+            u8 ref = stencil_test.reference_value & stencil_test.input_mask;
 
-                case Regs::CompareFunc::Equal:
-                    pass = combiner_output.a() == output_merger.alpha_test.ref;
-                    break;
+            bool pass = false;
+            switch (stencil_test.func) {
+            case Regs::CompareFunc::Never:
+                pass = false;
+                break;
 
-                case Regs::CompareFunc::NotEqual:
-                    pass = combiner_output.a() != output_merger.alpha_test.ref;
-                    break;
+            case Regs::CompareFunc::Always:
+                pass = true;
+                break;
 
-                case Regs::CompareFunc::LessThan:
-                    pass = combiner_output.a() < output_merger.alpha_test.ref;
-                    break;
+            case Regs::CompareFunc::Equal:
+                pass = (ref == dest);
+                break;
 
-                case Regs::CompareFunc::LessThanOrEqual:
-                    pass = combiner_output.a() <= output_merger.alpha_test.ref;
-                    break;
+            case Regs::CompareFunc::NotEqual:
+                pass = (ref != dest);
+                break;
 
-                case Regs::CompareFunc::GreaterThan:
-                    pass = combiner_output.a() > output_merger.alpha_test.ref;
-                    break;
+            case Regs::CompareFunc::LessThan:
+                pass = (ref < dest);
+                break;
 
-                case Regs::CompareFunc::GreaterThanOrEqual:
-                    pass = combiner_output.a() >= output_merger.alpha_test.ref;
-                    break;
-                }
+            case Regs::CompareFunc::LessThanOrEqual:
+                pass = (ref <= dest);
+                break;
 
-                if (!pass)
-                    continue;
+            case Regs::CompareFunc::GreaterThan:
+                pass = (ref > dest);
+                break;
+
+            case Regs::CompareFunc::GreaterThanOrEqual:
+                pass = (ref >= dest);
+                break;
             }
 
-            // Apply fog combiner
-            // Not fully accurate. We'd have to know what data type is used to
-            // store the depth etc. Using float for now until we know more
-            // about Pica datatypes
-            if (regs.fog_mode == Regs::FogMode::Fog) {
-                const Math::Vec3<u8> fog_color = {
-                    static_cast<u8>(regs.fog_color.r.Value()),
-                    static_cast<u8>(regs.fog_color.g.Value()),
-                    static_cast<u8>(regs.fog_color.b.Value()),
-                };
+            if (!pass) {
+                UpdateStencil(stencil_test.action_stencil_fail);
+                return;
+            }
+        }
 
-                // Get index into fog LUT
-                float fog_index;
-                if (g_state.regs.fog_flip) {
-                    fog_index = (1.0f - depth) * 128.0f;
-                } else {
-                    fog_index = depth * 128.0f;
-                }
+        // Convert float to integer
+        unsigned num_bits = Regs::DepthBitsPerPixel(regs.framebuffer.depth_format);
+        u32 z = (u32)(depth * ((1 << num_bits) - 1));
 
-                // Generate clamped fog factor from LUT for given fog index
-                float fog_i = MathUtil::Clamp(floorf(fog_index), 0.0f, 127.0f);
-                float fog_f = fog_index - fog_i;
-                const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
-                float fog_factor = (fog_lut_entry.value + fog_lut_entry.difference * fog_f) / 2047.0f; // This is signed fixed point 1.11
-                fog_factor = MathUtil::Clamp(fog_factor, 0.0f, 1.0f);
+        if (Features & FEATURE_DEPTH_TEST) {
+            u32 ref_z = GetDepth(x >> 4, y >> 4);
 
-                // Blend the fog
-                for (unsigned i = 0; i < 3; i++) {
-                    combiner_output[i] = fog_factor * combiner_output[i] + (1.0f - fog_factor) * fog_color[i];
-                }
+            bool pass = false;
+
+            switch (output_merger.depth_test_func) {
+            case Regs::CompareFunc::Never:
+                pass = false;
+                break;
+
+            case Regs::CompareFunc::Always:
+                pass = true;
+                break;
+
+            case Regs::CompareFunc::Equal:
+                pass = z == ref_z;
+                break;
+
+            case Regs::CompareFunc::NotEqual:
+                pass = z != ref_z;
+                break;
+
+            case Regs::CompareFunc::LessThan:
+                pass = z < ref_z;
+                break;
+
+            case Regs::CompareFunc::LessThanOrEqual:
+                pass = z <= ref_z;
+                break;
+
+            case Regs::CompareFunc::GreaterThan:
+                pass = z > ref_z;
+                break;
+
+            case Regs::CompareFunc::GreaterThanOrEqual:
+                pass = z >= ref_z;
+                break;
             }
 
-            u8 old_stencil = 0;
+            if (!pass) {
+                if (stencil_action_enable)
+                    UpdateStencil(stencil_test.action_depth_fail);
+                return;
+            }
+        }
 
-            auto UpdateStencil = [stencil_test, x, y, &old_stencil](Pica::Regs::StencilAction action) {
-                u8 new_stencil = PerformStencilAction(action, old_stencil, stencil_test.reference_value);
-                if (g_state.regs.framebuffer.allow_depth_stencil_write != 0)
-                    SetStencil(x >> 4, y >> 4, (new_stencil & stencil_test.write_mask) | (old_stencil & ~stencil_test.write_mask));
-            };
+        if (regs.framebuffer.allow_depth_stencil_write != 0 && output_merger.depth_write_enable)
+            SetDepth(x >> 4, y >> 4, z);
 
-            if (stencil_action_enable) {
-                old_stencil = GetStencil(x >> 4, y >> 4);
-                u8 dest = old_stencil & stencil_test.input_mask;
-                u8 ref = stencil_test.reference_value & stencil_test.input_mask;
+        // The stencil depth_pass action is executed even if depth testing is disabled
+        if (stencil_action_enable)
+            UpdateStencil(stencil_test.action_depth_pass);
 
-                bool pass = false;
-                switch (stencil_test.func) {
-                case Regs::CompareFunc::Never:
-                    pass = false;
-                    break;
+        auto dest = GetPixel(x >> 4, y >> 4);
+        Math::Vec4<u8> blend_output = combiner_output;
 
-                case Regs::CompareFunc::Always:
-                    pass = true;
-                    break;
+        if (Features & FEATURE_ALPHA_BLEND) {
+            auto params = output_merger.alpha_blending;
 
-                case Regs::CompareFunc::Equal:
-                    pass = (ref == dest);
-                    break;
+            auto LookupFactor = [&](unsigned channel, Regs::BlendFactor factor) -> u8 {
+                DEBUG_ASSERT(channel < 4);
 
-                case Regs::CompareFunc::NotEqual:
-                    pass = (ref != dest);
-                    break;
+                const Math::Vec4<u8> blend_const = {
+                    static_cast<u8>(output_merger.blend_const.r),
+                    static_cast<u8>(output_merger.blend_const.g),
+                    static_cast<u8>(output_merger.blend_const.b),
+                    static_cast<u8>(output_merger.blend_const.a)
+                };
 
-                case Regs::CompareFunc::LessThan:
-                    pass = (ref < dest);
-                    break;
+                switch (factor) {
+                case Regs::BlendFactor::Zero:
+                    return 0;
 
-                case Regs::CompareFunc::LessThanOrEqual:
-                    pass = (ref <= dest);
-                    break;
+                case Regs::BlendFactor::One:
+                    return 255;
 
-                case Regs::CompareFunc::GreaterThan:
-                    pass = (ref > dest);
-                    break;
+                case Regs::BlendFactor::SourceColor:
+                    return combiner_output[channel];
 
-                case Regs::CompareFunc::GreaterThanOrEqual:
-                    pass = (ref >= dest);
-                    break;
-                }
+                case Regs::BlendFactor::OneMinusSourceColor:
+                    return 255 - combiner_output[channel];
 
-                if (!pass) {
-                    UpdateStencil(stencil_test.action_stencil_fail);
-                    continue;
-                }
-            }
+                case Regs::BlendFactor::DestColor:
+                    return dest[channel];
 
-            // Convert float to integer
-            unsigned num_bits = Regs::DepthBitsPerPixel(regs.framebuffer.depth_format);
-            u32 z = (u32)(depth * ((1 << num_bits) - 1));
+                case Regs::BlendFactor::OneMinusDestColor:
+                    return 255 - dest[channel];
 
-            if (output_merger.depth_test_enable) {
-                u32 ref_z = GetDepth(x >> 4, y >> 4);
+                case Regs::BlendFactor::SourceAlpha:
+                    return combiner_output.a();
 
-                bool pass = false;
+                case Regs::BlendFactor::OneMinusSourceAlpha:
+                    return 255 - combiner_output.a();
 
-                switch (output_merger.depth_test_func) {
-                case Regs::CompareFunc::Never:
-                    pass = false;
-                    break;
+                case Regs::BlendFactor::DestAlpha:
+                    return dest.a();
 
-                case Regs::CompareFunc::Always:
-                    pass = true;
-                    break;
+                case Regs::BlendFactor::OneMinusDestAlpha:
+                    return 255 - dest.a();
+
+                case Regs::BlendFactor::ConstantColor:
+                    return blend_const[channel];
+
+                case Regs::BlendFactor::OneMinusConstantColor:
+                    return 255 - blend_const[channel];
+
+                case Regs::BlendFactor::ConstantAlpha:
+                    return blend_const.a();
 
-                case Regs::CompareFunc::Equal:
-                    pass = z == ref_z;
+                case Regs::BlendFactor::OneMinusConstantAlpha:
+                    return 255 - blend_const.a();
+
+                case Regs::BlendFactor::SourceAlphaSaturate:
+                    // Returns 1.0 for the alpha channel
+                    if (channel == 3)
+                        return 255;
+                    return std::min(combiner_output.a(), static_cast<u8>(255 - dest.a()));
+
+                default:
+                    LOG_CRITICAL(HW_GPU, "Unknown blend factor %x", factor);
+                    UNIMPLEMENTED();
                     break;
+                }
 
-                case Regs::CompareFunc::NotEqual:
-                    pass = z != ref_z;
+                return combiner_output[channel];
+            };
+
+            static auto EvaluateBlendEquation = [](const Math::Vec4<u8>& src, const Math::Vec4<u8>& srcfactor,
+                                                   const Math::Vec4<u8>& dest, const Math::Vec4<u8>& destfactor,
+                                                   Regs::BlendEquation equation) {
+                Math::Vec4<int> result;
+
+                auto src_result = (src  *  srcfactor).Cast<int>();
+                auto dst_result = (dest * destfactor).Cast<int>();
+
+                switch (equation) {
+                case Regs::BlendEquation::Add:
+                    result = (src_result + dst_result) / 255;
                     break;
 
-                case Regs::CompareFunc::LessThan:
-                    pass = z < ref_z;
+                case Regs::BlendEquation::Subtract:
+                    result = (src_result - dst_result) / 255;
                     break;
 
-                case Regs::CompareFunc::LessThanOrEqual:
-                    pass = z <= ref_z;
+                case Regs::BlendEquation::ReverseSubtract:
+                    result = (dst_result - src_result) / 255;
                     break;
 
-                case Regs::CompareFunc::GreaterThan:
-                    pass = z > ref_z;
+                // TODO: How do these two actually work?
+                //       OpenGL doesn't include the blend factors in the min/max computations,
+                //       but is this what the 3DS actually does?
+                case Regs::BlendEquation::Min:
+                    result.r() = std::min(src.r(), dest.r());
+                    result.g() = std::min(src.g(), dest.g());
+                    result.b() = std::min(src.b(), dest.b());
+                    result.a() = std::min(src.a(), dest.a());
                     break;
 
-                case Regs::CompareFunc::GreaterThanOrEqual:
-                    pass = z >= ref_z;
+                case Regs::BlendEquation::Max:
+                    result.r() = std::max(src.r(), dest.r());
+                    result.g() = std::max(src.g(), dest.g());
+                    result.b() = std::max(src.b(), dest.b());
+                    result.a() = std::max(src.a(), dest.a());
                     break;
-                }
 
-                if (!pass) {
-                    if (stencil_action_enable)
-                        UpdateStencil(stencil_test.action_depth_fail);
-                    continue;
+                default:
+                    LOG_CRITICAL(HW_GPU, "Unknown RGB blend equation %x", equation);
+                    UNIMPLEMENTED();
                 }
-            }
 
-            if (regs.framebuffer.allow_depth_stencil_write != 0 && output_merger.depth_write_enable)
-                SetDepth(x >> 4, y >> 4, z);
+                return Math::Vec4<u8>(MathUtil::Clamp(result.r(), 0, 255),
+                                MathUtil::Clamp(result.g(), 0, 255),
+                                MathUtil::Clamp(result.b(), 0, 255),
+                                MathUtil::Clamp(result.a(), 0, 255));
+            };
 
-            // The stencil depth_pass action is executed even if depth testing is disabled
-            if (stencil_action_enable)
-                UpdateStencil(stencil_test.action_depth_pass);
+            auto srcfactor = Math::MakeVec(LookupFactor(0, params.factor_source_rgb),
+                                           LookupFactor(1, params.factor_source_rgb),
+                                           LookupFactor(2, params.factor_source_rgb),
+                                           LookupFactor(3, params.factor_source_a));
 
-            auto dest = GetPixel(x >> 4, y >> 4);
-            Math::Vec4<u8> blend_output = combiner_output;
+            auto dstfactor = Math::MakeVec(LookupFactor(0, params.factor_dest_rgb),
+                                           LookupFactor(1, params.factor_dest_rgb),
+                                           LookupFactor(2, params.factor_dest_rgb),
+                                           LookupFactor(3, params.factor_dest_a));
 
-            if (output_merger.alphablend_enable) {
-                auto params = output_merger.alpha_blending;
+            blend_output     = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor, params.blend_equation_rgb);
+            blend_output.a() = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor, params.blend_equation_a).a();
+        } else {
+            static auto LogicOp = [](u8 src, u8 dest, Regs::LogicOp op) -> u8 {
+                switch (op) {
+                case Regs::LogicOp::Clear:
+                    return 0;
 
-                auto LookupFactor = [&](unsigned channel, Regs::BlendFactor factor) -> u8 {
-                    DEBUG_ASSERT(channel < 4);
+                case Regs::LogicOp::And:
+                    return src & dest;
 
-                    const Math::Vec4<u8> blend_const = {
-                        static_cast<u8>(output_merger.blend_const.r),
-                        static_cast<u8>(output_merger.blend_const.g),
-                        static_cast<u8>(output_merger.blend_const.b),
-                        static_cast<u8>(output_merger.blend_const.a)
-                    };
+                case Regs::LogicOp::AndReverse:
+                    return src & ~dest;
 
-                    switch (factor) {
-                    case Regs::BlendFactor::Zero:
-                        return 0;
+                case Regs::LogicOp::Copy:
+                    return src;
 
-                    case Regs::BlendFactor::One:
-                        return 255;
+                case Regs::LogicOp::Set:
+                    return 255;
 
-                    case Regs::BlendFactor::SourceColor:
-                        return combiner_output[channel];
+                case Regs::LogicOp::CopyInverted:
+                    return ~src;
 
-                    case Regs::BlendFactor::OneMinusSourceColor:
-                        return 255 - combiner_output[channel];
+                case Regs::LogicOp::NoOp:
+                    return dest;
 
-                    case Regs::BlendFactor::DestColor:
-                        return dest[channel];
+                case Regs::LogicOp::Invert:
+                    return ~dest;
 
-                    case Regs::BlendFactor::OneMinusDestColor:
-                        return 255 - dest[channel];
+                case Regs::LogicOp::Nand:
+                    return ~(src & dest);
 
-                    case Regs::BlendFactor::SourceAlpha:
-                        return combiner_output.a();
+                case Regs::LogicOp::Or:
+                    return src | dest;
 
-                    case Regs::BlendFactor::OneMinusSourceAlpha:
-                        return 255 - combiner_output.a();
+                case Regs::LogicOp::Nor:
+                    return ~(src | dest);
 
-                    case Regs::BlendFactor::DestAlpha:
-                        return dest.a();
+                case Regs::LogicOp::Xor:
+                    return src ^ dest;
 
-                    case Regs::BlendFactor::OneMinusDestAlpha:
-                        return 255 - dest.a();
+                case Regs::LogicOp::Equiv:
+                    return ~(src ^ dest);
 
-                    case Regs::BlendFactor::ConstantColor:
-                        return blend_const[channel];
+                case Regs::LogicOp::AndInverted:
+                    return ~src & dest;
 
-                    case Regs::BlendFactor::OneMinusConstantColor:
-                        return 255 - blend_const[channel];
+                case Regs::LogicOp::OrReverse:
+                    return src | ~dest;
 
-                    case Regs::BlendFactor::ConstantAlpha:
-                        return blend_const.a();
+                case Regs::LogicOp::OrInverted:
+                    return ~src | dest;
+                }
+            };
 
-                    case Regs::BlendFactor::OneMinusConstantAlpha:
-                        return 255 - blend_const.a();
+            blend_output = Math::MakeVec(
+                LogicOp(combiner_output.r(), dest.r(), output_merger.logic_op),
+                LogicOp(combiner_output.g(), dest.g(), output_merger.logic_op),
+                LogicOp(combiner_output.b(), dest.b(), output_merger.logic_op),
+                LogicOp(combiner_output.a(), dest.a(), output_merger.logic_op));
+        }
 
-                    case Regs::BlendFactor::SourceAlphaSaturate:
-                        // Returns 1.0 for the alpha channel
-                        if (channel == 3)
-                            return 255;
-                        return std::min(combiner_output.a(), static_cast<u8>(255 - dest.a()));
+        const Math::Vec4<u8> result = {
+            output_merger.red_enable   ? blend_output.r() : dest.r(),
+            output_merger.green_enable ? blend_output.g() : dest.g(),
+            output_merger.blue_enable  ? blend_output.b() : dest.b(),
+            output_merger.alpha_enable ? blend_output.a() : dest.a()
+        };
 
-                    default:
-                        LOG_CRITICAL(HW_GPU, "Unknown blend factor %x", factor);
-                        UNIMPLEMENTED();
-                        break;
-                    }
+        if (regs.framebuffer.allow_color_write != 0)
+            DrawPixel(x >> 4, y >> 4, result);
+    };
 
-                    return combiner_output[channel];
-                };
+    if (min_x >= max_x || min_y >= max_y)
+        return;
+
+    // Number of pixel centers within the bounds along each axis
+    const int width = ((int)max_x - (int)min_x + 7) >> 4;
+    const int height = ((int)max_y - (int)min_y + 7) >> 4;
+
+    // Barycentric coordinates relative to the center of the topleft pixel
+    const u16 origin_x = min_x + 8;
+    const u16 origin_y = min_y + 8;
+    const EdgeFunction edge0(vtxpos[1].xy(), vtxpos[2].xy(), bias0, origin_x, origin_y);
+    const EdgeFunction edge1(vtxpos[2].xy(), vtxpos[0].xy(), bias1, origin_x, origin_y);
+    const EdgeFunction edge2(vtxpos[0].xy(), vtxpos[1].xy(), bias2, origin_x, origin_y);
+
+    for (int block_y = 0; block_y < height; block_y += BLOCK_SIZE) {
+        const int block_height = std::min(BLOCK_SIZE, height - block_y);
+
+        for (int block_x = 0; block_x < width; block_x += BLOCK_SIZE) {
+            const int block_width = std::min(BLOCK_SIZE, width - block_x);
+
+            // Edge functions are linear, so their extrema over a block are at its corners. The block
+            // is skipped if one of them is negative at all corners, and its pixels don't need to be
+            // tested for coverage if all of them are non-negative at all corners.
+            bool reject = false;
+            bool accept = true;
+            for (const EdgeFunction* edge : {&edge0, &edge1, &edge2}) {
+                const int corner0 = edge->At(block_x, block_y);
+                const int corner1 = edge->At(block_x + block_width - 1, block_y);
+                const int corner2 = edge->At(block_x, block_y + block_height - 1);
+                const int corner3 = edge->At(block_x + block_width - 1, block_y + block_height - 1);
+                reject |= std::max({corner0, corner1, corner2, corner3}) < 0;
+                accept &= std::min({corner0, corner1, corner2, corner3}) >= 0;
+            }
+            if (reject)
+                continue;
 
-                static auto EvaluateBlendEquation = [](const Math::Vec4<u8>& src, const Math::Vec4<u8>& srcfactor,
-                                                       const Math::Vec4<u8>& dest, const Math::Vec4<u8>& destfactor,
-                                                       Regs::BlendEquation equation) {
-                    Math::Vec4<int> result;
-
-                    auto src_result = (src  *  srcfactor).Cast<int>();
-                    auto dst_result = (dest * destfactor).Cast<int>();
-
-                    switch (equation) {
-                    case Regs::BlendEquation::Add:
-                        result = (src_result + dst_result) / 255;
-                        break;
-
-                    case Regs::BlendEquation::Subtract:
-                        result = (src_result - dst_result) / 255;
-                        break;
-
-                    case Regs::BlendEquation::ReverseSubtract:
-                        result = (dst_result - src_result) / 255;
-                        break;
-
-                    // TODO: How do these two actually work?
-                    //       OpenGL doesn't include the blend factors in the min/max computations,
-                    //       but is this what the 3DS actually does?
-                    case Regs::BlendEquation::Min:
-                        result.r() = std::min(src.r(), dest.r());
-                        result.g() = std::min(src.g(), dest.g());
-                        result.b() = std::min(src.b(), dest.b());
-                        result.a() = std::min(src.a(), dest.a());
-                        break;
-
-                    case Regs::BlendEquation::Max:
-                        result.r() = std::max(src.r(), dest.r());
-                        result.g() = std::max(src.g(), dest.g());
-                        result.b() = std::max(src.b(), dest.b());
-                        result.a() = std::max(src.a(), dest.a());
-                        break;
+            if (regs.scissor_test.mode == Regs::ScissorMode::Exclude) {
+                const int block_x1 = origin_x + block_x * 0x10;
+                const int block_y1 = origin_y + block_y * 0x10;
+                const int block_x2 = block_x1 + (block_width - 1) * 0x10;
+                const int block_y2 = block_y1 + (block_height - 1) * 0x10;
+                if (block_x1 >= scissor_x1 && block_x2 < scissor_x2 &&
+                    block_y1 >= scissor_y1 && block_y2 < scissor_y2)
+                    continue;
+            }
 
-                    default:
-                        LOG_CRITICAL(HW_GPU, "Unknown RGB blend equation %x", equation);
-                        UNIMPLEMENTED();
+            for (int y = block_y; y < block_y + block_height; y += 2) {
+                QuadEdge quad0(edge0, block_x, y);
+                QuadEdge quad1(edge1, block_x, y);
+                QuadEdge quad2(edge2, block_x, y);
+
+                // Quads on the right and bottom borders of the block may be partially outside of it
+                const int row_mask = (y + 1 < block_y + block_height) ? 0xF : 0x3;
+
+                for (int x = block_x; x < block_x + block_width; x += 2) {
+                    int mask = row_mask & ((x + 1 < block_x + block_width) ? 0xF : 0x5);
+                    if (!accept)
+                        mask &= GetQuadCoverage(quad0, quad1, quad2);
+
+                    if (mask != 0) {
+                        std::array<int, 4> w0, w1, w2;
+                        quad0.Store(w0);
+                        quad1.Store(w1);
+                        quad2.Store(w2);
+                        for (int i = 0; i < 4; ++i) {
+                            if (mask & (1 << i)) {
+                                ShadePixel(origin_x + (x + (i & 1)) * 0x10,
+                                           origin_y + (y + (i >> 1)) * 0x10,
+                                           w0[i], w1[i], w2[i]);
+                            }
+                        }
                     }
 
-                    return Math::Vec4<u8>(MathUtil::Clamp(result.r(), 0, 255),
-                                    MathUtil::Clamp(result.g(), 0, 255),
-                                    MathUtil::Clamp(result.b(), 0, 255),
-                                    MathUtil::Clamp(result.a(), 0, 255));
-                };
+                    quad0.StepX();
+                    quad1.StepX();
+                    quad2.StepX();
+                }
+            }
+        }
+    }
+}
 
-                auto srcfactor = Math::MakeVec(LookupFactor(0, params.factor_source_rgb),
-                                               LookupFactor(1, params.factor_source_rgb),
-                                               LookupFactor(2, params.factor_source_rgb),
-                                               LookupFactor(3, params.factor_source_a));
+template <size_t... Features>
+static std::array<RasterizeFunction, sizeof...(Features)> MakeRasterizeFunctions(std::index_sequence<Features...>) {
+    return {{ &RasterizeTriangle<Features>... }};
+}
 
-                auto dstfactor = Math::MakeVec(LookupFactor(0, params.factor_dest_rgb),
-                                               LookupFactor(1, params.factor_dest_rgb),
-                                               LookupFactor(2, params.factor_dest_rgb),
-                                               LookupFactor(3, params.factor_dest_a));
+/// RasterizeTriangle instantiations, indexed by their combination of PixelPipelineFeature flags
+static const std::array<RasterizeFunction, NUM_FEATURE_COMBINATIONS> rasterize_functions =
+    MakeRasterizeFunctions(std::make_index_sequence<NUM_FEATURE_COMBINATIONS>());
+
+static bool IsPassThroughTevStage(const Regs::TevStageConfig& stage) {
+    return (stage.color_op             == Regs::TevStageConfig::Operation::Replace &&
+            stage.alpha_op             == Regs::TevStageConfig::Operation::Replace &&
+            stage.color_source1        == Regs::TevStageConfig::Source::Previous &&
+            stage.alpha_source1        == Regs::TevStageConfig::Source::Previous &&
+            stage.color_modifier1      == Regs::TevStageConfig::ColorModifier::SourceColor &&
+            stage.alpha_modifier1      == Regs::TevStageConfig::AlphaModifier::SourceAlpha &&
+            stage.GetColorMultiplier() == 1 &&
+            stage.GetAlphaMultiplier() == 1);
+}
 
-                blend_output     = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor, params.blend_equation_rgb);
-                blend_output.a() = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor, params.blend_equation_a).a();
-            } else {
-                static auto LogicOp = [](u8 src, u8 dest, Regs::LogicOp op) -> u8 {
-                    switch (op) {
-                    case Regs::LogicOp::Clear:
-                        return 0;
+/// Builds the pixel pipeline for the current render state
+static std::unique_ptr<PixelPipeline> CreatePixelPipeline() {
+    const auto& regs = g_state.regs;
+    const auto& output_merger = regs.output_merger;
+    auto pipeline = std::make_unique<PixelPipeline>();
 
-                    case Regs::LogicOp::And:
-                        return src & dest;
+    u32 features = 0;
 
-                    case Regs::LogicOp::AndReverse:
-                        return src & ~dest;
+    const auto textures = regs.GetTextures();
+    for (unsigned i = 0; i < 3; ++i) {
+        pipeline->texture_data[i] = nullptr;
+        if (!textures[i].enabled)
+            continue;
 
-                    case Regs::LogicOp::Copy:
-                        return src;
+        features |= FEATURE_TEXTURING;
+        pipeline->texture_info[i] = DebugUtils::TextureInfo::FromPicaRegister(textures[i].config, textures[i].format);
+        pipeline->texture_data[i] = Memory::GetPhysicalPointer(textures[i].config.GetPhysicalAddress());
+    }
 
-                    case Regs::LogicOp::Set:
-                        return 255;
+    const auto tev_stages = regs.GetTevStages();
+    for (unsigned i = 0; i < tev_stages.size(); ++i)
+        pipeline->passthrough_tev_stages[i] = IsPassThroughTevStage(tev_stages[i]);
+
+    // Tests which always pass don't need to be compiled in
+    if (output_merger.alpha_test.enable && output_merger.alpha_test.func != Regs::CompareFunc::Always)
+        features |= FEATURE_ALPHA_TEST;
+    if (output_merger.stencil_test.enable && regs.framebuffer.depth_format == Regs::DepthFormat::D24S8)
+        features |= FEATURE_STENCIL_TEST;
+    if (output_merger.depth_test_enable && output_merger.depth_test_func != Regs::CompareFunc::Always)
+        features |= FEATURE_DEPTH_TEST;
+    if (output_merger.alphablend_enable)
+        features |= FEATURE_ALPHA_BLEND;
+
+    pipeline->rasterize = rasterize_functions[features];
+    return pipeline;
+}
 
-                    case Regs::LogicOp::CopyInverted:
-                        return ~src;
+/// Maximum number of pixel pipelines kept around, the cache is emptied once it's exceeded
+static const size_t MAX_CACHED_PIXEL_PIPELINES = 1024;
 
-                    case Regs::LogicOp::NoOp:
-                        return dest;
+/// Pixel pipelines, keyed by the hash of the texturing, texture environment and output merger registers
+static std::unordered_map<u64, std::unique_ptr<PixelPipeline>> pixel_pipeline_cache;
+/// Pixel pipeline of the current render state, null if the registers changed since it was looked up
+static const PixelPipeline* current_pixel_pipeline = nullptr;
 
-                    case Regs::LogicOp::Invert:
-                        return ~dest;
+/// Cache of decoded textures, null if textures are sampled from their encoded data
+static TextureCache* texture_cache = nullptr;
 
-                    case Regs::LogicOp::Nand:
-                        return ~(src & dest);
+/// Returns the pixel pipeline for the current render state, creating it if necessary
+static const PixelPipeline& GetPixelPipeline() {
+    if (current_pixel_pipeline != nullptr)
+        return *current_pixel_pipeline;
 
-                    case Regs::LogicOp::Or:
-                        return src | dest;
+    if (texture_cache != nullptr)
+        texture_cache->Prune();
 
-                    case Regs::LogicOp::Nor:
-                        return ~(src | dest);
+    const unsigned first_reg = PICA_REG_INDEX(texture0_enable);
+    const unsigned last_reg = PICA_REG_INDEX(lighting);
+    const u64 hash = Common::ComputeHash64(&g_state.regs[first_reg], (last_reg - first_reg) * sizeof(u32));
 
-                    case Regs::LogicOp::Xor:
-                        return src ^ dest;
+    auto it = pixel_pipeline_cache.find(hash);
+    if (it == pixel_pipeline_cache.end()) {
+        if (pixel_pipeline_cache.size() >= MAX_CACHED_PIXEL_PIPELINES)
+            pixel_pipeline_cache.clear();
+        it = pixel_pipeline_cache.emplace(hash, CreatePixelPipeline()).first;
+    }
 
-                    case Regs::LogicOp::Equiv:
-                        return ~(src ^ dest);
+    // Decoded textures may have been invalidated since the pipeline was last used
+    PixelPipeline& pipeline = *it->second;
+    const auto textures = g_state.regs.GetTextures();
+    for (unsigned i = 0; i < 3; ++i) {
+        pipeline.texture_texels[i] = nullptr;
+        if (texture_cache != nullptr && textures[i].enabled)
+            pipeline.texture_texels[i] = texture_cache->GetTexture(pipeline.texture_data[i], pipeline.texture_info[i]);
+    }
 
-                    case Regs::LogicOp::AndInverted:
-                        return ~src & dest;
+    current_pixel_pipeline = &pipeline;
+    return pipeline;
+}
 
-                    case Regs::LogicOp::OrReverse:
-                        return src | ~dest;
+/**
+ * Marks the render targets as written, since pixels are written through raw pointers, and removes
+ * the decoded textures overlapping them. Called after pixels were written to them.
+ */
+static void FinishRenderTargetWrites() {
+    const auto& framebuffer = g_state.regs.framebuffer;
+    const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+    const u32 color_size = num_pixels * GPU::Regs::BytesPerPixel(GPU::Regs::PixelFormat(framebuffer.color_format.Value()));
+    const u32 depth_size = num_pixels * Regs::BytesPerDepthPixel(framebuffer.depth_format);
+
+    if (framebuffer.allow_color_write != 0)
+        Memory::MarkRegionDirty(Memory::PhysicalToVirtualAddress(framebuffer.GetColorBufferPhysicalAddress()), color_size);
+    if (framebuffer.allow_depth_stencil_write != 0)
+        Memory::MarkRegionDirty(Memory::PhysicalToVirtualAddress(framebuffer.GetDepthBufferPhysicalAddress()), depth_size);
+
+    if (texture_cache == nullptr)
+        return;
+
+    bool invalidated = false;
+    if (framebuffer.allow_color_write != 0)
+        invalidated |= texture_cache->InvalidateRegion(framebuffer.GetColorBufferPhysicalAddress(), color_size);
+    if (framebuffer.allow_depth_stencil_write != 0)
+        invalidated |= texture_cache->InvalidateRegion(framebuffer.GetDepthBufferPhysicalAddress(), depth_size);
+
+    if (invalidated)
+        current_pixel_pipeline = nullptr;
+}
 
-                    case Regs::LogicOp::OrInverted:
-                        return ~src | dest;
-                    }
-                };
+/// Width and height of the screen tiles triangles are binned into, in pixels
+static const unsigned TILE_SIZE = 32;
+/// Number of tiles covering the 12.4 fixed point coordinate range along each axis
+static const unsigned MAX_TILES = 0x1000 / TILE_SIZE;
+
+/// Threads rasterizing the binned triangles, null if binning is disabled
+static Common::ThreadPool* binning_thread_pool = nullptr;
+
+/// Triangles queued since the last flush, in submission order
+static std::vector<TriangleSetup> binned_triangles;
+/// Indices of the binned triangles covering each tile, in submission order
+static std::vector<u32> tile_triangles[MAX_TILES * MAX_TILES];
+/// Tiles which are covered by at least one binned triangle
+static std::vector<u32> active_tiles;
+
+/// Number of tiles along each axis, the last row and column also cover anything beyond the framebuffer
+static unsigned num_tiles_x;
+static unsigned num_tiles_y;
+
+/// Returns the bounds of a tile, in 12.4 fixed point coordinates
+static void GetTileBounds(unsigned tile_x, unsigned tile_y, u16& min_x, u16& min_y, u16& max_x, u16& max_y) {
+    min_x = static_cast<u16>(tile_x * TILE_SIZE << 4);
+    min_y = static_cast<u16>(tile_y * TILE_SIZE << 4);
+    max_x = tile_x + 1 < num_tiles_x ? static_cast<u16>((tile_x + 1) * TILE_SIZE << 4) : 0xFFFF;
+    max_y = tile_y + 1 < num_tiles_y ? static_cast<u16>((tile_y + 1) * TILE_SIZE << 4) : 0xFFFF;
+}
 
-                blend_output = Math::MakeVec(
-                    LogicOp(combiner_output.r(), dest.r(), output_merger.logic_op),
-                    LogicOp(combiner_output.g(), dest.g(), output_merger.logic_op),
-                    LogicOp(combiner_output.b(), dest.b(), output_merger.logic_op),
-                    LogicOp(combiner_output.a(), dest.a(), output_merger.logic_op));
-            }
+/// Queues a triangle into the tiles covered by its bounding box
+static void BinTriangle(const TriangleSetup& setup) {
+    if (binned_triangles.empty()) {
+        // The framebuffer can't change while triangles are queued, since any register write
+        // affecting rasterization flushes them
+        const auto& framebuffer = g_state.regs.framebuffer;
+        num_tiles_x = std::min((framebuffer.GetWidth() + TILE_SIZE - 1) / TILE_SIZE, MAX_TILES);
+        num_tiles_y = std::min((framebuffer.GetHeight() + TILE_SIZE - 1) / TILE_SIZE, MAX_TILES);
+        num_tiles_x = std::max(num_tiles_x, 1u);
+        num_tiles_y = std::max(num_tiles_y, 1u);
+    }
 
-            const Math::Vec4<u8> result = {
-                output_merger.red_enable   ? blend_output.r() : dest.r(),
-                output_merger.green_enable ? blend_output.g() : dest.g(),
-                output_merger.blue_enable  ? blend_output.b() : dest.b(),
-                output_merger.alpha_enable ? blend_output.a() : dest.a()
-            };
+    if (setup.min_x >= setup.max_x || setup.min_y >= setup.max_y)
+        return;
+
+    const u32 index = static_cast<u32>(binned_triangles.size());
+    binned_triangles.push_back(setup);
+
+    const unsigned tile_x0 = std::min<unsigned>((setup.min_x >> 4) / TILE_SIZE, num_tiles_x - 1);
+    const unsigned tile_y0 = std::min<unsigned>((setup.min_y >> 4) / TILE_SIZE, num_tiles_y - 1);
+    const unsigned tile_x1 = std::min<unsigned>(((setup.max_x >> 4) - 1) / TILE_SIZE, num_tiles_x - 1);
+    const unsigned tile_y1 = std::min<unsigned>(((setup.max_y >> 4) - 1) / TILE_SIZE, num_tiles_y - 1);
 
-            if (regs.framebuffer.allow_color_write != 0)
-                DrawPixel(x >> 4, y >> 4, result);
+    for (unsigned tile_y = tile_y0; tile_y <= tile_y1; ++tile_y) {
+        for (unsigned tile_x = tile_x0; tile_x <= tile_x1; ++tile_x) {
+            const u32 tile = tile_y * MAX_TILES + tile_x;
+            if (tile_triangles[tile].empty())
+                active_tiles.push_back(tile);
+            tile_triangles[tile].push_back(index);
         }
     }
 }
 
+void SetBinning(Common::ThreadPool* thread_pool) {
+    if (thread_pool == binning_thread_pool)
+        return;
+
+    FlushTriangles();
+    binning_thread_pool = thread_pool;
+}
+
+void FlushTriangles() {
+    if (binned_triangles.empty())
+        return;
+
+    MICROPROFILE_SCOPE(GPU_Rasterization);
+
+    const PixelPipeline& pipeline = GetPixelPipeline();
+
+    // Tiles don't share any pixels, so they can be rasterized independently. The triangles of a
+    // tile are rasterized in the order they were submitted in.
+    binning_thread_pool->ParallelFor(active_tiles.size(), [&pipeline](size_t task, size_t thread) {
+        const u32 tile = active_tiles[task];
+
+        u16 min_x, min_y, max_x, max_y;
+        GetTileBounds(tile % MAX_TILES, tile / MAX_TILES, min_x, min_y, max_x, max_y);
+
+        for (u32 index : tile_triangles[tile])
+            pipeline.rasterize(pipeline, binned_triangles[index], min_x, min_y, max_x, max_y);
+    });
+
+    for (u32 tile : active_tiles)
+        tile_triangles[tile].clear();
+    active_tiles.clear();
+    binned_triangles.clear();
+
+    FinishRenderTargetWrites();
+}
+
 void ProcessTriangle(const Shader::OutputVertex& v0,
                      const Shader::OutputVertex& v1,
                      const Shader::OutputVertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+    TriangleSetup setup;
+    if (!SetupTriangle(v0, v1, v2, setup))
+        return;
+
+    // Breakpoints after draws may inspect the framebuffer, so triangles are rasterized right away
+    if (binning_thread_pool != nullptr && !(g_debug_context && g_debug_context->RequiresSerialDraws())) {
+        BinTriangle(setup);
+        return;
+    }
+
+    FlushTriangles();
+
+    MICROPROFILE_SCOPE(GPU_Rasterization);
+    const PixelPipeline& pipeline = GetPixelPipeline();
+    pipeline.rasterize(pipeline, setup, 0, 0, 0xFFFF, 0xFFFF);
+
+    FinishRenderTargetWrites();
+}
+
+void InvalidatePixelPipeline() {
+    current_pixel_pipeline = nullptr;
+}
+
+void SetTextureCache(TextureCache* cache) {
+    FlushTriangles();
+    texture_cache = cache;
+    current_pixel_pipeline = nullptr;
 }
 
 } // namespace Rasterizer
@@ -4,18 +4,51 @@
 
 #pragma once
 
+namespace Common {
+class ThreadPool;
+}
+
 namespace Pica {
 
 namespace Shader {
     struct OutputVertex;
 }
 
+class TextureCache;
+
 namespace Rasterizer {
 
+/**
+ * Rasterizes a triangle. If binning is enabled, the triangle is only set up and queued into the
+ * screen tiles it covers, until FlushTriangles is called.
+ */
 void ProcessTriangle(const Shader::OutputVertex& v0,
                      const Shader::OutputVertex& v1,
                      const Shader::OutputVertex& v2);
 
+/**
+ * Enables or disables binning, after rasterizing any queued triangles. The rasterization state must
+ * not change while triangles are queued.
+ * @param thread_pool Threads rasterizing the tiles in parallel, or null to disable binning
+ */
+void SetBinning(Common::ThreadPool* thread_pool);
+
+/// Rasterizes the queued triangles, the tiles are processed in parallel
+void FlushTriangles();
+
+/**
+ * Discards the pixel pipeline specialised to the current render state, so that it's looked up again
+ * for the next triangle. Must be called when the rasterization registers change.
+ */
+void InvalidatePixelPipeline();
+
+/**
+ * Sets the cache textures are decoded into before they're sampled, after rasterizing any queued
+ * triangles. Decoded textures overlapping the render targets are invalidated as pixels are written.
+ * @param texture_cache Texture cache, or null to sample textures from their encoded data
+ */
+void SetTextureCache(TextureCache* texture_cache);
+
 } // namespace Rasterizer
 
 } // namespace Pica
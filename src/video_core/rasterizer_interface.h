@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "common/common_types.h"
 
 #include "core/hw/gpu.h"
@@ -42,14 +45,31 @@ public:
     /// Notify rasterizer that any caches of the specified region should be flushed to 3DS memory and invalidated
     virtual void FlushAndInvalidateRegion(PAddr addr, u32 size) = 0;
 
+    /// Notify rasterizer that writes to the specified region which it still has in flight should be completed
+    virtual void FinishPendingWrites(PAddr addr, u32 size) {}
+
     /// Attempt to use a faster method to perform a display transfer
     virtual bool AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) { return false; }
 
-    /// Attempt to use a faster method to fill a region
-    virtual bool AccelerateFill(const GPU::Regs::MemoryFillConfig& config) { return false; }
+    /**
+     * Attempt to use a faster method to fill a region, possibly only parts of it. Cached data
+     * overlapping the parts left to the CPU is flushed and invalidated.
+     * @param cpu_fill_regions Receives the [start, end) address ranges which the CPU still has to fill
+     * @return False if nothing was filled, leaving the whole region to the CPU
+     */
+    virtual bool AccelerateFill(const GPU::Regs::MemoryFillConfig& config, std::vector<std::pair<PAddr, PAddr>>& cpu_fill_regions) { return false; }
 
     /// Attempt to use a faster method to display the framebuffer to screen
     virtual bool AccelerateDisplay(const GPU::Regs::FramebufferConfig& config, PAddr framebuffer_addr, u32 pixel_stride, ScreenInfo& screen_info) { return false; }
+
+    /// Whether the rasterizer can be driven from a thread other than the one owning the render context
+    virtual bool SupportsGPUThread() const { return false; }
+
+    /**
+     * Called on the emulation thread before each GPU command is run, with whether it will run on the
+     * GPU thread. The GPU thread is idle whenever the value changes.
+     */
+    virtual void SetGPUThreadActive(bool active) {}
 };
 
 }
@@ -0,0 +1,40 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/emu_window.h"
+#include "common/logging/log.h"
+
+#include "core/tracer/recorder.h"
+
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica.h"
+#include "video_core/renderer_null/renderer_null.h"
+#include "video_core/video_core.h"
+
+void RendererNull::SwapBuffers() {
+    m_current_frame++;
+
+    render_window->PollEvents();
+    render_window->SwapBuffers();
+
+    if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
+        Pica::g_debug_context->recorder->FrameFinished();
+    }
+}
+
+void RendererNull::SetWindow(EmuWindow* window) {
+    render_window = window;
+}
+
+bool RendererNull::Init() {
+    // There is no graphics context to run the hardware rasterizer on
+    VideoCore::g_hw_renderer_enabled = false;
+    RefreshRasterizerSetting();
+
+    LOG_INFO(Render, "Running without a display, using the software rasterizer");
+    return true;
+}
+
+void RendererNull::ShutDown() {
+}
@@ -0,0 +1,34 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "video_core/renderer_base.h"
+
+class EmuWindow;
+
+/**
+ * Renderer that doesn't present anything, used when running without a display. Rendering is done
+ * by the software rasterizer, so the emulated framebuffers are always up to date in memory.
+ */
+class RendererNull : public RendererBase {
+public:
+    /// Swap buffers (render frame)
+    void SwapBuffers() override;
+
+    /**
+     * Set the emulator window to use for renderer
+     * @param window EmuWindow handle to emulator window to use for rendering
+     */
+    void SetWindow(EmuWindow* window) override;
+
+    /// Initialize the renderer
+    bool Init() override;
+
+    /// Shutdown the renderer
+    void ShutDown() override;
+
+private:
+    EmuWindow* render_window = nullptr;
+};
@@ -3,10 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <memory>
+#include <set>
 #include <string>
 #include <tuple>
 #include <utility>
 
+#include <boost/icl/interval_set.hpp>
 #include <glad/glad.h>
 
 #include "common/assert.h"
@@ -259,11 +261,11 @@ void RasterizerOpenGL::DrawTriangles() {
     // TODO: Restrict invalidation area to the viewport
     if (color_surface != nullptr) {
         color_surface->dirty = true;
-        res_cache.FlushRegion(color_surface->addr, color_surface->size, color_surface, true);
+        res_cache.InvalidateRegion(color_surface->addr, color_surface->size, color_surface);
     }
     if (depth_surface != nullptr) {
         depth_surface->dirty = true;
-        res_cache.FlushRegion(depth_surface->addr, depth_surface->size, depth_surface, true);
+        res_cache.InvalidateRegion(depth_surface->addr, depth_surface->size, depth_surface);
     }
 
     vertex_batch.clear();
@@ -681,6 +683,10 @@ void RasterizerOpenGL::FlushAndInvalidateRegion(PAddr addr, u32 size) {
     res_cache.FlushRegion(addr, size, nullptr, true);
 }
 
+void RasterizerOpenGL::FinishPendingWrites(PAddr addr, u32 size) {
+    res_cache.FinishDownloads(addr, size);
+}
+
 bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) {
     using PixelFormat = CachedSurface::PixelFormat;
     using SurfaceType = CachedSurface::SurfaceType;
@@ -737,29 +743,62 @@ bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransfe
 
     u32 dst_size = dst_params.width * dst_params.height * CachedSurface::GetFormatBpp(dst_params.pixel_format) / 8;
     dst_surface->dirty = true;
-    res_cache.FlushRegion(config.GetPhysicalOutputAddress(), dst_size, dst_surface, true);
+    res_cache.InvalidateRegion(config.GetPhysicalOutputAddress(), dst_size, dst_surface);
     return true;
 }
 
-bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config) {
-    using PixelFormat = CachedSurface::PixelFormat;
-    using SurfaceType = CachedSurface::SurfaceType;
-
-    CachedSurface* dst_surface = res_cache.TryGetFillSurface(config);
+bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config, std::vector<std::pair<PAddr, PAddr>>& cpu_fill_regions) {
+    std::vector<CachedSurface*> fill_surfaces = res_cache.GetFillSurfaces(config);
 
-    if (dst_surface == nullptr) {
+    if (fill_surfaces.empty()) {
         return false;
     }
 
     OpenGLState cur_state = OpenGLState::GetCurState();
 
-    SurfaceType dst_type = CachedSurface::GetFormatType(dst_surface->pixel_format);
-
     GLuint old_fb = cur_state.draw.draw_framebuffer;
     cur_state.draw.draw_framebuffer = framebuffer.handle;
     // TODO: When scissor test is implemented, need to disable scissor test in cur_state here so Clear call isn't affected
     cur_state.Apply();
 
+    const PAddr fill_start = config.GetStartAddress();
+    const PAddr fill_end = config.GetEndAddress();
+
+    // Surfaces that can't be cleared are left to the CPU, along with the memory between surfaces
+    std::set<const CachedSurface*> cleared_surfaces;
+    boost::icl::interval_set<PAddr> cpu_fill_set(boost::icl::interval<PAddr>::right_open(fill_start, fill_end));
+    for (CachedSurface* dst_surface : fill_surfaces) {
+        if (ClearSurface(dst_surface, config, cur_state)) {
+            dst_surface->dirty = true;
+            cleared_surfaces.insert(dst_surface);
+            cpu_fill_set -= boost::icl::interval<PAddr>::right_open(dst_surface->addr, dst_surface->addr + dst_surface->size);
+        }
+    }
+
+    cur_state.draw.draw_framebuffer = old_fb;
+    // TODO: Return scissor test to previous value when scissor test is implemented
+    cur_state.Apply();
+
+    if (cleared_surfaces.empty()) {
+        return false;
+    }
+
+    // Any other surface touching the fill is now stale, including those overlapping the cleared
+    // ones. They're written back before the CPU fills its part of the region, then dropped.
+    res_cache.FlushRegion(fill_start, fill_end - fill_start, cleared_surfaces, true);
+
+    for (const auto& interval : cpu_fill_set) {
+        cpu_fill_regions.emplace_back(interval.lower(), interval.upper());
+    }
+    return true;
+}
+
+bool RasterizerOpenGL::ClearSurface(CachedSurface* dst_surface, const GPU::Regs::MemoryFillConfig& config, OpenGLState& cur_state) {
+    using PixelFormat = CachedSurface::PixelFormat;
+    using SurfaceType = CachedSurface::SurfaceType;
+
+    SurfaceType dst_type = CachedSurface::GetFormatType(dst_surface->pixel_format);
+
     if (dst_type == SurfaceType::Color || dst_type == SurfaceType::Texture) {
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dst_surface->texture.handle, 0);
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
@@ -880,12 +919,6 @@ bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config)
         glClearBufferfi(GL_DEPTH_STENCIL, 0, value_float, value_int);
     }
 
-    cur_state.draw.draw_framebuffer = old_fb;
-    // TODO: Return scissor test to previous value when scissor test is implemented
-    cur_state.Apply();
-
-    dst_surface->dirty = true;
-    res_cache.FlushRegion(dst_surface->addr, dst_surface->size, dst_surface, true);
     return true;
 }
 
@@ -240,8 +240,9 @@ public:
     void FlushAll() override;
     void FlushRegion(PAddr addr, u32 size) override;
     void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+    void FinishPendingWrites(PAddr addr, u32 size) override;
     bool AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) override;
-    bool AccelerateFill(const GPU::Regs::MemoryFillConfig& config) override;
+    bool AccelerateFill(const GPU::Regs::MemoryFillConfig& config, std::vector<std::pair<PAddr, PAddr>>& cpu_fill_regions) override;
     bool AccelerateDisplay(const GPU::Regs::FramebufferConfig& config, PAddr framebuffer_addr, u32 pixel_stride, ScreenInfo& screen_info) override;
 
     /// OpenGL shader generated for a given Pica register state
@@ -346,6 +347,9 @@ private:
     static_assert(sizeof(UniformData) == 0x3C0, "The size of the UniformData structure has changed, update the structure in the shader");
     static_assert(sizeof(UniformData) < 16384, "UniformData structure must be less than 16kb as per the OpenGL spec");
 
+    /// Clears a surface to the value of a memory fill, returns false if its format can't be cleared to it
+    bool ClearSurface(CachedSurface* dst_surface, const GPU::Regs::MemoryFillConfig& config, OpenGLState& cur_state);
+
     /// Sets the OpenGL shader in accordance with the current PICA register state
     void SetShader();
 
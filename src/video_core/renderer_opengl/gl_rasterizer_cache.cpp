@@ -10,8 +10,10 @@
 #include <utility>
 #include <vector>
 
+#include <boost/icl/interval_set.hpp>
 #include <glad/glad.h>
 
+#include "common/alignment.h"
 #include "common/bit_field.h"
 #include "common/emu_window.h"
 #include "common/logging/log.h"
@@ -25,6 +27,7 @@
 #include "video_core/pica_state.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
 #include "video_core/video_core.h"
 
@@ -86,6 +89,19 @@ static void MortonCopyPixels(CachedSurface::PixelFormat pixel_format, u32 width,
                 memcpy(data_ptrs[0], &depth_stencil, sizeof(u32));
             }
         }
+    } else if (bytes_per_pixel == gl_bytes_per_pixel && width % 8 == 0 && height % 8 == 0) {
+        // Copy whole tiles, OpenGL rows being stored bottom to top
+        const int gl_stride = -static_cast<int>(width * bytes_per_pixel);
+        for (unsigned y = 0; y < height; y += 8) {
+            for (unsigned x = 0; x < width; x += 8) {
+                u8* tile = morton_data + (x * 8 + y * width) * bytes_per_pixel;
+                u8* gl_tile = gl_data + (x + (height - 1 - y) * width) * bytes_per_pixel;
+                if (morton_to_gl)
+                    VideoCore::MortonUnswizzleTile(bytes_per_pixel, tile, gl_tile, gl_stride);
+                else
+                    VideoCore::MortonSwizzleTile(bytes_per_pixel, gl_tile, gl_stride, tile);
+            }
+        }
     } else {
         for (unsigned y = 0; y < height; ++y) {
             for (unsigned x = 0; x < width; ++x) {
@@ -231,28 +247,19 @@ CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bo
     CachedSurface* best_exact_surface = nullptr;
     float exact_surface_goodness = -1.f;
 
-    auto surface_interval = boost::icl::interval<PAddr>::right_open(params.addr, params.addr + params_size);
-    auto range = surface_cache.equal_range(surface_interval);
+    auto range = exact_surfaces.equal_range(std::make_tuple(params.addr, params.width, params.height, params.pixel_format));
     for (auto it = range.first; it != range.second; ++it) {
-        for (auto it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
-            CachedSurface* surface = it2->get();
-
-            // Check if the request matches the surface exactly
-            if (params.addr == surface->addr &&
-                params.width == surface->width && params.height == surface->height &&
-                params.pixel_format == surface->pixel_format)
-            {
-                // Make sure optional param-matching criteria are fulfilled
-                bool tiling_match = (params.is_tiled == surface->is_tiled);
-                bool res_scale_match = (params.res_scale_width == surface->res_scale_width && params.res_scale_height == surface->res_scale_height);
-                if (!match_res_scale || res_scale_match) {
-                    // Prioritize same-tiling and highest resolution surfaces
-                    float match_goodness = (float)tiling_match + surface->res_scale_width * surface->res_scale_height;
-                    if (match_goodness > exact_surface_goodness || surface->dirty) {
-                        exact_surface_goodness = match_goodness;
-                        best_exact_surface = surface;
-                    }
-                }
+        CachedSurface* surface = it->second;
+
+        // Make sure optional param-matching criteria are fulfilled
+        bool tiling_match = (params.is_tiled == surface->is_tiled);
+        bool res_scale_match = (params.res_scale_width == surface->res_scale_width && params.res_scale_height == surface->res_scale_height);
+        if (!match_res_scale || res_scale_match) {
+            // Prioritize same-tiling and highest resolution surfaces
+            float match_goodness = (float)tiling_match + surface->res_scale_width * surface->res_scale_height;
+            if (match_goodness > exact_surface_goodness || surface->dirty) {
+                exact_surface_goodness = match_goodness;
+                best_exact_surface = surface;
             }
         }
     }
@@ -269,13 +276,13 @@ CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bo
     }
 
     MICROPROFILE_SCOPE(OpenGL_SurfaceUpload);
+    MICROPROFILE_META_CPU("Surfaces created", 1);
 
     std::shared_ptr<CachedSurface> new_surface = std::make_shared<CachedSurface>();
 
     new_surface->addr = params.addr;
     new_surface->size = params_size;
 
-    new_surface->texture.Create();
     new_surface->width = params.width;
     new_surface->height = params.height;
     new_surface->stride = params.stride;
@@ -288,12 +295,15 @@ CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bo
 
     if (!load_if_create) {
         // Don't load any data; just allocate the surface's texture
-        AllocateSurfaceTexture(new_surface->texture.handle, new_surface->pixel_format, new_surface->GetScaledWidth(), new_surface->GetScaledHeight());
+        AllocateTexture(new_surface->texture, new_surface->pixel_format, new_surface->GetScaledWidth(), new_surface->GetScaledHeight());
     } else {
         // TODO: Consider attempting subrect match in existing surfaces and direct blit here instead of memory upload below if that's a common scenario in some game
 
         Memory::RasterizerFlushRegion(params.addr, params_size);
 
+        // The data is uploaded at 1x, into storage that may come from the texture pool
+        AllocateTexture(new_surface->texture, new_surface->pixel_format, new_surface->width, new_surface->height);
+
         // Load data from memory to the new surface
         OpenGLState cur_state = OpenGLState::GetCurState();
 
@@ -308,8 +318,8 @@ CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bo
             ASSERT((size_t)new_surface->pixel_format < fb_format_tuples.size());
             const FormatTuple& tuple = fb_format_tuples[(unsigned int)params.pixel_format];
 
-            glTexImage2D(GL_TEXTURE_2D, 0, tuple.internal_format, params.width, params.height, 0,
-                         tuple.format, tuple.type, texture_src_data);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, params.width, params.height,
+                            tuple.format, tuple.type, texture_src_data);
         } else {
             SurfaceType type = CachedSurface::GetFormatType(new_surface->pixel_format);
             if (type != SurfaceType::Depth && type != SurfaceType::DepthStencil) {
@@ -330,13 +340,11 @@ CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bo
                 tex_info.format = (Pica::Regs::TextureFormat)params.pixel_format;
                 tex_info.physical_address = params.addr;
 
-                for (unsigned y = 0; y < params.height; ++y) {
-                    for (unsigned x = 0; x < params.width; ++x) {
-                        tex_buffer[x + params.width * y] = Pica::DebugUtils::LookupTexture(texture_src_data, x, params.height - 1 - y, tex_info);
-                    }
-                }
+                // OpenGL expects the rows bottom to top, so they're decoded starting from the last one
+                Pica::Texture::DecodeTexture(tex_info, texture_src_data, tex_buffer.data() + params.width * (params.height - 1),
+                                             -static_cast<int>(params.width));
 
-                glTexImage2D(GL_TEXTURE_2D, 0, tuple.internal_format, params.width, params.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, tex_buffer.data());
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, params.width, params.height, GL_RGBA, GL_UNSIGNED_BYTE, tex_buffer.data());
             } else {
                 // Depth/Stencil formats need special treatment since they aren't sampleable using LookupTexture and can't use RGBA format
                 size_t tuple_idx = (size_t)params.pixel_format - 14;
@@ -356,8 +364,8 @@ CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bo
 
                 MortonCopyPixels(params.pixel_format, params.width, params.height, bytes_per_pixel, gl_bytes_per_pixel, texture_src_data, temp_fb_depth_buffer_ptr, true);
 
-                glTexImage2D(GL_TEXTURE_2D, 0, tuple.internal_format, params.width, params.height, 0,
-                             tuple.format, tuple.type, temp_fb_depth_buffer.data());
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, params.width, params.height,
+                                tuple.format, tuple.type, temp_fb_depth_buffer.data());
             }
         }
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
@@ -365,16 +373,13 @@ CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bo
         // If not 1x scale, blit 1x texture to a new scaled texture and replace texture in surface
         if (new_surface->res_scale_width != 1.f || new_surface->res_scale_height != 1.f) {
             OGLTexture scaled_texture;
-            scaled_texture.Create();
-
-            AllocateSurfaceTexture(scaled_texture.handle, new_surface->pixel_format, new_surface->GetScaledWidth(), new_surface->GetScaledHeight());
+            AllocateTexture(scaled_texture, new_surface->pixel_format, new_surface->GetScaledWidth(), new_surface->GetScaledHeight());
             BlitTextures(new_surface->texture.handle, scaled_texture.handle, CachedSurface::GetFormatType(new_surface->pixel_format),
                 MathUtil::Rectangle<int>(0, 0, new_surface->width, new_surface->height),
                 MathUtil::Rectangle<int>(0, 0, new_surface->GetScaledWidth(), new_surface->GetScaledHeight()));
 
-            new_surface->texture.Release();
-            new_surface->texture.handle = scaled_texture.handle;
-            scaled_texture.handle = 0;
+            RecycleTexture(new_surface->texture, new_surface->pixel_format, new_surface->width, new_surface->height);
+            new_surface->texture = std::move(scaled_texture);
             cur_state.texture_units[0].texture_2d = new_surface->texture.handle;
             cur_state.Apply();
         }
@@ -389,7 +394,7 @@ CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bo
     }
 
     Memory::RasterizerMarkRegionCached(new_surface->addr, new_surface->size, 1);
-    surface_cache.add(std::make_pair(boost::icl::interval<PAddr>::right_open(new_surface->addr, new_surface->addr + new_surface->size), std::set<std::shared_ptr<CachedSurface>>({ new_surface })));
+    RegisterSurface(new_surface);
     return new_surface.get();
 }
 
@@ -563,64 +568,86 @@ std::tuple<CachedSurface*, CachedSurface*, MathUtil::Rectangle<int>> RasterizerC
     return std::make_tuple(color_surface, depth_surface, rect);
 }
 
-CachedSurface* RasterizerCacheOpenGL::TryGetFillSurface(const GPU::Regs::MemoryFillConfig& config) {
-    auto surface_interval = boost::icl::interval<PAddr>::right_open(config.GetStartAddress(), config.GetEndAddress());
+std::vector<CachedSurface*> RasterizerCacheOpenGL::GetFillSurfaces(const GPU::Regs::MemoryFillConfig& config) {
+    int bits_per_value = 0;
+    if (config.fill_24bit) {
+        bits_per_value = 24;
+    } else if (config.fill_32bit) {
+        bits_per_value = 32;
+    } else {
+        bits_per_value = 16;
+    }
+
+    const PAddr fill_start = config.GetStartAddress();
+    const PAddr fill_end = config.GetEndAddress();
+
+    std::unordered_set<CachedSurface*> fill_surfaces;
+    auto surface_interval = boost::icl::interval<PAddr>::right_open(fill_start, fill_end);
     auto range = surface_cache.equal_range(surface_interval);
     for (auto it = range.first; it != range.second; ++it) {
         for (auto it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
-            int bits_per_value = 0;
-            if (config.fill_24bit) {
-                bits_per_value = 24;
-            } else if (config.fill_32bit) {
-                bits_per_value = 32;
-            } else {
-                bits_per_value = 16;
-            }
-
             CachedSurface* surface = it2->get();
 
-            if (surface->addr == config.GetStartAddress() &&
+            // Each pixel must hold one whole fill value
+            if (surface->addr >= fill_start && surface->addr + surface->size <= fill_end &&
                 CachedSurface::GetFormatBpp(surface->pixel_format) == bits_per_value &&
-                (surface->width * surface->height * CachedSurface::GetFormatBpp(surface->pixel_format) / 8) == (config.GetEndAddress() - config.GetStartAddress()))
+                (surface->addr - fill_start) % (bits_per_value / 8) == 0)
             {
-                return surface;
+                fill_surfaces.insert(surface);
             }
         }
     }
 
-    return nullptr;
+    return std::vector<CachedSurface*>(fill_surfaces.begin(), fill_surfaces.end());
 }
 
 MICROPROFILE_DEFINE(OpenGL_SurfaceDownload, "OpenGL", "Surface Download", MP_RGB(128, 192, 64));
 void RasterizerCacheOpenGL::FlushSurface(CachedSurface* surface) {
-    using PixelFormat = CachedSurface::PixelFormat;
-    using SurfaceType = CachedSurface::SurfaceType;
-
     if (!surface->dirty) {
         return;
     }
 
-    MICROPROFILE_SCOPE(OpenGL_SurfaceDownload);
+    // Pending readbacks of older surfaces must not land on top of this one later
+    FinishDownloads(surface->addr, surface->size);
 
-    u8* dst_buffer = Memory::GetPhysicalPointer(surface->addr);
-    if (dst_buffer == nullptr) {
-        return;
-    }
+    PendingDownload download = BeginDownload(*surface);
+    FinishDownload(download);
+    surface->dirty = false;
+}
+
+RasterizerCacheOpenGL::PendingDownload RasterizerCacheOpenGL::BeginDownload(const CachedSurface& surface) {
+    using PixelFormat = CachedSurface::PixelFormat;
+    using SurfaceType = CachedSurface::SurfaceType;
+
+    MICROPROFILE_META_CPU("Surfaces flushed", 1);
+
+    PendingDownload download;
+    download.addr = surface.addr;
+    download.size = surface.size;
+    download.width = surface.width;
+    download.height = surface.height;
+    download.is_tiled = surface.is_tiled;
+    download.pixel_format = surface.pixel_format;
+
+    // OpenGL needs 4 bpp alignment for D24 since using GL_UNSIGNED_INT as type
+    u32 bytes_per_pixel = CachedSurface::GetFormatBpp(surface.pixel_format) / 8;
+    download.gl_bytes_per_pixel = (surface.pixel_format == PixelFormat::D24) ? 4 : bytes_per_pixel;
+
+    u32 row_length = surface.stride != 0 ? surface.stride : surface.width;
+    download.row_pitch = Common::AlignUp(row_length * download.gl_bytes_per_pixel, 4);
 
     OpenGLState cur_state = OpenGLState::GetCurState();
     GLuint old_tex = cur_state.texture_units[0].texture_2d;
 
     OGLTexture unscaled_tex;
-    GLuint texture_to_flush = surface->texture.handle;
+    GLuint texture_to_flush = surface.texture.handle;
 
     // If not 1x scale, blit scaled texture to a new 1x texture and use that to flush
-    if (surface->res_scale_width != 1.f || surface->res_scale_height != 1.f) {
-        unscaled_tex.Create();
-
-        AllocateSurfaceTexture(unscaled_tex.handle, surface->pixel_format, surface->width, surface->height);
-        BlitTextures(surface->texture.handle, unscaled_tex.handle, CachedSurface::GetFormatType(surface->pixel_format),
-            MathUtil::Rectangle<int>(0, 0, surface->GetScaledWidth(), surface->GetScaledHeight()),
-            MathUtil::Rectangle<int>(0, 0, surface->width, surface->height));
+    if (surface.res_scale_width != 1.f || surface.res_scale_height != 1.f) {
+        AllocateTexture(unscaled_tex, surface.pixel_format, surface.width, surface.height);
+        BlitTextures(surface.texture.handle, unscaled_tex.handle, CachedSurface::GetFormatType(surface.pixel_format),
+            MathUtil::Rectangle<int>(0, 0, surface.GetScaledWidth(), surface.GetScaledHeight()),
+            MathUtil::Rectangle<int>(0, 0, surface.width, surface.height));
 
         texture_to_flush = unscaled_tex.handle;
     }
@@ -629,58 +656,118 @@ void RasterizerCacheOpenGL::FlushSurface(CachedSurface* surface) {
     cur_state.Apply();
     glActiveTexture(GL_TEXTURE0);
 
-    glPixelStorei(GL_PACK_ROW_LENGTH, (GLint)surface->stride);
-    if (!surface->is_tiled) {
-        // TODO: Ensure this will always be a color format, not a depth or other format
-        ASSERT((size_t)surface->pixel_format < fb_format_tuples.size());
-        const FormatTuple& tuple = fb_format_tuples[(unsigned int)surface->pixel_format];
+    download.buffer.Create();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, download.buffer.handle);
+    glBufferData(GL_PIXEL_PACK_BUFFER, download.row_pitch * surface.height, nullptr, GL_STREAM_READ);
 
-        glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, dst_buffer);
+    FormatTuple tuple;
+    SurfaceType type = CachedSurface::GetFormatType(surface.pixel_format);
+    if (type != SurfaceType::Depth && type != SurfaceType::DepthStencil) {
+        // TODO: Ensure linear surfaces will always be a color format, not a depth or other format
+        ASSERT((size_t)surface.pixel_format < fb_format_tuples.size());
+        tuple = fb_format_tuples[(unsigned int)surface.pixel_format];
     } else {
-        SurfaceType type = CachedSurface::GetFormatType(surface->pixel_format);
-        if (type != SurfaceType::Depth && type != SurfaceType::DepthStencil) {
-            ASSERT((size_t)surface->pixel_format < fb_format_tuples.size());
-            const FormatTuple& tuple = fb_format_tuples[(unsigned int)surface->pixel_format];
+        // Depth/Stencil formats need special treatment since they aren't sampleable using LookupTexture and can't use RGBA format
+        size_t tuple_idx = (size_t)surface.pixel_format - 14;
+        ASSERT(tuple_idx < depth_format_tuples.size());
+        tuple = depth_format_tuples[tuple_idx];
+    }
 
-            u32 bytes_per_pixel = CachedSurface::GetFormatBpp(surface->pixel_format) / 8;
+    // Internal OpenGL color formats are consistent with the 3DS ones, so the pixels are copied as they are
+    glPixelStorei(GL_PACK_ROW_LENGTH, (GLint)surface.stride);
+    glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, nullptr);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
 
-            std::vector<u8> temp_gl_buffer(surface->width * surface->height * bytes_per_pixel);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    download.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
-            glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, temp_gl_buffer.data());
+    cur_state.texture_units[0].texture_2d = old_tex;
+    cur_state.Apply();
 
-            // Directly copy pixels. Internal OpenGL color formats are consistent so no conversion is necessary.
-            MortonCopyPixels(surface->pixel_format, surface->width, surface->height, bytes_per_pixel, bytes_per_pixel, dst_buffer, temp_gl_buffer.data(), false);
-        } else {
-            // Depth/Stencil formats need special treatment since they aren't sampleable using LookupTexture and can't use RGBA format
-            size_t tuple_idx = (size_t)surface->pixel_format - 14;
-            ASSERT(tuple_idx < depth_format_tuples.size());
-            const FormatTuple& tuple = depth_format_tuples[tuple_idx];
+    // The readback was queued before anything that can reuse the texture
+    RecycleTexture(unscaled_tex, surface.pixel_format, surface.width, surface.height);
 
-            u32 bytes_per_pixel = CachedSurface::GetFormatBpp(surface->pixel_format) / 8;
+    return download;
+}
 
-            // OpenGL needs 4 bpp alignment for D24 since using GL_UNSIGNED_INT as type
-            bool use_4bpp = (surface->pixel_format == PixelFormat::D24);
+void RasterizerCacheOpenGL::FinishDownload(PendingDownload& download) {
+    MICROPROFILE_SCOPE(OpenGL_SurfaceDownload);
 
-            u32 gl_bytes_per_pixel = use_4bpp ? 4 : bytes_per_pixel;
+    // Mapping the buffer waits for the readback, the fence is only used to poll it
+    glDeleteSync(download.fence);
+    download.fence = nullptr;
 
-            std::vector<u8> temp_gl_buffer(surface->width * surface->height * gl_bytes_per_pixel);
+    getting_download_pointer = true;
+    u8* dst_buffer = Memory::GetPhysicalPointer(download.addr);
+    getting_download_pointer = false;
+    if (dst_buffer == nullptr) {
+        return;
+    }
 
-            glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, temp_gl_buffer.data());
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, download.buffer.handle);
+    u8* gl_data = static_cast<u8*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, download.row_pitch * download.height, GL_MAP_READ_BIT));
 
-            u8* temp_gl_buffer_ptr = use_4bpp ? temp_gl_buffer.data() + 1 : temp_gl_buffer.data();
+    if (gl_data != nullptr) {
+        u32 bytes_per_pixel = CachedSurface::GetFormatBpp(download.pixel_format) / 8;
+        if (!download.is_tiled) {
+            // Only the pixels are written, keeping the memory between rows
+            for (u32 y = 0; y < download.height; ++y) {
+                std::memcpy(dst_buffer + y * download.row_pitch, gl_data + y * download.row_pitch,
+                            download.width * bytes_per_pixel);
+            }
+        } else {
+            u8* gl_pixels = (download.pixel_format == CachedSurface::PixelFormat::D24) ? gl_data + 1 : gl_data;
+            MortonCopyPixels(download.pixel_format, download.width, download.height, bytes_per_pixel, download.gl_bytes_per_pixel,
+                             dst_buffer, gl_pixels, false);
+        }
+        Memory::MarkRegionDirty(Memory::PhysicalToVirtualAddress(download.addr), download.row_pitch * download.height);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void RasterizerCacheOpenGL::RetireDownload(std::list<PendingDownload>::iterator it) {
+    FinishDownload(*it);
+    Memory::RasterizerMarkRegionCached(it->addr, it->size, -1);
+    pending_downloads.erase(it);
+}
+
+void RasterizerCacheOpenGL::FinishDownloads(PAddr addr, u32 size) {
+    if (pending_downloads.empty() || getting_download_pointer) {
+        return;
+    }
 
-            MortonCopyPixels(surface->pixel_format, surface->width, surface->height, bytes_per_pixel, gl_bytes_per_pixel, dst_buffer, temp_gl_buffer_ptr, false);
+    // Going from the newest readback to the oldest, an older readback overlapping one that is
+    // retired has to be retired before it, or it would later overwrite the newer data
+    boost::icl::interval_set<PAddr> retired_memory(boost::icl::interval<PAddr>::right_open(addr, addr + size));
+    std::vector<std::list<PendingDownload>::iterator> to_retire;
+    for (auto it = pending_downloads.end(); it != pending_downloads.begin();) {
+        --it;
+        auto download_interval = boost::icl::interval<PAddr>::right_open(it->addr, it->addr + it->size);
+        if (boost::icl::intersects(retired_memory, download_interval)) {
+            retired_memory += download_interval;
+            to_retire.push_back(it);
         }
     }
-    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
 
-    surface->dirty = false;
+    for (auto it = to_retire.rbegin(); it != to_retire.rend(); ++it) {
+        RetireDownload(*it);
+    }
+}
 
-    cur_state.texture_units[0].texture_2d = old_tex;
-    cur_state.Apply();
+void RasterizerCacheOpenGL::FinishCompletedDownloads() {
+    while (!pending_downloads.empty()) {
+        GLenum status = glClientWaitSync(pending_downloads.front().fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        RetireDownload(pending_downloads.begin());
+    }
 }
 
-void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, const CachedSurface* skip_surface, bool invalidate) {
+template <typename SkipFunc>
+void RasterizerCacheOpenGL::FlushRegionExcept(PAddr addr, u32 size, SkipFunc skip, bool invalidate, bool defer_downloads) {
     if (size == 0) {
         return;
     }
@@ -692,23 +779,117 @@ void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, const CachedSurfac
     auto cache_upper_bound = surface_cache.upper_bound(surface_interval);
     for (auto it = surface_cache.lower_bound(surface_interval); it != cache_upper_bound; ++it) {
         std::copy_if(it->second.begin(), it->second.end(), std::inserter(touching_surfaces, touching_surfaces.end()),
-            [skip_surface](std::shared_ptr<CachedSurface> surface) { return (surface.get() != skip_surface); });
+            [&skip](std::shared_ptr<CachedSurface> surface) { return !skip(surface.get()); });
+    }
+
+    // Memory about to be written by the surfaces has to be up to date first. Deferred readbacks
+    // are queued after the pending ones they overlap instead, which keeps them in order.
+    if (!defer_downloads) {
+        FinishDownloads(addr, size);
+        for (auto& surface : touching_surfaces) {
+            if (surface->dirty) {
+                FinishDownloads(surface->addr, surface->size);
+            }
+        }
+    }
+
+    // Start all readbacks before waiting for any of them
+    std::vector<PendingDownload> downloads;
+    for (auto& surface : touching_surfaces) {
+        if (surface->dirty) {
+            downloads.push_back(BeginDownload(*surface));
+            surface->dirty = false;
+        }
+    }
+
+    for (auto& download : downloads) {
+        if (defer_downloads) {
+            Memory::RasterizerMarkRegionCached(download.addr, download.size, 1);
+            pending_downloads.push_back(std::move(download));
+        } else {
+            FinishDownload(download);
+        }
+    }
+
+    while (pending_downloads.size() > MAX_PENDING_DOWNLOADS) {
+        RetireDownload(pending_downloads.begin());
     }
 
-    // Flush and invalidate surfaces
-    for (auto surface : touching_surfaces) {
-        FlushSurface(surface.get());
-        if (invalidate) {
+    // Invalidate surfaces
+    if (invalidate) {
+        for (auto& surface : touching_surfaces) {
             Memory::RasterizerMarkRegionCached(surface->addr, surface->size, -1);
-            surface_cache.subtract(std::make_pair(boost::icl::interval<PAddr>::right_open(surface->addr, surface->addr + surface->size), std::set<std::shared_ptr<CachedSurface>>({ surface })));
+            UnregisterSurface(surface);
         }
     }
 }
 
+void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, const CachedSurface* skip_surface, bool invalidate) {
+    FlushRegionExcept(addr, size, [skip_surface](const CachedSurface* surface) { return surface == skip_surface; }, invalidate);
+}
+
+void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, const std::set<const CachedSurface*>& skip_surfaces, bool invalidate) {
+    FlushRegionExcept(addr, size, [&skip_surfaces](const CachedSurface* surface) { return skip_surfaces.count(surface) != 0; }, invalidate);
+}
+
+void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const CachedSurface* skip_surface) {
+    FinishCompletedDownloads();
+    FlushRegionExcept(addr, size, [skip_surface](const CachedSurface* surface) { return surface == skip_surface; }, true, true);
+}
+
 void RasterizerCacheOpenGL::FlushAll() {
+    while (!pending_downloads.empty()) {
+        RetireDownload(pending_downloads.begin());
+    }
+
     for (auto& surfaces : surface_cache) {
         for (auto& surface : surfaces.second) {
             FlushSurface(surface.get());
         }
     }
 }
+
+void RasterizerCacheOpenGL::RegisterSurface(const std::shared_ptr<CachedSurface>& surface) {
+    surface_cache.add(std::make_pair(boost::icl::interval<PAddr>::right_open(surface->addr, surface->addr + surface->size), std::set<std::shared_ptr<CachedSurface>>({ surface })));
+    exact_surfaces.emplace(std::make_tuple(surface->addr, surface->width, surface->height, surface->pixel_format), surface.get());
+}
+
+void RasterizerCacheOpenGL::UnregisterSurface(const std::shared_ptr<CachedSurface>& surface) {
+    surface_cache.subtract(std::make_pair(boost::icl::interval<PAddr>::right_open(surface->addr, surface->addr + surface->size), std::set<std::shared_ptr<CachedSurface>>({ surface })));
+
+    auto range = exact_surfaces.equal_range(std::make_tuple(surface->addr, surface->width, surface->height, surface->pixel_format));
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == surface.get()) {
+            exact_surfaces.erase(it);
+            break;
+        }
+    }
+
+    RecycleTexture(surface->texture, surface->pixel_format, surface->GetScaledWidth(), surface->GetScaledHeight());
+}
+
+void RasterizerCacheOpenGL::AllocateTexture(OGLTexture& texture, CachedSurface::PixelFormat pixel_format, u32 width, u32 height) {
+    auto it = texture_pool.find(std::make_tuple(pixel_format, width, height));
+    if (it != texture_pool.end()) {
+        MICROPROFILE_META_CPU("Surface textures reused", 1);
+        texture = std::move(it->second);
+        texture_pool.erase(it);
+        return;
+    }
+
+    texture.Create();
+    AllocateSurfaceTexture(texture.handle, pixel_format, width, height);
+}
+
+void RasterizerCacheOpenGL::RecycleTexture(OGLTexture& texture, CachedSurface::PixelFormat pixel_format, u32 width, u32 height) {
+    if (texture.handle == 0) {
+        return;
+    }
+
+    // Make room by deleting the first texture in key order
+    if (texture_pool.size() >= MAX_POOLED_TEXTURES) {
+        texture_pool.erase(texture_pool.begin());
+    }
+
+    texture_pool.emplace(std::make_tuple(pixel_format, width, height), std::move(texture));
+}
@@ -5,9 +5,12 @@
 #pragma once
 
 #include <array>
+#include <list>
+#include <map>
 #include <memory>
 #include <set>
 #include <tuple>
+#include <vector>
 
 #include <boost/icl/interval_map.hpp>
 #include <glad/glad.h>
@@ -204,8 +207,8 @@ public:
     /// Gets the color and depth surfaces and rect (resolution scaled) based on the framebuffer configuration
     std::tuple<CachedSurface*, CachedSurface*, MathUtil::Rectangle<int>> GetFramebufferSurfaces(const Pica::Regs::FramebufferConfig& config);
 
-    /// Attempt to get a surface that exactly matches the fill region and format
-    CachedSurface* TryGetFillSurface(const GPU::Regs::MemoryFillConfig& config);
+    /// Gets the surfaces lying within the fill region whose pixels line up with the fill values
+    std::vector<CachedSurface*> GetFillSurfaces(const GPU::Regs::MemoryFillConfig& config);
 
     /// Write the surface back to memory
     void FlushSurface(CachedSurface* surface);
@@ -213,10 +216,93 @@ public:
     /// Write any cached resources overlapping the region back to memory (if dirty) and optionally invalidate them in the cache
     void FlushRegion(PAddr addr, u32 size, const CachedSurface* skip_surface, bool invalidate);
 
+    /// Same as above, skipping a set of surfaces
+    void FlushRegion(PAddr addr, u32 size, const std::set<const CachedSurface*>& skip_surfaces, bool invalidate);
+
+    /**
+     * Invalidates the cached resources overlapping the region, for when the GPU overwrites it. Dirty
+     * surfaces are read back asynchronously, their memory is only written once it is accessed.
+     */
+    void InvalidateRegion(PAddr addr, u32 size, const CachedSurface* skip_surface);
+
+    /**
+     * Retires the pending readbacks overlapping the region, along with the older ones they overlap.
+     * Called before the region is written or accessed without going through the cache.
+     */
+    void FinishDownloads(PAddr addr, u32 size);
+
     /// Flush all cached resources tracked by this cache manager
     void FlushAll();
 
 private:
+    /// Address, width, height and pixel format of a surface
+    using SurfaceKey = std::tuple<PAddr, u32, u32, CachedSurface::PixelFormat>;
+    /// Pixel format, width and height of an allocated texture
+    using TextureKey = std::tuple<CachedSurface::PixelFormat, u32, u32>;
+
+    /// Readback of a surface into a pixel buffer, waiting to be written to memory
+    struct PendingDownload {
+        PAddr addr;
+        u32 size;
+        u32 width;
+        u32 height;
+        bool is_tiled;
+        CachedSurface::PixelFormat pixel_format;
+
+        /// Distance between the rows of the buffer, as laid out by glGetTexImage
+        u32 row_pitch;
+        u32 gl_bytes_per_pixel;
+
+        OGLBuffer buffer;
+        GLsync fence;
+    };
+
+    /// Maximum number of textures kept in the pool for reuse
+    static constexpr size_t MAX_POOLED_TEXTURES = 64;
+
+    /// Maximum number of readbacks left pending before the oldest one is completed
+    static constexpr size_t MAX_PENDING_DOWNLOADS = 16;
+
+    /// Flushes the surfaces touching the region for which skip returns false
+    template <typename SkipFunc>
+    void FlushRegionExcept(PAddr addr, u32 size, SkipFunc skip, bool invalidate, bool defer_downloads = false);
+
+    /// Starts reading a dirty surface back into a pixel buffer, without waiting for the GPU
+    PendingDownload BeginDownload(const CachedSurface& surface);
+
+    /// Writes a readback to memory, waiting for the GPU to finish it
+    void FinishDownload(PendingDownload& download);
+
+    /// Finishes a pending readback and removes it, unmarking its memory as cached
+    void RetireDownload(std::list<PendingDownload>::iterator it);
+
+    /// Retires the oldest pending readbacks for as long as the GPU has already finished them
+    void FinishCompletedDownloads();
+
+    /// Adds a surface to the cache
+    void RegisterSurface(const std::shared_ptr<CachedSurface>& surface);
+
+    /// Removes a surface from the cache, returning its texture to the pool
+    void UnregisterSurface(const std::shared_ptr<CachedSurface>& surface);
+
+    /// Gives an empty texture object uninitialized storage, taking a texture from the pool if one matches
+    void AllocateTexture(OGLTexture& texture, CachedSurface::PixelFormat pixel_format, u32 width, u32 height);
+
+    /// Moves a texture with storage allocated by AllocateTexture to the pool
+    void RecycleTexture(OGLTexture& texture, CachedSurface::PixelFormat pixel_format, u32 width, u32 height);
+
+    /// Surfaces by the memory they cover, for overlap queries
     SurfaceCache surface_cache;
+    /// Surfaces by their exact parameters, for the exact match of GetSurface
+    std::multimap<SurfaceKey, CachedSurface*> exact_surfaces;
+    /// Textures of removed surfaces, reused by new surfaces instead of allocating storage again
+    std::multimap<TextureKey, OGLTexture> texture_pool;
+    /// Readbacks of invalidated surfaces, from oldest to newest. Their memory stays marked as cached
+    /// so that accessing it finishes them first.
+    std::list<PendingDownload> pending_downloads;
+    /// Set while FinishDownload gets the pointer to the memory of a readback, which is still marked as
+    /// cached and would otherwise retire the readbacks overlapping it, including this one
+    bool getting_download_pointer = false;
+
     OGLFramebuffer transfer_framebuffers[2];
 };
@@ -2,18 +2,37 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
 #include <atomic>
+#include <cinttypes>
 #include <cmath>
+#include <condition_variable>
+#include <cstdio>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include <boost/range/algorithm/fill.hpp>
 
+#ifdef ARCHITECTURE_x86_64
+#include <xmmintrin.h>
+#endif // ARCHITECTURE_x86_64
+
 #include "common/bit_field.h"
+#include "common/file_util.h"
 #include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/string_util.h"
+#include "common/swap.h"
+#include "common/thread.h"
+
+#include "core/hle/kernel/process.h"
 
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
@@ -21,6 +40,7 @@
 #include "video_core/shader/shader_interpreter.h"
 
 #ifdef ARCHITECTURE_x86_64
+#include "video_core/shader/shader_jit_batch_x64.h"
 #include "video_core/shader/shader_jit_x64.h"
 #endif // ARCHITECTURE_x86_64
 
@@ -30,7 +50,7 @@ namespace Pica {
 
 namespace Shader {
 
-OutputVertex OutputRegisters::ToVertex(const Regs::ShaderConfig& config) {
+OutputVertex OutputRegisters::ToVertex(const Regs::ShaderConfig& config) const {
     // Setup output data
     OutputVertex ret;
     // TODO(neobrain): Under some circumstances, up to 16 attributes may be output. We need to
@@ -82,32 +102,294 @@ OutputVertex OutputRegisters::ToVertex(const Regs::ShaderConfig& config) {
     return ret;
 }
 
+void GSEmitter::Emit(const OutputRegisters& output) {
+    ASSERT(vertex_id < 3);
+    buffer[vertex_id] = output.ToVertex(g_state.regs.gs);
+
+    if (prim_emit) {
+        if (winding) {
+            triangles->insert(triangles->end(), { buffer[0], buffer[2], buffer[1] });
+        } else {
+            triangles->insert(triangles->end(), buffer.begin(), buffer.end());
+        }
+    }
+}
+
+/// Returns the configuration registers of the shader unit a setup belongs to
+static const Regs::ShaderConfig& GetConfig(const ShaderSetup& setup) {
+    return &setup == &g_state.gs ? g_state.regs.gs : g_state.regs.vs;
+}
+
 #ifdef ARCHITECTURE_x86_64
-static std::unordered_map<u64, std::unique_ptr<JitShader>> shader_map;
-static const JitShader* jit_shader;
+/// Scalar and batched code compiled from a shader program
+struct CompiledShader {
+    JitShader shader;
+    BatchJitShader batch_shader;
+};
+
+/// Program code, swizzle data and used outputs a shader is compiled from
+struct ShaderSource {
+    u64 key;
+    u64 used_outputs;
+    std::array<u32, 1024> program_code;
+    std::array<u32, 1024> swizzle_data;
+};
+
+/// Identifies shader cache files, "CVSC"
+static const u32 SHADER_CACHE_MAGIC = 0x43535643;
+/// Must be incremented whenever the code emitted by the shader JITs changes, invalidates cache files
+static const u32 SHADER_JIT_VERSION = 3;
+
+struct ShaderCacheHeader {
+    u32_le magic;
+    u32_le version;
+};
+
+static std::unordered_map<u64, std::unique_ptr<CompiledShader>> shader_map;
+
+/// Guards shader_map and the compile queue, which are accessed by the compile thread
+static std::mutex shader_map_mutex;
+static std::condition_variable compile_queue_cv;
+static std::deque<ShaderSource> compile_queue;
+/// Shaders which are in the compile queue or being compiled
+static std::unordered_set<u64> pending_shaders;
+static std::thread compile_thread;
+static bool compile_thread_exit = false;
+
+static bool shader_cache_opened = false;
+static FileUtil::IOFile shader_cache_file;
+/// Shaders which are stored in the cache file of the running title
+static std::unordered_set<u64> cached_shaders;
+
+/**
+ * Returns the output register components of a shader which are read by the next pipeline stage with
+ * the current configuration, in the format expected by FindDeadInstructions.
+ */
+static u64 GetUsedOutputs(const ShaderSetup& setup) {
+    const auto& regs = g_state.regs;
+    const auto& config = GetConfig(setup);
+
+    u64 used_outputs = 0;
+    if (&setup == &g_state.vs && regs.use_gs == Regs::UseGS::Yes) {
+        // The geometry shader receives all enabled output registers
+        for (unsigned i = 0; i < 16; ++i) {
+            if (config.output_mask & (1 << i))
+                used_outputs |= u64(0xF) << (4 * i);
+        }
+        return used_outputs;
+    }
+
+    // Otherwise, only the components read by OutputRegisters::ToVertex are used
+    unsigned index = 0;
+    for (unsigned i = 0; i < 7 && index < regs.vs_output_total; ++i) {
+        if ((config.output_mask & (1 << i)) == 0)
+            continue;
+
+        const auto& output_register_map = regs.vs_output_attributes[index++];
+        const u32 semantics[4] = {
+            output_register_map.map_x, output_register_map.map_y,
+            output_register_map.map_z, output_register_map.map_w
+        };
+
+        for (unsigned comp = 0; comp < 4; ++comp) {
+            if (semantics[comp] != Regs::VSOutputAttributes::INVALID)
+                used_outputs |= u64(1) << (4 * i + comp);
+        }
+    }
+    return used_outputs;
+}
+
+/// Shaders are compiled separately for each output configuration, since unused outputs are skipped
+static u64 GetShaderKey(const std::array<u32, 1024>& program_code, const std::array<u32, 1024>& swizzle_data,
+                        u64 used_outputs) {
+    return Common::ComputeHash64(program_code.data(), sizeof(program_code)) ^
+        Common::ComputeHash64(swizzle_data.data(), sizeof(swizzle_data)) ^
+        Common::ComputeHash64(&used_outputs, sizeof(used_outputs));
+}
+
+static std::unique_ptr<CompiledShader> CompileShader(const ShaderSource& source) {
+    auto compiled = std::make_unique<CompiledShader>();
+    compiled->shader.Compile(source.program_code, source.swizzle_data, source.used_outputs);
+    compiled->batch_shader.Compile(source.program_code, source.swizzle_data, source.used_outputs);
+    return compiled;
+}
+
+static void CompileThreadFunc() {
+    Common::SetCurrentThreadName("ShaderCompiler");
+
+    std::unique_lock<std::mutex> lock(shader_map_mutex);
+    while (true) {
+        compile_queue_cv.wait(lock, [] { return compile_thread_exit || !compile_queue.empty(); });
+        if (compile_thread_exit)
+            return;
+
+        ShaderSource source = std::move(compile_queue.front());
+        compile_queue.pop_front();
+
+        lock.unlock();
+        auto compiled = CompileShader(source);
+        lock.lock();
+
+        // The shader may also have been compiled synchronously in the meantime, in which case the
+        // existing code is kept since it might already be in use
+        shader_map.emplace(source.key, std::move(compiled));
+        pending_shaders.erase(source.key);
+    }
+}
+
+/// Queues a shader for compilation on the compile thread, shader_map_mutex must be held
+static void QueueCompile(ShaderSource source) {
+    if (!pending_shaders.insert(source.key).second)
+        return;
+
+    compile_queue.emplace_back(std::move(source));
+    if (!compile_thread.joinable()) {
+        compile_thread_exit = false;
+        compile_thread = std::thread(CompileThreadFunc);
+    }
+    compile_queue_cv.notify_one();
+}
+
+static void StopCompileThread() {
+    if (!compile_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(shader_map_mutex);
+        compile_thread_exit = true;
+        compile_queue.clear();
+        pending_shaders.clear();
+    }
+    compile_queue_cv.notify_one();
+    compile_thread.join();
+}
+
+/**
+ * Opens the shader cache file of the running title and compiles the shaders stored in it, in the
+ * background if asynchronous compilation is enabled. The compiled code itself isn't stored, since
+ * it embeds absolute addresses of emulator functions and data which change between runs.
+ */
+static void OpenShaderCache() {
+    shader_cache_opened = true;
+    if (!VideoCore::g_shader_disk_cache_enabled || Kernel::g_current_process == nullptr)
+        return;
+
+    const std::string dir = FileUtil::GetUserPath(D_SHADERCACHE_IDX);
+    const std::string path = dir + Common::StringFromFormat("%016" PRIX64 ".vsc",
+        Kernel::g_current_process->codeset->program_id);
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(HW_GPU, "Failed to create shader cache directory %s", dir.c_str());
+        return;
+    }
+
+    ShaderCacheHeader header;
+    bool valid = false;
+    if (FileUtil::Exists(path)) {
+        shader_cache_file.Open(path, "r+b");
+        valid = shader_cache_file.ReadBytes(&header, sizeof(header)) == sizeof(header) &&
+            header.magic == SHADER_CACHE_MAGIC && header.version == SHADER_JIT_VERSION;
+    }
+
+    if (!valid) {
+        // Missing, corrupt or written by another version of the JIT: start over
+        shader_cache_file.Open(path, "wb");
+        header.magic = SHADER_CACHE_MAGIC;
+        header.version = SHADER_JIT_VERSION;
+        if (shader_cache_file.WriteBytes(&header, sizeof(header)) != sizeof(header)) {
+            LOG_ERROR(HW_GPU, "Failed to write shader cache %s", path.c_str());
+            shader_cache_file.Close();
+        }
+        return;
+    }
+
+    size_t num_entries = 0;
+    ShaderSource source;
+    while (shader_cache_file.ReadBytes(&source, sizeof(source)) == sizeof(source)) {
+        if (source.key != GetShaderKey(source.program_code, source.swizzle_data, source.used_outputs))
+            break;
+        ++num_entries;
+        if (!cached_shaders.insert(source.key).second)
+            continue;
+
+        if (VideoCore::g_shader_jit_async_enabled) {
+            std::lock_guard<std::mutex> lock(shader_map_mutex);
+            QueueCompile(source);
+        } else {
+            auto compiled = CompileShader(source);
+            std::lock_guard<std::mutex> lock(shader_map_mutex);
+            shader_map.emplace(source.key, std::move(compiled));
+        }
+    }
+    LOG_INFO(HW_GPU, "Loaded %zu shaders from %s", cached_shaders.size(), path.c_str());
+
+    // New shaders are appended after the last valid entry, overwriting any truncated or corrupt data
+    shader_cache_file.Seek(sizeof(header) + num_entries * sizeof(ShaderSource), SEEK_SET);
+}
+
+/// Appends a shader to the cache file of the running title
+static void StoreInShaderCache(const ShaderSource& source) {
+    if (!shader_cache_file.IsOpen() || !cached_shaders.insert(source.key).second)
+        return;
+
+    if (shader_cache_file.WriteBytes(&source, sizeof(source)) != sizeof(source)) {
+        LOG_ERROR(HW_GPU, "Failed to write shader cache, disabling it");
+        shader_cache_file.Close();
+        return;
+    }
+    shader_cache_file.Flush();
+}
 #endif // ARCHITECTURE_x86_64
 
 void ClearCache() {
 #ifdef ARCHITECTURE_x86_64
+    StopCompileThread();
     shader_map.clear();
+    for (ShaderSetup* setup : { &g_state.vs, &g_state.gs }) {
+        setup->jit_shader = nullptr;
+        setup->batch_jit_shader = nullptr;
+    }
+
+    shader_cache_file.Close();
+    shader_cache_opened = false;
+    cached_shaders.clear();
 #endif // ARCHITECTURE_x86_64
 }
 
 void ShaderSetup::Setup() {
 #ifdef ARCHITECTURE_x86_64
     if (VideoCore::g_shader_jit_enabled) {
-        u64 cache_key = (Common::ComputeHash64(&g_state.vs.program_code, sizeof(g_state.vs.program_code)) ^
-            Common::ComputeHash64(&g_state.vs.swizzle_data, sizeof(g_state.vs.swizzle_data)));
+        if (!shader_cache_opened)
+            OpenShaderCache();
 
+        const u64 used_outputs = GetUsedOutputs(*this);
+        u64 cache_key = GetShaderKey(program_code, swizzle_data, used_outputs);
+
+        std::unique_lock<std::mutex> lock(shader_map_mutex);
         auto iter = shader_map.find(cache_key);
         if (iter != shader_map.end()) {
-            jit_shader = iter->second.get();
-        } else {
-            auto shader = std::make_unique<JitShader>();
-            shader->Compile();
-            jit_shader = shader.get();
-            shader_map[cache_key] = std::move(shader);
+            jit_shader = &iter->second->shader;
+            batch_jit_shader = &iter->second->batch_shader;
+            return;
+        }
+
+        ShaderSource source{ cache_key, used_outputs, program_code, swizzle_data };
+        StoreInShaderCache(source);
+
+        if (VideoCore::g_shader_jit_async_enabled) {
+            // Use the interpreter until the compile thread is done with the shader
+            QueueCompile(std::move(source));
+            jit_shader = nullptr;
+            batch_jit_shader = nullptr;
+            return;
         }
+
+        lock.unlock();
+        auto compiled = CompileShader(source);
+        lock.lock();
+
+        iter = shader_map.emplace(cache_key, std::move(compiled)).first;
+        jit_shader = &iter->second->shader;
+        batch_jit_shader = &iter->second->batch_shader;
     }
 #endif // ARCHITECTURE_x86_64
 }
@@ -115,8 +397,8 @@ void ShaderSetup::Setup() {
 MICROPROFILE_DEFINE(GPU_Shader, "GPU", "Shader", MP_RGB(50, 50, 240));
 
 void ShaderSetup::Run(UnitState<false>& state, const InputVertex& input, int num_attributes) {
-    auto& config = g_state.regs.vs;
-    auto& setup = g_state.vs;
+    auto& config = GetConfig(*this);
+    auto& setup = *this;
 
     MICROPROFILE_SCOPE(GPU_Shader);
 
@@ -133,7 +415,7 @@ void ShaderSetup::Run(UnitState<false>& state, const InputVertex& input, int num
     state.conditional_code[1] = false;
 
 #ifdef ARCHITECTURE_x86_64
-    if (VideoCore::g_shader_jit_enabled)
+    if (VideoCore::g_shader_jit_enabled && jit_shader != nullptr)
         jit_shader->Run(setup, state, config.main_offset);
     else
         RunInterpreter(setup, state, config.main_offset);
@@ -143,6 +425,60 @@ void ShaderSetup::Run(UnitState<false>& state, const InputVertex& input, int num
 
 }
 
+void ShaderSetup::RunBatch(UnitState<false>& state, BatchUnitState& batch_state, const InputVertex* inputs,
+                           OutputRegisters* outputs, unsigned count, int num_attributes) {
+    ASSERT(count <= BATCH_SIZE);
+
+#ifdef ARCHITECTURE_x86_64
+    if (VideoCore::g_shader_jit_enabled && batch_jit_shader != nullptr) {
+        auto& config = GetConfig(*this);
+        auto& setup = *this;
+
+        MICROPROFILE_SCOPE(GPU_Shader);
+
+        // Setup input register table. The attributes of the four vertices are transposed so that
+        // each row of a register holds one component of all vertices. Unused lanes repeat the first
+        // vertex so that they don't make the batch diverge.
+        const auto& attribute_register_map = config.input_register_map;
+
+        for (int i = 0; i < num_attributes; i++) {
+            __m128 rows[BATCH_SIZE];
+            for (unsigned vertex = 0; vertex < BATCH_SIZE; ++vertex)
+                rows[vertex] = _mm_load_ps(reinterpret_cast<const float*>(&inputs[vertex < count ? vertex : 0].attr[i]));
+            _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+
+            auto& reg = batch_state.registers.input[attribute_register_map.GetRegisterForAttribute(i)];
+            for (unsigned component = 0; component < 4; ++component)
+                _mm_store_ps(reinterpret_cast<float*>(reg[component]), rows[component]);
+        }
+
+        if (!batch_jit_shader->Run(setup, batch_state, config.main_offset)) {
+            for (unsigned i = 0; i < 16; ++i) {
+                if ((config.output_mask & (1 << i)) == 0)
+                    continue;
+
+                const auto& reg = batch_state.registers.output[i];
+                __m128 rows[4];
+                for (unsigned component = 0; component < 4; ++component)
+                    rows[component] = _mm_load_ps(reinterpret_cast<const float*>(reg[component]));
+                _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+
+                for (unsigned vertex = 0; vertex < count; ++vertex)
+                    _mm_store_ps(reinterpret_cast<float*>(&outputs[vertex].value[i]), rows[vertex]);
+            }
+            return;
+        }
+
+        // The vertices took different paths through the shader, run them one at a time
+    }
+#endif // ARCHITECTURE_x86_64
+
+    for (unsigned vertex = 0; vertex < count; ++vertex) {
+        Run(state, inputs[vertex], num_attributes);
+        outputs[vertex] = state.output_registers;
+    }
+}
+
 DebugData<true> ShaderSetup::ProduceDebugInfo(const InputVertex& input, int num_attributes, const Regs::ShaderConfig& config, const ShaderSetup& setup) {
     UnitState<true> state;
 
@@ -89,10 +89,27 @@ struct OutputRegisters {
 
     alignas(16) Math::Vec4<float24> value[16];
 
-    OutputVertex ToVertex(const Regs::ShaderConfig& config);
+    OutputVertex ToVertex(const Regs::ShaderConfig& config) const;
 };
 static_assert(std::is_pod<OutputRegisters>::value, "Structure is not POD");
 
+/**
+ * Vertex buffer of a geometry shader unit. EMIT stores the output registers into the entry selected
+ * by the last SETEMIT, and also emits a triangle made of the three entries if SETEMIT requested so.
+ */
+struct GSEmitter {
+    std::array<OutputVertex, 3> buffer;
+
+    u8 vertex_id;
+    bool prim_emit;
+    bool winding;
+
+    /// Receives the three vertices of each emitted triangle
+    std::vector<OutputVertex>* triangles;
+
+    void Emit(const OutputRegisters& output);
+};
+
 // Helper structure used to keep track of data useful for inspection of shader emulation
 template<bool full_debugging>
 struct DebugData;
@@ -288,6 +305,9 @@ struct UnitState {
     // TODO: How many bits do these actually have?
     s32 address_registers[3];
 
+    // Vertex buffer written by EMIT, only set when running a geometry shader
+    GSEmitter* emitter_ptr = nullptr;
+
     DebugData<Debug> debug;
 
     static size_t InputOffset(const SourceRegister& reg) {
@@ -319,6 +339,58 @@ struct UnitState {
     }
 };
 
+/// Number of vertices processed together by ShaderSetup::RunBatch
+constexpr unsigned BATCH_SIZE = 4;
+
+/**
+ * State of a shader unit running the batched shader JIT. Registers are stored as structures of
+ * arrays: each register holds one row per component, and each row holds that component for all
+ * vertices of the batch.
+ */
+struct BatchUnitState {
+    struct Registers {
+        // The registers are accessed by the shader JIT using SSE instructions, and are therefore
+        // required to be 16-byte aligned.
+        alignas(16) float24 input[16][4][BATCH_SIZE];
+        alignas(16) float24 temporary[16][4][BATCH_SIZE];
+        alignas(16) float24 output[16][4][BATCH_SIZE];
+    } registers;
+
+    /// Row used to pass values to functions called by the shader JIT
+    alignas(16) float24 scratch[BATCH_SIZE];
+
+    static size_t InputOffset(const SourceRegister& reg) {
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Input:
+            return offsetof(BatchUnitState, registers.input) + reg.GetIndex()*sizeof(registers.input[0]);
+
+        case RegisterType::Temporary:
+            return offsetof(BatchUnitState, registers.temporary) + reg.GetIndex()*sizeof(registers.temporary[0]);
+
+        default:
+            UNREACHABLE();
+            return 0;
+        }
+    }
+
+    static size_t OutputOffset(const DestRegister& reg) {
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Output:
+            return offsetof(BatchUnitState, registers.output) + reg.GetIndex()*sizeof(registers.output[0]);
+
+        case RegisterType::Temporary:
+            return offsetof(BatchUnitState, registers.temporary) + reg.GetIndex()*sizeof(registers.temporary[0]);
+
+        default:
+            UNREACHABLE();
+            return 0;
+        }
+    }
+};
+
+class JitShader;
+class BatchJitShader;
+
 /// Clears the shader cache
 void ClearCache();
 
@@ -353,6 +425,10 @@ struct ShaderSetup {
     std::array<u32, 1024> program_code;
     std::array<u32, 1024> swizzle_data;
 
+    // Compiled shader used by `Run` and `RunBatch`, null while it isn't available
+    const JitShader* jit_shader;
+    const BatchJitShader* batch_jit_shader;
+
     /**
      * Performs any shader unit setup that only needs to happen once per shader (as opposed to once per
      * vertex, which would happen within the `Run` function).
@@ -367,6 +443,20 @@ struct ShaderSetup {
      */
     void Run(UnitState<false>& state, const InputVertex& input, int num_attributes);
 
+    /**
+     * Runs the currently setup shader for up to BATCH_SIZE vertices at once. If the batched shader
+     * JIT is unavailable, or if the vertices take different paths through the shader, the vertices
+     * are run one at a time using `state`.
+     * @param state Shader unit state, must be setup per shader and per shader unit
+     * @param batch_state Batched shader unit state
+     * @param inputs Input vertices into the shader
+     * @param outputs Receives the output registers of each vertex
+     * @param count Number of vertices, at most BATCH_SIZE
+     * @param num_attributes The number of vertex shader attributes
+     */
+    void RunBatch(UnitState<false>& state, BatchUnitState& batch_state, const InputVertex* inputs,
+                  OutputRegisters* outputs, unsigned count, int num_attributes);
+
     /**
      * Produce debug information based on the given shader and input vertex
      * @param input Input vertex into the shader
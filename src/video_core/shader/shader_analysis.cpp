@@ -0,0 +1,256 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "video_core/shader/shader_analysis.h"
+
+using nihstro::DestRegister;
+using nihstro::OpCode;
+using nihstro::RegisterType;
+using nihstro::SourceRegister;
+
+namespace Pica {
+
+namespace Shader {
+
+bool IsMAD(Instruction instr) {
+    return instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+           instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI;
+}
+
+SwizzlePattern GetSwizzlePattern(Instruction instr, const std::array<u32, 1024>& swizzle_data) {
+    return { swizzle_data[IsMAD(instr) ? instr.mad.operand_desc_id : instr.common.operand_desc_id] };
+}
+
+DestRegister GetDestRegister(Instruction instr) {
+    return IsMAD(instr) ? instr.mad.dest.Value() : instr.common.dest.Value();
+}
+
+unsigned GetAddressRegisterIndex(Instruction instr, unsigned& offset_src) {
+    const bool is_inverted = (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+    if (IsMAD(instr)) {
+        offset_src = is_inverted ? 3 : 2;
+        return instr.mad.address_register_index;
+    }
+
+    offset_src = is_inverted ? 2 : 1;
+    return instr.common.address_register_index;
+}
+
+bool IsSourceNegated(SwizzlePattern swizzle, unsigned src_num) {
+    switch (src_num) {
+    case 1:
+        return swizzle.negate_src1 != 0;
+    case 2:
+        return swizzle.negate_src2 != 0;
+    default:
+        return swizzle.negate_src3 != 0;
+    }
+}
+
+std::vector<unsigned> FindReturnOffsets(const std::array<u32, 1024>& program_code) {
+    std::vector<unsigned> return_offsets;
+
+    for (u32 word : program_code) {
+        const Instruction instr = { word };
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU:
+            return_offsets.push_back(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::sort(return_offsets.begin(), return_offsets.end());
+    return return_offsets;
+}
+
+static unsigned GetDestComponents(SwizzlePattern swizzle) {
+    unsigned components = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        if (swizzle.DestComponentEnabled(i))
+            components |= 1 << i;
+    }
+    return components;
+}
+
+unsigned GetSourceComponents(Instruction instr, SwizzlePattern swizzle, unsigned src_num) {
+    const unsigned dest_components = GetDestComponents(swizzle);
+
+    switch (instr.opcode.Value().EffectiveOpCode()) {
+    case OpCode::Id::ADD:
+    case OpCode::Id::MUL:
+    case OpCode::Id::SGE:
+    case OpCode::Id::SGEI:
+    case OpCode::Id::SLT:
+    case OpCode::Id::SLTI:
+    case OpCode::Id::MAX:
+    case OpCode::Id::MIN:
+        return src_num <= 2 ? dest_components : 0;
+
+    case OpCode::Id::MAD:
+    case OpCode::Id::MADI:
+        return dest_components;
+
+    case OpCode::Id::MOV:
+    case OpCode::Id::FLR:
+        return src_num == 1 ? dest_components : 0;
+
+    case OpCode::Id::DP3:
+        return src_num <= 2 ? 0x7 : 0;
+
+    case OpCode::Id::DP4:
+        return src_num <= 2 ? 0xF : 0;
+
+    case OpCode::Id::DPH:
+    case OpCode::Id::DPHI:
+        // The fourth component of src1 is replaced by 1.0
+        return src_num == 1 ? 0x7 : src_num == 2 ? 0xF : 0;
+
+    case OpCode::Id::EX2:
+    case OpCode::Id::LG2:
+    case OpCode::Id::RCP:
+    case OpCode::Id::RSQ:
+        return src_num == 1 ? 0x1 : 0;
+
+    case OpCode::Id::MOVA:
+        return src_num == 1 ? dest_components & 0x3 : 0;
+
+    case OpCode::Id::CMP:
+        return src_num <= 2 ? 0x3 : 0;
+
+    default:
+        return 0;
+    }
+}
+
+/// Returns whether the result of an instruction is only written to its destination register
+static bool WritesOnlyDest(Instruction instr) {
+    switch (instr.opcode.Value().EffectiveOpCode()) {
+    case OpCode::Id::ADD:
+    case OpCode::Id::DP3:
+    case OpCode::Id::DP4:
+    case OpCode::Id::DPH:
+    case OpCode::Id::DPHI:
+    case OpCode::Id::EX2:
+    case OpCode::Id::LG2:
+    case OpCode::Id::MUL:
+    case OpCode::Id::SGE:
+    case OpCode::Id::SGEI:
+    case OpCode::Id::SLT:
+    case OpCode::Id::SLTI:
+    case OpCode::Id::FLR:
+    case OpCode::Id::MAX:
+    case OpCode::Id::MIN:
+    case OpCode::Id::RCP:
+    case OpCode::Id::RSQ:
+    case OpCode::Id::MOV:
+    case OpCode::Id::MAD:
+    case OpCode::Id::MADI:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/// Applies the swizzle of a source operand to a mask of the components read from it
+static unsigned SwizzleComponents(SwizzlePattern swizzle, unsigned src_num, unsigned components) {
+    const unsigned selector = swizzle.GetRawSelector(src_num);
+
+    unsigned swizzled = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        if (components & (1 << i))
+            swizzled |= 1 << ((selector >> (6 - 2 * i)) & 3);
+    }
+    return swizzled;
+}
+
+std::bitset<1024> FindDeadInstructions(const std::array<u32, 1024>& program_code,
+                                       const std::array<u32, 1024>& swizzle_data, u64 used_outputs) {
+    std::bitset<1024> dead;
+
+    // Removing an instruction may leave the instructions computing its sources unused, so this is
+    // repeated until no more instructions are found
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        // Components of each temporary register read by the remaining instructions
+        std::array<unsigned, 16> temporaries_read = {};
+
+        for (size_t offset = 0; offset < program_code.size(); ++offset) {
+            if (dead[offset])
+                continue;
+
+            const Instruction instr = { program_code[offset] };
+            const bool is_mad = IsMAD(instr);
+            const SwizzlePattern swizzle = GetSwizzlePattern(instr, swizzle_data);
+            const bool is_inverted = is_mad ? instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI
+                : (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+            const unsigned offset_src = is_mad ? (is_inverted ? 3 : 2) : (is_inverted ? 2 : 1);
+            const unsigned address_register_index = is_mad ? instr.mad.address_register_index
+                                                           : instr.common.address_register_index;
+
+            for (unsigned src_num = 1; src_num <= 3; ++src_num) {
+                const unsigned components = GetSourceComponents(instr, swizzle, src_num);
+                if (components == 0)
+                    continue;
+
+                SourceRegister src;
+                if (is_mad) {
+                    src = src_num == 1 ? instr.mad.GetSrc1(is_inverted) : src_num == 2 ?
+                        instr.mad.GetSrc2(is_inverted) : instr.mad.GetSrc3(is_inverted);
+                } else {
+                    src = src_num == 1 ? instr.common.GetSrc1(is_inverted) : instr.common.GetSrc2(is_inverted);
+                }
+
+                if (src.GetRegisterType() == RegisterType::FloatUniform)
+                    continue;
+
+                if (src_num == offset_src && address_register_index != 0) {
+                    // Relative addressing can reach any register
+                    temporaries_read.fill(0xF);
+                } else if (src.GetRegisterType() == RegisterType::Temporary) {
+                    temporaries_read[src.GetIndex()] |= SwizzleComponents(swizzle, src_num, components);
+                }
+            }
+        }
+
+        for (size_t offset = 0; offset < program_code.size(); ++offset) {
+            const Instruction instr = { program_code[offset] };
+            if (dead[offset] || !WritesOnlyDest(instr))
+                continue;
+
+            const SwizzlePattern swizzle = GetSwizzlePattern(instr, swizzle_data);
+            const DestRegister dest = GetDestRegister(instr);
+
+            unsigned used;
+            if (dest.GetRegisterType() == RegisterType::Temporary) {
+                used = temporaries_read[dest.GetIndex()];
+            } else if (dest.GetRegisterType() == RegisterType::Output) {
+                used = (used_outputs >> (4 * dest.GetIndex())) & 0xF;
+            } else {
+                continue;
+            }
+
+            if ((GetDestComponents(swizzle) & used) == 0) {
+                dead.set(offset);
+                changed = true;
+            }
+        }
+    }
+
+    return dead;
+}
+
+} // namespace Shader
+
+} // namespace Pica
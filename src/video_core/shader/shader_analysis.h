@@ -0,0 +1,74 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <vector>
+
+#include <nihstro/shader_bytecode.h>
+
+#include "common/common_types.h"
+
+using nihstro::Instruction;
+using nihstro::SwizzlePattern;
+
+namespace Pica {
+
+namespace Shader {
+
+/// Returns whether an instruction uses the MAD encoding, which lays out its operands differently
+bool IsMAD(Instruction instr);
+
+/// Returns the swizzle pattern of an arithmetic instruction, looked up in the swizzle data of its program
+SwizzlePattern GetSwizzlePattern(Instruction instr, const std::array<u32, 1024>& swizzle_data);
+
+/// Returns the destination register of an arithmetic instruction
+nihstro::DestRegister GetDestRegister(Instruction instr);
+
+/**
+ * Returns the address register which offsets a source operand of an arithmetic instruction.
+ * @param instr Instruction reading the operand
+ * @param offset_src Set to the number of the source operand the offset applies to
+ * @return 0 if the operand isn't offset, 1 or 2 for the x or y component of the address
+ *         register, or 3 for the loop counter
+ */
+unsigned GetAddressRegisterIndex(Instruction instr, unsigned& offset_src);
+
+/// Returns whether a source operand (1 = src1, 2 = src2, 3 = src3) is negated by the swizzle pattern
+bool IsSourceNegated(SwizzlePattern swizzle, unsigned src_num);
+
+/**
+ * Finds the offsets at which the subroutines of a shader program return to their caller, that is
+ * the end of the range called by each CALL, CALLC and CALLU instruction.
+ * @return The offsets in ascending order, so they can be binary searched
+ */
+std::vector<unsigned> FindReturnOffsets(const std::array<u32, 1024>& program_code);
+
+/**
+ * Returns the components of a source operand an instruction reads, as a mask with bit i set for
+ * component i. Swizzling is not applied: the mask refers to the components of the swizzled operand.
+ * @param instr Instruction reading the operand
+ * @param swizzle Swizzle pattern of the instruction
+ * @param src_num Number of the source operand (1 = src1, 2 = src2, 3 = src3)
+ */
+unsigned GetSourceComponents(Instruction instr, SwizzlePattern swizzle, unsigned src_num);
+
+/**
+ * Finds the instructions of a shader program whose results are never used, so that they don't
+ * have to be compiled. The analysis doesn't follow the control flow of the program: a temporary
+ * register component is considered used if any instruction of the program reads it.
+ * @param program_code Program code of the shader
+ * @param swizzle_data Swizzle data of the shader
+ * @param used_outputs Output register components used after running the shader, bit 4 * i + j is
+ *                     set if component j of output register i is used
+ * @return Set with a bit set for the offset of each instruction which can be skipped
+ */
+std::bitset<1024> FindDeadInstructions(const std::array<u32, 1024>& program_code,
+                                       const std::array<u32, 1024>& swizzle_data, u64 used_outputs);
+
+} // namespace Shader
+
+} // namespace Pica
@@ -47,9 +47,9 @@ void RunInterpreter(const ShaderSetup& setup, UnitState<Debug>& state, unsigned
 
     u32 program_counter = offset;
 
-    const auto& uniforms = g_state.vs.uniforms;
-    const auto& swizzle_data = g_state.vs.swizzle_data;
-    const auto& program_code = g_state.vs.program_code;
+    const auto& uniforms = setup.uniforms;
+    const auto& swizzle_data = setup.swizzle_data;
+    const auto& program_code = setup.program_code;
 
     // Placeholder for invalid inputs
     static float24 dummy_vec4_float24[4];
@@ -77,7 +77,7 @@ void RunInterpreter(const ShaderSetup& setup, UnitState<Debug>& state, unsigned
         const Instruction instr = { program_code[program_counter] };
         const SwizzlePattern swizzle = { swizzle_data[instr.common.operand_desc_id] };
 
-        static auto call = [&program_counter, &call_stack](UnitState<Debug>& state, u32 offset, u32 num_instructions,
+        auto call = [&program_counter, &call_stack](UnitState<Debug>& state, u32 offset, u32 num_instructions,
                               u32 return_offset, u8 repeat_count, u8 loop_increment) {
             program_counter = offset - 1; // -1 to make sure when incrementing the PC we end up at the correct offset
             ASSERT(call_stack.size() < call_stack.capacity());
@@ -577,6 +577,26 @@ void RunInterpreter(const ShaderSetup& setup, UnitState<Debug>& state, unsigned
             case OpCode::Id::NOP:
                 break;
 
+            case OpCode::Id::EMIT:
+                if (state.emitter_ptr == nullptr) {
+                    LOG_ERROR(HW_GPU, "Execute EMIT outside of a geometry shader");
+                    break;
+                }
+                state.emitter_ptr->Emit(state.output_registers);
+                break;
+
+            case OpCode::Id::SETEMIT:
+            {
+                if (state.emitter_ptr == nullptr) {
+                    LOG_ERROR(HW_GPU, "Execute SETEMIT outside of a geometry shader");
+                    break;
+                }
+                state.emitter_ptr->vertex_id = instr.setemit.vertex_id;
+                state.emitter_ptr->prim_emit = instr.setemit.prim_emit != 0;
+                state.emitter_ptr->winding = instr.setemit.winding != 0;
+                break;
+            }
+
             case OpCode::Id::IFU:
                 Record<DebugDataRecord::COND_BOOL_IN>(state.debug, iteration, uniforms.b[instr.flow_control.bool_uniform_id]);
                 if (uniforms.b[instr.flow_control.bool_uniform_id]) {
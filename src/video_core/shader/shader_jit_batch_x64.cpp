@@ -0,0 +1,839 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <xmmintrin.h>
+
+#include <nihstro/shader_bytecode.h>
+
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+#include "common/x64/abi.h"
+#include "common/x64/cpu_detect.h"
+#include "common/x64/emitter.h"
+
+#include "shader.h"
+#include "shader_analysis.h"
+#include "shader_jit_batch_x64.h"
+
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+
+namespace Pica {
+
+namespace Shader {
+
+using namespace Gen;
+
+typedef void (BatchJitShader::*JitFunction)(Instruction instr);
+
+const JitFunction instr_table[64] = {
+    &BatchJitShader::Compile_ADD,        // add
+    &BatchJitShader::Compile_DP3,        // dp3
+    &BatchJitShader::Compile_DP4,        // dp4
+    &BatchJitShader::Compile_DPH,        // dph
+    nullptr,                             // unknown
+    &BatchJitShader::Compile_EX2,        // ex2
+    &BatchJitShader::Compile_LG2,        // lg2
+    nullptr,                             // unknown
+    &BatchJitShader::Compile_MUL,        // mul
+    &BatchJitShader::Compile_SGE,        // sge
+    &BatchJitShader::Compile_SLT,        // slt
+    &BatchJitShader::Compile_FLR,        // flr
+    &BatchJitShader::Compile_MAX,        // max
+    &BatchJitShader::Compile_MIN,        // min
+    &BatchJitShader::Compile_RCP,        // rcp
+    &BatchJitShader::Compile_RSQ,        // rsq
+    nullptr,                             // unknown
+    nullptr,                             // unknown
+    &BatchJitShader::Compile_MOVA,       // mova
+    &BatchJitShader::Compile_MOV,        // mov
+    nullptr,                             // unknown
+    nullptr,                             // unknown
+    nullptr,                             // unknown
+    nullptr,                             // unknown
+    &BatchJitShader::Compile_DPH,        // dphi
+    nullptr,                             // unknown
+    &BatchJitShader::Compile_SGE,        // sgei
+    &BatchJitShader::Compile_SLT,        // slti
+    nullptr,                             // unknown
+    nullptr,                             // unknown
+    nullptr,                             // unknown
+    nullptr,                             // unknown
+    nullptr,                             // unknown
+    &BatchJitShader::Compile_NOP,        // nop
+    &BatchJitShader::Compile_END,        // end
+    nullptr,                             // break
+    &BatchJitShader::Compile_CALL,       // call
+    &BatchJitShader::Compile_CALLC,      // callc
+    &BatchJitShader::Compile_CALLU,      // callu
+    &BatchJitShader::Compile_IF,         // ifu
+    &BatchJitShader::Compile_IF,         // ifc
+    &BatchJitShader::Compile_LOOP,       // loop
+    nullptr,                             // emit
+    nullptr,                             // sete
+    &BatchJitShader::Compile_JMP,        // jmpc
+    &BatchJitShader::Compile_JMP,        // jmpu
+    &BatchJitShader::Compile_CMP,        // cmp
+    &BatchJitShader::Compile_CMP,        // cmp
+    &BatchJitShader::Compile_MAD,        // madi
+    &BatchJitShader::Compile_MAD,        // madi
+    &BatchJitShader::Compile_MAD,        // madi
+    &BatchJitShader::Compile_MAD,        // madi
+    &BatchJitShader::Compile_MAD,        // madi
+    &BatchJitShader::Compile_MAD,        // madi
+    &BatchJitShader::Compile_MAD,        // madi
+    &BatchJitShader::Compile_MAD,        // madi
+    &BatchJitShader::Compile_MAD,        // mad
+    &BatchJitShader::Compile_MAD,        // mad
+    &BatchJitShader::Compile_MAD,        // mad
+    &BatchJitShader::Compile_MAD,        // mad
+    &BatchJitShader::Compile_MAD,        // mad
+    &BatchJitShader::Compile_MAD,        // mad
+    &BatchJitShader::Compile_MAD,        // mad
+    &BatchJitShader::Compile_MAD,        // mad
+};
+
+// The following is used to alias some commonly used registers. Generally, RAX-RDX and XMM0-XMM3 can
+// be used as scratch registers within a compiler function. The other registers have designated
+// purposes, as documented below:
+
+/// Pointer to the uniform memory
+static const X64Reg SETUP = R9;
+/// The two 32-bit VS address offset registers set by the MOVA instruction
+static const X64Reg ADDROFFS_REG_0 = R10;
+static const X64Reg ADDROFFS_REG_1 = R11;
+/// VS loop count register
+static const X64Reg LOOPCOUNT_REG = R12;
+/// Current VS loop iteration number (we could probably use LOOPCOUNT_REG, but this quicker)
+static const X64Reg LOOPCOUNT = RSI;
+/// Number to increment LOOPCOUNT_REG by on each loop iteration
+static const X64Reg LOOPINC = RDI;
+/// Per-vertex results of the previous CMP instruction for the X-component comparison, one bit per vertex
+static const X64Reg COND0 = R13;
+/// Per-vertex results of the previous CMP instruction for the Y-component comparison, one bit per vertex
+static const X64Reg COND1 = R14;
+/// Pointer to the BatchUnitState instance for the current VS unit
+static const X64Reg STATE = R15;
+/// Stack pointer after the prologue, used to leave the program from within subroutines
+static const X64Reg STACK_BASE = RBP;
+/// Loaded with a component of the first source register, otherwise can be used as a scratch register
+static const X64Reg SRC1 = XMM0;
+/// Loaded with a component of the second source register, otherwise can be used as a scratch register
+static const X64Reg SRC2 = XMM1;
+/// Loaded with a component of the third source register, otherwise can be used as a scratch register
+static const X64Reg SRC3 = XMM2;
+/// SIMD scratch register
+static const X64Reg SCRATCH = XMM3;
+/// Hold the components of the result until they are stored, so that a source aliasing the
+/// destination register is read before it is overwritten
+static const std::array<X64Reg, 4> RESULT = {{ XMM4, XMM5, XMM6, XMM7 }};
+/// Constant vector of [1.0f, 1.0f, 1.0f, 1.0f], used to efficiently set a vector to one
+static const X64Reg ONE = XMM14;
+/// Constant vector of [-0.f, -0.f, -0.f, -0.f], used to efficiently negate a vector with XOR
+static const X64Reg NEGBIT = XMM15;
+
+// State registers that must not be modified by external functions calls
+// Scratch registers, e.g., SRC1 and SCRATCH, have to be saved on the side if needed
+static const BitSet32 persistent_regs = {
+    SETUP, STATE, STACK_BASE, // Pointers to register blocks
+    ADDROFFS_REG_0, ADDROFFS_REG_1, LOOPCOUNT_REG, LOOPCOUNT, LOOPINC, COND0, COND1, // Cached registers
+    ONE+16, NEGBIT+16, // Constants
+};
+
+/// Lane mask of a comparison which is true for all vertices of the batch
+static const u32 ALL_LANES = (1 << BATCH_SIZE) - 1;
+
+/**
+ * Get the vertex shader instruction for a given offset in the current shader program
+ * @param offset Offset in the current shader program of the instruction
+ * @return Instruction at the specified offset
+ */
+Instruction BatchJitShader::GetVertexShaderInstruction(size_t offset) const {
+    return { (*program_code)[offset] };
+}
+
+SwizzlePattern BatchJitShader::GetSwizzlePattern(Instruction instr) const {
+    return Shader::GetSwizzlePattern(instr, *swizzle_data);
+}
+
+static void LogCritical(const char* msg) {
+    LOG_CRITICAL(HW_GPU, "%s", msg);
+}
+
+static void Exp2Row(float24* row) {
+    for (unsigned i = 0; i < BATCH_SIZE; ++i)
+        row[i] = float24::FromFloat32(exp2f(row[i].ToFloat32()));
+}
+
+static void Log2Row(float24* row) {
+    for (unsigned i = 0; i < BATCH_SIZE; ++i)
+        row[i] = float24::FromFloat32(log2f(row[i].ToFloat32()));
+}
+
+void BatchJitShader::Compile_Assert(bool condition, const char* msg) {
+    if (!condition) {
+        ABI_CallFunctionP(reinterpret_cast<const void*>(LogCritical), const_cast<char*>(msg));
+    }
+}
+
+void BatchJitShader::Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRegister src_reg, unsigned component, X64Reg dest) {
+    const bool is_uniform = src_reg.GetRegisterType() == RegisterType::FloatUniform;
+
+    X64Reg src_ptr;
+    size_t src_offset;
+    SwizzlePattern swiz = GetSwizzlePattern(instr);
+
+    // Select the row holding the requested component of the swizzled register
+    const unsigned selector = (swiz.GetRawSelector(src_num) >> (6 - 2 * component)) & 3;
+
+    if (is_uniform) {
+        src_ptr = SETUP;
+        src_offset = ShaderSetup::UniformOffset(RegisterType::FloatUniform, src_reg.GetIndex()) + selector * sizeof(float24);
+    } else {
+        src_ptr = STATE;
+        src_offset = BatchUnitState::InputOffset(src_reg) + selector * sizeof(float24) * BATCH_SIZE;
+    }
+
+    int src_offset_disp = (int)src_offset;
+    ASSERT_MSG(src_offset == static_cast<size_t>(src_offset_disp), "Source register offset too large for int type");
+
+    unsigned offset_src;
+    const unsigned address_register_index = GetAddressRegisterIndex(instr, offset_src);
+
+    OpArg src = MDisp(src_ptr, src_offset_disp);
+    if (src_num == offset_src && address_register_index != 0) {
+        static const X64Reg address_registers[] = { ADDROFFS_REG_0, ADDROFFS_REG_1, LOOPCOUNT_REG };
+
+        // The offsets are scaled for registers holding one vector, registers of the batch state
+        // hold one vector per vertex
+        src = MComplex(src_ptr, address_registers[address_register_index - 1],
+                       is_uniform ? SCALE_1 : SCALE_4, src_offset_disp);
+    }
+
+    if (is_uniform) {
+        // Uniforms are the same for all vertices
+        if (Common::GetCPUCaps().avx) {
+            VBROADCASTSS(dest, src);
+        } else {
+            MOVSS(dest, src);
+            SHUFPS(dest, R(dest), _MM_SHUFFLE(0, 0, 0, 0));
+        }
+    } else {
+        MOVAPS(dest, src);
+    }
+
+    // If the source register should be negated, flip the negative bit using XOR
+    if (IsSourceNegated(swiz, src_num)) {
+        XORPS(dest, R(NEGBIT));
+    }
+}
+
+void BatchJitShader::Compile_DestEnable(Instruction instr, const std::array<X64Reg, 4>& results) {
+    DestRegister dest = GetDestRegister(instr);
+    SwizzlePattern swiz = GetSwizzlePattern(instr);
+
+    const size_t dest_offset = BatchUnitState::OutputOffset(dest);
+    int dest_offset_disp = (int)dest_offset;
+    ASSERT_MSG(dest_offset == static_cast<size_t>(dest_offset_disp), "Destinaton offset too large for int type");
+
+    // Each component is stored in its own row, so disabled components are simply not written
+    for (unsigned component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            int row_offset = static_cast<int>(component * sizeof(float24) * BATCH_SIZE);
+            MOVAPS(MDisp(STATE, dest_offset_disp + row_offset), results[component]);
+        }
+    }
+}
+
+void BatchJitShader::Compile_DestEnableBroadcast(Instruction instr, X64Reg result) {
+    Compile_DestEnable(instr, {{ result, result, result, result }});
+}
+
+template <typename F>
+void BatchJitShader::Compile_ComponentWise(Instruction instr, SourceRegister src1, SourceRegister src2, F op) {
+    SwizzlePattern swiz = GetSwizzlePattern(instr);
+
+    for (unsigned component = 0; component < 4; ++component) {
+        if (!swiz.DestComponentEnabled(component))
+            continue;
+
+        Compile_SwizzleSrc(instr, 1, src1, component, RESULT[component]);
+        Compile_SwizzleSrc(instr, 2, src2, component, SRC2);
+        op(RESULT[component], SRC2);
+    }
+
+    Compile_DestEnable(instr, RESULT);
+}
+
+void BatchJitShader::Compile_DotProduct(Instruction instr, SourceRegister src1, SourceRegister src2, unsigned num_components, bool homogeneous, X64Reg dest) {
+    // Products of each component. The summation order matches JitShader so both produce the same
+    // results: DP3 = (x + y) + z, DP4 = (x + y) + (z + w)
+    for (unsigned component = 0; component < num_components; ++component) {
+        if (homogeneous && component == 3) {
+            MOVAPS(RESULT[component], R(ONE));
+        } else {
+            Compile_SwizzleSrc(instr, 1, src1, component, RESULT[component]);
+        }
+        Compile_SwizzleSrc(instr, 2, src2, component, SRC2);
+        Compile_SanitizedMul(RESULT[component], SRC2, SCRATCH);
+    }
+
+    if (num_components == 3) {
+        MOVAPS(dest, R(RESULT[0]));
+        ADDPS(dest, R(RESULT[1]));
+        ADDPS(dest, R(RESULT[2]));
+    } else {
+        ADDPS(RESULT[0], R(RESULT[1]));
+        ADDPS(RESULT[2], R(RESULT[3]));
+        MOVAPS(dest, R(RESULT[0]));
+        ADDPS(dest, R(RESULT[2]));
+    }
+}
+
+void BatchJitShader::Compile_CallScalarFunction(Instruction instr, const void* func) {
+    const int scratch_offset = static_cast<int>(offsetof(BatchUnitState, scratch));
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0, SRC1);
+    MOVAPS(MDisp(STATE, scratch_offset), SRC1);
+
+    ABI_PushRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
+    LEA(64, ABI_PARAM1, MDisp(STATE, scratch_offset));
+    ABI_CallFunction(func);
+    ABI_PopRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
+
+    MOVAPS(SRC1, MDisp(STATE, scratch_offset));
+    Compile_DestEnableBroadcast(instr, SRC1);
+}
+
+void BatchJitShader::Compile_SanitizedMul(Gen::X64Reg src1, Gen::X64Reg src2, Gen::X64Reg scratch) {
+    if (Common::GetCPUCaps().avx) {
+        VCMPPS(scratch, src1, R(src2), CMP_ORD);
+        VMULPS(src1, src1, R(src2));
+        VCMPPS(src2, src1, R(src1), CMP_UNORD);
+        VXORPS(scratch, scratch, R(src2));
+        VANDPS(src1, src1, R(scratch));
+        return;
+    }
+
+    MOVAPS(scratch, R(src1));
+    CMPPS(scratch, R(src2), CMP_ORD);
+
+    MULPS(src1, R(src2));
+
+    MOVAPS(src2, R(src1));
+    CMPPS(src2, R(src2), CMP_UNORD);
+
+    XORPS(scratch, R(src2));
+    ANDPS(src1, R(scratch));
+}
+
+void BatchJitShader::Compile_DivergenceCheck(X64Reg mask) {
+    // The vertices agree if none or all of the lanes are set
+    TEST(32, R(mask), R(mask));
+    FixupBranch uniform = J_CC(CC_Z);
+    CMP(32, R(mask), Imm32(ALL_LANES));
+    divergence_branches.push_back(J_CC(CC_NZ, true));
+    SetJumpTarget(uniform);
+}
+
+void BatchJitShader::Compile_EvaluateCondition(Instruction instr) {
+    // Lanes are XORed with the inverse of the reference value to check for equality
+    const u32 invert_x = instr.flow_control.refx.Value() ? 0 : ALL_LANES;
+    const u32 invert_y = instr.flow_control.refy.Value() ? 0 : ALL_LANES;
+
+    switch (instr.flow_control.op) {
+    case Instruction::FlowControlType::Or:
+        MOV(32, R(RAX), R(COND0));
+        MOV(32, R(RBX), R(COND1));
+        XOR(32, R(RAX), Imm32(invert_x));
+        XOR(32, R(RBX), Imm32(invert_y));
+        OR(32, R(RAX), R(RBX));
+        break;
+
+    case Instruction::FlowControlType::And:
+        MOV(32, R(RAX), R(COND0));
+        MOV(32, R(RBX), R(COND1));
+        XOR(32, R(RAX), Imm32(invert_x));
+        XOR(32, R(RBX), Imm32(invert_y));
+        AND(32, R(RAX), R(RBX));
+        break;
+
+    case Instruction::FlowControlType::JustX:
+        MOV(32, R(RAX), R(COND0));
+        XOR(32, R(RAX), Imm32(invert_x));
+        break;
+
+    case Instruction::FlowControlType::JustY:
+        MOV(32, R(RAX), R(COND1));
+        XOR(32, R(RAX), Imm32(invert_y));
+        break;
+    }
+
+    Compile_DivergenceCheck(RAX);
+    TEST(32, R(RAX), R(RAX));
+}
+
+void BatchJitShader::Compile_UniformCondition(Instruction instr) {
+    int offset = ShaderSetup::UniformOffset(RegisterType::BoolUniform, instr.flow_control.bool_uniform_id);
+    CMP(sizeof(bool) * 8, MDisp(SETUP, offset), Imm8(0));
+}
+
+BitSet32 BatchJitShader::PersistentCallerSavedRegs() {
+    return persistent_regs & ABI_ALL_CALLER_SAVED;
+}
+
+void BatchJitShader::Compile_ADD(Instruction instr) {
+    Compile_ComponentWise(instr, instr.common.src1, instr.common.src2, [this](X64Reg dest, X64Reg src2) {
+        ADDPS(dest, R(src2));
+    });
+}
+
+void BatchJitShader::Compile_DP3(Instruction instr) {
+    Compile_DotProduct(instr, instr.common.src1, instr.common.src2, 3, false, SRC1);
+    Compile_DestEnableBroadcast(instr, SRC1);
+}
+
+void BatchJitShader::Compile_DP4(Instruction instr) {
+    Compile_DotProduct(instr, instr.common.src1, instr.common.src2, 4, false, SRC1);
+    Compile_DestEnableBroadcast(instr, SRC1);
+}
+
+void BatchJitShader::Compile_DPH(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::DPHI) {
+        Compile_DotProduct(instr, instr.common.src1i, instr.common.src2i, 4, true, SRC1);
+    } else {
+        Compile_DotProduct(instr, instr.common.src1, instr.common.src2, 4, true, SRC1);
+    }
+    Compile_DestEnableBroadcast(instr, SRC1);
+}
+
+void BatchJitShader::Compile_EX2(Instruction instr) {
+    Compile_CallScalarFunction(instr, reinterpret_cast<const void*>(Exp2Row));
+}
+
+void BatchJitShader::Compile_LG2(Instruction instr) {
+    Compile_CallScalarFunction(instr, reinterpret_cast<const void*>(Log2Row));
+}
+
+void BatchJitShader::Compile_MUL(Instruction instr) {
+    Compile_ComponentWise(instr, instr.common.src1, instr.common.src2, [this](X64Reg dest, X64Reg src2) {
+        Compile_SanitizedMul(dest, src2, SCRATCH);
+    });
+}
+
+void BatchJitShader::Compile_SGE(Instruction instr) {
+    auto op = [this](X64Reg dest, X64Reg src2) {
+        CMPPS(src2, R(dest), CMP_LE);
+        ANDPS(src2, R(ONE));
+        MOVAPS(dest, R(src2));
+    };
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SGEI) {
+        Compile_ComponentWise(instr, instr.common.src1i, instr.common.src2i, op);
+    } else {
+        Compile_ComponentWise(instr, instr.common.src1, instr.common.src2, op);
+    }
+}
+
+void BatchJitShader::Compile_SLT(Instruction instr) {
+    auto op = [this](X64Reg dest, X64Reg src2) {
+        CMPPS(dest, R(src2), CMP_LT);
+        ANDPS(dest, R(ONE));
+    };
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SLTI) {
+        Compile_ComponentWise(instr, instr.common.src1i, instr.common.src2i, op);
+    } else {
+        Compile_ComponentWise(instr, instr.common.src1, instr.common.src2, op);
+    }
+}
+
+void BatchJitShader::Compile_FLR(Instruction instr) {
+    SwizzlePattern swiz = GetSwizzlePattern(instr);
+
+    for (unsigned component = 0; component < 4; ++component) {
+        if (!swiz.DestComponentEnabled(component))
+            continue;
+
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, component, RESULT[component]);
+
+        if (Common::GetCPUCaps().sse4_1) {
+            ROUNDFLOORPS(RESULT[component], R(RESULT[component]));
+        } else {
+            CVTPS2DQ(RESULT[component], R(RESULT[component]));
+            CVTDQ2PS(RESULT[component], R(RESULT[component]));
+        }
+    }
+
+    Compile_DestEnable(instr, RESULT);
+}
+
+void BatchJitShader::Compile_MAX(Instruction instr) {
+    // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
+    Compile_ComponentWise(instr, instr.common.src1, instr.common.src2, [this](X64Reg dest, X64Reg src2) {
+        MAXPS(dest, R(src2));
+    });
+}
+
+void BatchJitShader::Compile_MIN(Instruction instr) {
+    // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
+    Compile_ComponentWise(instr, instr.common.src1, instr.common.src2, [this](X64Reg dest, X64Reg src2) {
+        MINPS(dest, R(src2));
+    });
+}
+
+void BatchJitShader::Compile_MOVA(Instruction instr) {
+    SwizzlePattern swiz = GetSwizzlePattern(instr);
+
+    static const X64Reg address_registers[] = { ADDROFFS_REG_0, ADDROFFS_REG_1 };
+
+    for (unsigned component = 0; component < 2; ++component) {
+        if (!swiz.DestComponentEnabled(component))
+            continue;
+
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+
+        // Convert floats to integers using truncation
+        CVTTPS2DQ(SRC1, R(SRC1));
+
+        // Relative addressing is only supported if all vertices use the same offset
+        PSHUFD(SCRATCH, R(SRC1), _MM_SHUFFLE(0, 0, 0, 0));
+        PCMPEQD(SCRATCH, R(SRC1));
+        MOVMSKPS(RAX, R(SCRATCH));
+        CMP(32, R(RAX), Imm32(ALL_LANES));
+        divergence_branches.push_back(J_CC(CC_NZ, true));
+
+        // Move and sign-extend the value of the first vertex
+        MOVD_xmm(R(RAX), SRC1);
+        MOVSX(64, 32, address_registers[component], R(RAX));
+
+        // Multiply by 16 to be used as an offset later
+        SHL(64, R(address_registers[component]), Imm8(4));
+    }
+}
+
+void BatchJitShader::Compile_MOV(Instruction instr) {
+    SwizzlePattern swiz = GetSwizzlePattern(instr);
+
+    for (unsigned component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component))
+            Compile_SwizzleSrc(instr, 1, instr.common.src1, component, RESULT[component]);
+    }
+
+    Compile_DestEnable(instr, RESULT);
+}
+
+void BatchJitShader::Compile_RCP(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0, SRC1);
+
+    // TODO(bunnei): RCPPS is a pretty rough approximation, this might cause problems if Pica
+    // performs this operation more accurately. This should be checked on hardware.
+    RCPPS(SRC1, R(SRC1));
+
+    Compile_DestEnableBroadcast(instr, SRC1);
+}
+
+void BatchJitShader::Compile_RSQ(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0, SRC1);
+
+    // TODO(bunnei): RSQRTPS is a pretty rough approximation, this might cause problems if Pica
+    // performs this operation more accurately. This should be checked on hardware.
+    RSQRTPS(SRC1, R(SRC1));
+
+    Compile_DestEnableBroadcast(instr, SRC1);
+}
+
+void BatchJitShader::Compile_NOP(Instruction instr) {
+}
+
+void BatchJitShader::Compile_END(Instruction instr) {
+    // The program may end from within a subroutine, discard the return offsets on the stack
+    MOV(64, R(RSP), R(STACK_BASE));
+    XOR(32, R(RAX), R(RAX));
+    ABI_PopRegistersAndAdjustStack(ABI_ALL_CALLEE_SAVED, 8);
+    RET();
+}
+
+void BatchJitShader::Compile_CALL(Instruction instr) {
+    // Push offset of the return
+    PUSH(64, Imm32(instr.flow_control.dest_offset + instr.flow_control.num_instructions));
+
+    // Call the subroutine
+    FixupBranch b = CALL();
+    fixup_branches.push_back({ b, instr.flow_control.dest_offset });
+
+    // Skip over the return offset that's on the stack
+    ADD(64, R(RSP), Imm32(8));
+}
+
+void BatchJitShader::Compile_CALLC(Instruction instr) {
+    Compile_EvaluateCondition(instr);
+    FixupBranch b = J_CC(CC_Z, true);
+    Compile_CALL(instr);
+    SetJumpTarget(b);
+}
+
+void BatchJitShader::Compile_CALLU(Instruction instr) {
+    Compile_UniformCondition(instr);
+    FixupBranch b = J_CC(CC_Z, true);
+    Compile_CALL(instr);
+    SetJumpTarget(b);
+}
+
+void BatchJitShader::Compile_CMP(Instruction instr) {
+    using Op = Instruction::Common::CompareOpType::Op;
+    Op op_x = instr.common.compare_op.x;
+    Op op_y = instr.common.compare_op.y;
+
+    // SSE doesn't have greater-than (GT) or greater-equal (GE) comparison operators. You need to
+    // emulate them by swapping the lhs and rhs and using LT and LE. NLT and NLE can't be used here
+    // because they don't match when used with NaNs.
+    static const u8 cmp[] = { CMP_EQ, CMP_NEQ, CMP_LT, CMP_LE, CMP_LT, CMP_LE };
+
+    const Op ops[] = { op_x, op_y };
+    const X64Reg conds[] = { COND0, COND1 };
+
+    for (unsigned component = 0; component < 2; ++component) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, component, SRC2);
+
+        bool invert_op = (ops[component] == Op::GreaterThan || ops[component] == Op::GreaterEqual);
+        X64Reg lhs = invert_op ? SRC2 : SRC1;
+        X64Reg rhs = invert_op ? SRC1 : SRC2;
+
+        // One bit per vertex
+        CMPPS(lhs, R(rhs), cmp[ops[component]]);
+        MOVMSKPS(conds[component], R(lhs));
+    }
+}
+
+void BatchJitShader::Compile_MAD(Instruction instr) {
+    SourceRegister src2 = instr.mad.src2;
+    SourceRegister src3 = instr.mad.src3;
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        src2 = instr.mad.src2i;
+        src3 = instr.mad.src3i;
+    }
+
+    SwizzlePattern swiz = GetSwizzlePattern(instr);
+
+    for (unsigned component = 0; component < 4; ++component) {
+        if (!swiz.DestComponentEnabled(component))
+            continue;
+
+        Compile_SwizzleSrc(instr, 1, instr.mad.src1, component, RESULT[component]);
+        Compile_SwizzleSrc(instr, 2, src2, component, SRC2);
+        Compile_SwizzleSrc(instr, 3, src3, component, SRC3);
+
+        Compile_SanitizedMul(RESULT[component], SRC2, SCRATCH);
+        ADDPS(RESULT[component], R(SRC3));
+    }
+
+    Compile_DestEnable(instr, RESULT);
+}
+
+void BatchJitShader::Compile_IF(Instruction instr) {
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter, "Backwards if-statements not supported");
+
+    // Evaluate the "IF" condition
+    if (instr.opcode.Value() == OpCode::Id::IFU) {
+        Compile_UniformCondition(instr);
+    } else if (instr.opcode.Value() == OpCode::Id::IFC) {
+        Compile_EvaluateCondition(instr);
+    }
+    FixupBranch b = J_CC(CC_Z, true);
+
+    // Compile the code that corresponds to the condition evaluating as true
+    Compile_Block(instr.flow_control.dest_offset);
+
+    // If there isn't an "ELSE" condition, we are done here
+    if (instr.flow_control.num_instructions == 0) {
+        SetJumpTarget(b);
+        return;
+    }
+
+    FixupBranch b2 = J(true);
+
+    SetJumpTarget(b);
+
+    // This code corresponds to the "ELSE" condition
+    // Comple the code that corresponds to the condition evaluating as false
+    Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+
+    SetJumpTarget(b2);
+}
+
+void BatchJitShader::Compile_LOOP(Instruction instr) {
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter, "Backwards loops not supported");
+    Compile_Assert(!looping, "Nested loops not supported");
+
+    looping = true;
+
+    int offset = ShaderSetup::UniformOffset(RegisterType::IntUniform, instr.flow_control.int_uniform_id);
+    MOV(32, R(LOOPCOUNT), MDisp(SETUP, offset));
+    MOV(32, R(LOOPCOUNT_REG), R(LOOPCOUNT));
+    SHR(32, R(LOOPCOUNT_REG), Imm8(8));
+    AND(32, R(LOOPCOUNT_REG), Imm32(0xff)); // Y-component is the start
+    MOV(32, R(LOOPINC), R(LOOPCOUNT));
+    SHR(32, R(LOOPINC), Imm8(16));
+    MOVZX(32, 8, LOOPINC, R(LOOPINC)); // Z-component is the incrementer
+    MOVZX(32, 8, LOOPCOUNT, R(LOOPCOUNT)); // X-component is iteration count
+    ADD(32, R(LOOPCOUNT), Imm8(1)); // Iteration count is X-component + 1
+
+    auto loop_start = GetCodePtr();
+
+    Compile_Block(instr.flow_control.dest_offset + 1);
+
+    ADD(32, R(LOOPCOUNT_REG), R(LOOPINC)); // Increment LOOPCOUNT_REG by Z-component
+    SUB(32, R(LOOPCOUNT), Imm8(1)); // Increment loop count by 1
+    J_CC(CC_NZ, loop_start); // Loop if not equal
+
+    looping = false;
+}
+
+void BatchJitShader::Compile_JMP(Instruction instr) {
+    if (instr.opcode.Value() == OpCode::Id::JMPC)
+        Compile_EvaluateCondition(instr);
+    else if (instr.opcode.Value() == OpCode::Id::JMPU)
+        Compile_UniformCondition(instr);
+    else
+        UNREACHABLE();
+
+    bool inverted_condition = (instr.opcode.Value() == OpCode::Id::JMPU) &&
+        (instr.flow_control.num_instructions & 1);
+
+    FixupBranch b = J_CC(inverted_condition ? CC_Z : CC_NZ, true);
+    fixup_branches.push_back({ b, instr.flow_control.dest_offset });
+}
+
+void BatchJitShader::Compile_Block(unsigned end) {
+    while (program_counter < end) {
+        Compile_NextInstr();
+    }
+}
+
+void BatchJitShader::Compile_Return() {
+    // Peek return offset on the stack and check if we're at that offset
+    MOV(64, R(RAX), MDisp(RSP, 8));
+    CMP(32, R(RAX), Imm32(program_counter));
+
+    // If so, jump back to before CALL
+    FixupBranch b = J_CC(CC_NZ, true);
+    RET();
+    SetJumpTarget(b);
+}
+
+void BatchJitShader::Compile_NextInstr() {
+    if (std::binary_search(return_offsets.begin(), return_offsets.end(), program_counter)) {
+        Compile_Return();
+    }
+
+    ASSERT_MSG(code_ptr[program_counter] == nullptr, "Tried to compile already compiled shader location!");
+    code_ptr[program_counter] = GetCodePtr();
+
+    Instruction instr = GetVertexShaderInstruction(program_counter++);
+
+    // Skip instructions whose results are never used
+    if (dead_instructions[program_counter - 1])
+        return;
+
+    OpCode::Id opcode = instr.opcode.Value();
+    auto instr_func = instr_table[static_cast<unsigned>(opcode)];
+
+    if (instr_func) {
+        // JIT the instruction!
+        ((*this).*instr_func)(instr);
+    } else {
+        // Unhandled instruction
+        LOG_CRITICAL(HW_GPU, "Unhandled instruction: 0x%02x (0x%08x)",
+                instr.opcode.Value().EffectiveOpCode(), instr.hex);
+    }
+}
+
+void BatchJitShader::Compile(const std::array<u32, 1024>& program_code, const std::array<u32, 1024>& swizzle_data,
+                             u64 used_outputs) {
+    this->program_code = &program_code;
+    this->swizzle_data = &swizzle_data;
+    dead_instructions = FindDeadInstructions(program_code, swizzle_data, used_outputs);
+
+    // Reset flow control state
+    program = (CompiledShader*)GetCodePtr();
+    program_counter = 0;
+    looping = false;
+    code_ptr.fill(nullptr);
+    fixup_branches.clear();
+    divergence_branches.clear();
+
+    // Find all `CALL` instructions and identify return locations
+    return_offsets = FindReturnOffsets(program_code);
+
+    // The stack pointer is 8 modulo 16 at the entry of a procedure
+    ABI_PushRegistersAndAdjustStack(ABI_ALL_CALLEE_SAVED, 8);
+    MOV(64, R(STACK_BASE), R(RSP));
+
+    MOV(PTRBITS, R(SETUP), R(ABI_PARAM1));
+    MOV(PTRBITS, R(STATE), R(ABI_PARAM2));
+
+    // Zero address/loop registers and conditional codes
+    XOR(64, R(ADDROFFS_REG_0), R(ADDROFFS_REG_0));
+    XOR(64, R(ADDROFFS_REG_1), R(ADDROFFS_REG_1));
+    XOR(64, R(LOOPCOUNT_REG), R(LOOPCOUNT_REG));
+    XOR(32, R(COND0), R(COND0));
+    XOR(32, R(COND1), R(COND1));
+
+    // Used to set a register to one
+    static const __m128 one = { 1.f, 1.f, 1.f, 1.f };
+    MOV(PTRBITS, R(RAX), ImmPtr(&one));
+    MOVAPS(ONE, MatR(RAX));
+
+    // Used to negate registers
+    static const __m128 neg = { -0.f, -0.f, -0.f, -0.f };
+    MOV(PTRBITS, R(RAX), ImmPtr(&neg));
+    MOVAPS(NEGBIT, MatR(RAX));
+
+    // Jump to start of the shader program
+    JMPptr(R(ABI_PARAM3));
+
+    // Compile entire program
+    Compile_Block(static_cast<unsigned>(program_code.size()));
+
+    // Set the target for any incomplete branches now that the entire shader program has been emitted
+    for (const auto& branch : fixup_branches) {
+        SetJumpTarget(branch.first, code_ptr[branch.second]);
+    }
+
+    // Leave the program, reporting that the vertices diverged
+    for (const auto& branch : divergence_branches) {
+        SetJumpTarget(branch);
+    }
+    MOV(64, R(RSP), R(STACK_BASE));
+    MOV(32, R(RAX), Imm32(1));
+    ABI_PopRegistersAndAdjustStack(ABI_ALL_CALLEE_SAVED, 8);
+    RET();
+
+    // Free memory that's no longer needed
+    return_offsets.clear();
+    return_offsets.shrink_to_fit();
+    fixup_branches.clear();
+    fixup_branches.shrink_to_fit();
+    divergence_branches.clear();
+    divergence_branches.shrink_to_fit();
+
+    uintptr_t size = reinterpret_cast<uintptr_t>(GetCodePtr()) - reinterpret_cast<uintptr_t>(program);
+    ASSERT_MSG(size <= MAX_BATCH_SHADER_SIZE, "Compiled a shader that exceeds the allocated size!");
+
+    LOG_DEBUG(HW_GPU, "Compiled batched shader size=%lu", size);
+}
+
+BatchJitShader::BatchJitShader() {
+    AllocCodeSpace(MAX_BATCH_SHADER_SIZE);
+}
+
+} // namespace Shader
+
+} // namespace Pica
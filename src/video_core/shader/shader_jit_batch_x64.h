@@ -0,0 +1,183 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <nihstro/shader_bytecode.h>
+
+#include "common/bit_set.h"
+#include "common/common_types.h"
+#include "common/x64/emitter.h"
+
+#include "video_core/shader/shader.h"
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::SwizzlePattern;
+
+namespace Pica {
+
+namespace Shader {
+
+/// Memory allocated for each compiled batched shader (256Kb), the code is larger than the code
+/// emitted by JitShader since each component is processed separately
+constexpr size_t MAX_BATCH_SHADER_SIZE = 1024 * 256;
+
+/**
+ * This class implements a variant of the shader JIT compiler which runs the shader program for
+ * BATCH_SIZE vertices at once. Registers are kept in the structure of arrays layout of
+ * BatchUnitState, so each SSE instruction operates on one component of all vertices instead of all
+ * components of one vertex. This removes the shuffles needed for swizzles and dot products.
+ *
+ * The vertices of a batch must take the same path through the program. When a conditional branch
+ * or an address register depends on per-vertex data and the vertices disagree, the program stops
+ * and reports it, and the caller runs the vertices one at a time instead.
+ */
+class BatchJitShader : public Gen::XCodeBlock {
+public:
+    BatchJitShader();
+
+    /**
+     * Runs the shader program for all vertices of the batch.
+     * @return True if the vertices diverged and the results must be discarded
+     */
+    bool Run(const ShaderSetup& setup, BatchUnitState& state, unsigned offset) const {
+        return program(&setup, &state, code_ptr[offset]);
+    }
+
+    /**
+     * Compiles a shader program. The program is only read during the call, so the compilation can
+     * happen on a different thread than the one running the shader.
+     * @param used_outputs Output register components used after running the shader, as passed to
+     *                     FindDeadInstructions. Instructions which only compute unused values are skipped.
+     */
+    void Compile(const std::array<u32, 1024>& program_code, const std::array<u32, 1024>& swizzle_data,
+                 u64 used_outputs);
+
+    void Compile_ADD(Instruction instr);
+    void Compile_DP3(Instruction instr);
+    void Compile_DP4(Instruction instr);
+    void Compile_DPH(Instruction instr);
+    void Compile_EX2(Instruction instr);
+    void Compile_LG2(Instruction instr);
+    void Compile_MUL(Instruction instr);
+    void Compile_SGE(Instruction instr);
+    void Compile_SLT(Instruction instr);
+    void Compile_FLR(Instruction instr);
+    void Compile_MAX(Instruction instr);
+    void Compile_MIN(Instruction instr);
+    void Compile_RCP(Instruction instr);
+    void Compile_RSQ(Instruction instr);
+    void Compile_MOVA(Instruction instr);
+    void Compile_MOV(Instruction instr);
+    void Compile_NOP(Instruction instr);
+    void Compile_END(Instruction instr);
+    void Compile_CALL(Instruction instr);
+    void Compile_CALLC(Instruction instr);
+    void Compile_CALLU(Instruction instr);
+    void Compile_IF(Instruction instr);
+    void Compile_LOOP(Instruction instr);
+    void Compile_JMP(Instruction instr);
+    void Compile_CMP(Instruction instr);
+    void Compile_MAD(Instruction instr);
+
+private:
+    Instruction GetVertexShaderInstruction(size_t offset) const;
+    SwizzlePattern GetSwizzlePattern(Instruction instr) const;
+
+    void Compile_Block(unsigned end);
+    void Compile_NextInstr();
+
+    /**
+     * Loads one component of a swizzled source register for all vertices of the batch.
+     * @param component Component of the swizzled source register (0 = x, ..., 3 = w)
+     */
+    void Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRegister src_reg, unsigned component, Gen::X64Reg dest);
+
+    /**
+     * Stores the enabled components of the destination register.
+     * @param results Registers holding each component of the result
+     */
+    void Compile_DestEnable(Instruction instr, const std::array<Gen::X64Reg, 4>& results);
+
+    /// Stores `result` to all enabled components of the destination register.
+    void Compile_DestEnableBroadcast(Instruction instr, Gen::X64Reg result);
+
+    /**
+     * Compiles an instruction which operates on each component separately. `op` emits the code
+     * combining the components of the sources loaded in `dest` and `src2`.
+     */
+    template <typename F>
+    void Compile_ComponentWise(Instruction instr, SourceRegister src1, SourceRegister src2, F op);
+
+    /// Compiles a dot product of `num_components` components, the result is left in `dest`.
+    void Compile_DotProduct(Instruction instr, SourceRegister src1, SourceRegister src2, unsigned num_components, bool homogeneous, Gen::X64Reg dest);
+
+    /// Calls `func` on the batch scratch row after loading the x component of the first source into it.
+    void Compile_CallScalarFunction(Instruction instr, const void* func);
+
+    /**
+     * Compiles a `MUL src1, src2` operation, properly handling the PICA semantics when multiplying
+     * zero by inf. Clobbers `src2` and `scratch`.
+     */
+    void Compile_SanitizedMul(Gen::X64Reg src1, Gen::X64Reg src2, Gen::X64Reg scratch);
+
+    /**
+     * Evaluates the condition of a conditional flow control instruction. Clears the zero flag if
+     * the condition is true for all vertices and sets it if it is false for all vertices.
+     */
+    void Compile_EvaluateCondition(Instruction instr);
+    void Compile_UniformCondition(Instruction instr);
+
+    /// Emits a branch taken when the 4-bit lane mask in `mask` isn't uniform.
+    void Compile_DivergenceCheck(Gen::X64Reg mask);
+
+    /**
+     * Emits the code to conditionally return from a subroutine envoked by the `CALL` instruction.
+     */
+    void Compile_Return();
+
+    BitSet32 PersistentCallerSavedRegs();
+
+    /**
+     * Assertion evaluated at compile-time, but only triggered if executed at runtime.
+     * @param msg Message to be logged if the assertion fails.
+     */
+    void Compile_Assert(bool condition, const char* msg);
+
+    /// Mapping of Pica VS instructions to pointers in the emitted code
+    std::array<const u8*, 1024> code_ptr;
+
+    /// Program code and swizzle data of the shader being compiled
+    const std::array<u32, 1024>* program_code = nullptr;
+    const std::array<u32, 1024>* swizzle_data = nullptr;
+
+    /// Instructions of the shader being compiled whose results are never used
+    std::bitset<1024> dead_instructions;
+
+    /// Offsets in code where a return needs to be inserted
+    std::vector<unsigned> return_offsets;
+
+    unsigned program_counter = 0;       ///< Offset of the next instruction to decode
+    bool looping = false;               ///< True if compiling a loop, used to check for nested loops
+
+    /// Branches that need to be fixed up once the entire shader program is compiled
+    std::vector<std::pair<Gen::FixupBranch, unsigned>> fixup_branches;
+
+    /// Branches taken when the vertices of the batch diverge
+    std::vector<Gen::FixupBranch> divergence_branches;
+
+    using CompiledShader = bool(const void* setup, void* state, const u8* start_addr);
+    CompiledShader* program = nullptr;
+};
+
+} // Shader
+
+} // Pica
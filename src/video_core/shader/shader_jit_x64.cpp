@@ -17,6 +17,7 @@
 #include "common/x64/emitter.h"
 
 #include "shader.h"
+#include "shader_analysis.h"
 #include "shader_jit_x64.h"
 
 #include "video_core/pica_state.h"
@@ -73,8 +74,8 @@ const JitFunction instr_table[64] = {
     &JitShader::Compile_IF,         // ifu
     &JitShader::Compile_IF,         // ifc
     &JitShader::Compile_LOOP,       // loop
-    nullptr,                        // emit
-    nullptr,                        // sete
+    &JitShader::Compile_EMIT,       // emit
+    &JitShader::Compile_SETE,       // sete
     &JitShader::Compile_JMP,        // jmpc
     &JitShader::Compile_JMP,        // jmpu
     &JitShader::Compile_CMP,        // cmp
@@ -137,7 +138,7 @@ static const X64Reg NEGBIT = XMM15;
 // Scratch registers, e.g., SRC1 and SCRATCH, have to be saved on the side if needed
 static const BitSet32 persistent_regs = {
     SETUP, STATE, // Pointers to register blocks
-    ADDROFFS_REG_0, ADDROFFS_REG_1, LOOPCOUNT_REG, COND0, COND1, // Cached registers
+    ADDROFFS_REG_0, ADDROFFS_REG_1, LOOPCOUNT_REG, LOOPCOUNT, LOOPINC, COND0, COND1, // Cached registers
     ONE+16, NEGBIT+16, // Constants
 };
 
@@ -151,8 +152,8 @@ static const u8 NO_DEST_REG_MASK = 0xf;
  * @param offset Offset in the current shader program of the instruction
  * @return Instruction at the specified offset
  */
-static Instruction GetVertexShaderInstruction(size_t offset) {
-    return { g_state.vs.program_code[offset] };
+Instruction JitShader::GetVertexShaderInstruction(size_t offset) const {
+    return { (*program_code)[offset] };
 }
 
 static void LogCritical(const char* msg) {
@@ -185,81 +186,65 @@ void JitShader::Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRe
     }
 
     int src_offset_disp = (int)src_offset;
-    ASSERT_MSG(src_offset == src_offset_disp, "Source register offset too large for int type");
+    ASSERT_MSG(src_offset == static_cast<size_t>(src_offset_disp), "Source register offset too large for int type");
 
-    unsigned operand_desc_id;
-
-    const bool is_inverted = (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
-
-    unsigned address_register_index;
     unsigned offset_src;
+    const unsigned address_register_index = GetAddressRegisterIndex(instr, offset_src);
 
-    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
-        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
-        operand_desc_id = instr.mad.operand_desc_id;
-        offset_src = is_inverted ? 3 : 2;
-        address_register_index = instr.mad.address_register_index;
-    } else {
-        operand_desc_id = instr.common.operand_desc_id;
-        offset_src = is_inverted ? 2 : 1;
-        address_register_index = instr.common.address_register_index;
-    }
-
+    OpArg src = MDisp(src_ptr, src_offset_disp);
     if (src_num == offset_src && address_register_index != 0) {
         switch (address_register_index) {
         case 1: // address offset 1
-            MOVAPS(dest, MComplex(src_ptr, ADDROFFS_REG_0, SCALE_1, src_offset_disp));
+            src = MComplex(src_ptr, ADDROFFS_REG_0, SCALE_1, src_offset_disp);
             break;
         case 2: // address offset 2
-            MOVAPS(dest, MComplex(src_ptr, ADDROFFS_REG_1, SCALE_1, src_offset_disp));
+            src = MComplex(src_ptr, ADDROFFS_REG_1, SCALE_1, src_offset_disp);
             break;
         case 3: // address offset 3
-            MOVAPS(dest, MComplex(src_ptr, LOOPCOUNT_REG, SCALE_1, src_offset_disp));
+            src = MComplex(src_ptr, LOOPCOUNT_REG, SCALE_1, src_offset_disp);
             break;
         default:
             UNREACHABLE();
             break;
         }
-    } else {
-        // Load the source
-        MOVAPS(dest, MDisp(src_ptr, src_offset_disp));
     }
 
-    SwizzlePattern swiz = { g_state.vs.swizzle_data[operand_desc_id] };
+    SwizzlePattern swiz = GetSwizzlePattern(instr, *swizzle_data);
 
-    // Generate instructions for source register swizzling as needed
+    // Generate instructions for source register swizzling as needed. Components which the
+    // instruction doesn't read can be left in any order.
     u8 sel = swiz.GetRawSelector(src_num);
-    if (sel != NO_SRC_REG_SWIZZLE) {
+    u8 identity_mask = 0;
+    const unsigned components = GetSourceComponents(instr, swiz, src_num);
+    for (unsigned i = 0; i < 4; ++i) {
+        if (components & (1 << i))
+            identity_mask |= 3 << (6 - 2 * i);
+    }
+
+    if ((sel & identity_mask) != (NO_SRC_REG_SWIZZLE & identity_mask)) {
         // Selector component order needs to be reversed for the SHUFPS instruction
         sel = ((sel & 0xc0) >> 6) | ((sel & 3) << 6) | ((sel & 0xc) << 2) | ((sel & 0x30) >> 2);
 
-        // Shuffle inputs for swizzle
-        SHUFPS(dest, R(dest), sel);
+        // Load and shuffle inputs for swizzle
+        Compile_Shuffle(dest, src, sel);
+    } else {
+        // Load the source
+        MOVAPS(dest, src);
     }
 
     // If the source register should be negated, flip the negative bit using XOR
-    const bool negate[] = { swiz.negate_src1, swiz.negate_src2, swiz.negate_src3 };
-    if (negate[src_num - 1]) {
+    if (IsSourceNegated(swiz, src_num)) {
         XORPS(dest, R(NEGBIT));
     }
 }
 
 void JitShader::Compile_DestEnable(Instruction instr,X64Reg src) {
-    DestRegister dest;
-    unsigned operand_desc_id;
-    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
-        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
-        operand_desc_id = instr.mad.operand_desc_id;
-        dest = instr.mad.dest.Value();
-    } else {
-        operand_desc_id = instr.common.operand_desc_id;
-        dest = instr.common.dest.Value();
-    }
-
-    SwizzlePattern swiz = { g_state.vs.swizzle_data[operand_desc_id] };
+    DestRegister dest = GetDestRegister(instr);
+    SwizzlePattern swiz = GetSwizzlePattern(instr, *swizzle_data);
 
-    int dest_offset_disp = (int)UnitState<false>::OutputOffset(dest);
-    ASSERT_MSG(dest_offset_disp == UnitState<false>::OutputOffset(dest), "Destinaton offset too large for int type");
+    const size_t dest_offset = UnitState<false>::OutputOffset(dest);
+    int dest_offset_disp = (int)dest_offset;
+    ASSERT_MSG(dest_offset == static_cast<size_t>(dest_offset_disp), "Destinaton offset too large for int type");
 
     // If all components are enabled, write the result to the destination register
     if (swiz.dest_mask == NO_DEST_REG_MASK) {
@@ -291,7 +276,26 @@ void JitShader::Compile_DestEnable(Instruction instr,X64Reg src) {
     }
 }
 
+void JitShader::Compile_Shuffle(X64Reg dest, const OpArg& src, u8 sel) {
+    if (Common::GetCPUCaps().avx) {
+        VPERMILPS(dest, src, sel);
+    } else {
+        if (!src.IsSimpleReg(dest))
+            MOVAPS(dest, src);
+        SHUFPS(dest, R(dest), sel);
+    }
+}
+
 void JitShader::Compile_SanitizedMul(Gen::X64Reg src1, Gen::X64Reg src2, Gen::X64Reg scratch) {
+    if (Common::GetCPUCaps().avx) {
+        VCMPPS(scratch, src1, R(src2), CMP_ORD);
+        VMULPS(src1, src1, R(src2));
+        VCMPPS(src2, src1, R(src1), CMP_UNORD);
+        VXORPS(scratch, scratch, R(src2));
+        VANDPS(src1, src1, R(scratch));
+        return;
+    }
+
     MOVAPS(scratch, R(src1));
     CMPPS(scratch, R(src2), CMP_ORD);
 
@@ -357,13 +361,9 @@ void JitShader::Compile_DP3(Instruction instr) {
 
     Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
 
-    MOVAPS(SRC2, R(SRC1));
-    SHUFPS(SRC2, R(SRC2), _MM_SHUFFLE(1, 1, 1, 1));
-
-    MOVAPS(SRC3, R(SRC1));
-    SHUFPS(SRC3, R(SRC3), _MM_SHUFFLE(2, 2, 2, 2));
-
-    SHUFPS(SRC1, R(SRC1), _MM_SHUFFLE(0, 0, 0, 0));
+    Compile_Shuffle(SRC2, R(SRC1), _MM_SHUFFLE(1, 1, 1, 1));
+    Compile_Shuffle(SRC3, R(SRC1), _MM_SHUFFLE(2, 2, 2, 2));
+    Compile_Shuffle(SRC1, R(SRC1), _MM_SHUFFLE(0, 0, 0, 0));
     ADDPS(SRC1, R(SRC2));
     ADDPS(SRC1, R(SRC3));
 
@@ -376,12 +376,10 @@ void JitShader::Compile_DP4(Instruction instr) {
 
     Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
 
-    MOVAPS(SRC2, R(SRC1));
-    SHUFPS(SRC1, R(SRC1), _MM_SHUFFLE(2, 3, 0, 1)); // XYZW -> ZWXY
+    Compile_Shuffle(SRC2, R(SRC1), _MM_SHUFFLE(2, 3, 0, 1)); // XYZW -> ZWXY
     ADDPS(SRC1, R(SRC2));
 
-    MOVAPS(SRC2, R(SRC1));
-    SHUFPS(SRC1, R(SRC1), _MM_SHUFFLE(0, 1, 2, 3)); // XYZW -> WZYX
+    Compile_Shuffle(SRC2, R(SRC1), _MM_SHUFFLE(0, 1, 2, 3)); // XYZW -> WZYX
     ADDPS(SRC1, R(SRC2));
 
     Compile_DestEnable(instr, SRC1);
@@ -408,12 +406,10 @@ void JitShader::Compile_DPH(Instruction instr) {
 
     Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
 
-    MOVAPS(SRC2, R(SRC1));
-    SHUFPS(SRC1, R(SRC1), _MM_SHUFFLE(2, 3, 0, 1)); // XYZW -> ZWXY
+    Compile_Shuffle(SRC2, R(SRC1), _MM_SHUFFLE(2, 3, 0, 1)); // XYZW -> ZWXY
     ADDPS(SRC1, R(SRC2));
 
-    MOVAPS(SRC2, R(SRC1));
-    SHUFPS(SRC1, R(SRC1), _MM_SHUFFLE(0, 1, 2, 3)); // XYZW -> WZYX
+    Compile_Shuffle(SRC2, R(SRC1), _MM_SHUFFLE(0, 1, 2, 3)); // XYZW -> WZYX
     ADDPS(SRC1, R(SRC2));
 
     Compile_DestEnable(instr, SRC1);
@@ -512,7 +508,7 @@ void JitShader::Compile_MIN(Instruction instr) {
 }
 
 void JitShader::Compile_MOVA(Instruction instr) {
-    SwizzlePattern swiz = { g_state.vs.swizzle_data[instr.common.operand_desc_id] };
+    SwizzlePattern swiz = GetSwizzlePattern(instr, *swizzle_data);
 
     if (!swiz.DestComponentEnabled(0) && !swiz.DestComponentEnabled(1)) {
         return; // NoOp
@@ -591,6 +587,25 @@ void JitShader::Compile_END(Instruction instr) {
     RET();
 }
 
+static void EmitVertex(GSEmitter* emitter, const OutputRegisters* output) {
+    emitter->Emit(*output);
+}
+
+void JitShader::Compile_EMIT(Instruction instr) {
+    ABI_PushRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
+    MOV(PTRBITS, R(ABI_PARAM1), MDisp(STATE, offsetof(UnitState<false>, emitter_ptr)));
+    LEA(PTRBITS, ABI_PARAM2, MDisp(STATE, offsetof(UnitState<false>, output_registers)));
+    ABI_CallFunction(reinterpret_cast<const void*>(EmitVertex));
+    ABI_PopRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
+}
+
+void JitShader::Compile_SETE(Instruction instr) {
+    MOV(PTRBITS, R(RAX), MDisp(STATE, offsetof(UnitState<false>, emitter_ptr)));
+    MOV(8, MDisp(RAX, offsetof(GSEmitter, vertex_id)), Imm8(static_cast<u8>(instr.setemit.vertex_id)));
+    MOV(8, MDisp(RAX, offsetof(GSEmitter, prim_emit)), Imm8(static_cast<u8>(instr.setemit.prim_emit)));
+    MOV(8, MDisp(RAX, offsetof(GSEmitter, winding)), Imm8(static_cast<u8>(instr.setemit.winding)));
+}
+
 void JitShader::Compile_CALL(Instruction instr) {
     // Push offset of the return
     PUSH(64, Imm32(instr.flow_control.dest_offset + instr.flow_control.num_instructions));
@@ -778,6 +793,10 @@ void JitShader::Compile_NextInstr() {
 
     Instruction instr = GetVertexShaderInstruction(program_counter++);
 
+    // Skip instructions whose results are never used
+    if (dead_instructions[program_counter - 1])
+        return;
+
     OpCode::Id opcode = instr.opcode.Value();
     auto instr_func = instr_table[static_cast<unsigned>(opcode)];
 
@@ -791,28 +810,12 @@ void JitShader::Compile_NextInstr() {
     }
 }
 
-void JitShader::FindReturnOffsets() {
-    return_offsets.clear();
-
-    for (size_t offset = 0; offset < g_state.vs.program_code.size(); ++offset) {
-        Instruction instr = GetVertexShaderInstruction(offset);
-
-        switch (instr.opcode.Value()) {
-        case OpCode::Id::CALL:
-        case OpCode::Id::CALLC:
-        case OpCode::Id::CALLU:
-            return_offsets.push_back(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
-            break;
-        default:
-            break;
-        }
-    }
-
-    // Sort for efficient binary search later
-    std::sort(return_offsets.begin(), return_offsets.end());
-}
+void JitShader::Compile(const std::array<u32, 1024>& program_code, const std::array<u32, 1024>& swizzle_data,
+                        u64 used_outputs) {
+    this->program_code = &program_code;
+    this->swizzle_data = &swizzle_data;
+    dead_instructions = FindDeadInstructions(program_code, swizzle_data, used_outputs);
 
-void JitShader::Compile() {
     // Reset flow control state
     program = (CompiledShader*)GetCodePtr();
     program_counter = 0;
@@ -821,7 +824,7 @@ void JitShader::Compile() {
     fixup_branches.clear();
 
     // Find all `CALL` instructions and identify return locations
-    FindReturnOffsets();
+    return_offsets = FindReturnOffsets(program_code);
 
     // The stack pointer is 8 modulo 16 at the entry of a procedure
     ABI_PushRegistersAndAdjustStack(ABI_ALL_CALLEE_SAVED, 8);
@@ -848,7 +851,7 @@ void JitShader::Compile() {
     JMPptr(R(ABI_PARAM3));
 
     // Compile entire program
-    Compile_Block(static_cast<unsigned>(g_state.vs.program_code.size()));
+    Compile_Block(static_cast<unsigned>(program_code.size()));
 
     // Set the target for any incomplete branches now that the entire shader program has been emitted
     for (const auto& branch : fixup_branches) {
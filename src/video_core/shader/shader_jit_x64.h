@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <bitset>
 #include <cstddef>
 #include <utility>
 #include <vector>
@@ -40,7 +41,14 @@ public:
         program(&setup, &state, code_ptr[offset]);
     }
 
-    void Compile();
+    /**
+     * Compiles a shader program. The program is only read during the call, so the compilation can
+     * happen on a different thread than the one running the shader.
+     * @param used_outputs Output register components used after running the shader, as passed to
+     *                     FindDeadInstructions. Instructions which only compute unused values are skipped.
+     */
+    void Compile(const std::array<u32, 1024>& program_code, const std::array<u32, 1024>& swizzle_data,
+                 u64 used_outputs);
 
     void Compile_ADD(Instruction instr);
     void Compile_DP3(Instruction instr);
@@ -60,6 +68,8 @@ public:
     void Compile_MOV(Instruction instr);
     void Compile_NOP(Instruction instr);
     void Compile_END(Instruction instr);
+    void Compile_EMIT(Instruction instr);
+    void Compile_SETE(Instruction instr);
     void Compile_CALL(Instruction instr);
     void Compile_CALLC(Instruction instr);
     void Compile_CALLU(Instruction instr);
@@ -70,6 +80,7 @@ public:
     void Compile_MAD(Instruction instr);
 
 private:
+    Instruction GetVertexShaderInstruction(size_t offset) const;
 
     void Compile_Block(unsigned end);
     void Compile_NextInstr();
@@ -83,6 +94,9 @@ private:
      */
     void Compile_SanitizedMul(Gen::X64Reg src1, Gen::X64Reg src2, Gen::X64Reg scratch);
 
+    /// Loads `src` into `dest` with the components shuffled as by SHUFPS, using AVX if available
+    void Compile_Shuffle(Gen::X64Reg dest, const Gen::OpArg& src, u8 sel);
+
     void Compile_EvaluateCondition(Instruction instr);
     void Compile_UniformCondition(Instruction instr);
 
@@ -99,15 +113,16 @@ private:
      */
     void Compile_Assert(bool condition, const char* msg);
 
-    /**
-     * Analyzes the entire shader program for `CALL` instructions before emitting any code,
-     * identifying the locations where a return needs to be inserted.
-     */
-    void FindReturnOffsets();
-
     /// Mapping of Pica VS instructions to pointers in the emitted code
     std::array<const u8*, 1024> code_ptr;
 
+    /// Program code and swizzle data of the shader being compiled
+    const std::array<u32, 1024>* program_code = nullptr;
+    const std::array<u32, 1024>* swizzle_data = nullptr;
+
+    /// Instructions of the shader being compiled whose results are never used
+    std::bitset<1024> dead_instructions;
+
     /// Offsets in code where a return needs to be inserted
     std::vector<unsigned> return_offsets;
 
@@ -2,15 +2,101 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <thread>
+
+#include "common/thread_pool.h"
+
 #include "video_core/clipper.h"
+#include "video_core/pica.h"
+#include "video_core/rasterizer.h"
 #include "video_core/swrasterizer.h"
+#include "video_core/video_core.h"
 
 namespace VideoCore {
 
+SWRasterizer::SWRasterizer() {
+    // Tiles are also rasterized by the thread flushing them
+    const unsigned int num_threads = std::thread::hardware_concurrency();
+    if (num_threads > 1)
+        thread_pool = std::make_unique<Common::ThreadPool>(num_threads - 1);
+
+    // The registers may have changed while another rasterizer was in use
+    Pica::Rasterizer::InvalidatePixelPipeline();
+    Pica::Rasterizer::SetTextureCache(&texture_cache);
+}
+
+SWRasterizer::~SWRasterizer() {
+    Pica::Rasterizer::SetBinning(nullptr);
+    Pica::Rasterizer::SetTextureCache(nullptr);
+}
+
+void SWRasterizer::SetGPUThreadActive(bool active) {
+    if (active == gpu_thread_active)
+        return;
+    gpu_thread_active = active;
+
+    // Caching a texture marks its pages in the page table, which only the emulation thread may
+    // modify, so decoded textures are only used while rasterizing on the emulation thread
+    if (active) {
+        Pica::Rasterizer::SetTextureCache(nullptr);
+        texture_cache.Clear();
+    } else {
+        Pica::Rasterizer::SetTextureCache(&texture_cache);
+    }
+}
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
         const Pica::Shader::OutputVertex& v1,
         const Pica::Shader::OutputVertex& v2) {
+    Pica::Rasterizer::SetBinning(g_sw_rasterizer_binning_enabled ? thread_pool.get() : nullptr);
     Pica::Clipper::ProcessTriangle(v0, v1, v2);
 }
 
+void SWRasterizer::DrawTriangles() {
+    Pica::Rasterizer::FlushTriangles();
+}
+
+void SWRasterizer::NotifyPicaRegisterChanged(u32 id) {
+    // Registers below the vertex attribute configuration control rasterization, or trigger the
+    // interrupt games wait on before reading the rendered data. Queued triangles were already
+    // flushed before a rasterization register changed.
+    if (id < PICA_REG_INDEX(vertex_attributes)) {
+        Pica::Rasterizer::FlushTriangles();
+        Pica::Rasterizer::InvalidatePixelPipeline();
+    }
+}
+
+void SWRasterizer::FlushAll() {
+    Pica::Rasterizer::FlushTriangles();
+}
+
+void SWRasterizer::FlushRegion(PAddr addr, u32 size) {
+    Pica::Rasterizer::FlushTriangles();
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    Pica::Rasterizer::FlushTriangles();
+    if (texture_cache.InvalidateRegion(addr, size))
+        Pica::Rasterizer::InvalidatePixelPipeline();
+}
+
+// The memory operations below aren't accelerated, but may read or overwrite rendered data
+
+bool SWRasterizer::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) {
+    Pica::Rasterizer::FlushTriangles();
+    return false;
+}
+
+bool SWRasterizer::AccelerateFill(const GPU::Regs::MemoryFillConfig& config,
+                                  std::vector<std::pair<PAddr, PAddr>>& cpu_fill_regions) {
+    Pica::Rasterizer::FlushTriangles();
+    return false;
+}
+
+bool SWRasterizer::AccelerateDisplay(const GPU::Regs::FramebufferConfig& config, PAddr framebuffer_addr,
+                                     u32 pixel_stride, ScreenInfo& screen_info) {
+    Pica::Rasterizer::FlushTriangles();
+    return false;
+}
+
 }
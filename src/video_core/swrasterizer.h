@@ -4,9 +4,16 @@
 
 #pragma once
 
+#include <memory>
+
 #include "common/common_types.h"
 
 #include "video_core/rasterizer_interface.h"
+#include "video_core/texture_cache.h"
+
+namespace Common {
+class ThreadPool;
+}
 
 namespace Pica {
 namespace Shader {
@@ -16,15 +23,38 @@ struct OutputVertex;
 
 namespace VideoCore {
 
+/**
+ * Software rasterizer. If VideoCore::g_sw_rasterizer_binning_enabled is set, triangles are binned
+ * into screen tiles and rasterized in parallel once the rasterization state changes, or when the
+ * rendered data is needed. Textures are decoded once into a cache, until their memory is written.
+ */
 class SWRasterizer : public RasterizerInterface {
+public:
+    SWRasterizer();
+    ~SWRasterizer() override;
+
     void AddTriangle(const Pica::Shader::OutputVertex& v0,
             const Pica::Shader::OutputVertex& v1,
             const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
-    void NotifyPicaRegisterChanged(u32 id) override {}
-    void FlushAll() override {}
-    void FlushRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
+    void DrawTriangles() override;
+    void NotifyPicaRegisterChanged(u32 id) override;
+    void FlushAll() override;
+    void FlushRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+    bool AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) override;
+    bool AccelerateFill(const GPU::Regs::MemoryFillConfig& config, std::vector<std::pair<PAddr, PAddr>>& cpu_fill_regions) override;
+    bool AccelerateDisplay(const GPU::Regs::FramebufferConfig& config, PAddr framebuffer_addr, u32 pixel_stride, ScreenInfo& screen_info) override;
+    bool SupportsGPUThread() const override { return true; }
+    void SetGPUThreadActive(bool active) override;
+
+private:
+    /// Whether the GPU commands currently run on the GPU thread
+    bool gpu_thread_active = false;
+
+    /// Threads rasterizing the tiles, null if the host has a single core
+    std::unique_ptr<Common::ThreadPool> thread_pool;
+
+    Pica::TextureCache texture_cache;
 };
 
 }
@@ -0,0 +1,460 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+#include "common/bit_field.h"
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "common/math_util.h"
+
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/texture/texture_decode.h"
+#include "video_core/utils.h"
+
+namespace Pica {
+
+namespace Texture {
+
+static_assert(sizeof(Math::Vec4<u8>) == sizeof(u32), "Decoded texels are copied as 32-bit words");
+
+namespace {
+
+union ETC1Tile {
+    // Each of these two is a collection of 16 bits (one per lookup value)
+    BitField< 0, 16, u64> table_subindexes;
+    BitField<16, 16, u64> negation_flags;
+
+    unsigned GetTableSubIndex(unsigned index) const {
+        return (table_subindexes >> index) & 1;
+    }
+
+    bool GetNegationFlag(unsigned index) const {
+        return ((negation_flags >> index) & 1) == 1;
+    }
+
+    BitField<32, 1, u64> flip;
+    BitField<33, 1, u64> differential_mode;
+
+    BitField<34, 3, u64> table_index_2;
+    BitField<37, 3, u64> table_index_1;
+
+    union {
+        // delta value + base value
+        BitField<40, 3, s64> db;
+        BitField<43, 5, u64> b;
+
+        BitField<48, 3, s64> dg;
+        BitField<51, 5, u64> g;
+
+        BitField<56, 3, s64> dr;
+        BitField<59, 5, u64> r;
+    } differential;
+
+    union {
+        BitField<40, 4, u64> b2;
+        BitField<44, 4, u64> b1;
+
+        BitField<48, 4, u64> g2;
+        BitField<52, 4, u64> g1;
+
+        BitField<56, 4, u64> r2;
+        BitField<60, 4, u64> r1;
+    } separate;
+
+    /**
+     * Returns the base color of one half of the subtile. The subtile is split into its left and
+     * right halves, or into its top and bottom halves if the flip bit is set.
+     */
+    Math::Vec3<int> GetBaseColor(bool second_half) const {
+        Math::Vec3<int> ret;
+        if (differential_mode) {
+            ret.r() = static_cast<int>(differential.r);
+            ret.g() = static_cast<int>(differential.g);
+            ret.b() = static_cast<int>(differential.b);
+            if (second_half) {
+                ret.r() += static_cast<int>(differential.dr);
+                ret.g() += static_cast<int>(differential.dg);
+                ret.b() += static_cast<int>(differential.db);
+            }
+            ret.r() = Color::Convert5To8(ret.r());
+            ret.g() = Color::Convert5To8(ret.g());
+            ret.b() = Color::Convert5To8(ret.b());
+        } else {
+            if (!second_half) {
+                ret.r() = Color::Convert4To8(static_cast<u8>(separate.r1));
+                ret.g() = Color::Convert4To8(static_cast<u8>(separate.g1));
+                ret.b() = Color::Convert4To8(static_cast<u8>(separate.b1));
+            } else {
+                ret.r() = Color::Convert4To8(static_cast<u8>(separate.r2));
+                ret.g() = Color::Convert4To8(static_cast<u8>(separate.g2));
+                ret.b() = Color::Convert4To8(static_cast<u8>(separate.b2));
+            }
+        }
+        return ret;
+    }
+
+    /// Returns the modifier added to the base color of a texel, indexed by 4 * x + y
+    int GetModifier(bool second_half, unsigned texel) const {
+        static const std::array<std::array<u8, 2>, 8> etc1_modifier_table = {{
+            {{  2,  8 }}, {{  5, 17 }}, {{  9,  29 }}, {{ 13,  42 }},
+            {{ 18, 60 }}, {{ 24, 80 }}, {{ 33, 106 }}, {{ 47, 183 }}
+        }};
+
+        unsigned table_index = static_cast<unsigned>(second_half ? table_index_2.Value() : table_index_1.Value());
+        int modifier = etc1_modifier_table[table_index][GetTableSubIndex(texel)];
+        if (GetNegationFlag(texel))
+            modifier *= -1;
+        return modifier;
+    }
+
+    /// Returns whether a texel belongs to the second half of the subtile
+    bool IsInSecondHalf(unsigned x, unsigned y) const {
+        return (flip ? y : x) >= 2;
+    }
+};
+
+} // anonymous namespace
+
+static Math::Vec3<u8> ApplyETC1Modifier(const Math::Vec3<int>& base, int modifier) {
+    return Math::MakeVec(MathUtil::Clamp(base.r() + modifier, 0, 255),
+                         MathUtil::Clamp(base.g() + modifier, 0, 255),
+                         MathUtil::Clamp(base.b() + modifier, 0, 255)).Cast<u8>();
+}
+
+Math::Vec3<u8> SampleETC1Subtile(u64 subtile, unsigned x, unsigned y) {
+    const ETC1Tile& tile = *reinterpret_cast<const ETC1Tile*>(&subtile);
+    const bool second_half = tile.IsInSecondHalf(x, y);
+    return ApplyETC1Modifier(tile.GetBaseColor(second_half), tile.GetModifier(second_half, 4 * x + y));
+}
+
+size_t GetTileSize(Regs::TextureFormat format) {
+    switch (format) {
+    case Regs::TextureFormat::ETC1:
+        return 32;
+    case Regs::TextureFormat::ETC1A4:
+        return 64;
+    default:
+        return Regs::NibblesPerPixel(format) * 64 / 2;
+    }
+}
+
+static u32 PackTexel(const Math::Vec4<u8>& texel) {
+    u32 packed;
+    std::memcpy(&packed, &texel, sizeof(packed));
+    return packed;
+}
+
+/// Decodes the texel stored at a position of a tile, in the Morton order texels are stored in
+static u32 DecodeTexel(Regs::TextureFormat format, const u8* source, unsigned index) {
+    switch (format) {
+    case Regs::TextureFormat::RGBA8:
+        return PackTexel(Color::DecodeRGBA8(source + index * 4));
+
+    case Regs::TextureFormat::RGB8:
+        return PackTexel(Color::DecodeRGB8(source + index * 3));
+
+    case Regs::TextureFormat::RGB5A1:
+        return PackTexel(Color::DecodeRGB5A1(source + index * 2));
+
+    case Regs::TextureFormat::RGB565:
+        return PackTexel(Color::DecodeRGB565(source + index * 2));
+
+    case Regs::TextureFormat::RGBA4:
+        return PackTexel(Color::DecodeRGBA4(source + index * 2));
+
+    case Regs::TextureFormat::IA8:
+    {
+        const u8* source_ptr = source + index * 2;
+        return PackTexel({ source_ptr[1], source_ptr[1], source_ptr[1], source_ptr[0] });
+    }
+
+    case Regs::TextureFormat::RG8:
+    {
+        auto res = Color::DecodeRG8(source + index * 2);
+        return PackTexel({ res.r(), res.g(), 0, 255 });
+    }
+
+    case Regs::TextureFormat::I8:
+        return PackTexel({ source[index], source[index], source[index], 255 });
+
+    case Regs::TextureFormat::A8:
+        return PackTexel({ 0, 0, 0, source[index] });
+
+    case Regs::TextureFormat::IA4:
+    {
+        u8 i = Color::Convert4To8((source[index] & 0xF0) >> 4);
+        u8 a = Color::Convert4To8(source[index] & 0xF);
+        return PackTexel({ i, i, i, a });
+    }
+
+    case Regs::TextureFormat::I4:
+    {
+        u8 i = (index % 2) ? ((source[index / 2] & 0xF0) >> 4) : (source[index / 2] & 0xF);
+        i = Color::Convert4To8(i);
+        return PackTexel({ i, i, i, 255 });
+    }
+
+    case Regs::TextureFormat::A4:
+    {
+        u8 a = (index % 2) ? ((source[index / 2] & 0xF0) >> 4) : (source[index / 2] & 0xF);
+        a = Color::Convert4To8(a);
+        return PackTexel({ 0, 0, 0, a });
+    }
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown texture format: %x", (u32)format);
+        DEBUG_ASSERT(false);
+        return 0;
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// The SSE2 kernels below decode the 64 texels of a tile in the order they're stored in. Each one
+// produces vectors of four RGBA8 texels by interleaving 16-bit lanes holding the red and green
+// components with 16-bit lanes holding the blue and alpha components.
+
+static void StoreTexels(u32* dest, __m128i rg, __m128i ba) {
+    _mm_store_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi16(rg, ba));
+    _mm_store_si128(reinterpret_cast<__m128i*>(dest + 4), _mm_unpackhi_epi16(rg, ba));
+}
+
+/// Expands 16-bit lanes of 4-bit, 5-bit or 6-bit components to 8 bits by replicating their top bits
+template <int Bits>
+static __m128i ExpandComponents(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 8 - Bits), _mm_srli_epi16(value, 2 * Bits - 8));
+}
+
+static void DecodeRGBA8Tile(const u8* source, u32* dest) {
+    for (unsigned i = 0; i < 64; i += 4) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        // Reverse the bytes of each texel: swap the bytes of each 16-bit half, then the halves
+        const __m128i swapped = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+        const __m128i result = _mm_shufflehi_epi16(_mm_shufflelo_epi16(swapped, 0xB1), 0xB1);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dest + i), result);
+    }
+}
+
+static void DecodeRGB565Tile(const u8* source, u32* dest) {
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i mask6 = _mm_set1_epi16(0x3F);
+    const __m128i alpha = _mm_set1_epi16(0xFF00);
+    for (unsigned i = 0; i < 64; i += 8) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        const __m128i r = ExpandComponents<5>(_mm_srli_epi16(value, 11));
+        const __m128i g = ExpandComponents<6>(_mm_and_si128(_mm_srli_epi16(value, 5), mask6));
+        const __m128i b = ExpandComponents<5>(_mm_and_si128(value, mask5));
+        StoreTexels(dest + i, _mm_or_si128(r, _mm_slli_epi16(g, 8)), _mm_or_si128(b, alpha));
+    }
+}
+
+static void DecodeRGB5A1Tile(const u8* source, u32* dest) {
+    const __m128i mask1 = _mm_set1_epi16(0x1);
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    for (unsigned i = 0; i < 64; i += 8) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        const __m128i r = ExpandComponents<5>(_mm_srli_epi16(value, 11));
+        const __m128i g = ExpandComponents<5>(_mm_and_si128(_mm_srli_epi16(value, 6), mask5));
+        const __m128i b = ExpandComponents<5>(_mm_and_si128(_mm_srli_epi16(value, 1), mask5));
+        // 0 - 1 sets all bits of the lane, of which the top 8 are the alpha component
+        const __m128i a = _mm_slli_epi16(_mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(value, mask1)), 8);
+        StoreTexels(dest + i, _mm_or_si128(r, _mm_slli_epi16(g, 8)), _mm_or_si128(b, a));
+    }
+}
+
+static void DecodeRGBA4Tile(const u8* source, u32* dest) {
+    const __m128i mask4 = _mm_set1_epi16(0xF);
+    for (unsigned i = 0; i < 64; i += 8) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        const __m128i r = ExpandComponents<4>(_mm_srli_epi16(value, 12));
+        const __m128i g = ExpandComponents<4>(_mm_and_si128(_mm_srli_epi16(value, 8), mask4));
+        const __m128i b = ExpandComponents<4>(_mm_and_si128(_mm_srli_epi16(value, 4), mask4));
+        const __m128i a = ExpandComponents<4>(_mm_and_si128(value, mask4));
+        StoreTexels(dest + i, _mm_or_si128(r, _mm_slli_epi16(g, 8)), _mm_or_si128(b, _mm_slli_epi16(a, 8)));
+    }
+}
+
+static void DecodeIA8Tile(const u8* source, u32* dest) {
+    const __m128i high_mask = _mm_set1_epi16(static_cast<s16>(0xFF00));
+    for (unsigned i = 0; i < 64; i += 8) {
+        // Each lane holds the alpha component in its low byte and the intensity in its high byte
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        const __m128i intensity = _mm_srli_epi16(value, 8);
+        const __m128i ii = _mm_or_si128(intensity, _mm_and_si128(value, high_mask));
+        const __m128i ia = _mm_or_si128(intensity, _mm_slli_epi16(value, 8));
+        StoreTexels(dest + i, ii, ia);
+    }
+}
+
+/// Decodes 16 texels from 8-bit intensity and alpha components
+static void StoreIntensityAlpha(u32* dest, __m128i intensity, __m128i alpha) {
+    StoreTexels(dest, _mm_unpacklo_epi8(intensity, intensity), _mm_unpacklo_epi8(intensity, alpha));
+    StoreTexels(dest + 8, _mm_unpackhi_epi8(intensity, intensity), _mm_unpackhi_epi8(intensity, alpha));
+}
+
+/// Expands each nibble of 16 bytes to 8 bits, the low nibble of each byte coming first
+static void ExpandNibbles(__m128i value, __m128i& first, __m128i& second) {
+    const __m128i mask4 = _mm_set1_epi8(0xF);
+    const __m128i low = _mm_and_si128(value, mask4);
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(value, 4), mask4);
+    first = _mm_unpacklo_epi8(low, high);
+    second = _mm_unpackhi_epi8(low, high);
+    first = _mm_or_si128(first, _mm_slli_epi16(first, 4));
+    second = _mm_or_si128(second, _mm_slli_epi16(second, 4));
+}
+
+static void DecodeI8Tile(const u8* source, u32* dest) {
+    const __m128i alpha = _mm_set1_epi8(static_cast<s8>(0xFF));
+    for (unsigned i = 0; i < 64; i += 16) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        StoreIntensityAlpha(dest + i, value, alpha);
+    }
+}
+
+static void DecodeA8Tile(const u8* source, u32* dest) {
+    for (unsigned i = 0; i < 64; i += 16) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        const __m128i zero = _mm_setzero_si128();
+        StoreTexels(dest + i, zero, _mm_unpacklo_epi8(zero, value));
+        StoreTexels(dest + i + 8, zero, _mm_unpackhi_epi8(zero, value));
+    }
+}
+
+static void DecodeIA4Tile(const u8* source, u32* dest) {
+    const __m128i mask4 = _mm_set1_epi8(0xF);
+    for (unsigned i = 0; i < 64; i += 16) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        __m128i intensity = _mm_and_si128(_mm_srli_epi16(value, 4), mask4);
+        __m128i alpha = _mm_and_si128(value, mask4);
+        intensity = _mm_or_si128(intensity, _mm_slli_epi16(intensity, 4));
+        alpha = _mm_or_si128(alpha, _mm_slli_epi16(alpha, 4));
+        StoreIntensityAlpha(dest + i, intensity, alpha);
+    }
+}
+
+static void DecodeI4Tile(const u8* source, u32* dest) {
+    const __m128i alpha = _mm_set1_epi8(static_cast<s8>(0xFF));
+    for (unsigned i = 0; i < 64; i += 32) {
+        __m128i first, second;
+        ExpandNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i / 2)), first, second);
+        StoreIntensityAlpha(dest + i, first, alpha);
+        StoreIntensityAlpha(dest + i + 16, second, alpha);
+    }
+}
+
+static void DecodeA4Tile(const u8* source, u32* dest) {
+    const __m128i zero = _mm_setzero_si128();
+    for (unsigned i = 0; i < 64; i += 32) {
+        __m128i first, second;
+        ExpandNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i / 2)), first, second);
+        StoreTexels(dest + i, zero, _mm_unpacklo_epi8(zero, first));
+        StoreTexels(dest + i + 8, zero, _mm_unpackhi_epi8(zero, first));
+        StoreTexels(dest + i + 16, zero, _mm_unpacklo_epi8(zero, second));
+        StoreTexels(dest + i + 24, zero, _mm_unpackhi_epi8(zero, second));
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
+
+/// Decodes the 64 texels of a tile, in the Morton order they're stored in
+static void DecodeMortonTile(Regs::TextureFormat format, const u8* source, u32* dest) {
+#ifdef ARCHITECTURE_x86_64
+    switch (format) {
+    case Regs::TextureFormat::RGBA8:  DecodeRGBA8Tile(source, dest);  return;
+    case Regs::TextureFormat::RGB5A1: DecodeRGB5A1Tile(source, dest); return;
+    case Regs::TextureFormat::RGB565: DecodeRGB565Tile(source, dest); return;
+    case Regs::TextureFormat::RGBA4:  DecodeRGBA4Tile(source, dest);  return;
+    case Regs::TextureFormat::IA8:    DecodeIA8Tile(source, dest);    return;
+    case Regs::TextureFormat::I8:     DecodeI8Tile(source, dest);     return;
+    case Regs::TextureFormat::A8:     DecodeA8Tile(source, dest);     return;
+    case Regs::TextureFormat::IA4:    DecodeIA4Tile(source, dest);    return;
+    case Regs::TextureFormat::I4:     DecodeI4Tile(source, dest);     return;
+    case Regs::TextureFormat::A4:     DecodeA4Tile(source, dest);     return;
+    default:
+        break;
+    }
+#endif
+
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = DecodeTexel(format, source, i);
+}
+
+/// Decodes an ETC1 or ETC1A4 tile, made of four 4x4 subtiles
+static void DecodeETC1Tile(const u8* source, bool has_alpha, Math::Vec4<u8>* dest, int dest_stride) {
+    for (int subtile_index = 0; subtile_index < 4; ++subtile_index) {
+        u64 alpha = 0xFFFFFFFFFFFFFFFF;
+        if (has_alpha) {
+            std::memcpy(&alpha, source, sizeof(u64));
+            source += sizeof(u64);
+        }
+
+        u64 subtile;
+        std::memcpy(&subtile, source, sizeof(u64));
+        source += sizeof(u64);
+
+        // The base colors are the same for each half of the subtile
+        const ETC1Tile& tile = *reinterpret_cast<const ETC1Tile*>(&subtile);
+        const Math::Vec3<int> base_colors[2] = { tile.GetBaseColor(false), tile.GetBaseColor(true) };
+
+        Math::Vec4<u8>* subtile_dest = dest + (subtile_index & 1) * 4 + (subtile_index >> 1) * 4 * dest_stride;
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 0; x < 4; ++x) {
+                const unsigned texel = 4 * x + y;
+                const bool second_half = tile.IsInSecondHalf(x, y);
+                const auto color = ApplyETC1Modifier(base_colors[second_half], tile.GetModifier(second_half, texel));
+                subtile_dest[x + y * dest_stride] = Math::MakeVec(color, Color::Convert4To8((alpha >> (4 * texel)) & 0xF));
+            }
+        }
+    }
+}
+
+void DecodeTile(Regs::TextureFormat format, const u8* source, Math::Vec4<u8>* dest, int dest_stride) {
+    if (format == Regs::TextureFormat::ETC1 || format == Regs::TextureFormat::ETC1A4) {
+        DecodeETC1Tile(source, format == Regs::TextureFormat::ETC1A4, dest, dest_stride);
+        return;
+    }
+
+    alignas(16) u32 texels[64];
+    DecodeMortonTile(format, source, texels);
+    VideoCore::MortonUnswizzleTile(sizeof(u32), reinterpret_cast<const u8*>(texels), reinterpret_cast<u8*>(dest),
+                                   dest_stride * static_cast<int>(sizeof(u32)));
+}
+
+void DecodeTexture(const DebugUtils::TextureInfo& info, const u8* source, Math::Vec4<u8>* dest, int dest_stride) {
+    const bool is_etc1 = (info.format == Regs::TextureFormat::ETC1 || info.format == Regs::TextureFormat::ETC1A4);
+    const size_t tile_size = GetTileSize(info.format);
+
+    for (int tile_y = 0; tile_y < info.height; tile_y += 8) {
+        for (int tile_x = 0; tile_x < info.width; tile_x += 8) {
+            // Rows of ETC1 tiles aren't laid out according to the stride, as in LookupTexture
+            const u8* tile_source = is_etc1 ? source + (tile_y / 8 * (info.width / 8) + tile_x / 8) * tile_size
+                                            : source + tile_y * info.stride + tile_x / 8 * tile_size;
+            Math::Vec4<u8>* tile_dest = dest + tile_x + tile_y * dest_stride;
+
+            if (tile_x + 8 <= info.width && tile_y + 8 <= info.height) {
+                DecodeTile(info.format, tile_source, tile_dest, dest_stride);
+                continue;
+            }
+
+            // Tiles crossing the texture bounds are decoded separately, then clipped
+            Math::Vec4<u8> tile[64];
+            DecodeTile(info.format, tile_source, tile, 8);
+            const int width = std::min(8, info.width - tile_x);
+            const int height = std::min(8, info.height - tile_y);
+            for (int y = 0; y < height; ++y)
+                std::copy(tile + y * 8, tile + y * 8 + width, tile_dest + y * dest_stride);
+        }
+    }
+}
+
+} // namespace
+
+} // namespace
@@ -0,0 +1,53 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+#include "video_core/pica.h"
+
+namespace Pica {
+
+namespace DebugUtils {
+struct TextureInfo;
+}
+
+namespace Texture {
+
+/// Returns the size in bytes of an 8x8 tile of a texture format
+size_t GetTileSize(Regs::TextureFormat format);
+
+/**
+ * Decodes an 8x8 tile of a texture to RGBA8.
+ * @param format Format of the tile
+ * @param source Encoded tile
+ * @param dest Decoded texel (0, 0) of the tile, in the coordinates of DebugUtils::LookupTexture
+ * @param dest_stride Distance in texels between two rows of decoded texels, may be negative
+ */
+void DecodeTile(Regs::TextureFormat format, const u8* source, Math::Vec4<u8>* dest, int dest_stride);
+
+/**
+ * Decodes a texture to RGBA8, tile by tile. The texel at (x, y) is the same as the one returned by
+ * DebugUtils::LookupTexture for these coordinates.
+ * @param info Texture setup
+ * @param source Encoded texture data
+ * @param dest Decoded texel (0, 0) of the texture
+ * @param dest_stride Distance in texels between two rows of decoded texels, may be negative
+ */
+void DecodeTexture(const DebugUtils::TextureInfo& info, const u8* source, Math::Vec4<u8>* dest, int dest_stride);
+
+/**
+ * Decodes the color of a texel of a 4x4 ETC1 subtile.
+ * @param subtile 64-bit word storing the subtile
+ * @param x,y Coordinates of the texel within the subtile
+ */
+Math::Vec3<u8> SampleETC1Subtile(u64 subtile, unsigned x, unsigned y);
+
+} // namespace
+
+} // namespace
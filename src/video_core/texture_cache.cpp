@@ -0,0 +1,88 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "common/microprofile.h"
+
+#include "core/memory.h"
+
+#include "video_core/texture/texture_decode.h"
+#include "video_core/texture_cache.h"
+
+namespace Pica {
+
+/// Number of decoded texels kept before the cache is emptied, 64 MiB worth of RGBA8 data
+static const size_t MAX_CACHED_TEXELS = 16 * 1024 * 1024;
+
+MICROPROFILE_DEFINE(GPU_TextureDecode, "GPU", "Texture Decode", MP_RGB(128, 64, 192));
+
+TextureCache::~TextureCache() {
+    Clear();
+}
+
+const Math::Vec4<u8>* TextureCache::GetTexture(const u8* data, const DebugUtils::TextureInfo& info) {
+    const Key key{ info.physical_address, info.format, info.width, info.height };
+
+    auto it = textures.find(key);
+    if (it != textures.end())
+        return it->second.texels.data();
+
+    MICROPROFILE_SCOPE(GPU_TextureDecode);
+
+    CachedTexture texture;
+    texture.addr = info.physical_address;
+    texture.size = info.width * info.height * Regs::NibblesPerPixel(info.format) / 2;
+    texture.texels.resize(info.width * info.height);
+
+    Memory::RasterizerMarkRegionCached(texture.addr, texture.size, 1);
+    Texture::DecodeTexture(info, data, texture.texels.data(), info.width);
+
+    if (textures.empty()) {
+        cached_begin = texture.addr;
+        cached_end = texture.addr + texture.size;
+    } else {
+        cached_begin = std::min(cached_begin, texture.addr);
+        cached_end = std::max(cached_end, texture.addr + texture.size);
+    }
+    num_texels += texture.texels.size();
+
+    it = textures.emplace(key, std::move(texture)).first;
+    return it->second.texels.data();
+}
+
+bool TextureCache::InvalidateRegion(PAddr addr, u32 size) {
+    if (textures.empty() || addr >= cached_end || addr + size <= cached_begin)
+        return false;
+
+    bool invalidated = false;
+    for (auto it = textures.begin(); it != textures.end();) {
+        const CachedTexture& texture = it->second;
+        if (addr < texture.addr + texture.size && texture.addr < addr + size) {
+            Remove(it++);
+            invalidated = true;
+        } else {
+            ++it;
+        }
+    }
+    return invalidated;
+}
+
+void TextureCache::Prune() {
+    if (num_texels > MAX_CACHED_TEXELS)
+        Clear();
+}
+
+void TextureCache::Clear() {
+    while (!textures.empty())
+        Remove(textures.begin());
+}
+
+void TextureCache::Remove(std::map<Key, CachedTexture>::iterator it) {
+    Memory::RasterizerMarkRegionCached(it->second.addr, it->second.size, -1);
+    num_texels -= it->second.texels.size();
+    textures.erase(it);
+}
+
+} // namespace
@@ -0,0 +1,71 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica.h"
+
+namespace Pica {
+
+/**
+ * Textures decoded to linear RGBA8 for the software rasterizer, keyed by their address, format and
+ * size. The memory of a cached texture is marked as cached by the rasterizer, so that writes to it
+ * invalidate the texture through RasterizerInterface::FlushAndInvalidateRegion. Only used on the
+ * emulation thread, as marking the memory modifies the page table.
+ */
+class TextureCache {
+public:
+    ~TextureCache();
+
+    /**
+     * Returns the texels of a texture, decoding it if it isn't cached. Texels are stored row by row,
+     * with the texel at (s, t) in the coordinates of DebugUtils::LookupTexture at s + t * width.
+     * The returned data stays valid until the texture is invalidated or the cache is pruned.
+     * @param data Encoded texture data
+     * @param info Texture setup
+     */
+    const Math::Vec4<u8>* GetTexture(const u8* data, const DebugUtils::TextureInfo& info);
+
+    /**
+     * Removes the textures overlapping a memory region.
+     * @return True if any texture was removed
+     */
+    bool InvalidateRegion(PAddr addr, u32 size);
+
+    /// Empties the cache if the decoded textures exceed its memory budget
+    void Prune();
+
+    /// Removes all textures
+    void Clear();
+
+private:
+    struct CachedTexture {
+        PAddr addr;
+        u32 size;
+        std::vector<Math::Vec4<u8>> texels;
+    };
+
+    using Key = std::tuple<PAddr, Regs::TextureFormat, int, int>;
+
+    void Remove(std::map<Key, CachedTexture>::iterator it);
+
+    std::map<Key, CachedTexture> textures;
+
+    /// Bounds of the memory covered by the cached textures, to skip most invalidations quickly
+    PAddr cached_begin = 0;
+    PAddr cached_end = 0;
+
+    /// Total number of cached texels
+    size_t num_texels = 0;
+};
+
+} // namespace
@@ -0,0 +1,147 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+#include "video_core/utils.h"
+
+namespace VideoCore {
+
+/// Offset of a row of a 2x2 block of a tile in rows of pixels, blocks being indexed in Morton order
+static int LinearOffset(unsigned block, int row, u32 bytes_per_pixel, int linear_stride) {
+    const int x = ((block & 1) << 1) | (block & 4);
+    const int y = (block & 2) | ((block & 8) >> 1);
+    return x * static_cast<int>(bytes_per_pixel) + (y + row) * linear_stride;
+}
+
+static void UnswizzleTileGeneric(u32 bytes_per_pixel, const u8* tile, u8* linear, int linear_stride) {
+    // The rows of a 2x2 block are pairs of consecutive pixels
+    for (unsigned i = 0; i < 32; ++i) {
+        std::memcpy(linear + LinearOffset(i / 2, i % 2, bytes_per_pixel, linear_stride),
+                    tile + i * 2 * bytes_per_pixel, 2 * bytes_per_pixel);
+    }
+}
+
+static void SwizzleTileGeneric(u32 bytes_per_pixel, const u8* linear, int linear_stride, u8* tile) {
+    for (unsigned i = 0; i < 32; ++i) {
+        std::memcpy(tile + i * 2 * bytes_per_pixel,
+                    linear + LinearOffset(i / 2, i % 2, bytes_per_pixel, linear_stride), 2 * bytes_per_pixel);
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// Every 8 consecutive pixels of a tile in Morton order form a 4x2 block, with the pixels 0, 1, 4
+// and 5 on its first row and 2, 3, 6 and 7 on its second one. The bits of the block index
+// interleave its coordinates in the same way as the bits of the pixel index.
+
+static int BlockX(unsigned block) {
+    return (block & 2) << 1;
+}
+
+static int BlockY(unsigned block) {
+    return ((block & 1) << 1) | (block & 4);
+}
+
+static void UnswizzleTile32(const u8* tile, u8* linear, int linear_stride) {
+    for (unsigned block = 0; block < 8; ++block) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile + block * 32));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile + block * 32 + 16));
+        u8* dest = linear + BlockX(block) * 4 + BlockY(block) * linear_stride;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi64(a, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + linear_stride), _mm_unpackhi_epi64(a, b));
+    }
+}
+
+static void SwizzleTile32(const u8* linear, int linear_stride, u8* tile) {
+    for (unsigned block = 0; block < 8; ++block) {
+        const u8* source = linear + BlockX(block) * 4 + BlockY(block) * linear_stride;
+        const __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+        const __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + linear_stride));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(tile + block * 32), _mm_unpacklo_epi64(row0, row1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(tile + block * 32 + 16), _mm_unpackhi_epi64(row0, row1));
+    }
+}
+
+static void UnswizzleTile16(const u8* tile, u8* linear, int linear_stride) {
+    for (unsigned block = 0; block < 8; ++block) {
+        // Gather the pixel pairs of the first row in the low half, and those of the second one in
+        // the high half
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile + block * 16));
+        const __m128i rows = _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 1, 2, 0));
+        u8* dest = linear + BlockX(block) * 2 + BlockY(block) * linear_stride;
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest), rows);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + linear_stride), _mm_unpackhi_epi64(rows, rows));
+    }
+}
+
+static void SwizzleTile16(const u8* linear, int linear_stride, u8* tile) {
+    for (unsigned block = 0; block < 8; ++block) {
+        const u8* source = linear + BlockX(block) * 2 + BlockY(block) * linear_stride;
+        const __m128i row0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source));
+        const __m128i row1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + linear_stride));
+        const __m128i pixels = _mm_shuffle_epi32(_mm_unpacklo_epi64(row0, row1), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(tile + block * 16), pixels);
+    }
+}
+
+// With one byte per pixel, 16 pixels of a tile form a 4x4 block made of two 4x2 blocks stacked
+// on top of each other. Swapping the middle pixel pairs of each 4x2 block puts its rows in order.
+
+static void UnswizzleTile8(const u8* tile, u8* linear, int linear_stride) {
+    for (int block = 0; block < 4; ++block) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile + block * 16));
+        pixels = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+        u8* dest = linear + (block & 1) * 4 + (block >> 1) * 4 * linear_stride;
+        for (int row = 0; row < 4; ++row) {
+            const u32 value = static_cast<u32>(_mm_cvtsi128_si32(pixels));
+            std::memcpy(dest + row * linear_stride, &value, sizeof(value));
+            pixels = _mm_srli_si128(pixels, 4);
+        }
+    }
+}
+
+static void SwizzleTile8(const u8* linear, int linear_stride, u8* tile) {
+    for (int block = 0; block < 4; ++block) {
+        const u8* source = linear + (block & 1) * 4 + (block >> 1) * 4 * linear_stride;
+        u32 rows[4];
+        for (int row = 0; row < 4; ++row)
+            std::memcpy(&rows[row], source + row * linear_stride, sizeof(u32));
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows));
+        pixels = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(tile + block * 16), pixels);
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
+
+void MortonUnswizzleTile(u32 bytes_per_pixel, const u8* tile, u8* linear, int linear_stride) {
+#ifdef ARCHITECTURE_x86_64
+    switch (bytes_per_pixel) {
+    case 1: UnswizzleTile8(tile, linear, linear_stride);  return;
+    case 2: UnswizzleTile16(tile, linear, linear_stride); return;
+    case 4: UnswizzleTile32(tile, linear, linear_stride); return;
+    }
+#endif
+
+    UnswizzleTileGeneric(bytes_per_pixel, tile, linear, linear_stride);
+}
+
+void MortonSwizzleTile(u32 bytes_per_pixel, const u8* linear, int linear_stride, u8* tile) {
+#ifdef ARCHITECTURE_x86_64
+    switch (bytes_per_pixel) {
+    case 1: SwizzleTile8(linear, linear_stride, tile);  return;
+    case 2: SwizzleTile16(linear, linear_stride, tile); return;
+    case 4: SwizzleTile32(linear, linear_stride, tile); return;
+    }
+#endif
+
+    SwizzleTileGeneric(bytes_per_pixel, linear, linear_stride, tile);
+}
+
+} // namespace
@@ -55,4 +55,22 @@ static inline u32 GetMortonOffset(u32 x, u32 y, u32 bytes_per_pixel) {
     return (i + offset) * bytes_per_pixel;
 }
 
+/**
+ * Copies an 8x8 tile from Morton order to rows of pixels, as laid out by GetMortonOffset.
+ * @param bytes_per_pixel Size of a pixel, from 1 to 4 bytes
+ * @param tile The 64 pixels of the tile in Morton order
+ * @param linear Destination of the pixel at (0, 0) of the tile
+ * @param linear_stride Distance in bytes between two rows of linear pixels, may be negative
+ */
+void MortonUnswizzleTile(u32 bytes_per_pixel, const u8* tile, u8* linear, int linear_stride);
+
+/**
+ * Copies an 8x8 tile from rows of pixels to Morton order, the inverse of MortonUnswizzleTile.
+ * @param bytes_per_pixel Size of a pixel, from 1 to 4 bytes
+ * @param linear Source pixel at (0, 0) of the tile
+ * @param linear_stride Distance in bytes between two rows of linear pixels, may be negative
+ * @param tile The 64 pixels of the tile in Morton order
+ */
+void MortonSwizzleTile(u32 bytes_per_pixel, const u8* linear, int linear_stride, u8* tile);
+
 } // namespace
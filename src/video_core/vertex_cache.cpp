@@ -0,0 +1,131 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+#include "common/bit_set.h"
+
+#include "video_core/vertex_cache.h"
+
+namespace Pica {
+
+template <typename T>
+static void GetIndexRangeScalar(const T* indices, u32 num_indices, u32& min_vertex, u32& max_vertex) {
+    for (u32 i = 0; i < num_indices; ++i) {
+        min_vertex = std::min<u32>(min_vertex, indices[i]);
+        max_vertex = std::max<u32>(max_vertex, indices[i]);
+    }
+}
+
+void GetIndexRange(const u8* indices, bool index_u16, u32 num_indices, u32& min_vertex, u32& max_vertex) {
+    min_vertex = 0xFFFF;
+    max_vertex = 0;
+
+    const u32 index_size = index_u16 ? 2 : 1;
+    u32 num_scanned = 0;
+
+#ifdef ARCHITECTURE_x86_64
+    // Processes 16 bytes of indices at a time. SSE2 only has unsigned min/max for bytes, so 16-bit
+    // indices are biased into the signed range first.
+    const u32 indices_per_vector = 16 / index_size;
+    if (num_indices >= indices_per_vector) {
+        const __m128i bias = index_u16 ? _mm_set1_epi16(-0x8000) : _mm_setzero_si128();
+        __m128i min = _mm_xor_si128(_mm_set1_epi8(-1), bias);
+        __m128i max = _mm_xor_si128(_mm_setzero_si128(), bias);
+
+        for (; num_scanned + indices_per_vector <= num_indices; num_scanned += indices_per_vector) {
+            const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + num_scanned * index_size));
+            if (index_u16) {
+                const __m128i biased = _mm_xor_si128(data, bias);
+                min = _mm_min_epi16(min, biased);
+                max = _mm_max_epi16(max, biased);
+            } else {
+                min = _mm_min_epu8(min, data);
+                max = _mm_max_epu8(max, data);
+            }
+        }
+
+        alignas(16) u8 min_bytes[16];
+        alignas(16) u8 max_bytes[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(min_bytes), _mm_xor_si128(min, bias));
+        _mm_store_si128(reinterpret_cast<__m128i*>(max_bytes), _mm_xor_si128(max, bias));
+        if (index_u16) {
+            GetIndexRangeScalar(reinterpret_cast<const u16*>(min_bytes), 8, min_vertex, max_vertex);
+            GetIndexRangeScalar(reinterpret_cast<const u16*>(max_bytes), 8, min_vertex, max_vertex);
+        } else {
+            GetIndexRangeScalar(min_bytes, 16, min_vertex, max_vertex);
+            GetIndexRangeScalar(max_bytes, 16, min_vertex, max_vertex);
+        }
+    }
+#endif // ARCHITECTURE_x86_64
+
+    if (index_u16) {
+        GetIndexRangeScalar(reinterpret_cast<const u16*>(indices) + num_scanned, num_indices - num_scanned, min_vertex, max_vertex);
+    } else {
+        GetIndexRangeScalar(indices + num_scanned, num_indices - num_scanned, min_vertex, max_vertex);
+    }
+}
+
+void VertexCache::Setup(const u8* indices, bool index_u16, u32 num_indices, u32 min_vertex, u32 max_vertex) {
+    slot_vertices.clear();
+    if (num_indices == 0)
+        return;
+
+    // Clearing a bitmap covering the index range is only worth it if most of it is used
+    const u32 range = max_vertex - min_vertex + 1;
+    use_table = range <= std::max<u32>(num_indices * 4, 1024);
+    this->min_vertex = min_vertex;
+
+    if (use_table) {
+        ScanDense(indices, index_u16, num_indices, range);
+    } else {
+        InsertSparse(indices, index_u16, num_indices);
+    }
+
+    if (vertices.size() < slot_vertices.size())
+        vertices.resize(slot_vertices.size());
+}
+
+void VertexCache::ScanDense(const u8* indices, bool index_u16, u32 num_indices, u32 range) {
+    referenced.assign((range + 63) / 64, 0);
+    slot_table.resize(range);
+
+    auto Mark = [this](const auto* indices, u32 num_indices) {
+        for (u32 i = 0; i < num_indices; ++i) {
+            const u32 offset = indices[i] - min_vertex;
+            referenced[offset / 64] |= u64(1) << (offset % 64);
+        }
+    };
+    if (index_u16) {
+        Mark(reinterpret_cast<const u16*>(indices), num_indices);
+    } else {
+        Mark(indices, num_indices);
+    }
+
+    // Entries of the slot table for vertices which aren't referenced are left undefined
+    for (u32 word = 0; word < referenced.size(); ++word) {
+        for (u64 bits = referenced[word]; bits != 0; bits &= bits - 1) {
+            const u32 offset = word * 64 + Common::LeastSignificantSetBit(bits);
+            slot_table[offset] = static_cast<u32>(slot_vertices.size());
+            slot_vertices.push_back(min_vertex + offset);
+        }
+    }
+}
+
+void VertexCache::InsertSparse(const u8* indices, bool index_u16, u32 num_indices) {
+    slot_map.clear();
+    slot_map.reserve(num_indices);
+
+    for (u32 i = 0; i < num_indices; ++i) {
+        const u32 vertex = index_u16 ? reinterpret_cast<const u16*>(indices)[i] : indices[i];
+        if (slot_map.emplace(vertex, static_cast<u32>(slot_vertices.size())).second)
+            slot_vertices.push_back(vertex);
+    }
+}
+
+} // namespace
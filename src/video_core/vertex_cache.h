@@ -0,0 +1,85 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "common/common_types.h"
+
+#include "video_core/shader/shader.h"
+
+namespace Pica {
+
+/**
+ * Determines the range of vertices referenced by the index array of a draw.
+ * @param indices Index array, made of 8-bit or 16-bit indices
+ * @param index_u16 True if the indices are 16-bit
+ * @param num_indices Number of indices of the draw
+ * @param min_vertex Set to the lowest referenced vertex
+ * @param max_vertex Set to the highest referenced vertex
+ */
+void GetIndexRange(const u8* indices, bool index_u16, u32 num_indices, u32& min_vertex, u32& max_vertex);
+
+/**
+ * Post-transform vertex cache for a single indexed draw. Each vertex referenced by the draw is
+ * assigned a slot, so that it's only shaded once per draw.
+ *
+ * If the index range of the draw is dense, the index array is scanned into a bitmap of the
+ * referenced vertices, which are then assigned slots in ascending order. This keeps the accesses
+ * to the vertex arrays sequential when shading. Otherwise, vertices are assigned slots in the
+ * order they are referenced in, and are mapped to their slot through a hash map.
+ */
+class VertexCache {
+public:
+    /**
+     * Empties the cache and inserts the vertices referenced by a draw.
+     * @param indices Index array, made of 8-bit or 16-bit indices
+     * @param index_u16 True if the indices are 16-bit
+     * @param num_indices Number of indices of the draw
+     * @param min_vertex Lowest vertex referenced by the draw, as returned by GetIndexRange
+     * @param max_vertex Highest vertex referenced by the draw, as returned by GetIndexRange
+     */
+    void Setup(const u8* indices, bool index_u16, u32 num_indices, u32 min_vertex, u32 max_vertex);
+
+    /// Returns the slot of a vertex referenced by the draw
+    u32 GetSlot(u32 vertex) const {
+        return use_table ? slot_table[vertex - min_vertex] : slot_map.at(vertex);
+    }
+
+    /// Returns the vertex assigned to a slot
+    u32 GetVertex(u32 slot) const {
+        return slot_vertices[slot];
+    }
+
+    /// Returns the shaded vertex stored in a slot
+    Shader::OutputVertex& Get(u32 slot) {
+        return vertices[slot];
+    }
+
+    /// Returns the number of vertices in the cache, slots are numbered from 0
+    u32 GetNumVertices() const {
+        return static_cast<u32>(slot_vertices.size());
+    }
+
+private:
+    void ScanDense(const u8* indices, bool index_u16, u32 num_indices, u32 range);
+    void InsertSparse(const u8* indices, bool index_u16, u32 num_indices);
+
+    bool use_table = false;
+    u32 min_vertex = 0;
+
+    /// Bit set for each vertex of the index range referenced by the draw, if the indices are dense
+    std::vector<u64> referenced;
+    /// Slot of each vertex in the index range of the draw, used if the indices are dense
+    std::vector<u32> slot_table;
+    /// Slot of each vertex, used if the indices are sparse
+    std::unordered_map<u32, u32> slot_map;
+
+    std::vector<u32> slot_vertices;
+    std::vector<Shader::OutputVertex> vertices;
+};
+
+} // namespace
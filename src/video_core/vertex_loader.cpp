@@ -1,4 +1,6 @@
+#include <cstring>
 #include <memory>
+#include <unordered_map>
 
 #include <boost/range/algorithm/fill.hpp>
 
@@ -6,6 +8,7 @@
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/vector_math.h"
 
@@ -18,8 +21,29 @@
 #include "video_core/shader/shader.h"
 #include "video_core/vertex_loader.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/vertex_loader_jit_x64.h"
+#endif // ARCHITECTURE_x86_64
+
+#include "video_core/video_core.h"
+
 namespace Pica {
 
+#ifdef ARCHITECTURE_x86_64
+static std::unordered_map<u64, std::unique_ptr<VertexLoaderJit>> jit_loader_map;
+#endif // ARCHITECTURE_x86_64
+
+void VertexLoader::ClearCache() {
+#ifdef ARCHITECTURE_x86_64
+    jit_loader_map.clear();
+#endif // ARCHITECTURE_x86_64
+}
+
+static u32 GetAttributeSizeInBytes(Regs::VertexAttributeFormat format, u32 elements) {
+    return elements * ((format == Regs::VertexAttributeFormat::FLOAT) ? 4
+                       : (format == Regs::VertexAttributeFormat::SHORT) ? 2 : 1);
+}
+
 void VertexLoader::Setup(const Pica::Regs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -64,20 +88,105 @@ void VertexLoader::Setup(const Pica::Regs& regs) {
     }
 
     is_setup = true;
+
+#ifdef ARCHITECTURE_x86_64
+    if (VideoCore::g_shader_jit_enabled) {
+        // The compiled code only depends on the layout of each attribute, the offsets of the
+        // attributes are passed in when it is run.
+        struct {
+            std::array<u32, 16> formats;
+            std::array<u32, 16> elements;
+            std::array<u32, 16> strides;
+            std::array<u32, 16> is_default;
+            u32 num_total_attributes;
+        } layout;
+        std::memset(&layout, 0, sizeof(layout));
+
+        for (int i = 0; i < num_total_attributes; ++i) {
+            if (vertex_attribute_elements[i] != 0) {
+                layout.formats[i] = static_cast<u32>(vertex_attribute_formats[i]);
+                layout.elements[i] = vertex_attribute_elements[i];
+                layout.strides[i] = vertex_attribute_strides[i];
+            }
+            layout.is_default[i] = vertex_attribute_is_default[i];
+        }
+        layout.num_total_attributes = num_total_attributes;
+
+        u64 cache_key = Common::ComputeHash64(&layout, sizeof(layout));
+
+        auto iter = jit_loader_map.find(cache_key);
+        if (iter != jit_loader_map.end()) {
+            jit_loader = iter->second.get();
+        } else {
+            auto compiled = std::make_unique<VertexLoaderJit>();
+            compiled->Compile(*this);
+            jit_loader = compiled.get();
+            jit_loader_map[cache_key] = std::move(compiled);
+        }
+    }
+#endif // ARCHITECTURE_x86_64
+}
+
+void VertexLoader::PrepareDraw(u32 base_address, u32 min_vertex, u32 max_vertex) {
+    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before preparing a draw.");
+
+    jit_ready = false;
+    if (jit_loader == nullptr || min_vertex > max_vertex)
+        return;
+
+    for (int i = 0; i < num_total_attributes; ++i) {
+        if (vertex_attribute_elements[i] == 0)
+            continue;
+
+        const u32 start = base_address + vertex_attribute_sources[i] + vertex_attribute_strides[i] * min_vertex;
+        const u32 end = base_address + vertex_attribute_sources[i] + vertex_attribute_strides[i] * max_vertex +
+                        GetAttributeSizeInBytes(vertex_attribute_formats[i], vertex_attribute_elements[i]);
+
+        const u8* start_pointer = Memory::GetPhysicalPointer(start);
+        if (start_pointer == nullptr)
+            return;
+
+        // Emulated memory is only contiguous on the host within a single memory block, check that
+        // every page touched by the attribute follows the previous one.
+        for (u32 page = (start & ~Memory::PAGE_MASK) + Memory::PAGE_SIZE; page < end; page += Memory::PAGE_SIZE) {
+            if (Memory::GetPhysicalPointer(page) != start_pointer + (page - start))
+                return;
+        }
+
+        jit_attribute_pointers[i] = start_pointer;
+    }
+
+    jit_min_vertex = min_vertex;
+    jit_max_vertex = max_vertex;
+    jit_ready = true;
 }
 
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex, Shader::InputVertex& input, DebugUtils::MemoryAccessTracker& memory_accesses) {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
+#ifdef ARCHITECTURE_x86_64
+    // The interpreter is used when recording, since it reports the memory accesses of each vertex
+    const bool recording = g_debug_context && g_debug_context->recorder;
+    const u32 offset = static_cast<u32>(vertex) - jit_min_vertex;
+    if (jit_ready && !recording && offset <= jit_max_vertex - jit_min_vertex) {
+        jit_loader->Run(jit_attribute_pointers.data(), offset, input);
+        return;
+    }
+#endif // ARCHITECTURE_x86_64
+
+    LoadVertexInterpreted(base_address, index, vertex, input, memory_accesses);
+}
+
+void VertexLoader::LoadVertexInterpreted(u32 base_address, int index, int vertex, Shader::InputVertex& input, DebugUtils::MemoryAccessTracker& memory_accesses) {
+
     for (int i = 0; i < num_total_attributes; ++i) {
         if (vertex_attribute_elements[i] != 0) {
             // Load per-vertex data from the loader arrays
             u32 source_addr = base_address + vertex_attribute_sources[i] + vertex_attribute_strides[i] * vertex;
 
             if (g_debug_context && Pica::g_debug_context->recorder) {
-                memory_accesses.AddAccess(source_addr, vertex_attribute_elements[i] * (
-                    (vertex_attribute_formats[i] == Regs::VertexAttributeFormat::FLOAT) ? 4
-                    : (vertex_attribute_formats[i] == Regs::VertexAttributeFormat::SHORT) ? 2 : 1));
+                memory_accesses.AddAccess(source_addr,
+                    GetAttributeSizeInBytes(vertex_attribute_formats[i], vertex_attribute_elements[i]));
             }
 
             switch (vertex_attribute_formats[i]) {
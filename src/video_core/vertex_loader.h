@@ -15,6 +15,8 @@ namespace Shader {
 struct InputVertex;
 }
 
+class VertexLoaderJit;
+
 class VertexLoader {
 public:
     VertexLoader() = default;
@@ -23,11 +25,28 @@ public:
     }
 
     void Setup(const Pica::Regs& regs);
+
+    /**
+     * Prepares the compiled vertex loader for a draw, if one is available. The compiled loader is
+     * only used if the data of all vertices in the given range lies in contiguous host memory.
+     * @param base_address Physical base address of the vertex arrays
+     * @param min_vertex Lowest vertex index that will be loaded
+     * @param max_vertex Highest vertex index that will be loaded
+     */
+    void PrepareDraw(u32 base_address, u32 min_vertex, u32 max_vertex);
+
     void LoadVertex(u32 base_address, int index, int vertex, Shader::InputVertex& input, DebugUtils::MemoryAccessTracker& memory_accesses);
 
     int GetNumTotalAttributes() const { return num_total_attributes; }
 
+    /// Clears the cache of compiled vertex loaders
+    static void ClearCache();
+
 private:
+    friend class VertexLoaderJit;
+
+    void LoadVertexInterpreted(u32 base_address, int index, int vertex, Shader::InputVertex& input, DebugUtils::MemoryAccessTracker& memory_accesses);
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<Regs::VertexAttributeFormat, 16> vertex_attribute_formats;
@@ -35,6 +54,15 @@ private:
     std::array<bool, 16> vertex_attribute_is_default;
     int num_total_attributes = 0;
     bool is_setup = false;
+
+    /// Compiled loader for the attribute layout, nullptr if the interpreter is used
+    const VertexLoaderJit* jit_loader = nullptr;
+    /// Host pointers to the data of each attribute for `jit_min_vertex`
+    std::array<const u8*, 16> jit_attribute_pointers{};
+    u32 jit_min_vertex = 0;
+    u32 jit_max_vertex = 0;
+    /// True if PrepareDraw found all attribute data for the draw in contiguous host memory
+    bool jit_ready = false;
 };
 
 }  // namespace Pica
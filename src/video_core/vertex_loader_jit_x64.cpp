@@ -0,0 +1,199 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdint>
+#include <xmmintrin.h>
+
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+#include "common/x64/abi.h"
+#include "common/x64/cpu_detect.h"
+#include "common/x64/emitter.h"
+
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/vertex_loader_jit_x64.h"
+
+namespace Pica {
+
+using namespace Gen;
+
+// Only caller-saved registers are used, so the compiled code doesn't need to save any registers.
+
+/// Array of host pointers to the data of each attribute
+static const X64Reg ATTRIBUTE_POINTERS = ABI_PARAM1;
+/// Index of the vertex to load, relative to the first vertex of the draw
+static const X64Reg VERTEX = ABI_PARAM2;
+/// Pointer to the InputVertex the attributes are written to
+static const X64Reg INPUT = ABI_PARAM3;
+/// Address of the data of the attribute being loaded
+static const X64Reg ADDRESS = RAX;
+/// General purpose scratch registers
+static const X64Reg SCRATCH = R10;
+static const X64Reg SCRATCH2 = R11;
+/// Loaded with the converted attribute
+static const X64Reg ATTRIBUTE = XMM0;
+/// SIMD scratch register
+static const X64Reg SCRATCH_XMM = XMM1;
+/// Constant vector of [0.0f, 0.0f, 0.0f, 1.0f], used to fill in the components that aren't loaded
+static const X64Reg DEFAULT_W = XMM2;
+
+void VertexLoaderJit::Compile_LoadAttribute(const VertexLoader& loader, int index) {
+    const u32 elements = loader.vertex_attribute_elements[index];
+    const bool sse4_1 = Common::GetCPUCaps().sse4_1;
+
+    switch (loader.vertex_attribute_formats[index]) {
+    case Regs::VertexAttributeFormat::FLOAT:
+        switch (elements) {
+        case 1:
+            MOVSS(ATTRIBUTE, MatR(ADDRESS));
+            break;
+        case 2:
+            MOVQ_xmm(ATTRIBUTE, MatR(ADDRESS));
+            break;
+        case 3:
+            MOVQ_xmm(ATTRIBUTE, MatR(ADDRESS));
+            MOVSS(SCRATCH_XMM, MDisp(ADDRESS, 8));
+            MOVLHPS(ATTRIBUTE, SCRATCH_XMM);
+            break;
+        case 4:
+            MOVUPS(ATTRIBUTE, MatR(ADDRESS));
+            break;
+        }
+        // float24 values are stored as 32-bit floats, no conversion is needed
+        return;
+
+    case Regs::VertexAttributeFormat::SHORT:
+        if (elements == 4 && sse4_1) {
+            PMOVSXWD(ATTRIBUTE, MatR(ADDRESS));
+            break;
+        }
+
+        // Never read past the end of the attribute, it might be the end of the mapped memory
+        switch (elements) {
+        case 1:
+            MOVZX(32, 16, SCRATCH, MatR(ADDRESS));
+            MOVD_xmm(ATTRIBUTE, R(SCRATCH));
+            break;
+        case 2:
+            MOVD_xmm(ATTRIBUTE, MatR(ADDRESS));
+            break;
+        case 3:
+            MOVD_xmm(ATTRIBUTE, MatR(ADDRESS));
+            PINSRW(ATTRIBUTE, MDisp(ADDRESS, 4), 2);
+            break;
+        case 4:
+            MOVQ_xmm(ATTRIBUTE, MatR(ADDRESS));
+            break;
+        }
+
+        if (sse4_1) {
+            PMOVSXWD(ATTRIBUTE, R(ATTRIBUTE));
+        } else {
+            PUNPCKLWD(ATTRIBUTE, R(ATTRIBUTE));
+            PSRAD(ATTRIBUTE, 16);
+        }
+        break;
+
+    case Regs::VertexAttributeFormat::BYTE:
+    case Regs::VertexAttributeFormat::UBYTE:
+    {
+        const bool is_signed = loader.vertex_attribute_formats[index] == Regs::VertexAttributeFormat::BYTE;
+
+        switch (elements) {
+        case 1:
+            MOVZX(32, 8, SCRATCH, MatR(ADDRESS));
+            MOVD_xmm(ATTRIBUTE, R(SCRATCH));
+            break;
+        case 2:
+            MOVZX(32, 16, SCRATCH, MatR(ADDRESS));
+            MOVD_xmm(ATTRIBUTE, R(SCRATCH));
+            break;
+        case 3:
+            MOVZX(32, 16, SCRATCH, MatR(ADDRESS));
+            MOVZX(32, 8, SCRATCH2, MDisp(ADDRESS, 2));
+            SHL(32, R(SCRATCH2), Imm8(16));
+            OR(32, R(SCRATCH), R(SCRATCH2));
+            MOVD_xmm(ATTRIBUTE, R(SCRATCH));
+            break;
+        case 4:
+            MOVD_xmm(ATTRIBUTE, MatR(ADDRESS));
+            break;
+        }
+
+        if (is_signed) {
+            if (sse4_1) {
+                PMOVSXBD(ATTRIBUTE, R(ATTRIBUTE));
+            } else {
+                PUNPCKLBW(ATTRIBUTE, R(ATTRIBUTE));
+                PUNPCKLWD(ATTRIBUTE, R(ATTRIBUTE));
+                PSRAD(ATTRIBUTE, 24);
+            }
+        } else {
+            if (sse4_1) {
+                PMOVZXBD(ATTRIBUTE, R(ATTRIBUTE));
+            } else {
+                PXOR(SCRATCH_XMM, R(SCRATCH_XMM));
+                PUNPCKLBW(ATTRIBUTE, R(SCRATCH_XMM));
+                PUNPCKLWD(ATTRIBUTE, R(SCRATCH_XMM));
+            }
+        }
+        break;
+    }
+    }
+
+    CVTDQ2PS(ATTRIBUTE, R(ATTRIBUTE));
+}
+
+void VertexLoaderJit::Compile(const VertexLoader& loader) {
+    program = (CompiledLoader*)GetCodePtr();
+
+    // The vertex index is a 32-bit argument, the upper half of the register is undefined
+    MOV(32, R(VERTEX), R(VERTEX));
+
+    static const __m128 default_w = { 0.f, 0.f, 0.f, 1.f };
+    MOV(PTRBITS, R(ADDRESS), ImmPtr(&default_w));
+    MOVAPS(DEFAULT_W, MatR(ADDRESS));
+
+    for (int i = 0; i < loader.num_total_attributes; ++i) {
+        const int input_offset = static_cast<int>(i * sizeof(Math::Vec4<float24>));
+
+        if (loader.vertex_attribute_elements[i] != 0) {
+            MOV(PTRBITS, R(ADDRESS), MDisp(ATTRIBUTE_POINTERS, static_cast<int>(i * sizeof(const u8*))));
+            IMUL(32, SCRATCH, R(VERTEX), Imm32(loader.vertex_attribute_strides[i]));
+            ADD(64, R(ADDRESS), R(SCRATCH));
+
+            Compile_LoadAttribute(loader, i);
+
+            // Default attribute values set if array elements have < 4 components. The components
+            // which weren't loaded are zero at this point.
+            if (loader.vertex_attribute_elements[i] < 4)
+                ORPS(ATTRIBUTE, R(DEFAULT_W));
+
+            MOVAPS(MDisp(INPUT, input_offset), ATTRIBUTE);
+        } else if (loader.vertex_attribute_is_default[i]) {
+            // Default attributes may change between draws, so they are read when the loader runs
+            MOV(PTRBITS, R(ADDRESS), ImmPtr(&g_state.vs_default_attributes[i]));
+            MOVUPS(ATTRIBUTE, MatR(ADDRESS));
+            MOVAPS(MDisp(INPUT, input_offset), ATTRIBUTE);
+        }
+    }
+
+    RET();
+
+    uintptr_t size = reinterpret_cast<uintptr_t>(GetCodePtr()) - reinterpret_cast<uintptr_t>(program);
+    ASSERT_MSG(size <= MAX_VERTEX_LOADER_SIZE, "Compiled a vertex loader that exceeds the allocated size!");
+
+    LOG_DEBUG(HW_GPU, "Compiled vertex loader size=%lu", size);
+}
+
+VertexLoaderJit::VertexLoaderJit() {
+    AllocCodeSpace(MAX_VERTEX_LOADER_SIZE);
+}
+
+} // namespace Pica
@@ -0,0 +1,56 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/common_types.h"
+#include "common/x64/emitter.h"
+
+namespace Pica {
+
+namespace Shader {
+struct InputVertex;
+}
+
+class VertexLoader;
+
+/// Memory allocated for each compiled vertex loader (4Kb)
+constexpr size_t MAX_VERTEX_LOADER_SIZE = 1024 * 4;
+
+/**
+ * This class implements the vertex loader JIT compiler. It compiles the attribute layout
+ * configured in a VertexLoader into x86_64 code which converts the attributes of a single vertex
+ * and writes them to an InputVertex.
+ */
+class VertexLoaderJit : public Gen::XCodeBlock {
+public:
+    VertexLoaderJit();
+
+    /**
+     * Loads the attributes of a vertex.
+     * @param attribute_pointers Host pointers to the data of each attribute for the first vertex
+     *        of the draw
+     * @param vertex Index of the vertex, relative to the first vertex of the draw
+     * @param input InputVertex the attributes are written to
+     */
+    void Run(const u8* const* attribute_pointers, u32 vertex, Shader::InputVertex& input) const {
+        program(attribute_pointers, vertex, &input);
+    }
+
+    void Compile(const VertexLoader& loader);
+
+private:
+    /**
+     * Emits the code loading attribute `index` of the vertex into XMM0, converted to float.
+     * Expects the address of the attribute data in RAX. Components which aren't loaded are zeroed.
+     */
+    void Compile_LoadAttribute(const VertexLoader& loader, int index);
+
+    using CompiledLoader = void(const u8* const* attribute_pointers, u32 vertex, Shader::InputVertex* input);
+    CompiledLoader* program = nullptr;
+};
+
+} // namespace Pica
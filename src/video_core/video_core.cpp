@@ -9,6 +9,7 @@
 #include "video_core/pica.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
+#include "video_core/renderer_null/renderer_null.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -21,14 +22,23 @@ std::unique_ptr<RendererBase> g_renderer;             ///< Renderer plugin
 
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
+std::atomic<bool> g_shader_jit_async_enabled;
+std::atomic<bool> g_shader_disk_cache_enabled;
 std::atomic<bool> g_scaled_resolution_enabled;
+std::atomic<int> g_parallel_vertex_threshold;
+std::atomic<bool> g_sw_rasterizer_binning_enabled;
+std::atomic<bool> g_async_gpu_enabled;
 
 /// Initialize the video core
-bool Init(EmuWindow* emu_window) {
+bool Init(EmuWindow* emu_window, bool headless) {
     Pica::Init();
 
     g_emu_window = emu_window;
-    g_renderer = std::make_unique<RendererOpenGL>();
+    if (headless) {
+        g_renderer = std::make_unique<RendererNull>();
+    } else {
+        g_renderer = std::make_unique<RendererOpenGL>();
+    }
     g_renderer->SetWindow(g_emu_window);
     if (g_renderer->Init()) {
         LOG_DEBUG(Render, "initialized OK");
@@ -36,13 +36,27 @@ extern EmuWindow*                    g_emu_window; ///< Emu window
 // TODO: Wrap these in a user settings struct along with any other graphics settings (often set from qt ui)
 extern std::atomic<bool> g_hw_renderer_enabled;
 extern std::atomic<bool> g_shader_jit_enabled;
+/// Whether shaders are compiled on a background thread, the interpreter runs them in the meantime
+extern std::atomic<bool> g_shader_jit_async_enabled;
+/// Whether the shaders of each title are stored on disk and compiled ahead of time on the next run
+extern std::atomic<bool> g_shader_disk_cache_enabled;
 extern std::atomic<bool> g_scaled_resolution_enabled;
+/// Minimum vertex count of draws which are processed on multiple threads, 0 if disabled
+extern std::atomic<int> g_parallel_vertex_threshold;
+/// Whether the software rasterizer bins triangles into tiles rasterized on multiple threads
+extern std::atomic<bool> g_sw_rasterizer_binning_enabled;
+/// Whether GPU commands run on a separate thread when the rasterizer supports it
+extern std::atomic<bool> g_async_gpu_enabled;
 
 /// Start the video core
 void Start();
 
-/// Initialize the video core
-bool Init(EmuWindow* emu_window);
+/**
+ * Initialize the video core
+ * @param emu_window Window frames are presented to
+ * @param headless If true, frames aren't presented and no graphics context is required
+ */
+bool Init(EmuWindow* emu_window, bool headless);
 
 /// Shutdown the video core
 void Shutdown();